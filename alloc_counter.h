@@ -0,0 +1,40 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Heap allocations made by the current thread.
+ *
+ * alloc_counter.cpp replaces the global operator new to bump these thread-local counters,
+ * so a caller can attribute allocations to a piece of work by differencing them around it.
+ * Linking alloc_counter.cpp into a program is what enables the counting.
+ */
+struct AllocCounter {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+extern thread_local AllocCounter thread_allocations;
@@ -0,0 +1,408 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "archive_writer.h"
+
+#include "tsc_clock.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+
+constexpr auto drain_interval = std::chrono::milliseconds(10);
+constexpr size_t archive_page = 4096;
+constexpr size_t frame_header_size = 15;  // kind, stream id, time, size
+constexpr size_t entry_header_size = 4;  // entry size in the staging ring, 0 for padding to the end
+
+/**
+ * @brief Returns CLOCK_MONOTONIC in microseconds.
+ */
+static int64_t monotonic_us() {
+    return TscClock::Get().MonotonicNs() / 1000;
+}
+
+/**
+ * @brief Returns the CPU time of the calling thread in microseconds.
+ */
+static int64_t thread_cpu_us() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Stages one frame of a stream; drops and counts it if the ring is full.
+ *
+ * @param stream Stream id, as in the names given to Open().
+ * @param time_us Arrival time in Unix microseconds.
+ * @return true if the frame was staged.
+ */
+bool ArchiveWriter::Producer::Append(uint32_t stream, int64_t time_us, const uint8_t* frame, size_t size) {
+    size_t entry = (entry_header_size + frame_header_size + size + 7) & ~static_cast<size_t>(7);
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    size_t offset = head & (capacity_ - 1);
+    // an entry never wraps; the rest of the ring is skipped instead
+    size_t pad = offset + entry > capacity_ ? capacity_ - offset : 0;
+    if (size > archive_max_frame || head + pad + entry - cached_tail_ > capacity_) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (size > archive_max_frame || head + pad + entry - cached_tail_ > capacity_) {
+            dropped_frames_.store(dropped_frames_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            dropped_bytes_.store(dropped_bytes_.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    if (pad > 0) {
+        memset(data_.get() + offset, 0, entry_header_size);
+        head += pad;
+    }
+    uint8_t* out = data_.get() + (head & (capacity_ - 1));
+    uint32_t entry32 = static_cast<uint32_t>(entry);
+    uint16_t size16 = static_cast<uint16_t>(size);
+    memcpy(out, &entry32, 4);
+    out[4] = 'F';
+    memcpy(out + 5, &stream, 4);
+    memcpy(out + 9, &time_us, 8);
+    memcpy(out + 17, &size16, 2);
+    memcpy(out + 19, frame, size);
+    head += entry;
+    uint64_t staged = head - tail_.load(std::memory_order_relaxed);
+    if (staged > high_water_.load(std::memory_order_relaxed)) {
+        high_water_.store(staged, std::memory_order_relaxed);
+    }
+    head_.store(head, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Destructor for ArchiveWriter, closing the archive.
+ */
+ArchiveWriter::~ArchiveWriter() {
+    Close();
+}
+
+/**
+ * @brief Opens the first file and starts the writer thread.
+ *
+ * @param options Where and how to write.
+ * @param streams The name of every stream id, written at the start of each file.
+ * @return true if the first file could be created.
+ */
+bool ArchiveWriter::Open(const ArchiveOptions& options, const std::vector<std::string>& streams) {
+    Close();
+    options_ = options;
+    options_.batch_bytes = (options.batch_bytes + archive_page - 1) / archive_page * archive_page;
+    if (options_.batch_bytes == 0) {
+        options_.batch_bytes = archive_page;
+    }
+    streams_ = streams;
+    void* batch = nullptr;
+    if (posix_memalign(&batch, archive_page, options_.batch_bytes) != 0) {
+        std::cerr << "Error: Could not allocate the archive batch" << std::endl;
+        return false;
+    }
+    batch_ = static_cast<uint8_t*>(batch);
+    batch_used_ = 0;
+    failed_ = false;
+    int64_t now = monotonic_us();
+    if (!OpenFile(now)) {
+        free(batch_);
+        batch_ = nullptr;
+        return false;
+    }
+    next_sync_us_ = now + options_.sync_interval_us;
+    stop_ = false;
+    writer_ = std::thread(&ArchiveWriter::Run, this);
+    return true;
+}
+
+/**
+ * @brief Creates a staging ring for the calling thread, which should use it from now on.
+ *
+ * The ring is allocated and touched by the caller, so it lives on the caller's NUMA node.
+ * Producers stay valid until the writer is destroyed.
+ */
+ArchiveWriter::Producer* ArchiveWriter::AddProducer() {
+    std::unique_ptr<Producer> producer(new Producer());
+    size_t capacity = 1 << 16;  // room for the largest frame
+    while (capacity < options_.staging_bytes) {
+        capacity <<= 1;
+    }
+    producer->data_.reset(new uint8_t[capacity]);
+    memset(producer->data_.get(), 0, capacity);  // fault the pages in now rather than while recording
+    producer->capacity_ = capacity;
+    std::lock_guard<std::mutex> lock(mutex_);
+    producers_.push_back(std::move(producer));
+    return producers_.back().get();
+}
+
+/**
+ * @brief Writes everything staged, syncs and closes the file and stops the writer thread.
+ */
+void ArchiveWriter::Close() {
+    if (!writer_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+    Drain();
+    CloseFile();
+    free(batch_);
+    batch_ = nullptr;
+}
+
+/**
+ * @brief Returns a snapshot of the counters; may be called from any thread.
+ */
+ArchiveStats ArchiveWriter::stats() const {
+    ArchiveStats stats;
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.writes = writes_.load(std::memory_order_relaxed);
+    stats.syncs = syncs_.load(std::memory_order_relaxed);
+    stats.files = files_.load(std::memory_order_relaxed);
+    stats.max_sync_us = max_sync_us_.load(std::memory_order_relaxed);
+    stats.writer_cpu_us = writer_cpu_us_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& producer : producers_) {
+        stats.dropped_frames += producer->dropped_frames_.load(std::memory_order_relaxed);
+        stats.dropped_bytes += producer->dropped_bytes_.load(std::memory_order_relaxed);
+        stats.staged_bytes += producer->head_.load(std::memory_order_relaxed) -
+                              producer->tail_.load(std::memory_order_relaxed);
+        uint64_t high_water = producer->high_water_.load(std::memory_order_relaxed);
+        stats.staged_high_water = high_water > stats.staged_high_water ? high_water : stats.staged_high_water;
+    }
+    return stats;
+}
+
+/**
+ * @brief Formats the counters as a text report.
+ */
+std::string ArchiveWriter::Report() const {
+    ArchiveStats s = stats();
+    char text[512];
+    snprintf(text, sizeof(text),
+             "archive %s: %llu frames, %llu bytes in %llu files, %llu writes, %llu syncs (longest %.1f ms)\n"
+             "dropped %llu frames (%llu bytes), staged %llu bytes, staging high water %llu bytes, "
+             "writer cpu %.3f s\n",
+             s.failed ? "failed" : "ok", static_cast<unsigned long long>(s.frames),
+             static_cast<unsigned long long>(s.bytes), static_cast<unsigned long long>(s.files),
+             static_cast<unsigned long long>(s.writes), static_cast<unsigned long long>(s.syncs),
+             s.max_sync_us / 1000.0, static_cast<unsigned long long>(s.dropped_frames),
+             static_cast<unsigned long long>(s.dropped_bytes), static_cast<unsigned long long>(s.staged_bytes),
+             static_cast<unsigned long long>(s.staged_high_water), s.writer_cpu_us / 1e6);
+    return text;
+}
+
+/**
+ * @brief The writer thread, draining the rings until the archive is closed.
+ */
+void ArchiveWriter::Run() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (!stop_) {
+        wake_.wait_for(lock, drain_interval);
+        lock.unlock();
+        Drain();
+        int64_t now = monotonic_us();
+        bool rotate = (options_.rotate_us > 0 && now - file_opened_us_ >= options_.rotate_us) ||
+                      (options_.rotate_bytes > 0 && file_bytes_ + batch_used_ >= options_.rotate_bytes);
+        if (rotate && fd_ >= 0) {
+            CloseFile();
+            OpenFile(now);
+            next_sync_us_ = now + options_.sync_interval_us;
+        } else if (now >= next_sync_us_) {
+            // without a durability interval the rest of the batch still goes out once a second
+            int64_t interval = options_.sync_interval_us > 0 ? options_.sync_interval_us : 1000000;
+            if (options_.sync_interval_us > 0) {
+                Sync();
+            } else {
+                WriteBatch();
+            }
+            next_sync_us_ = now + interval;
+        }
+        writer_cpu_us_.store(thread_cpu_us(), std::memory_order_relaxed);
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Moves every staged record of every producer into the batch.
+ */
+void ArchiveWriter::Drain() {
+    std::vector<Producer*> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& producer : producers_) {
+            pending.push_back(producer.get());
+        }
+    }
+    uint64_t frames = 0;
+    for (Producer* producer : pending) {
+        uint64_t tail = producer->tail_.load(std::memory_order_relaxed);
+        uint64_t head = producer->head_.load(std::memory_order_acquire);
+        size_t mask = producer->capacity_ - 1;
+        while (tail < head) {
+            const uint8_t* entry = producer->data_.get() + (tail & mask);
+            uint32_t entry_size;
+            memcpy(&entry_size, entry, 4);
+            if (entry_size == 0) {
+                tail += producer->capacity_ - (tail & mask);  // padding up to the end of the ring
+                continue;
+            }
+            uint16_t size;
+            memcpy(&size, entry + 17, 2);
+            Append(entry + entry_header_size, frame_header_size + size);
+            frames++;
+            tail += entry_size;
+        }
+        producer->tail_.store(tail, std::memory_order_release);
+    }
+    frames_.fetch_add(frames, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Appends bytes to the batch, writing each batch to the file as it fills.
+ */
+void ArchiveWriter::Append(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        size_t room = options_.batch_bytes - batch_used_;
+        size_t part = size < room ? size : room;
+        memcpy(batch_ + batch_used_, data, part);
+        batch_used_ += part;
+        data += part;
+        size -= part;
+        if (batch_used_ == options_.batch_bytes) {
+            WriteBatch();
+        }
+    }
+}
+
+/**
+ * @brief Writes the filled part of the batch to the file.
+ */
+void ArchiveWriter::WriteBatch() {
+    size_t done = 0;
+    while (fd_ >= 0 && done < batch_used_) {
+        ssize_t ret = write(fd_, batch_ + done, batch_used_ - done);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            // the frames staged from now on are discarded, the streams keep running
+            std::cerr << "Error: Could not write the archive: " << strerror(errno) << std::endl;
+            failed_ = true;
+            close(fd_);
+            fd_ = -1;
+            break;
+        }
+        done += static_cast<size_t>(ret);
+    }
+    if (done > 0) {
+        writes_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(done, std::memory_order_relaxed);
+        file_bytes_ += done;
+    }
+    batch_used_ = 0;
+}
+
+/**
+ * @brief Writes the rest of the batch and calls fdatasync.
+ */
+void ArchiveWriter::Sync() {
+    WriteBatch();
+    if (fd_ < 0) {
+        return;
+    }
+    int64_t start = monotonic_us();
+    fdatasync(fd_);
+    int64_t took = monotonic_us() - start;
+    syncs_.fetch_add(1, std::memory_order_relaxed);
+    if (took > max_sync_us_.load(std::memory_order_relaxed)) {
+        max_sync_us_.store(took, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Opens the next file and writes its header.
+ */
+bool ArchiveWriter::OpenFile(int64_t now_us) {
+    int64_t unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    time_t seconds = static_cast<time_t>(unix_ns / 1000000000);
+    tm utc;
+    gmtime_r(&seconds, &utc);
+    char name[64];
+    snprintf(name, sizeof(name), "-%04d%02d%02d-%02d%02d%02d-%u.arc", utc.tm_year + 1900, utc.tm_mon + 1,
+             utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, sequence_++);
+    std::string path = options_.prefix + name;
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    while (fd_ < 0 && errno == EEXIST) {
+        // e.g. written by the hub this one took over from, in the same second
+        snprintf(name, sizeof(name), "-%04d%02d%02d-%02d%02d%02d-%u.arc", utc.tm_year + 1900, utc.tm_mon + 1,
+                 utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, sequence_++);
+        path = options_.prefix + name;
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    }
+    if (fd_ < 0) {
+        std::cerr << "Error: Could not create the archive file " << path << ": " << strerror(errno) << std::endl;
+        failed_ = true;
+        return false;
+    }
+    files_.fetch_add(1, std::memory_order_relaxed);
+    file_bytes_ = 0;
+    file_opened_us_ = now_us;
+    Append(reinterpret_cast<const uint8_t*>(archive_magic), sizeof(archive_magic));
+    Append(reinterpret_cast<const uint8_t*>(&unix_ns), 8);
+    for (size_t id = 0; id < streams_.size(); id++) {
+        uint8_t kind = 'S';
+        uint32_t id32 = static_cast<uint32_t>(id);
+        uint16_t length = static_cast<uint16_t>(streams_[id].size() < 65535 ? streams_[id].size() : 65535);
+        Append(&kind, 1);
+        Append(reinterpret_cast<const uint8_t*>(&id32), 4);
+        Append(reinterpret_cast<const uint8_t*>(&length), 2);
+        Append(reinterpret_cast<const uint8_t*>(streams_[id].data()), length);
+    }
+    return true;
+}
+
+/**
+ * @brief Writes what is left, syncs and closes the current file.
+ */
+void ArchiveWriter::CloseFile() {
+    Sync();
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
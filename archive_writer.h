@@ -0,0 +1,220 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Records the frames of many streams into shared, rotated archive files.
+ *
+ * Each event loop thread appends frames to its own lock-free staging ring through a
+ * Producer; a full ring drops the frame and counts it rather than stalling the stream. One
+ * writer thread moves the staged frames of every producer into a page aligned batch, writes
+ * whole batches, and at every sync interval writes the rest and calls fdatasync once for all
+ * streams. Files rotate by age and size and are named prefix-YYYYMMDD-HHMMSS-N.arc (UTC).
+ *
+ * A file starts with archive_magic and the Unix time in nanoseconds at which it was opened,
+ * followed by records of one kind byte each:
+ * - 'S' stream: u32 id, u16 length and the stream name; every stream, at the start of each file.
+ * - 'F' frame: u32 stream id, i64 arrival time in Unix microseconds, u16 size and the frame.
+ */
+
+constexpr char archive_magic[8] = {'N', 'T', 'R', 'P', 'A', 'R', 'C', '1'};
+constexpr size_t archive_max_frame = 65535;
+
+/**
+ * @brief Settings of an archive writer.
+ */
+struct ArchiveOptions {
+    std::string prefix;  // path and file name prefix of the archive files
+    size_t batch_bytes = 1 << 20;  // size of one write, a multiple of the page size
+    size_t staging_bytes = 1 << 22;  // staging ring per producer
+    int64_t sync_interval_us = 1000000;  // durability interval; 0 leaves syncing to the kernel
+    int64_t rotate_us = 3600000000;  // start a new file after this long, 0 for never
+    uint64_t rotate_bytes = 1ULL << 30;  // or once the file has grown past this size, 0 for never
+};
+
+/**
+ * @brief Counters of an archive writer, see ArchiveWriter::stats().
+ */
+struct ArchiveStats {
+    uint64_t frames = 0;  // written to the files
+    uint64_t bytes = 0;  // written to the files, records included
+    uint64_t dropped_frames = 0;  // lost to full staging rings
+    uint64_t dropped_bytes = 0;
+    uint64_t writes = 0;
+    uint64_t syncs = 0;
+    uint64_t files = 0;
+    uint64_t staged_bytes = 0;  // waiting in the staging rings now
+    uint64_t staged_high_water = 0;  // most bytes ever waiting in one staging ring
+    int64_t max_sync_us = 0;  // longest fdatasync
+    int64_t writer_cpu_us = 0;  // CPU time of the writer thread
+    bool failed = false;  // a write failed; the archive stopped
+};
+
+class ArchiveWriter {
+public:
+
+    /**
+     * @brief The staging ring of one thread; Append() may only be called from that thread.
+     */
+    class Producer {
+    public:
+
+        /**
+         * @brief Stages one frame of a stream; drops and counts it if the ring is full.
+         *
+         * @param stream Stream id, as in the names given to Open().
+         * @param time_us Arrival time in Unix microseconds.
+         * @return true if the frame was staged.
+         */
+        bool Append(uint32_t stream, int64_t time_us, const uint8_t* frame, size_t size);
+
+    private:
+        friend class ArchiveWriter;
+
+        std::unique_ptr<uint8_t[]> data_;
+        size_t capacity_ = 0;  // power of two
+        std::atomic<uint64_t> head_{0};  // bytes staged, written by the producing thread
+        std::atomic<uint64_t> tail_{0};  // bytes taken, written by the writer thread
+        std::atomic<uint64_t> dropped_frames_{0};
+        std::atomic<uint64_t> dropped_bytes_{0};
+        std::atomic<uint64_t> high_water_{0};
+        uint64_t cached_tail_ = 0;  // producing thread only
+    };
+
+    ArchiveWriter() = default;
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    /**
+     * @brief Destructor for ArchiveWriter, closing the archive.
+     */
+    ~ArchiveWriter();
+
+    /**
+     * @brief Opens the first file and starts the writer thread.
+     *
+     * @param options Where and how to write.
+     * @param streams The name of every stream id, written at the start of each file.
+     * @return true if the first file could be created.
+     */
+    bool Open(const ArchiveOptions& options, const std::vector<std::string>& streams);
+
+    /**
+     * @brief Creates a staging ring for the calling thread, which should use it from now on.
+     *
+     * The ring is allocated and touched by the caller, so it lives on the caller's NUMA node.
+     * Producers stay valid until the writer is destroyed.
+     */
+    Producer* AddProducer();
+
+    /**
+     * @brief Writes everything staged, syncs and closes the file and stops the writer thread.
+     */
+    void Close();
+
+    /**
+     * @brief Returns a snapshot of the counters; may be called from any thread.
+     */
+    ArchiveStats stats() const;
+
+    /**
+     * @brief Formats the counters as a text report.
+     */
+    std::string Report() const;
+
+private:
+
+    /**
+     * @brief The writer thread, draining the rings until the archive is closed.
+     */
+    void Run();
+
+    /**
+     * @brief Moves every staged record of every producer into the batch.
+     */
+    void Drain();
+
+    /**
+     * @brief Appends bytes to the batch, writing each batch to the file as it fills.
+     */
+    void Append(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Writes the filled part of the batch to the file.
+     */
+    void WriteBatch();
+
+    /**
+     * @brief Writes the rest of the batch and calls fdatasync.
+     */
+    void Sync();
+
+    /**
+     * @brief Opens the next file and writes its header.
+     */
+    bool OpenFile(int64_t now_us);
+
+    /**
+     * @brief Writes what is left, syncs and closes the current file.
+     */
+    void CloseFile();
+
+    ArchiveOptions options_;
+    std::vector<std::string> streams_;
+    mutable std::mutex mutex_;  // guards producers_ and the open/close sequence
+    std::vector<std::unique_ptr<Producer>> producers_;
+    std::thread writer_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+
+    // writer thread only
+    int fd_ = -1;
+    unsigned sequence_ = 0;
+    uint8_t* batch_ = nullptr;  // page aligned, batch_bytes
+    size_t batch_used_ = 0;
+    uint64_t file_bytes_ = 0;
+    int64_t file_opened_us_ = 0;
+    int64_t next_sync_us_ = 0;
+
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> writes_{0};
+    std::atomic<uint64_t> syncs_{0};
+    std::atomic<uint64_t> files_{0};
+    std::atomic<int64_t> max_sync_us_{0};
+    std::atomic<int64_t> writer_cpu_us_{0};
+    std::atomic<bool> failed_{false};
+};
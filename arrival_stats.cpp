@@ -0,0 +1,242 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "arrival_stats.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+/**
+ * @brief Adds to a counter that only one thread writes, without a locked instruction.
+ */
+template <typename T>
+static void add_relaxed(std::atomic<T>& counter, T value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the bucket of a value.
+ */
+int LogHistogram::Bucket(uint64_t value) {
+    if (value < 4) {
+        return static_cast<int>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    int bucket = (exponent - 1) * 4 + static_cast<int>((value >> (exponent - 2)) & 3);
+    return std::min(bucket, kBuckets - 1);
+}
+
+/**
+ * @brief Returns the smallest value of a bucket.
+ */
+uint64_t LogHistogram::BucketLow(int bucket) {
+    if (bucket < 4) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int exponent = bucket / 4 + 1;
+    return static_cast<uint64_t>(4 + bucket % 4) << (exponent - 2);
+}
+
+/**
+ * @brief Adds one value. Only one thread may record.
+ */
+void LogHistogram::Record(uint64_t value) {
+    std::atomic<uint32_t>& bucket = counts_[Bucket(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    add_relaxed(count_, uint64_t(1));
+    add_relaxed(sum_, value);
+    if (value > max_.load(std::memory_order_relaxed)) {
+        max_.store(value, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Adds the values recorded by another histogram. Only the recording thread may merge.
+ */
+void LogHistogram::Merge(const LogHistogram& other) {
+    for (int i = 0; i < kBuckets; i++) {
+        add_relaxed(counts_[i], other.counts_[i].load(std::memory_order_relaxed));
+    }
+    add_relaxed(count_, other.count());
+    add_relaxed(sum_, other.sum_.load(std::memory_order_relaxed));
+    if (other.max() > max()) {
+        max_.store(other.max(), std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Returns an approximate percentile, p from 0 to 100; 0 if empty.
+ */
+uint64_t LogHistogram::Percentile(double p) const {
+    uint64_t total = 0;
+    uint32_t counts[kBuckets];
+    for (int i = 0; i < kBuckets; i++) {
+        counts[i] = counts_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // the middle of the bucket, but never beyond the largest value seen
+            uint64_t low = BucketLow(i);
+            uint64_t high = i + 1 < kBuckets ? BucketLow(i + 1) : low;
+            return std::min(low + (high - low) / 2, max());
+        }
+    }
+    return max();
+}
+
+double LogHistogram::mean() const {
+    uint64_t n = count();
+    return n > 0 ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+/**
+ * @brief Constructor for ArrivalStats.
+ *
+ * @param burst_gap_us Arrival gap that starts a new burst.
+ */
+ArrivalStats::ArrivalStats(int64_t burst_gap_us) :
+    burst_gap_us_(burst_gap_us) {
+}
+
+/**
+ * @brief Closes the current burst, recording its size and spread.
+ */
+void ArrivalStats::CloseBurst() {
+    if (burst_start_us_ < 0) {
+        return;
+    }
+    burst_bytes_hist_.Record(burst_bytes_);
+    burst_spread_us_.Record(static_cast<uint64_t>(last_arrival_us_ - burst_start_us_));
+    add_relaxed(bursts_, uint64_t(1));
+}
+
+/**
+ * @brief Records a frame. Only one thread may record.
+ *
+ * @param message_type The RTCM message number, 0 for frames without one.
+ * @param size The frame size in bytes.
+ * @param arrival_us The arrival time in microseconds; frames from one read share it.
+ */
+void ArrivalStats::OnFrame(int message_type, size_t size, int64_t arrival_us) {
+    if (burst_start_us_ < 0 || arrival_us - last_arrival_us_ > burst_gap_us_) {
+        CloseBurst();
+        if (burst_start_us_ >= 0) {
+            burst_interval_us_.Record(static_cast<uint64_t>(arrival_us - burst_start_us_));
+        }
+        burst_start_us_ = arrival_us;
+        burst_bytes_ = 0;
+    }
+    burst_bytes_ += size;
+    last_arrival_us_ = arrival_us;
+
+    // a short linear scan: a stream carries a handful of message types
+    int count = num_types_.load(std::memory_order_relaxed);
+    TypeStats* stats = &types_[kMaxTypes];
+    for (int i = 0; i < count; i++) {
+        if (types_[i].type.load(std::memory_order_relaxed) == message_type) {
+            stats = &types_[i];
+            break;
+        }
+    }
+    if (stats == &types_[kMaxTypes] && count < kMaxTypes) {
+        stats = &types_[count];
+        stats->type.store(message_type, std::memory_order_relaxed);
+        num_types_.store(count + 1, std::memory_order_release);
+    }
+
+    add_relaxed(stats->frames, uint64_t(1));
+    add_relaxed(stats->bytes, static_cast<uint64_t>(size));
+    if (stats->last_us >= 0) {
+        stats->interval_us.Record(static_cast<uint64_t>(arrival_us - stats->last_us));
+    }
+    stats->last_us = arrival_us;
+    stats->offset_us.Record(static_cast<uint64_t>(arrival_us - burst_start_us_));
+}
+
+/**
+ * @brief Formats the burst and per message type statistics as a text table.
+ */
+std::string ArrivalStats::Report() const {
+    std::string out;
+    char line[256];
+    snprintf(line, sizeof(line), "bursts %llu (split at gaps over %.1f ms)\n",
+             static_cast<unsigned long long>(bursts_.load(std::memory_order_relaxed)), burst_gap_us_ / 1e3);
+    out += line;
+    snprintf(line, sizeof(line), "%-16s %10s %10s %10s %10s %10s\n", "burst", "p50", "p90", "p99", "max", "mean");
+    out += line;
+    const struct {
+        const char* name;
+        const LogHistogram* histogram;
+        double scale;
+    } rows[] = {
+        {"bytes", &burst_bytes_hist_, 1.0},
+        {"spread_ms", &burst_spread_us_, 1e-3},
+        {"interval_ms", &burst_interval_us_, 1e-3},
+    };
+    for (const auto& row : rows) {
+        const LogHistogram& h = *row.histogram;
+        snprintf(line, sizeof(line), "%-16s %10.1f %10.1f %10.1f %10.1f %10.1f\n", row.name,
+                 h.Percentile(50) * row.scale, h.Percentile(90) * row.scale, h.Percentile(99) * row.scale,
+                 h.max() * row.scale, h.mean() * row.scale);
+        out += line;
+    }
+
+    snprintf(line, sizeof(line), "%-6s %8s %10s %9s %9s %9s %9s %9s %9s %9s\n", "type", "frames", "bytes",
+             "int_p50", "int_p99", "int_max", "int_mean", "off_p50", "off_p99", "off_max");
+    out += line;
+    int count = num_types_.load(std::memory_order_acquire);
+    for (int i = 0; i <= kMaxTypes; i++) {
+        if (i >= count && i < kMaxTypes) {
+            continue;
+        }
+        const TypeStats& t = types_[i];
+        uint64_t frames = t.frames.load(std::memory_order_relaxed);
+        if (frames == 0) {
+            continue;
+        }
+        char type[16];
+        if (i == kMaxTypes) {
+            snprintf(type, sizeof(type), "other");
+        } else {
+            snprintf(type, sizeof(type), "%d", t.type.load(std::memory_order_relaxed));
+        }
+        snprintf(line, sizeof(line), "%-6s %8llu %10llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", type,
+                 static_cast<unsigned long long>(frames),
+                 static_cast<unsigned long long>(t.bytes.load(std::memory_order_relaxed)),
+                 t.interval_us.Percentile(50) / 1e3, t.interval_us.Percentile(99) / 1e3, t.interval_us.max() / 1e3,
+                 t.interval_us.mean() / 1e3, t.offset_us.Percentile(50) / 1e3, t.offset_us.Percentile(99) / 1e3,
+                 t.offset_us.max() / 1e3);
+        out += line;
+    }
+    out += "intervals (int) and offsets from the burst start (off) in ms\n";
+    return out;
+}
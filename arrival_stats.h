@@ -0,0 +1,141 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+/**
+ * @brief Histogram of microsecond or byte values in fixed logarithmic buckets.
+ *
+ * Four buckets per power of two, about 19% wide, from 0 to 2^32 with larger values in the
+ * last bucket. Recording is O(1) and never allocates. The counts are relaxed atomics written
+ * by one thread, so another thread can read a report while the writer keeps recording.
+ */
+class LogHistogram {
+public:
+    static constexpr int kBuckets = 128;
+
+    /**
+     * @brief Adds one value. Only one thread may record.
+     */
+    void Record(uint64_t value);
+
+    /**
+     * @brief Adds the values recorded by another histogram. Only the recording thread may merge.
+     */
+    void Merge(const LogHistogram& other);
+
+    /**
+     * @brief Returns an approximate percentile, p from 0 to 100; 0 if empty.
+     */
+    uint64_t Percentile(double p) const;
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    /**
+     * @brief Returns the bucket of a value.
+     */
+    static int Bucket(uint64_t value);
+
+    /**
+     * @brief Returns the smallest value of a bucket.
+     */
+    static uint64_t BucketLow(int bucket);
+
+private:
+    std::atomic<uint32_t> counts_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * @brief Inter-arrival and burst structure of one stream's frames.
+ *
+ * Frames that arrive less than the burst gap apart form a burst, normally one epoch of
+ * corrections. Per burst it records the bytes, the spread from first to last arrival and the
+ * interval between burst starts. Per message type it records the interval between frames of
+ * the type and the frame's offset from the start of its burst: a caster that batches
+ * messages shows offsets near zero after long intervals, one that paces them shows offsets
+ * spread across the epoch. Everything is O(1) per frame with no allocation.
+ */
+class ArrivalStats {
+public:
+    static constexpr int kMaxTypes = 24;  // further message types share one "other" row
+
+    /**
+     * @brief Constructor for ArrivalStats.
+     *
+     * @param burst_gap_us Arrival gap that starts a new burst.
+     */
+    explicit ArrivalStats(int64_t burst_gap_us = 100000);
+
+    /**
+     * @brief Records a frame. Only one thread may record.
+     *
+     * @param message_type The RTCM message number, 0 for frames without one.
+     * @param size The frame size in bytes.
+     * @param arrival_us The arrival time in microseconds; frames from one read share it.
+     */
+    void OnFrame(int message_type, size_t size, int64_t arrival_us);
+
+    /**
+     * @brief Formats the burst and per message type statistics as a text table.
+     */
+    std::string Report() const;
+
+private:
+
+    /**
+     * @brief Closes the current burst, recording its size and spread.
+     */
+    void CloseBurst();
+
+    struct TypeStats {
+        std::atomic<int> type{-1};  // -1 while the row is unused
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> bytes{0};
+        int64_t last_us = -1;
+        LogHistogram interval_us;
+        LogHistogram offset_us;
+    };
+
+    int64_t burst_gap_us_;
+    TypeStats types_[kMaxTypes + 1];
+    std::atomic<int> num_types_{0};
+
+    int64_t burst_start_us_ = -1;
+    int64_t last_arrival_us_ = -1;
+    uint64_t burst_bytes_ = 0;
+    std::atomic<uint64_t> bursts_{0};
+    LogHistogram burst_bytes_hist_;
+    LogHistogram burst_spread_us_;
+    LogHistogram burst_interval_us_;
+};
@@ -2,5 +2,15 @@
 
 # Build the project
 echo "Building the project..."
-g++ main.cpp ntrip_client.cpp -o ntrip_client.o -lpthread
+g++ main.cpp nmea.cpp ntrip_client.cpp stream_checkpoint.cpp stream_framer.cpp rtcm2.cpp arrival_stats.cpp event_log.cpp tsc_clock.cpp transport.cpp base64.cpp rtcm3.cpp -o ntrip_client.o -lpthread
+g++ rtcm2rinex.cpp decode_pipeline.cpp ntrip_client.cpp stream_checkpoint.cpp stream_framer.cpp rtcm2.cpp arrival_stats.cpp event_log.cpp tsc_clock.cpp transport.cpp base64.cpp rtcm3.cpp rinex_converter.cpp -O2 -o rtcm2rinex.o -lpthread
+g++ rtcm_gen.cpp synthetic_network.cpp rtcm3_encoder.cpp ephemeris.cpp rtcm3.cpp -O2 -o rtcm_gen.o
+g++ ntrip_proxy.cpp -O2 -o ntrip_proxy.o
+g++ ntrip_sim.cpp ntrip_manager.cpp caster_admission.cpp stream_usage.cpp stream_health.cpp alloc_counter.cpp ntrip_client.cpp stream_checkpoint.cpp stream_framer.cpp rtcm2.cpp arrival_stats.cpp event_log.cpp tsc_clock.cpp transport.cpp base64.cpp sim_transport.cpp rtcm3.cpp -O2 -o ntrip_sim.o -lpthread
+g++ ntrip_hub.cpp archive_writer.cpp stream_rollup.cpp cluster_client.cpp shard_ring.cpp cpu_topology.cpp stream_handover.cpp ntrip_manager.cpp caster_admission.cpp stream_usage.cpp stream_health.cpp alloc_counter.cpp metrics_server.cpp nmea.cpp ntrip_client.cpp stream_checkpoint.cpp stream_framer.cpp rtcm2.cpp arrival_stats.cpp event_log.cpp tsc_clock.cpp transport.cpp base64.cpp rtcm3.cpp -O2 -o ntrip_hub.o -lpthread
+g++ ntrip_coord.cpp -O2 -o ntrip_coord.o
+g++ ntrip_diff.cpp stream_diff.cpp ntrip_manager.cpp caster_admission.cpp stream_usage.cpp stream_health.cpp alloc_counter.cpp nmea.cpp ntrip_client.cpp stream_checkpoint.cpp stream_framer.cpp rtcm2.cpp arrival_stats.cpp event_log.cpp tsc_clock.cpp transport.cpp base64.cpp rtcm3.cpp -O2 -o ntrip_diff.o -lpthread
+g++ ntrip_spp.cpp spp_engine.cpp ephemeris.cpp ntrip_manager.cpp caster_admission.cpp stream_usage.cpp stream_health.cpp alloc_counter.cpp ntrip_client.cpp stream_checkpoint.cpp stream_framer.cpp rtcm2.cpp arrival_stats.cpp event_log.cpp tsc_clock.cpp transport.cpp base64.cpp rtcm3.cpp -O2 -o ntrip_spp.o -lpthread
+g++ ntrip_logdump.cpp -O2 -o ntrip_logdump.o
+g++ ntrip_bench.cpp decode_pipeline.cpp ntrip_client.cpp stream_checkpoint.cpp transport.cpp stream_framer.cpp rtcm2.cpp arrival_stats.cpp event_log.cpp tsc_clock.cpp nmea.cpp base64.cpp rtcm3.cpp rtcm3_encoder.cpp synthetic_network.cpp spp_engine.cpp ephemeris.cpp -O2 -o ntrip_bench.o -lpthread
 echo "Build complete."
@@ -0,0 +1,85 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "caster_admission.h"
+
+#include <algorithm>
+
+constexpr double max_retry_spread_us = 1000000.0;  // the limit may grow meanwhile, so look again soon
+
+/**
+ * @brief Takes a handshake slot if one is free.
+ */
+bool CasterAdmission::TryAdmit(bool waiting) {
+    if (in_flight_ >= static_cast<int>(limit_)) {
+        if (!waiting) {
+            waiting_++;
+        }
+        return false;
+    }
+    if (waiting) {
+        waiting_--;
+    }
+    in_flight_++;
+    return true;
+}
+
+/**
+ * @brief Returns a slot taken by TryAdmit() and learns from how the handshake ended.
+ */
+bool CasterAdmission::Finish(int64_t now, Outcome outcome, int64_t handshake_us) {
+    in_flight_--;
+    switch (outcome) {
+        case Outcome::kAccepted:
+            handshake_us_ += (std::max<int64_t>(handshake_us, 1000) - handshake_us_) / 8;
+            // grow only while streams queue for the limit, so it tracks the caster and not the demand
+            if (waiting_ > 0) {
+                limit_ += limit_ < threshold_ ? 1.0 : 1.0 / limit_;
+                limit_ = std::min<double>(limit_, kMaxLimit);
+            }
+            return false;
+        case Outcome::kOverloaded:
+            overloads_++;
+            if (now < hold_until_) {
+                return false;
+            }
+            threshold_ = std::max(limit_ / 2, 1.0);
+            limit_ = threshold_;
+            hold_until_ = now + handshake_us_;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Returns how long a stream that was not admitted waits before it asks again.
+ *
+ * Half a handshake time plus a uniform share of the time the queue takes to drain at the
+ * current limit, which offers the caster about as many handshakes as the limit lets through.
+ */
+int64_t CasterAdmission::RetryDelay(uint64_t random) const {
+    double drain_us = static_cast<double>(handshake_us_) * std::max(waiting_, 1) / std::max(limit_, 1.0);
+    double share = static_cast<double>(random % 1000000) / 1000000.0;
+    return handshake_us_ / 2 + static_cast<int64_t>(share * std::min(drain_us, max_retry_spread_us));
+}
@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Admission control for the connection handshakes to one caster.
+ *
+ * Limits the handshakes in flight the way TCP limits its congestion window: the limit grows
+ * by one per accepted handshake until the first overload (slow start), then by one per
+ * limit's worth of accepted handshakes, and halves on an overload: a 429 or 5xx answer or a
+ * timed out handshake. Only one halving happens per handshake time, since a single overload
+ * fails every handshake that was in flight. The limit is thereby a learned estimate of what
+ * the caster accepts, and it is kept while the streams are up.
+ *
+ * Streams that find no free slot wait for a random part of the expected time to work off
+ * the queue, so a caster restart is followed by a steady trickle of handshakes instead of
+ * every stream retrying at once.
+ */
+class CasterAdmission {
+public:
+    enum class Outcome : uint8_t {
+        kAccepted,  // the caster started streaming
+        kOverloaded,  // rejected with 429 or 5xx, or timed out
+        kAborted,  // failed for another reason, such as a refused connection; says nothing about capacity
+    };
+
+    static constexpr int kInitialLimit = 8;
+    static constexpr int kMaxLimit = 1024;
+
+    /**
+     * @brief Takes a handshake slot if one is free.
+     *
+     * @param waiting Whether the stream was already waiting, so it leaves the queue when admitted.
+     * @return true if the handshake may start; false queues the stream.
+     */
+    bool TryAdmit(bool waiting);
+
+    /**
+     * @brief Returns a slot taken by TryAdmit() and learns from how the handshake ended.
+     *
+     * @param now The clock time in microseconds.
+     * @param handshake_us How long the handshake took since it was admitted.
+     * @return true if the outcome lowered the limit.
+     */
+    bool Finish(int64_t now, Outcome outcome, int64_t handshake_us);
+
+    /**
+     * @brief Removes a waiting stream that gave up, e.g. because it was stopped.
+     */
+    void Withdraw() { waiting_ = waiting_ > 0 ? waiting_ - 1 : 0; }
+
+    /**
+     * @brief Returns how long a stream that was not admitted waits before it asks again.
+     *
+     * @param random A uniformly distributed value that spreads the retries.
+     */
+    int64_t RetryDelay(uint64_t random) const;
+
+    int limit() const { return static_cast<int>(limit_); }
+    int in_flight() const { return in_flight_; }
+    int waiting() const { return waiting_; }
+    int64_t handshake_us() const { return handshake_us_; }
+    uint64_t overloads() const { return overloads_; }
+
+private:
+    double limit_ = kInitialLimit;
+    double threshold_ = kMaxLimit;  // slow start below, additive increase above
+    int in_flight_ = 0;
+    int waiting_ = 0;
+    int64_t handshake_us_ = 100000;  // moving average of accepted handshakes
+    int64_t hold_until_ = 0;  // no further halving before this time
+    uint64_t overloads_ = 0;
+};
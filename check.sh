@@ -0,0 +1,54 @@
+#!/usr/bin/bash
+
+# Stress checks that need more than one thread or process; run after build.sh
+set -e
+
+echo "Building ntrip_bench with ThreadSanitizer..."
+g++ ntrip_bench.cpp decode_pipeline.cpp ntrip_client.cpp stream_checkpoint.cpp transport.cpp stream_framer.cpp rtcm2.cpp arrival_stats.cpp event_log.cpp tsc_clock.cpp nmea.cpp base64.cpp rtcm3.cpp rtcm3_encoder.cpp synthetic_network.cpp spp_engine.cpp ephemeris.cpp -O1 -g -fsanitize=thread -Wno-tsan -o ntrip_bench_tsan.o -lpthread
+
+echo "Checking the decode pipeline order..."
+TSAN_OPTIONS=halt_on_error=1 ./ntrip_bench_tsan.o -s
+echo "Checking a hub upgrade under load..."
+# 50 stations at 10 Hz plus ALL; a second hub takes the streams over mid-stream and must count
+# every byte the mock caster served, with no CRC error and no reconnect
+work=$(mktemp -d)
+caster_port=12101
+metrics_port=12102
+for i in $(seq 0 49); do
+    printf "127.0.0.1 %d STA%04d\n" $caster_port $i
+done > $work/streams
+echo "127.0.0.1 $caster_port ALL" >> $work/streams
+./rtcm_gen.o -l $caster_port -s 50 -r 10 > $work/caster.txt &
+caster=$!
+sleep 1
+./ntrip_hub.o -s $work/streams -U $work/upgrade -m $metrics_port -q -r 0 > $work/old_hub.txt &
+old_hub=$!
+sleep 5
+./ntrip_hub.o -s $work/streams -U $work/upgrade -m $metrics_port -q -r 0 > $work/new_hub.txt &
+new_hub=$!
+wait $old_hub
+sleep 5
+curl -s localhost:$metrics_port/health > $work/streaming.json
+kill -INT $caster
+wait $caster
+sleep 1
+curl -s localhost:$metrics_port/health > $work/stopped.json
+kill -INT $new_hub
+wait $new_hub
+
+sum() {
+    grep -o "\"$1\":[0-9]*" $2 | awk -F: '{ total += $2 } END { print total + 0 }'
+}
+served=$(sed -n 's/^Served .* frames (\([0-9]*\) bytes).*/\1/p' $work/caster.txt)
+received=$(sum bytes_received $work/stopped.json)
+crc_errors=$(sum crc_errors $work/stopped.json)
+reconnects=$(sum reconnects $work/streaming.json)
+taken=$(sed -n 's/^Took over \([0-9]*\) streams.*/\1/p' $work/new_hub.txt)
+echo "handover: ${taken:-0} streams taken over, $served bytes served, $received received," \
+     "$crc_errors CRC errors, $reconnects reconnects"
+rm -rf $work
+if [ "${taken:-0}" != 51 ] || [ "$served" != "$received" ] || [ "$crc_errors" != 0 ] || [ "$reconnects" != 0 ]; then
+    echo "Check failed."
+    exit 1
+fi
+echo "Checks passed."
@@ -0,0 +1,74 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "tsc_clock.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Monotonic time source in microseconds.
+ *
+ * Client timing (handshake timeouts, GGA cadence, reconnect backoff) is computed from the
+ * injected clock, so a simulation can substitute virtual time for the system clock.
+ */
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    /**
+     * @brief Returns the current monotonic time in microseconds.
+     */
+    virtual int64_t Now() = 0;
+};
+
+/**
+ * @brief Clock backed by CLOCK_MONOTONIC, read through the calibrated TscClock.
+ */
+class SystemClock : public Clock {
+public:
+    int64_t Now() override {
+        return TscClock::Get().MonotonicNs() / 1000;
+    }
+};
+
+/**
+ * @brief Clock that only moves when told to, for deterministic simulation.
+ */
+class VirtualClock : public Clock {
+public:
+    int64_t Now() override { return now_; }
+
+    /**
+     * @brief Moves the clock forward to a time; earlier times are ignored.
+     */
+    void AdvanceTo(int64_t time) {
+        if (time > now_) {
+            now_ = time;
+        }
+    }
+
+private:
+    int64_t now_ = 0;
+};
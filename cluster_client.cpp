@@ -0,0 +1,243 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "cluster_client.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <sstream>
+
+constexpr int64_t heartbeat_us = 1000000;  // well within the coordinator's timeout
+constexpr int64_t retry_us = 1000000;
+constexpr size_t max_line = 1 << 16;
+
+/**
+ * @brief Destructor for ClusterClient, closing the connection.
+ */
+ClusterClient::~ClusterClient() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+/**
+ * @brief Sets the coordinator and the name of this node; the next Poll() connects.
+ */
+void ClusterClient::Init(const std::string& host, const std::string& port, const std::string& name) {
+    host_ = host;
+    port_ = port;
+    name_ = name;
+}
+
+/**
+ * @brief Starts a non-blocking connect to the coordinator.
+ */
+void ClusterClient::Connect(int64_t now) {
+    addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host_.c_str(), port_.c_str(), &hints, &res) != 0) {
+        std::cerr << "Error: Could not resolve the coordinator " << host_ << std::endl;
+        retry_at_ = now + retry_us;
+        return;
+    }
+    fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int ret = fd_ < 0 ? -1 : connect(fd_, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if (ret < 0 && errno != EINPROGRESS) {
+        Close(now);
+        return;
+    }
+    state_ = State::kConnecting;
+    in_.clear();
+    out_ = "HELLO " + name_ + "\n" + out_;
+    next_ping_ = now + heartbeat_us;
+}
+
+/**
+ * @brief Closes the connection and schedules the next attempt.
+ */
+void ClusterClient::Close(int64_t now) {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    if (state_ == State::kConnected) {
+        std::cerr << "Error: Lost the coordinator " << host_ << ":" << port_
+                  << ", keeping the last member list" << std::endl;
+    } else if (!warned_) {
+        std::cerr << "Error: Could not reach the coordinator " << host_ << ":" << port_ << std::endl;
+    }
+    warned_ = true;
+    // the HELLO goes out again first on the next connection
+    if (out_.compare(0, 6, "HELLO ") == 0) {
+        out_.erase(0, out_.find('\n') + 1);
+    }
+    state_ = State::kClosed;
+    retry_at_ = now + retry_us;
+}
+
+/**
+ * @brief Connects if needed, sends the heartbeat and queued lines and reads what arrived.
+ *
+ * @return true if a new member list arrived.
+ */
+bool ClusterClient::Poll(int64_t now) {
+    if (state_ == State::kClosed) {
+        if (now < retry_at_ || host_.empty() || leaving_) {
+            return false;
+        }
+        Connect(now);
+        if (state_ == State::kClosed) {
+            return false;
+        }
+    }
+    if (state_ == State::kConnected && now >= next_ping_) {
+        out_ += "PING\n";
+        next_ping_ = now + heartbeat_us;
+    }
+
+    struct pollfd fd = {fd_, static_cast<short>(POLLIN | (out_.empty() ? 0 : POLLOUT)), 0};
+    if (poll(&fd, 1, 0) <= 0) {
+        return false;
+    }
+    if (state_ == State::kConnecting) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+            Close(now);
+            return false;
+        }
+        state_ = State::kConnected;
+        warned_ = false;
+    }
+    if (!out_.empty() && (fd.revents & POLLOUT)) {
+        ssize_t ret = send(fd_, out_.data(), out_.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            Close(now);
+            return false;
+        }
+        out_.erase(0, ret > 0 ? ret : 0);
+    }
+
+    bool changed = false;
+    if (fd.revents & (POLLIN | POLLHUP | POLLERR)) {
+        char buf[4096];
+        ssize_t ret = recv(fd_, buf, sizeof(buf), MSG_DONTWAIT);
+        if (ret == 0 || (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            Close(now);
+            return false;
+        }
+        if (ret > 0) {
+            in_.append(buf, ret);
+        }
+        size_t end;
+        while (fd_ >= 0 && (end = in_.find('\n')) != std::string::npos) {
+            std::string line = in_.substr(0, end);
+            in_.erase(0, end + 1);
+            changed = HandleLine(line, now) || changed;
+        }
+        if (in_.size() > max_line) {
+            Close(now);
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Continues on the coordinator connection of a hub that handed over to this one.
+ */
+void ClusterClient::Adopt(int fd, int64_t now) {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    fd_ = fd;
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    state_ = State::kConnected;
+    in_.clear();
+    out_ = "SYNC\n" + out_;
+    next_ping_ = now;
+}
+
+/**
+ * @brief Leaves the member list but keeps exchanging announcements while the streams move.
+ */
+void ClusterClient::Leave() {
+    out_ += "LEAVE\n";
+    leaving_ = true;
+}
+
+/**
+ * @brief Handles one line from the coordinator.
+ *
+ * @return true if it was a new member list.
+ */
+bool ClusterClient::HandleLine(const std::string& line, int64_t now) {
+    std::istringstream fields(line);
+    std::string kind;
+    fields >> kind;
+    if (kind == "MEMBERS") {
+        uint64_t epoch = 0;
+        fields >> epoch;
+        std::vector<std::string> members;
+        std::string name;
+        while (fields >> name) {
+            members.push_back(name);
+        }
+        epoch_ = epoch;
+        members_.swap(members);
+        return true;
+    } else if (kind == "UP") {
+        std::string node, key;
+        if (fields >> node >> key) {
+            announced_.push_back(key);
+        }
+    } else if (kind == "ERROR") {
+        std::cerr << "Error: The coordinator refused " << name_ << ": " << line.substr(6) << std::endl;
+        Close(now);
+    }
+    return false;
+}
+
+/**
+ * @brief Tells the other nodes that this one streams a key; kept while disconnected.
+ */
+void ClusterClient::Announce(const std::string& key) {
+    out_ += "UP " + key + "\n";
+}
+
+/**
+ * @brief Moves the keys other nodes announced since the last call into keys.
+ */
+void ClusterClient::TakeAnnounced(std::vector<std::string>* keys) {
+    keys->clear();
+    keys->swap(announced_);
+}
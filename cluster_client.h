@@ -0,0 +1,128 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief A hub's connection to the ntrip_coord cluster coordinator.
+ *
+ * Non-blocking and driven by Poll() from one thread. Lines go out as "HELLO name",
+ * "PING", "UP key", "LEAVE" and "SYNC"; the coordinator sends "MEMBERS epoch name..."
+ * when the member list changes and "UP name key" when another node announced a stream.
+ * A lost connection is reopened every retry interval and the last member list stays in
+ * effect meanwhile.
+ */
+class ClusterClient {
+public:
+
+    ClusterClient() = default;
+    ClusterClient(const ClusterClient&) = delete;
+    ClusterClient& operator=(const ClusterClient&) = delete;
+
+    /**
+     * @brief Destructor for ClusterClient, closing the connection.
+     */
+    ~ClusterClient();
+
+    /**
+     * @brief Sets the coordinator and the name of this node; the next Poll() connects.
+     */
+    void Init(const std::string& host, const std::string& port, const std::string& name);
+
+    /**
+     * @brief Connects if needed, sends the heartbeat and queued lines and reads what arrived.
+     *
+     * @param now Clock time in microseconds.
+     * @return true if a new member list arrived.
+     */
+    bool Poll(int64_t now);
+
+    /**
+     * @brief Continues on the coordinator connection of a hub that handed over to this one.
+     *
+     * The coordinator still knows the connection by the old hub's name, so it must be this
+     * node's name too. The member list is asked for again.
+     */
+    void Adopt(int fd, int64_t now);
+
+    /**
+     * @brief Leaves the member list but keeps exchanging announcements while the streams move.
+     */
+    void Leave();
+
+    /**
+     * @brief Tells the other nodes that this one streams a key; kept while disconnected.
+     */
+    void Announce(const std::string& key);
+
+    /**
+     * @brief Moves the keys other nodes announced since the last call into keys.
+     */
+    void TakeAnnounced(std::vector<std::string>* keys);
+
+    const std::vector<std::string>& members() const { return members_; }  // sorted
+    uint64_t epoch() const { return epoch_; }  // of the member list, 0 before the first one
+    const std::string& name() const { return name_; }
+    bool connected() const { return state_ == State::kConnected; }
+    int fd() const { return fd_; }  // the coordinator connection, -1 if none
+
+private:
+    enum class State { kClosed, kConnecting, kConnected };
+
+    /**
+     * @brief Starts a non-blocking connect to the coordinator.
+     */
+    void Connect(int64_t now);
+
+    /**
+     * @brief Closes the connection and schedules the next attempt.
+     */
+    void Close(int64_t now);
+
+    /**
+     * @brief Handles one line from the coordinator.
+     *
+     * @return true if it was a new member list.
+     */
+    bool HandleLine(const std::string& line, int64_t now);
+
+    std::string host_;
+    std::string port_;
+    std::string name_;
+    int fd_ = -1;
+    State state_ = State::kClosed;
+    int64_t retry_at_ = 0;
+    int64_t next_ping_ = 0;
+    bool warned_ = false;  // about the coordinator being unreachable, once per outage
+    bool leaving_ = false;  // no reconnect, which would join again
+    std::string in_;
+    std::string out_;  // sent once connected, after the HELLO
+    std::vector<std::string> members_;
+    uint64_t epoch_ = 0;
+    std::vector<std::string> announced_;
+};
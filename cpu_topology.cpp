@@ -0,0 +1,151 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "cpu_topology.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/**
+ * @brief Parses a kernel CPU list such as "0-3,8,10-11".
+ *
+ * @return false if the list is malformed.
+ */
+bool parse_cpu_list(const std::string& list, std::vector<int>* cpus) {
+    cpus->clear();
+    std::istringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        int first = 0;
+        int last = 0;
+        char dash = 0;
+        int fields = sscanf(range.c_str(), "%d%c%d", &first, &dash, &last);
+        if (fields == 1) {
+            last = first;
+        } else if (fields != 3 || dash != '-' || last < first) {
+            return false;
+        }
+        if (first < 0) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus->push_back(cpu);
+        }
+    }
+    std::sort(cpus->begin(), cpus->end());
+    cpus->erase(std::unique(cpus->begin(), cpus->end()), cpus->end());
+    return !cpus->empty();
+}
+
+/**
+ * @brief Reads the NUMA layout from sysfs, restricted to the CPUs in the affinity mask.
+ */
+CpuTopology load_cpu_topology() {
+    CpuTopology topology;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &mask)) {
+                topology.cpus.push_back(cpu);
+            }
+        }
+    }
+    if (topology.cpus.empty()) {
+        topology.cpus.push_back(0);
+    }
+    topology.node_of_cpu.assign(topology.cpus.back() + 1, 0);
+
+    int nodes = 0;
+    for (int node = 0; node < 1024; node++) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file) {
+            // node numbers may have holes on some machines, give up after a few
+            if (node > nodes + 8) {
+                break;
+            }
+            continue;
+        }
+        std::string list;
+        std::getline(file, list);
+        std::vector<int> cpus;
+        if (!parse_cpu_list(list, &cpus)) {
+            continue;
+        }
+        for (int cpu : cpus) {
+            if (static_cast<size_t>(cpu) < topology.node_of_cpu.size()) {
+                topology.node_of_cpu[cpu] = node;
+            }
+        }
+        nodes = node + 1;
+    }
+    topology.num_nodes = std::max(nodes, 1);
+    return topology;
+}
+
+/**
+ * @brief Picks a CPU for each of a number of workers, alternating between NUMA nodes.
+ */
+std::vector<int> place_workers(const CpuTopology& topology, const std::vector<int>& allowed, int workers) {
+    std::vector<std::vector<int>> by_node(topology.num_nodes);
+    for (int cpu : topology.cpus) {
+        if (allowed.empty() || std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+            by_node[topology.Node(cpu)].push_back(cpu);
+        }
+    }
+    by_node.erase(std::remove_if(by_node.begin(), by_node.end(),
+                                 [](const std::vector<int>& cpus) { return cpus.empty(); }), by_node.end());
+    std::vector<int> placement;
+    if (by_node.empty()) {
+        return placement;
+    }
+    std::vector<size_t> next(by_node.size(), 0);
+    for (int i = 0; i < workers; i++) {
+        size_t node = static_cast<size_t>(i) % by_node.size();
+        placement.push_back(by_node[node][next[node]++ % by_node[node].size()]);
+    }
+    return placement;
+}
+
+/**
+ * @brief Pins the calling thread to one CPU.
+ *
+ * @return false if the affinity could not be set.
+ */
+bool pin_current_thread(int cpu) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) != 0) {
+        std::cerr << "Error: Could not pin thread to CPU " << cpu << std::endl;
+        return false;
+    }
+    return true;
+}
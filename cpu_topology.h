@@ -0,0 +1,80 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief The CPUs this process may run on and the NUMA node of each.
+ */
+struct CpuTopology {
+    std::vector<int> cpus;  // usable CPUs in ascending order
+    std::vector<int> node_of_cpu;  // NUMA node indexed by CPU number
+    int num_nodes = 1;
+
+    /**
+     * @brief Returns the NUMA node of a CPU, 0 if unknown.
+     */
+    int Node(int cpu) const {
+        return cpu >= 0 && static_cast<size_t>(cpu) < node_of_cpu.size() ? node_of_cpu[cpu] : 0;
+    }
+};
+
+/**
+ * @brief Parses a kernel CPU list such as "0-3,8,10-11".
+ *
+ * @return false if the list is malformed.
+ */
+bool parse_cpu_list(const std::string& list, std::vector<int>* cpus);
+
+/**
+ * @brief Reads the NUMA layout from sysfs, restricted to the CPUs in the affinity mask.
+ *
+ * Without /sys/devices/system/node every CPU is placed on node 0.
+ */
+CpuTopology load_cpu_topology();
+
+/**
+ * @brief Picks a CPU for each of a number of workers, alternating between NUMA nodes.
+ *
+ * Worker i goes to node i % num_nodes, on that node's next unused CPU, so workers spread
+ * over the sockets before they share cores.
+ *
+ * @param topology The usable CPUs.
+ * @param allowed Further restricts the CPUs, empty for all usable ones.
+ * @param workers The number of workers.
+ * @return One CPU per worker; CPUs are reused if there are more workers than CPUs.
+ */
+std::vector<int> place_workers(const CpuTopology& topology, const std::vector<int>& allowed, int workers);
+
+/**
+ * @brief Pins the calling thread to one CPU.
+ *
+ * Memory the thread touches first is then allocated on that CPU's node by the kernel's
+ * default first-touch policy.
+ *
+ * @return false if the affinity could not be set.
+ */
+bool pin_current_thread(int cpu);
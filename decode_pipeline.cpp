@@ -0,0 +1,362 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "decode_pipeline.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+
+constexpr size_t entry_header_size = 24;  // entry size (0 for padding to the end), stream, sequence, frame size
+constexpr auto idle_wait = std::chrono::milliseconds(100);  // sleep bound, should a wake-up ever be missed
+constexpr auto drain_poll = std::chrono::microseconds(100);
+constexpr int full_yields = 64;  // a producer facing a full ring yields this often before it sleeps
+constexpr auto full_sleep_min = std::chrono::microseconds(10);
+constexpr auto full_sleep_max = std::chrono::milliseconds(1);  // doubling up to this
+
+/**
+ * @brief Returns the CPU time of the calling thread in microseconds.
+ */
+static int64_t thread_cpu_us() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Stages a frame for the stream's worker, waiting while the worker's ring is full.
+ *
+ * The wait yields a few times, then sleeps with a backoff of up to 1 ms, so a slow worker
+ * does not keep the submitting thread spinning.
+ *
+ * @return false if the stream id is out of range, the frame does not fit a ring or the pipeline
+ *         is stopping.
+ */
+bool DecodePipeline::Producer::Submit(uint32_t stream, const uint8_t* frame, size_t size) {
+    const size_t capacity = pipeline_->capacity_;
+    size_t entry = (entry_header_size + size + 7) & ~static_cast<size_t>(7);
+    if (stream >= pipeline_max_streams) {
+        return false;
+    }
+    if (entry > capacity / 2 || pipeline_->stop_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    int worker = pipeline_->WorkerOf(stream);
+    Ring& ring = rings_[worker];
+    uint64_t head = ring.staged;
+    size_t offset = head & (capacity - 1);
+    // an entry never wraps; the rest of the ring is skipped instead
+    size_t pad = offset + entry > capacity ? capacity - offset : 0;
+    int waits = 0;
+    auto sleep = full_sleep_min;
+    while (head + pad + entry - ring.cached_tail > capacity) {
+        ring.cached_tail = ring.tail.load(std::memory_order_acquire);
+        if (head + pad + entry - ring.cached_tail <= capacity) {
+            break;
+        }
+        // full: hand over what is staged and wait for the worker to make room
+        if (ring.head.load(std::memory_order_relaxed) != head) {
+            Publish(worker);
+        }
+        if (waits++ == 0) {
+            stalls_.store(stalls_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        if (pipeline_->stop_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        // a slow worker must not cost the receive thread a whole CPU: yield briefly, then back off
+        if (waits <= full_yields) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(sleep);
+            sleep = std::min<std::chrono::microseconds>(sleep * 2, full_sleep_max);
+        }
+    }
+    if (pad > 0) {
+        memset(ring.data.get() + offset, 0, 4);
+        head += pad;
+    }
+    if (stream >= sequences_.size()) {
+        sequences_.resize(stream + 1, 0);
+    }
+    uint8_t* out = ring.data.get() + (head & (capacity - 1));
+    uint32_t entry32 = static_cast<uint32_t>(entry);
+    uint64_t sequence = sequences_[stream]++;
+    uint64_t size64 = size;
+    memcpy(out, &entry32, 4);
+    memcpy(out + 4, &stream, 4);
+    memcpy(out + 8, &sequence, 8);
+    memcpy(out + 16, &size64, 8);
+    memcpy(out + entry_header_size, frame, size);
+    ring.staged = head + entry;
+    submitted_.store(submitted_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (ring.staged - ring.head.load(std::memory_order_relaxed) >= pipeline_->batch_bytes_) {
+        Publish(worker);
+    }
+    return true;
+}
+
+/**
+ * @brief Hands every staged frame over to the workers.
+ */
+void DecodePipeline::Producer::Flush() {
+    for (int worker = 0; worker < pipeline_->num_workers(); worker++) {
+        if (rings_[worker].staged != rings_[worker].head.load(std::memory_order_relaxed)) {
+            Publish(worker);
+        }
+    }
+}
+
+/**
+ * @brief Publishes a ring's staged frames and wakes its worker.
+ */
+void DecodePipeline::Producer::Publish(int worker) {
+    rings_[worker].head.store(rings_[worker].staged, std::memory_order_release);
+    handoffs_.store(handoffs_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    pipeline_->Wake(worker);
+}
+
+/**
+ * @brief Constructor for DecodePipeline, starting the workers.
+ *
+ * @param num_workers The number of worker threads, at least 1.
+ * @param handler Called for every frame on the stream's worker.
+ * @param ring_bytes The ring size per producer and worker, rounded up to a power of two.
+ * @param batch_bytes The staged bytes handed over at once.
+ */
+DecodePipeline::DecodePipeline(int num_workers, Handler handler, size_t ring_bytes, size_t batch_bytes) :
+    handler_(std::move(handler)),
+    capacity_(4096),
+    batch_bytes_(batch_bytes > 0 ? batch_bytes : 1) {
+    while (capacity_ < ring_bytes) {
+        capacity_ <<= 1;
+    }
+    if (batch_bytes_ > capacity_ / 2) {
+        batch_bytes_ = capacity_ / 2;
+    }
+    for (int i = 0; i < (num_workers > 0 ? num_workers : 1); i++) {
+        workers_.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < workers_.size(); i++) {
+        workers_[i]->thread = std::thread(&DecodePipeline::Run, this, static_cast<int>(i));
+    }
+}
+
+/**
+ * @brief Destructor for DecodePipeline, handling what was flushed and stopping the workers.
+ */
+DecodePipeline::~DecodePipeline() {
+    Stop();
+}
+
+/**
+ * @brief Creates the rings of the calling thread, which should submit through them from now on.
+ *
+ * @return nullptr if pipeline_max_producers producers exist.
+ */
+DecodePipeline::Producer* DecodePipeline::AddProducer() {
+    std::lock_guard<std::mutex> lock(producers_mutex_);
+    int index = num_producers_.load(std::memory_order_relaxed);
+    if (index >= pipeline_max_producers) {
+        return nullptr;
+    }
+    Producer* producer = new Producer();
+    producer->pipeline_ = this;
+    producer->rings_.reset(new Producer::Ring[num_workers()]);
+    for (int worker = 0; worker < num_workers(); worker++) {
+        // touched here so the pages live on the producing thread's NUMA node
+        producer->rings_[worker].data.reset(new uint8_t[capacity_]);
+        memset(producer->rings_[worker].data.get(), 0, capacity_);
+    }
+    producers_[index].reset(producer);
+    num_producers_.store(index + 1, std::memory_order_release);
+    return producer;
+}
+
+/**
+ * @brief Waits until every frame flushed so far has been handled.
+ */
+void DecodePipeline::Drain() {
+    int producers = num_producers_.load(std::memory_order_acquire);
+    for (int p = 0; p < producers; p++) {
+        for (int worker = 0; worker < num_workers(); worker++) {
+            const Producer::Ring& ring = producers_[p]->rings_[worker];
+            uint64_t head = ring.head.load(std::memory_order_acquire);
+            while (ring.tail.load(std::memory_order_acquire) < head && workers_[worker]->thread.joinable()) {
+                std::this_thread::sleep_for(drain_poll);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Handles every flushed frame and stops the workers; later submissions fail.
+ */
+void DecodePipeline::Stop() {
+    stop_.store(true);
+    for (int worker = 0; worker < num_workers(); worker++) {
+        Wake(worker);
+        if (workers_[worker]->thread.joinable()) {
+            workers_[worker]->thread.join();
+        }
+    }
+}
+
+/**
+ * @brief Wakes a worker if it sleeps.
+ */
+void DecodePipeline::Wake(int worker) {
+    Worker& w = *workers_[worker];
+    // pairs with the fence in Run(): either the worker sees the new head or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (w.sleeping.load(std::memory_order_relaxed) || stop_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.wakeups.store(w.wakeups.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        w.wake.notify_one();
+    }
+}
+
+/**
+ * @brief The worker thread, handling batches until the pipeline stops.
+ */
+void DecodePipeline::Run(int worker) {
+    Worker& w = *workers_[worker];
+    while (true) {
+        if (Poll(worker)) {
+            w.cpu_us.store(thread_cpu_us(), std::memory_order_relaxed);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(w.mutex);
+        w.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool stopping = stop_.load(std::memory_order_relaxed);
+        // check again now that producers will see this worker sleeping
+        bool pending = false;
+        int producers = num_producers_.load(std::memory_order_acquire);
+        for (int p = 0; p < producers && !pending; p++) {
+            const Producer::Ring& ring = producers_[p]->rings_[worker];
+            pending = ring.head.load(std::memory_order_acquire) != ring.tail.load(std::memory_order_relaxed);
+        }
+        if (!pending && stopping) {
+            w.sleeping.store(false, std::memory_order_relaxed);
+            break;
+        }
+        if (!pending) {
+            w.wake.wait_for(lock, idle_wait);
+        }
+        w.sleeping.store(false, std::memory_order_relaxed);
+    }
+    w.cpu_us.store(thread_cpu_us(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Handles everything published to a worker.
+ *
+ * @return true if there was anything.
+ */
+bool DecodePipeline::Poll(int worker) {
+    Worker& w = *workers_[worker];
+    const size_t mask = capacity_ - 1;
+    uint64_t frames = 0;
+    uint64_t batches = 0;
+    int producers = num_producers_.load(std::memory_order_acquire);
+    for (int p = 0; p < producers; p++) {
+        Producer::Ring& ring = producers_[p]->rings_[worker];
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        if (tail == head) {
+            continue;
+        }
+        batches++;
+        PipelineFrame frame;
+        while (tail < head) {
+            const uint8_t* entry = ring.data.get() + (tail & mask);
+            uint32_t entry_size;
+            memcpy(&entry_size, entry, 4);
+            if (entry_size == 0) {
+                tail += capacity_ - (tail & mask);  // padding up to the end of the ring
+                continue;
+            }
+            uint64_t size64;
+            memcpy(&frame.stream, entry + 4, 4);
+            memcpy(&frame.sequence, entry + 8, 8);
+            memcpy(&size64, entry + 16, 8);
+            frame.data = entry + entry_header_size;
+            frame.size = static_cast<size_t>(size64);
+            handler_(worker, frame);
+            frames++;
+            tail += entry_size;
+        }
+        // the whole batch is released at once, after its frames were handled in place
+        ring.tail.store(tail, std::memory_order_release);
+    }
+    if (batches > 0) {
+        w.frames.store(w.frames.load(std::memory_order_relaxed) + frames, std::memory_order_relaxed);
+        w.batches.store(w.batches.load(std::memory_order_relaxed) + batches, std::memory_order_relaxed);
+    }
+    return batches > 0;
+}
+
+/**
+ * @brief Returns a snapshot of the counters; may be called from any thread.
+ */
+PipelineStats DecodePipeline::stats() const {
+    PipelineStats stats;
+    int producers = num_producers_.load(std::memory_order_acquire);
+    for (int p = 0; p < producers; p++) {
+        stats.submitted += producers_[p]->submitted_.load(std::memory_order_relaxed);
+        stats.handoffs += producers_[p]->handoffs_.load(std::memory_order_relaxed);
+        stats.stalls += producers_[p]->stalls_.load(std::memory_order_relaxed);
+    }
+    for (const auto& worker : workers_) {
+        stats.wakeups += worker->wakeups.load(std::memory_order_relaxed);
+        stats.worker_frames.push_back(worker->frames.load(std::memory_order_relaxed));
+        stats.worker_batches.push_back(worker->batches.load(std::memory_order_relaxed));
+        stats.worker_cpu_us.push_back(worker->cpu_us.load(std::memory_order_relaxed));
+    }
+    return stats;
+}
+
+/**
+ * @brief Formats the counters as a text report, with each worker's share of the frames.
+ */
+std::string DecodePipeline::Report() const {
+    PipelineStats s = stats();
+    char line[256];
+    snprintf(line, sizeof(line), "pipeline: %d workers, %llu frames submitted in %llu handoffs, %llu stalls, "
+             "%llu wakeups\n", num_workers(), static_cast<unsigned long long>(s.submitted),
+             static_cast<unsigned long long>(s.handoffs), static_cast<unsigned long long>(s.stalls),
+             static_cast<unsigned long long>(s.wakeups));
+    std::string out = line;
+    for (int worker = 0; worker < num_workers(); worker++) {
+        snprintf(line, sizeof(line), "  worker %2d: %10llu frames (%5.1f%%) in %8llu batches, cpu %.3f s\n", worker,
+                 static_cast<unsigned long long>(s.worker_frames[worker]),
+                 s.submitted > 0 ? 100.0 * s.worker_frames[worker] / s.submitted : 0.0,
+                 static_cast<unsigned long long>(s.worker_batches[worker]), s.worker_cpu_us[worker] / 1e6);
+        out += line;
+    }
+    return out;
+}
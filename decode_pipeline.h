@@ -0,0 +1,238 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int pipeline_max_producers = 64;
+constexpr uint32_t pipeline_max_streams = 1 << 16;  // stream ids are below this, see Producer::Submit()
+constexpr size_t pipeline_ring_bytes = 1 << 22;  // per producer and worker
+constexpr size_t pipeline_batch_bytes = 1 << 14;  // staged bytes a producer hands over at once
+
+/**
+ * @brief A frame as a decode worker sees it.
+ */
+struct PipelineFrame {
+    uint32_t stream = 0;
+    uint64_t sequence = 0;  // per stream from 0, in submission order
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * @brief Counters of a decode pipeline, see DecodePipeline::stats().
+ */
+struct PipelineStats {
+    uint64_t submitted = 0;  // frames staged by the producers
+    uint64_t handoffs = 0;  // batches published to a worker
+    uint64_t stalls = 0;  // times a producer found a ring full and waited
+    uint64_t wakeups = 0;  // times a sleeping worker was woken
+    std::vector<uint64_t> worker_frames;  // frames handled, per worker
+    std::vector<uint64_t> worker_batches;  // batches taken, per worker
+    std::vector<int64_t> worker_cpu_us;  // CPU time, per worker
+};
+
+/**
+ * @brief Moves frame decoding off the network threads onto a pool of workers.
+ *
+ * Every stream belongs to one worker (stream id modulo the number of workers), so a stream's
+ * frames are handled strictly in submission order, one at a time, while different streams are
+ * decoded in parallel; per-stream decoder state such as a RinexConverter stream needs no lock.
+ * Each network thread submits through its own Producer, which has a lock-free
+ * single-producer ring per worker. Frames are staged in the ring and handed over in batches:
+ * the ring's head is published, and a sleeping worker woken, only once pipeline_batch_bytes
+ * are staged or at Flush(), which the submitting thread calls once per socket read or file chunk,
+ * e.g. from an NtripClient batch callback after submitting the batch's frames. A worker handles
+ * a whole batch straight from the ring memory and then releases it. A full ring makes the
+ * producer wait rather than drop, so a slow decoder pushes back on the socket it reads from.
+ * A stream must always be submitted by the same producer.
+ */
+class DecodePipeline {
+public:
+
+    /**
+     * @brief Called on a worker thread for each frame, in order within a stream.
+     *
+     * @param worker The worker index, for per-worker state.
+     * @param frame The frame, valid until the call returns.
+     */
+    using Handler = std::function<void(int worker, const PipelineFrame& frame)>;
+
+    /**
+     * @brief The rings of one submitting thread; its methods may only be called from that thread.
+     */
+    class Producer {
+    public:
+
+        /**
+         * @brief Stages a frame for the stream's worker, waiting while the worker's ring is full.
+         *
+         * The wait yields a few times, then sleeps with a backoff of up to 1 ms, so a slow worker
+         * does not keep the submitting thread spinning.
+         *
+         * Each producer keeps a sequence number per stream id, so ids are dense from 0 and must be
+         * below pipeline_max_streams.
+         *
+         * @return false if the stream id is out of range, the frame does not fit a ring or the
+         *         pipeline is stopping; the frame is then dropped.
+         */
+        bool Submit(uint32_t stream, const uint8_t* frame, size_t size);
+
+        /**
+         * @brief Hands every staged frame over to the workers.
+         */
+        void Flush();
+
+    private:
+        friend class DecodePipeline;
+
+        /**
+         * @brief A single-producer single-consumer ring from this producer to one worker.
+         */
+        struct Ring {
+            std::unique_ptr<uint8_t[]> data;
+            alignas(64) std::atomic<uint64_t> head{0};  // bytes published, written by the producer
+            alignas(64) std::atomic<uint64_t> tail{0};  // bytes handled, written by the worker
+            alignas(64) uint64_t staged = 0;  // bytes written, producer only
+            uint64_t cached_tail = 0;  // producer only
+        };
+
+        /**
+         * @brief Publishes a ring's staged frames and wakes its worker.
+         */
+        void Publish(int worker);
+
+        DecodePipeline* pipeline_ = nullptr;
+        std::unique_ptr<Ring[]> rings_;
+        std::vector<uint64_t> sequences_;  // next sequence number per stream
+        std::atomic<uint64_t> submitted_{0};
+        std::atomic<uint64_t> handoffs_{0};
+        std::atomic<uint64_t> stalls_{0};
+    };
+
+    /**
+     * @brief Constructor for DecodePipeline, starting the workers.
+     *
+     * @param num_workers The number of worker threads, at least 1.
+     * @param handler Called for every frame on the stream's worker.
+     * @param ring_bytes The ring size per producer and worker, rounded up to a power of two.
+     * @param batch_bytes The staged bytes handed over at once.
+     */
+    DecodePipeline(int num_workers, Handler handler, size_t ring_bytes = pipeline_ring_bytes,
+                   size_t batch_bytes = pipeline_batch_bytes);
+
+    DecodePipeline(const DecodePipeline&) = delete;
+    DecodePipeline& operator=(const DecodePipeline&) = delete;
+
+    /**
+     * @brief Destructor for DecodePipeline, handling what was flushed and stopping the workers.
+     */
+    ~DecodePipeline();
+
+    /**
+     * @brief Creates the rings of the calling thread, which should submit through them from now on.
+     *
+     * @return nullptr if pipeline_max_producers producers exist.
+     */
+    Producer* AddProducer();
+
+    /**
+     * @brief Waits until every frame flushed so far has been handled.
+     */
+    void Drain();
+
+    /**
+     * @brief Handles every flushed frame and stops the workers; later submissions fail.
+     */
+    void Stop();
+
+    /**
+     * @brief Returns the worker that handles a stream.
+     */
+    int WorkerOf(uint32_t stream) const { return static_cast<int>(stream % workers_.size()); }
+
+    int num_workers() const { return static_cast<int>(workers_.size()); }
+
+    /**
+     * @brief Returns a snapshot of the counters; may be called from any thread.
+     */
+    PipelineStats stats() const;
+
+    /**
+     * @brief Formats the counters as a text report, with each worker's share of the frames.
+     */
+    std::string Report() const;
+
+private:
+
+    /**
+     * @brief A worker thread and what it needs to sleep and be woken.
+     */
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::atomic<bool> sleeping{false};
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> wakeups{0};
+        std::atomic<int64_t> cpu_us{0};
+    };
+
+    /**
+     * @brief Wakes a worker if it sleeps.
+     */
+    void Wake(int worker);
+
+    /**
+     * @brief The worker thread, handling batches until the pipeline stops.
+     */
+    void Run(int worker);
+
+    /**
+     * @brief Handles everything published to a worker.
+     *
+     * @return true if there was anything.
+     */
+    bool Poll(int worker);
+
+    Handler handler_;
+    size_t capacity_;  // ring bytes, power of two
+    size_t batch_bytes_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::unique_ptr<Producer> producers_[pipeline_max_producers];
+    std::atomic<int> num_producers_{0};
+    std::mutex producers_mutex_;  // serializes AddProducer()
+    std::atomic<bool> stop_{false};
+};
@@ -0,0 +1,142 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ephemeris.h"
+
+#include <math.h>
+
+constexpr double gm_gps = 3.986005e14;  // m^3/s^2, IS-GPS-200
+constexpr double gm_gal = 3.986004418e14;  // m^3/s^2, Galileo ICD and BDS ICD
+constexpr double omega_bds = 7.292115e-5;  // rad/s, CGCS2000
+constexpr double half_week = 302400.0;
+
+/**
+ * @brief Computes the ECEF satellite position and clock bias from a Keplerian broadcast ephemeris.
+ *
+ * @param eph The ephemeris.
+ * @param t Time of week in the constellation's time scale (GPST, GST or BDT), in seconds.
+ * @param pos Receives the ECEF position in meters.
+ * @param clock_bias Receives the satellite clock bias in seconds, including the relativistic term.
+ */
+void ephemeris_position(const Rtcm3Ephemeris& eph, double t, double pos[3], double* clock_bias) {
+    double gm = gm_gps;
+    double omega_e = earth_rotation_rate;
+    if (eph.system == GnssSystem::kGalileo) {
+        gm = gm_gal;
+    } else if (eph.system == GnssSystem::kBeidou) {
+        gm = gm_gal;
+        omega_e = omega_bds;
+    }
+
+    double tk = t - eph.toe;
+    if (tk > half_week) tk -= 2 * half_week;
+    if (tk < -half_week) tk += 2 * half_week;
+
+    double a = eph.sqrt_a * eph.sqrt_a;
+    double n = sqrt(gm / (a * a * a)) + eph.delta_n;
+    double m = eph.m0 + n * tk;
+    double e_anomaly = m;
+    for (int i = 0; i < 10; i++) {
+        double next = m + eph.e * sin(e_anomaly);
+        if (fabs(next - e_anomaly) < 1e-13) {
+            e_anomaly = next;
+            break;
+        }
+        e_anomaly = next;
+    }
+    double sin_e = sin(e_anomaly);
+    double cos_e = cos(e_anomaly);
+    double nu = atan2(sqrt(1.0 - eph.e * eph.e) * sin_e, cos_e - eph.e);
+    double phi = nu + eph.omega;
+    double sin_2phi = sin(2.0 * phi);
+    double cos_2phi = cos(2.0 * phi);
+    double u = phi + eph.cus * sin_2phi + eph.cuc * cos_2phi;
+    double r = a * (1.0 - eph.e * cos_e) + eph.crs * sin_2phi + eph.crc * cos_2phi;
+    double i = eph.i0 + eph.idot * tk + eph.cis * sin_2phi + eph.cic * cos_2phi;
+    double x = r * cos(u);
+    double y = r * sin(u);
+    double cos_i = cos(i);
+
+    bool bds_geo = eph.system == GnssSystem::kBeidou && (eph.prn <= 5 || eph.prn >= 59);
+    if (bds_geo) {
+        // GEO orbits are given in an inertial frame tilted by -5 degrees
+        double omega = eph.omega0 + eph.omega_dot * tk - omega_e * eph.toe;
+        double sin_o = sin(omega);
+        double cos_o = cos(omega);
+        double xg = x * cos_o - y * cos_i * sin_o;
+        double yg = x * sin_o + y * cos_i * cos_o;
+        double zg = y * sin(i);
+        double sin_5 = sin(-5.0 * gnss_pi / 180.0);
+        double cos_5 = cos(-5.0 * gnss_pi / 180.0);
+        double sin_r = sin(omega_e * tk);
+        double cos_r = cos(omega_e * tk);
+        pos[0] = xg * cos_r + yg * sin_r * cos_5 + zg * sin_r * sin_5;
+        pos[1] = -xg * sin_r + yg * cos_r * cos_5 + zg * cos_r * sin_5;
+        pos[2] = -yg * sin_5 + zg * cos_5;
+    } else {
+        double omega = eph.omega0 + (eph.omega_dot - omega_e) * tk - omega_e * eph.toe;
+        double sin_o = sin(omega);
+        double cos_o = cos(omega);
+        pos[0] = x * cos_o - y * cos_i * sin_o;
+        pos[1] = x * sin_o + y * cos_i * cos_o;
+        pos[2] = y * sin(i);
+    }
+
+    double dt = t - eph.toc;
+    if (dt > half_week) dt -= 2 * half_week;
+    if (dt < -half_week) dt += 2 * half_week;
+    double relativistic = -2.0 * sqrt(gm * a) * eph.e * sin_e / (speed_of_light * speed_of_light);
+    *clock_bias = eph.af0 + eph.af1 * dt + eph.af2 * dt * dt + relativistic;
+}
+
+/**
+ * @brief Converts geodetic latitude/longitude (radians) and height (m) to WGS84 ECEF.
+ */
+void geodetic_to_ecef(double lat, double lon, double height, double ecef[3]) {
+    double e2 = wgs84_f * (2.0 - wgs84_f);
+    double sin_lat = sin(lat);
+    double n = wgs84_a / sqrt(1.0 - e2 * sin_lat * sin_lat);
+    ecef[0] = (n + height) * cos(lat) * cos(lon);
+    ecef[1] = (n + height) * cos(lat) * sin(lon);
+    ecef[2] = (n * (1.0 - e2) + height) * sin_lat;
+}
+
+/**
+ * @brief Converts WGS84 ECEF to geodetic latitude/longitude (radians) and height (m).
+ */
+void ecef_to_geodetic(const double ecef[3], double* lat, double* lon, double* height) {
+    double e2 = wgs84_f * (2.0 - wgs84_f);
+    double p = sqrt(ecef[0] * ecef[0] + ecef[1] * ecef[1]);
+    double z = ecef[2];
+    double latitude = atan2(z, p * (1.0 - e2));
+    double n = wgs84_a;
+    for (int i = 0; i < 5; i++) {
+        double sin_lat = sin(latitude);
+        n = wgs84_a / sqrt(1.0 - e2 * sin_lat * sin_lat);
+        latitude = atan2(z + e2 * n * sin_lat, p);
+    }
+    *lat = latitude;
+    *lon = atan2(ecef[1], ecef[0]);
+    double cos_lat = cos(latitude);
+    *height = fabs(cos_lat) > 1e-9 ? p / cos_lat - n : fabs(z) - n * (1.0 - e2);
+}
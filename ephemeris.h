@@ -0,0 +1,50 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "rtcm3.h"
+
+constexpr double earth_rotation_rate = 7.2921151467e-5;  // rad/s, WGS84
+constexpr double wgs84_a = 6378137.0;
+constexpr double wgs84_f = 1.0 / 298.257223563;
+
+/**
+ * @brief Computes the ECEF satellite position and clock bias from a Keplerian broadcast ephemeris.
+ *
+ * @param eph The ephemeris.
+ * @param t Time of week in the constellation's time scale (GPST, GST or BDT), in seconds.
+ * @param pos Receives the ECEF position in meters.
+ * @param clock_bias Receives the satellite clock bias in seconds, including the relativistic term.
+ */
+void ephemeris_position(const Rtcm3Ephemeris& eph, double t, double pos[3], double* clock_bias);
+
+/**
+ * @brief Converts geodetic latitude/longitude (radians) and height (m) to WGS84 ECEF.
+ */
+void geodetic_to_ecef(double lat, double lon, double height, double ecef[3]);
+
+/**
+ * @brief Converts WGS84 ECEF to geodetic latitude/longitude (radians) and height (m).
+ */
+void ecef_to_geodetic(const double ecef[3], double* lat, double* lon, double* height);
@@ -0,0 +1,338 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "event_log.h"
+
+#include <stdio.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+constexpr auto drain_interval = std::chrono::milliseconds(10);
+
+namespace {
+
+/**
+ * @brief Ring buffer of events written by one thread and drained by the writer thread.
+ *
+ * Buffers live until the process exits so that a thread racing with event_log_close() never
+ * writes into freed memory; a reopened log reuses them.
+ */
+struct ThreadBuffer {
+    std::unique_ptr<uint8_t[]> data;
+    size_t capacity = 0;  // power of two
+    uint32_t index = 0;
+    std::atomic<uint64_t> head{0};  // bytes committed, written by the owning thread
+    std::atomic<uint64_t> tail{0};  // bytes drained, written by the writer thread
+    std::atomic<uint64_t> dropped{0};
+    uint64_t cached_tail = 0;  // owning thread only
+    uint64_t reserved_end = 0;  // owning thread only
+    uint64_t reported_drops = 0;  // writer thread only
+};
+
+struct Site {
+    LogSite* site;
+    std::string types;
+};
+
+std::mutex mutex;  // guards sites, buffers and the open/close sequence, never held by a log call
+std::vector<Site> sites;  // index id - 1
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+size_t buffer_size = 1 << 20;
+
+FILE* file = nullptr;
+std::thread writer;
+std::mutex writer_mutex;
+std::condition_variable writer_wake;
+bool writer_stop = false;
+size_t sites_written = 0;  // writer thread only
+
+thread_local ThreadBuffer* thread_buffer = nullptr;
+
+/**
+ * @brief Closes a log the program left open, before the writer thread object is destroyed.
+ */
+struct CloseAtExit {
+    ~CloseAtExit();
+} close_at_exit;
+
+/**
+ * @brief Writes a u16 length prefixed string to the file.
+ */
+void write_string(const char* value) {
+    uint16_t length = static_cast<uint16_t>(strlen(value));
+    fwrite(&length, 2, 1, file);
+    fwrite(value, 1, length, file);
+}
+
+/**
+ * @brief Writes the definitions of the sites registered since the last call.
+ */
+void write_sites() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (; sites_written < sites.size(); sites_written++) {
+        const Site& site = sites[sites_written];
+        uint8_t kind = 'F';
+        uint32_t id = static_cast<uint32_t>(sites_written + 1);
+        uint8_t level = static_cast<uint8_t>(site.site->level);
+        uint32_t line = static_cast<uint32_t>(site.site->line);
+        fwrite(&kind, 1, 1, file);
+        fwrite(&id, 4, 1, file);
+        fwrite(&level, 1, 1, file);
+        fwrite(&line, 4, 1, file);
+        write_string(site.site->file);
+        write_string(site.site->format);
+        write_string(site.types.c_str());
+    }
+}
+
+/**
+ * @brief Appends a value to the output staging buffer.
+ */
+template <typename T>
+void append(std::vector<uint8_t>* out, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out->insert(out->end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * @brief Moves every committed event from the thread buffers to the file.
+ */
+void drain() {
+    static std::vector<uint8_t> out;  // staging for one write per buffer, used by one drainer at a time
+    std::vector<ThreadBuffer*> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& buffer : buffers) {
+            pending.push_back(buffer.get());
+        }
+    }
+    for (ThreadBuffer* buffer : pending) {
+        uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        size_t mask = buffer->capacity - 1;
+        out.clear();
+        while (tail < head) {
+            const uint8_t* event = buffer->data.get() + (tail & mask);
+            uint16_t size;
+            memcpy(&size, event, 2);
+            if (size == 0) {
+                tail += buffer->capacity - (tail & mask);  // padding up to the end of the ring
+                continue;
+            }
+            uint32_t id;
+            memcpy(&id, event + 4, 4);
+            if (id > sites_written) {
+                fwrite(out.data(), 1, out.size(), file);
+                out.clear();
+                write_sites();
+            }
+            out.push_back('E');
+            append(&out, buffer->index);
+            out.insert(out.end(), event, event + size);
+            tail += size;
+        }
+        fwrite(out.data(), 1, out.size(), file);
+        buffer->tail.store(tail, std::memory_order_release);
+
+        uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped != buffer->reported_drops) {
+            uint8_t kind = 'D';
+            uint64_t count = dropped - buffer->reported_drops;
+            fwrite(&kind, 1, 1, file);
+            fwrite(&buffer->index, 4, 1, file);
+            fwrite(&count, 8, 1, file);
+            buffer->reported_drops = dropped;
+        }
+    }
+    fflush(file);
+}
+
+/**
+ * @brief The writer thread, draining the buffers until the log is closed.
+ */
+void writer_thread() {
+    std::unique_lock<std::mutex> lock(writer_mutex);
+    while (!writer_stop) {
+        writer_wake.wait_for(lock, drain_interval);
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Creates and registers the calling thread's buffer.
+ */
+ThreadBuffer* create_thread_buffer() {
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    buffer->data.reset(new uint8_t[buffer_size]);
+    memset(buffer->data.get(), 0, buffer_size);  // fault the pages in now rather than while logging
+    buffer->capacity = buffer_size;
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer->index = static_cast<uint32_t>(buffers.size());
+    buffers.push_back(std::move(buffer));
+    return buffers.back().get();
+}
+
+CloseAtExit::~CloseAtExit() {
+    event_log_close();
+}
+
+}  // namespace
+
+namespace event_log_detail {
+
+std::atomic<bool> enabled{false};
+
+/**
+ * @brief Assigns an id to a site on its first use and queues its definition for the file.
+ */
+uint32_t register_site(LogSite* site, const char* types) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t id = site->id.load(std::memory_order_relaxed);
+    if (id == 0) {
+        sites.push_back(Site{site, types});
+        id = static_cast<uint32_t>(sites.size());
+        site->id.store(id, std::memory_order_release);
+    }
+    return id;
+}
+
+/**
+ * @brief Reserves space for one event in the calling thread's buffer.
+ *
+ * @return The space, nullptr if the buffer is full and the event was counted as dropped.
+ */
+uint8_t* reserve(size_t size) {
+    ThreadBuffer* buffer = thread_buffer;
+    if (buffer == nullptr) {
+        buffer = thread_buffer = create_thread_buffer();
+    }
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    size_t offset = head & (buffer->capacity - 1);
+    // an event never wraps; the rest of the ring is skipped instead
+    size_t pad = offset + size > buffer->capacity ? buffer->capacity - offset : 0;
+    if (head + pad + size - buffer->cached_tail > buffer->capacity) {
+        buffer->cached_tail = buffer->tail.load(std::memory_order_acquire);
+        if (head + pad + size - buffer->cached_tail > buffer->capacity) {
+            buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+    if (pad > 0) {
+        memset(buffer->data.get() + offset, 0, 2);
+        head += pad;
+    }
+    buffer->reserved_end = head + size;
+    return buffer->data.get() + (head & (buffer->capacity - 1));
+}
+
+/**
+ * @brief Publishes the event written into the last reserved space.
+ */
+void commit() {
+    thread_buffer->head.store(thread_buffer->reserved_end, std::memory_order_release);
+}
+
+}  // namespace event_log_detail
+
+/**
+ * @brief Opens the log file and starts the background writer; events before this are discarded.
+ *
+ * @param path The file to write, truncated.
+ * @param buffer_size The ring buffer size per thread in bytes, rounded up to a power of two.
+ * @return true if the file could be opened.
+ */
+bool event_log_open(const std::string& path, size_t size) {
+    event_log_close();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (buffers.empty()) {
+        buffer_size = event_log_max_event * 2;
+        while (buffer_size < size) {
+            buffer_size <<= 1;
+        }
+    }
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Error: Could not open event log " << path << std::endl;
+        return false;
+    }
+    double rate = cycles_per_second();
+    uint64_t start_cycles = read_cycles();
+    int64_t start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    fwrite(event_log_magic, 1, sizeof(event_log_magic), file);
+    fwrite(&rate, 8, 1, file);
+    fwrite(&start_cycles, 8, 1, file);
+    fwrite(&start_ns, 8, 1, file);
+    sites_written = 0;
+
+    // events left over from an earlier session are skipped
+    for (const auto& buffer : buffers) {
+        buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+        buffer->reported_drops = buffer->dropped.load(std::memory_order_relaxed);
+    }
+    writer_stop = false;
+    writer = std::thread(writer_thread);
+    event_log_detail::enabled = true;
+    return true;
+}
+
+/**
+ * @brief Drains every buffer, stops the background writer and closes the file.
+ */
+void event_log_close() {
+    event_log_detail::enabled = false;
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            writer_stop = true;
+        }
+        writer_wake.notify_one();
+        writer.join();
+        drain();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+/**
+ * @brief Returns the number of events dropped because a thread buffer was full.
+ */
+uint64_t event_log_dropped() {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : buffers) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
@@ -0,0 +1,264 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "tsc_clock.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief Binary structured event log.
+ *
+ * A log statement stores its format string once, in a static LogSite, and writes only the
+ * site id, a cycle counter timestamp and its raw arguments into a lock-free ring buffer owned
+ * by the calling thread. A background thread drains every buffer into the log file, and the
+ * ntrip_logdump tool formats the file offline. A full buffer drops the event and counts it
+ * instead of blocking the caller.
+ *
+ * The file starts with event_log_magic, the cycle rate, the start cycle count and the start
+ * time in Unix nanoseconds, followed by records of one kind byte each:
+ * - 'F' site definition: u32 id, u8 level, u32 line, then file, format and argument types
+ *   as u16 length prefixed strings.
+ * - 'E' event: u32 thread, then the event as written to the ring buffer: u16 size, u16 zero,
+ *   u32 site id, u64 cycles and the arguments, 8-byte aligned.
+ * - 'D' drops: u32 thread, u64 events dropped since the last drop record.
+ *
+ * Arguments are 8 bytes for the types 'i' (int64), 'u' (uint64) and 'd' (double), and a u16
+ * length followed by the bytes for 's' (string, at most event_log_max_string bytes).
+ */
+
+enum class LogLevel : uint8_t { kDebug, kInfo, kWarning, kError };
+
+constexpr char event_log_magic[8] = {'N', 'T', 'R', 'P', 'L', 'O', 'G', '1'};
+constexpr size_t event_log_header_size = 16;  // size, padding, site id, cycles
+constexpr size_t event_log_max_string = 1024;
+constexpr size_t event_log_max_event = 4096;
+
+/**
+ * @brief A log statement: its static description and, once registered, its id.
+ */
+struct LogSite {
+    LogLevel level;
+    const char* file;
+    int line;
+    const char* format;
+    std::atomic<uint32_t> id{0};
+};
+
+/**
+ * @brief Opens the log file and starts the background writer; events before this are discarded.
+ *
+ * @param path The file to write, truncated.
+ * @param buffer_size The ring buffer size per thread in bytes, rounded up to a power of two.
+ * @return true if the file could be opened.
+ */
+bool event_log_open(const std::string& path, size_t buffer_size = 1 << 20);
+
+/**
+ * @brief Drains every buffer, stops the background writer and closes the file.
+ */
+void event_log_close();
+
+/**
+ * @brief Returns the number of events dropped because a thread buffer was full.
+ */
+uint64_t event_log_dropped();
+
+namespace event_log_detail {
+
+extern std::atomic<bool> enabled;
+
+/**
+ * @brief Assigns an id to a site on its first use and queues its definition for the file.
+ */
+uint32_t register_site(LogSite* site, const char* types);
+
+/**
+ * @brief Reserves space for one event in the calling thread's buffer.
+ *
+ * @return The space, nullptr if the buffer is full and the event was counted as dropped.
+ */
+uint8_t* reserve(size_t size);
+
+/**
+ * @brief Publishes the event written into the last reserved space.
+ */
+void commit();
+
+template <typename T>
+struct ArgType {
+    static constexpr char value = std::is_floating_point<T>::value ? 'd'
+                                  : std::is_signed<T>::value       ? 'i'
+                                                                   : 'u';
+};
+template <>
+struct ArgType<const char*> {
+    static constexpr char value = 's';
+};
+template <>
+struct ArgType<char*> {
+    static constexpr char value = 's';
+};
+template <>
+struct ArgType<std::string> {
+    static constexpr char value = 's';
+};
+
+/**
+ * @brief The argument type string of a log statement, e.g. "isd".
+ */
+template <typename... Args>
+struct ArgTypes {
+    static constexpr char value[sizeof...(Args) + 1] = {ArgType<std::decay_t<Args>>::value..., '\0'};
+};
+
+inline size_t string_size(size_t length) {
+    return 2 + (length < event_log_max_string ? length : event_log_max_string);
+}
+
+template <typename T>
+inline size_t arg_size(const T&) {
+    return 8;
+}
+inline size_t arg_size(const char* value) {
+    return string_size(strlen(value));
+}
+inline size_t arg_size(const std::string& value) {
+    return string_size(value.size());
+}
+template <size_t N>
+inline size_t arg_size(const char (&value)[N]) {
+    return string_size(strlen(value));
+}
+
+inline uint8_t* put_string(uint8_t* out, const char* value, size_t length) {
+    uint16_t size = static_cast<uint16_t>(length < event_log_max_string ? length : event_log_max_string);
+    memcpy(out, &size, 2);
+    // short strings are the common case; word copies avoid the startup cost of rep movs
+    uint8_t* p = out + 2;
+    size_t n = size;
+    for (; n >= 8; n -= 8, p += 8, value += 8) {
+        uint64_t word;
+        memcpy(&word, value, 8);
+        memcpy(p, &word, 8);
+    }
+    for (; n > 0; n--) {
+        *p++ = static_cast<uint8_t>(*value++);
+    }
+    return p;
+}
+
+template <typename T>
+inline uint8_t* put_arg(uint8_t* out, const T& value) {
+    if constexpr (std::is_floating_point<T>::value) {
+        double v = static_cast<double>(value);
+        memcpy(out, &v, 8);
+    } else if constexpr (std::is_signed<T>::value) {
+        int64_t v = static_cast<int64_t>(value);
+        memcpy(out, &v, 8);
+    } else {
+        uint64_t v = static_cast<uint64_t>(value);
+        memcpy(out, &v, 8);
+    }
+    return out + 8;
+}
+inline uint8_t* put_arg(uint8_t* out, const char* value) {
+    return put_string(out, value, strlen(value));
+}
+inline uint8_t* put_arg(uint8_t* out, const std::string& value) {
+    return put_string(out, value.data(), value.size());
+}
+template <size_t N>
+inline uint8_t* put_arg(uint8_t* out, const char (&value)[N]) {
+    return put_string(out, value, strlen(value));
+}
+
+/**
+ * @brief Writes the arguments of an event one after the other.
+ */
+inline void put_args(uint8_t*) {}
+template <typename T, typename... Rest>
+inline void put_args(uint8_t* out, const T& value, const Rest&... rest) {
+    put_args(put_arg(out, value), rest...);
+}
+
+}  // namespace event_log_detail
+
+/**
+ * @brief Writes one event: the site id, a timestamp and the raw arguments.
+ */
+template <typename... Args>
+void event_log_write(LogSite* site, const Args&... args) {
+    using namespace event_log_detail;
+    uint32_t id = site->id.load(std::memory_order_acquire);
+    if (id == 0) {
+        id = register_site(site, ArgTypes<Args...>::value);
+    }
+    size_t size = event_log_header_size;
+    ((size += arg_size(args)), ...);
+    size = (size + 7) & ~static_cast<size_t>(7);
+    if (size > event_log_max_event) {
+        return;
+    }
+    uint8_t* out = reserve(size);
+    if (out == nullptr) {
+        return;
+    }
+    uint16_t size16 = static_cast<uint16_t>(size);
+    uint16_t zero = 0;
+    uint64_t cycles = read_cycles();
+    memcpy(out, &size16, 2);
+    memcpy(out + 2, &zero, 2);
+    memcpy(out + 4, &id, 4);
+    memcpy(out + 8, &cycles, 8);
+    put_args(out + event_log_header_size, args...);
+    commit();
+}
+
+/**
+ * @brief Logs an event with a printf style format; costs one relaxed load while the log is closed.
+ *
+ * Arguments may be integers, floating point numbers, C strings or std::string, and the
+ * format must use a matching conversion for each: %d/%u/%x (any length modifier), %f/%g/%e, %s.
+ */
+#define EVENT_LOG(level, format, ...)                                                     \
+    do {                                                                                  \
+        if (event_log_detail::enabled.load(std::memory_order_relaxed)) {                  \
+            static LogSite event_log_site{level, __FILE__, __LINE__, format};             \
+            event_log_write(&event_log_site, ##__VA_ARGS__);                              \
+        }                                                                                 \
+    } while (0)
+
+/**
+ * @brief Returns true while the event log is open.
+ */
+inline bool event_log_enabled() {
+    return event_log_detail::enabled.load(std::memory_order_relaxed);
+}
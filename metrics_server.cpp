@@ -0,0 +1,263 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "metrics_server.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+constexpr size_t max_request_size = 8192;
+constexpr int max_clients = 64;
+constexpr int poll_ms = 100;
+constexpr int request_timeout_ms = 5000;
+
+/**
+ * @brief Destructor for MetricsServer, stopping the server thread.
+ */
+MetricsServer::~MetricsServer() {
+    Stop();
+}
+
+/**
+ * @brief Registers the handler for a path. Must be called before Start().
+ *
+ * @param path The request path, e.g. "/metrics".
+ * @param content_type The Content-Type of the responses.
+ * @param handler The handler.
+ */
+void MetricsServer::AddHandler(const std::string& path, const std::string& content_type, Handler handler) {
+    routes_[path] = Route{content_type, std::move(handler)};
+}
+
+/**
+ * @brief Starts listening and serving requests on a thread.
+ *
+ * @param port The TCP port, on every address.
+ * @return true if the port could be bound.
+ */
+bool MetricsServer::Start(int port) {
+    if (running_) {
+        return true;
+    }
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "Error: Could not create the metrics socket" << std::endl;
+        return false;
+    }
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd_, 16) < 0) {
+        std::cerr << "Error: Could not listen for metrics on port " << port << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    fcntl(listen_fd_, F_SETFL, fcntl(listen_fd_, F_GETFL) | O_NONBLOCK);
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::ThreadHandler, this);
+    return true;
+}
+
+/**
+ * @brief Serves on a listening socket handed over by another process instead of binding a port.
+ *
+ * @return false if it is not a listening socket.
+ */
+bool MetricsServer::Adopt(int listen_fd) {
+    if (running_) {
+        return true;
+    }
+    int listening = 0;
+    socklen_t len = sizeof(listening);
+    if (getsockopt(listen_fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &len) < 0 || !listening) {
+        std::cerr << "Error: The handed over metrics socket is not listening" << std::endl;
+        close(listen_fd);
+        return false;
+    }
+    listen_fd_ = listen_fd;
+    fcntl(listen_fd_, F_SETFL, fcntl(listen_fd_, F_GETFL) | O_NONBLOCK);
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::ThreadHandler, this);
+    return true;
+}
+
+/**
+ * @brief Stops the server thread and closes every connection.
+ */
+void MetricsServer::Stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+/**
+ * @brief The server thread, polling the listening socket and the open requests.
+ */
+void MetricsServer::ThreadHandler() {
+    struct Client {
+        int fd;
+        std::string in;
+        std::string out;
+        size_t sent;
+        int idle_ms;
+    };
+    std::vector<Client> clients;
+    std::vector<struct pollfd> fds;
+
+    while (running_) {
+        fds.clear();
+        fds.push_back({listen_fd_, POLLIN, 0});
+        for (const Client& client : clients) {
+            fds.push_back({client.fd, static_cast<short>(client.out.empty() ? POLLIN : POLLOUT), 0});
+        }
+        int ret = poll(fds.data(), fds.size(), poll_ms);
+        if (ret < 0) {
+            continue;
+        }
+
+        for (size_t i = 0; i < clients.size(); i++) {
+            Client& client = clients[i];
+            short events = fds[i + 1].revents;
+            bool done = false;
+            if (events == 0) {
+                client.idle_ms += poll_ms;
+                done = client.idle_ms >= request_timeout_ms;
+            } else if (client.out.empty()) {
+                client.idle_ms = 0;
+                char buffer[1024];
+                ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    done = true;
+                } else {
+                    client.in.append(buffer, n);
+                    if (client.in.find("\r\n\r\n") != std::string::npos || client.in.size() > max_request_size) {
+                        client.out = Respond(client.in);
+                    }
+                }
+            } else {
+                client.idle_ms = 0;
+                ssize_t n = send(client.fd, client.out.data() + client.sent, client.out.size() - client.sent,
+                                 MSG_NOSIGNAL);
+                if (n < 0) {
+                    done = true;
+                } else {
+                    client.sent += n;
+                    done = client.sent == client.out.size();
+                }
+            }
+            if (done) {
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client& c) { return c.fd < 0; }),
+                      clients.end());
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listen_fd_, nullptr, nullptr)) >= 0) {
+                if (static_cast<int>(clients.size()) >= max_clients) {
+                    close(fd);
+                    continue;
+                }
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                clients.push_back(Client{fd, std::string(), std::string(), 0, 0});
+            }
+        }
+    }
+
+    for (const Client& client : clients) {
+        close(client.fd);
+    }
+}
+
+/**
+ * @brief Builds the complete HTTP response to a request head.
+ */
+std::string MetricsServer::Respond(const std::string& request) {
+    std::string status = "200 OK";
+    std::string content_type = "text/plain";
+    std::string body;
+
+    size_t method_end = request.find(' ');
+    size_t target_end = method_end == std::string::npos ? std::string::npos : request.find(' ', method_end + 1);
+    if (target_end == std::string::npos) {
+        status = "400 Bad Request";
+    } else if (request.compare(0, method_end, "GET") != 0) {
+        status = "405 Method Not Allowed";
+    } else {
+        std::string target = request.substr(method_end + 1, target_end - method_end - 1);
+        size_t question = target.find('?');
+        std::string path = target.substr(0, question);
+        std::string query = question == std::string::npos ? std::string() : target.substr(question + 1);
+        auto route = routes_.find(path);
+        if (route == routes_.end()) {
+            status = "404 Not Found";
+        } else {
+            content_type = route->second.content_type;
+            body = route->second.handler(query);
+        }
+    }
+    if (status.compare(0, 3, "200") != 0) {
+        body = status + "\n";
+    }
+    return "HTTP/1.0 " + status + "\r\nContent-Type: " + content_type + "\r\nContent-Length: " +
+           std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
+
+/**
+ * @brief Returns the value of a key in a query string such as "top=20&by=cpu", or the fallback.
+ */
+std::string query_value(const std::string& query, const std::string& key, const std::string& fallback) {
+    size_t pos = 0;
+    while (pos <= query.size()) {
+        size_t end = query.find('&', pos);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        size_t equals = query.find('=', pos);
+        if (equals != std::string::npos && equals < end && query.compare(pos, equals - pos, key) == 0 &&
+            equals - pos == key.size()) {
+            return query.substr(equals + 1, end - equals - 1);
+        }
+        pos = end + 1;
+    }
+    return fallback;
+}
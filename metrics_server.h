@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Minimal HTTP server for metrics and health pages, on its own thread.
+ *
+ * Every request is a GET answered from a handler registered for its path and the connection
+ * is closed after the response. Handlers run on the server thread, so anything they read
+ * from the event loop must be safe to read concurrently.
+ */
+class MetricsServer {
+public:
+
+    /**
+     * @brief Produces a response body from the query string (the part after '?', without it).
+     */
+    using Handler = std::function<std::string(const std::string& query)>;
+
+    /**
+     * @brief Destructor for MetricsServer, stopping the server thread.
+     */
+    ~MetricsServer();
+
+    /**
+     * @brief Registers the handler for a path. Must be called before Start().
+     *
+     * @param path The request path, e.g. "/metrics".
+     * @param content_type The Content-Type of the responses.
+     * @param handler The handler.
+     */
+    void AddHandler(const std::string& path, const std::string& content_type, Handler handler);
+
+    /**
+     * @brief Starts listening and serving requests on a thread.
+     *
+     * @param port The TCP port, on every address.
+     * @return true if the port could be bound.
+     */
+    bool Start(int port);
+
+    /**
+     * @brief Serves on a listening socket handed over by another process instead of binding a port.
+     *
+     * @param listen_fd The listening socket; the server owns it afterwards.
+     * @return false if it is not a listening socket.
+     */
+    bool Adopt(int listen_fd);
+
+    /**
+     * @brief Returns the listening socket, -1 unless started; it stays open until Stop().
+     */
+    int listen_fd() const { return listen_fd_; }
+
+    /**
+     * @brief Stops the server thread and closes every connection.
+     */
+    void Stop();
+
+private:
+
+    /**
+     * @brief The server thread, polling the listening socket and the open requests.
+     */
+    void ThreadHandler();
+
+    /**
+     * @brief Builds the complete HTTP response to a request head.
+     */
+    std::string Respond(const std::string& request);
+
+    struct Route {
+        std::string content_type;
+        Handler handler;
+    };
+
+    std::map<std::string, Route> routes_;
+    int listen_fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+/**
+ * @brief Returns the value of a key in a query string such as "top=20&by=cpu", or the fallback.
+ */
+std::string query_value(const std::string& query, const std::string& key, const std::string& fallback);
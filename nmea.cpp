@@ -0,0 +1,120 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "nmea.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Computes the NMEA checksum, the XOR of the characters between '$' and '*'.
+ * 
+ * @param sentence The first character after '$'.
+ * @param size The number of characters up to, not including, the '*'.
+ * @return The checksum.
+ */
+uint8_t nmea_checksum(const char* sentence, size_t size) {
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < size; i++) {
+        checksum ^= static_cast<uint8_t>(sentence[i]);
+    }
+    return checksum;
+}
+
+/**
+ * @brief Converts a decimal degree to a DDMM format.
+ * 
+ * @param degree The decimal degree to convert.
+ * @return The DDMM format of the decimal degree.
+ */
+double degree_to_ddmm(double const& degree) {
+  int deg = static_cast<int>(floor(degree));
+  double minute = degree - deg*1.0;
+  return (deg*1.0 + minute*60.0/100.0);
+}
+
+/**
+ * @brief Generates a GGA message from the provided latitude, longitude, and altitude.
+ * 
+ * @param lat The latitude in decimal degrees.
+ * @param lon The longitude in decimal degrees.
+ * @param alt The altitude in meters.
+ * @return The GGA message.
+ */
+std::string generage_gga_message(double lat, double lon, double alt) {
+    char buffer[256];
+    time_t now = time(0);
+    struct tm tstruct;
+    tstruct = *gmtime(&now);
+    char utc_time[20];
+    strftime(utc_time, sizeof(utc_time), "%H%M%S", &tstruct);
+
+    double lat_ddmm = degree_to_ddmm(lat);
+    double lon_ddmm = degree_to_ddmm(lon);
+
+    snprintf(buffer, sizeof(buffer),
+             "$GPGGA,%s,%.4f,%c,%.4f,%c,1,08,0.9,%.1f,M,0.0,M,,",
+             utc_time,
+             fabs(lat_ddmm), (lat >= 0) ? 'N' : 'S',
+             fabs(lon_ddmm), (lon >= 0) ? 'E' : 'W',
+             alt);
+
+    int checksum = nmea_checksum(buffer + 1, strlen(buffer + 1));
+
+    char checksum_str[10];
+    snprintf(checksum_str, sizeof(checksum_str), "*%02X", checksum);
+    std::string gga_message = std::string(buffer) + std::string(checksum_str) + "\r\n";
+
+    return gga_message;
+}
+
+/**
+ * @brief Generates a GGA message with centimeter level coordinates from the local time.
+ * 
+ * @param lat The latitude in decimal degrees.
+ * @param lon The longitude in decimal degrees.
+ * @param alt The altitude in meters.
+ * @param gga_out Receives the GGA message.
+ */
+void generage_gga_message(double lat, double lon, double alt, std::string* gga_out) {
+    char src[256];
+    time_t time_now = time(0);
+    struct tm tm_now {};
+    localtime_r(&time_now, &tm_now);
+
+    char *ptr = src;
+    ptr += snprintf(ptr, sizeof(src)+src-ptr,
+        "$GPGGA,%02.0f%02.0f%05.2f,%012.7f,%s,%013.7f,%s,1,"
+        "30,1.2,%.4f,M,-2.860,M,,0000",
+        tm_now.tm_hour*1.0, tm_now.tm_min*1.0, tm_now.tm_sec*1.0,
+        fabs(degree_to_ddmm(lat))*100.0,
+        lat > 0.0 ? "N" : "S",
+        fabs(degree_to_ddmm(lon))*100.0,
+        lon > 0.0 ? "E" : "W",
+        alt);
+    uint8_t checksum = nmea_checksum(src + 1, ptr - src - 1);
+    ptr += snprintf(ptr, sizeof(src)+src-ptr, "*%02X%c%c", checksum, 0x0D, 0x0A);
+    *gga_out = std::string(src, ptr-src);
+}
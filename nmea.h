@@ -0,0 +1,66 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+/**
+ * @brief Computes the NMEA checksum, the XOR of the characters between '$' and '*'.
+ * 
+ * @param sentence The first character after '$'.
+ * @param size The number of characters up to, not including, the '*'.
+ * @return The checksum.
+ */
+uint8_t nmea_checksum(const char* sentence, size_t size);
+
+/**
+ * @brief Converts a decimal degree to a DDMM format.
+ * 
+ * @param degree The decimal degree to convert.
+ * @return The DDMM format of the decimal degree.
+ */
+double degree_to_ddmm(double const& degree);
+
+/**
+ * @brief Generates a GGA message from the provided latitude, longitude, and altitude.
+ * 
+ * @param lat The latitude in decimal degrees.
+ * @param lon The longitude in decimal degrees.
+ * @param alt The altitude in meters.
+ * @return The GGA message.
+ */
+std::string generage_gga_message(double lat, double lon, double alt);
+
+/**
+ * @brief Generates a GGA message with centimeter level coordinates from the local time.
+ * 
+ * @param lat The latitude in decimal degrees.
+ * @param lon The longitude in decimal degrees.
+ * @param alt The altitude in meters.
+ * @param gga_out Receives the GGA message.
+ */
+void generage_gga_message(double lat, double lon, double alt, std::string* gga_out);
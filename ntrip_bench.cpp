@@ -0,0 +1,792 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "arrival_stats.h"
+#include "base64.h"
+#include "clock.h"
+#include "decode_pipeline.h"
+#include "event_log.h"
+#include "nmea.h"
+#include "ntrip_client.h"
+#include "rtcm2.h"
+#include "rtcm3.h"
+#include "rtcm3_encoder.h"
+#include "spp_engine.h"
+#include "stream_framer.h"
+#include "synthetic_network.h"
+#include "tsc_clock.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+constexpr int repetitions = 7;
+
+/**
+ * @brief Keeps the compiler from discarding a value computed by a benchmark.
+ */
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Returns the monotonic time in nanoseconds.
+ */
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Reads the time stamp counter, 0 where there is none.
+ */
+static uint64_t read_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Measures the time stamp counter rate in cycles per nanosecond.
+ */
+static double measure_tsc_ghz() {
+    uint64_t tsc_start = read_tsc();
+    int64_t start = now_ns();
+    while (now_ns() - start < 100000000) {
+    }
+    uint64_t tsc_end = read_tsc();
+    int64_t end = now_ns();
+    return tsc_end > tsc_start ? static_cast<double>(tsc_end - tsc_start) / (end - start) : 0.0;
+}
+
+/**
+ * @brief Returns the first line of a file, empty if it cannot be read.
+ */
+static std::string read_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+/**
+ * @brief Prints what may make the numbers noisy and how to pin the CPU.
+ */
+static void print_hints(bool pinned) {
+    std::string governor = read_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    if (!governor.empty() && governor != "performance") {
+        printf("hint: scaling governor is '%s'; for stable numbers: cpupower frequency-set -g performance\n",
+               governor.c_str());
+    }
+    if (read_line("/sys/devices/system/cpu/intel_pstate/no_turbo") == "0" ||
+        read_line("/sys/devices/system/cpu/cpufreq/boost") == "1") {
+        printf("hint: turbo boost is on; the clock varies with temperature and load, consider disabling it\n");
+    }
+    cpu_set_t set;
+    if (!pinned && sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 1) {
+        printf("hint: not pinned; use -c <cpu> (or taskset -c) on an isolated core\n");
+    }
+}
+
+/**
+ * @brief Transport with one connection that accepts the request, then returns a stream in a loop.
+ *
+ * Drives an NtripClient without sockets, so a benchmark measures its framing and dispatch.
+ */
+class LoopbackTransport : public Transport {
+public:
+
+    /**
+     * @brief Constructor for LoopbackTransport.
+     *
+     * @param stream The correction data, ending at a frame boundary.
+     * @param read_size The bytes one Recv() returns.
+     */
+    LoopbackTransport(const std::vector<uint8_t>& stream, size_t read_size) : stream_(stream), read_size_(read_size) {}
+
+    int Connect(const std::string&, const std::string&, size_t) override {
+        response_ = true;
+        return 0;
+    }
+    int ConnectResult(int) override { return 1; }
+    ssize_t Send(int, const void*, size_t size) override { return static_cast<ssize_t>(size); }
+    ssize_t Recv(int, void* data, size_t size) override {
+        if (response_) {
+            static const char ok[] = "ICY 200 OK\r\n\r\n";
+            response_ = false;
+            memcpy(data, ok, sizeof(ok) - 1);
+            return sizeof(ok) - 1;
+        }
+        size_t n = std::min(std::min(size, read_size_), stream_.size() - pos_);
+        memcpy(data, stream_.data() + pos_, n);
+        pos_ = pos_ + n == stream_.size() ? 0 : pos_ + n;
+        return static_cast<ssize_t>(n);
+    }
+    void Close(int) override {}
+    void Wait(int64_t, std::vector<int>* ready) override { ready->assign(1, 0); }
+
+private:
+    const std::vector<uint8_t>& stream_;
+    size_t read_size_;
+    size_t pos_ = 0;
+    bool response_ = false;
+};
+
+/**
+ * @brief Writes the frames of a batch with writev(), one iovec per run of adjacent frames.
+ *
+ * @return The bytes written, or -1.
+ */
+static ssize_t write_frames(int fd, const FrameBatch& batch, std::vector<iovec>* runs) {
+    runs->clear();
+    for (size_t f = 0; f < batch.count; f++) {
+        const FrameRef& frame = batch.frames[f];
+        if (!runs->empty() && static_cast<const uint8_t*>(runs->back().iov_base) + runs->back().iov_len == frame.data) {
+            runs->back().iov_len += frame.size;
+        } else {
+            runs->push_back({const_cast<uint8_t*>(frame.data), frame.size});
+        }
+    }
+    ssize_t total = 0;
+    for (size_t first = 0; first < runs->size(); first += IOV_MAX) {
+        int count = static_cast<int>(std::min<size_t>(IOV_MAX, runs->size() - first));
+        ssize_t written = writev(fd, runs->data() + first, count);
+        if (written < 0) {
+            return -1;
+        }
+        total += written;
+    }
+    return total;
+}
+
+/**
+ * @brief Benchmark runner printing ns/op and bytes/cycle.
+ */
+class Bench {
+public:
+
+    /**
+     * @brief Constructor for Bench.
+     *
+     * @param filters Substrings of the benchmark names to run, all if empty.
+     * @param target_ns The time spent in each repetition.
+     */
+    Bench(const std::vector<std::string>& filters, int64_t target_ns, double tsc_ghz) :
+        filters_(filters),
+        target_ns_(target_ns),
+        tsc_ghz_(tsc_ghz) {
+        printf("%-28s %12s %12s %10s %10s\n", "benchmark", "ns/op", "median", "bytes/op", "bytes/cyc");
+    }
+
+    /**
+     * @brief Times an operation, reporting the best and the median repetition.
+     *
+     * @param name The benchmark name.
+     * @param bytes The bytes processed by one operation, 0 if not meaningful.
+     * @param op The operation.
+     */
+    template <typename Op>
+    void Run(const std::string& name, size_t bytes, Op op) {
+        if (!Selected(name)) {
+            return;
+        }
+        // grow the batch until it takes a tenth of a repetition
+        uint64_t batch = 1;
+        while (true) {
+            int64_t start = now_ns();
+            for (uint64_t i = 0; i < batch; i++) {
+                op();
+            }
+            if (now_ns() - start >= target_ns_ / 10 || batch >= (1ull << 40)) {
+                break;
+            }
+            batch *= 2;
+        }
+        std::vector<double> samples;
+        for (int r = 0; r < repetitions; r++) {
+            uint64_t ops = 0;
+            int64_t start = now_ns();
+            int64_t elapsed = 0;
+            do {
+                for (uint64_t i = 0; i < batch; i++) {
+                    op();
+                }
+                ops += batch;
+                elapsed = now_ns() - start;
+            } while (elapsed < target_ns_);
+            samples.push_back(static_cast<double>(elapsed) / ops);
+        }
+        std::sort(samples.begin(), samples.end());
+        double best = samples.front();
+        double median = samples[samples.size() / 2];
+        char per_cycle[32] = "-";
+        if (bytes > 0 && tsc_ghz_ > 0.0) {
+            snprintf(per_cycle, sizeof(per_cycle), "%.3f", bytes / (best * tsc_ghz_));
+        }
+        printf("%-28s %12.2f %12.2f %10zu %10s\n", name.c_str(), best, median, bytes, per_cycle);
+        fflush(stdout);
+    }
+
+    /**
+     * @brief Returns true if the benchmark matches a filter.
+     */
+    bool Selected(const std::string& name) const {
+        if (filters_.empty()) {
+            return true;
+        }
+        for (const std::string& filter : filters_) {
+            if (name.find(filter) != std::string::npos) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+
+    std::vector<std::string> filters_;
+    int64_t target_ns_;
+    double tsc_ghz_;
+};
+
+/**
+ * @brief Checks that the decode pipeline keeps every stream's frames in order under load.
+ *
+ * Each producer thread submits its own share of the streams with frames of varying size that
+ * carry their stream and per-stream index, flushing at odd intervals. The rings are kept small
+ * so producers stall and entries wrap. Every handled frame must be the next of its stream, on
+ * the stream's worker, with its own bytes. Build with -fsanitize=thread to check the handoff too.
+ *
+ * @return true if every frame arrived once and in order.
+ */
+static bool check_pipeline_order(int producers, int workers, uint32_t streams, uint64_t frames_per_stream) {
+    std::vector<uint64_t> next(streams, 0);  // each element is only touched by its stream's worker
+    std::atomic<uint64_t> errors{0};
+    DecodePipeline* owner = nullptr;
+    DecodePipeline pipeline(workers, [&next, &errors, &owner](int worker, const PipelineFrame& frame) {
+        uint32_t stream = 0;
+        uint64_t index = 0;
+        bool ok = frame.size >= 12 && frame.stream < next.size() && worker == owner->WorkerOf(frame.stream);
+        if (ok) {
+            memcpy(&stream, frame.data, 4);
+            memcpy(&index, frame.data + 4, 8);
+            ok = stream == frame.stream && index == frame.sequence && index == next[stream];
+            for (size_t i = 12; ok && i < frame.size; i++) {
+                ok = frame.data[i] == static_cast<uint8_t>(index + i);
+            }
+        }
+        if (ok) {
+            next[stream]++;
+        } else {
+            errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }, 1 << 16, 1 << 12);
+    owner = &pipeline;
+
+    std::atomic<uint64_t> rejected{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&pipeline, &rejected, p, producers, streams, frames_per_stream] {
+            DecodePipeline::Producer* producer = pipeline.AddProducer();
+            uint8_t frame[1100];
+            uint64_t submitted = 0;
+            for (uint64_t index = 0; index < frames_per_stream; index++) {
+                for (uint32_t stream = p; stream < streams; stream += producers) {
+                    size_t size = 12 + (stream * 7 + index * 13) % 1000;
+                    memcpy(frame, &stream, 4);
+                    memcpy(frame + 4, &index, 8);
+                    for (size_t i = 12; i < size; i++) {
+                        frame[i] = static_cast<uint8_t>(index + i);
+                    }
+                    if (!producer->Submit(stream, frame, size)) {
+                        rejected.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    if (++submitted % 997 == 0) {
+                        producer->Flush();
+                    }
+                }
+            }
+            producer->Flush();
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    pipeline.Drain();
+    pipeline.Stop();
+
+    uint64_t missing = 0;
+    for (uint32_t stream = 0; stream < streams; stream++) {
+        missing += frames_per_stream - next[stream];
+    }
+    PipelineStats stats = pipeline.stats();
+    printf("pipeline order: %d producers, %d workers, %u streams, %llu frames, %llu stalls\n", producers, workers,
+           streams, static_cast<unsigned long long>(stats.submitted), static_cast<unsigned long long>(stats.stalls));
+    printf("  out of order or corrupt: %llu, missing: %llu, rejected: %llu\n",
+           static_cast<unsigned long long>(errors.load()), static_cast<unsigned long long>(missing),
+           static_cast<unsigned long long>(rejected.load()));
+    return errors.load() == 0 && missing == 0 && rejected.load() == 0;
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: ntrip_bench [-c cpu] [-t ms] [-s] [filter ...]\n"
+              << "  -c cpu   pin the benchmark to a CPU\n"
+              << "  -t ms    time per repetition (default 200)\n"
+              << "  -s       stress check instead: decode pipeline order with 3 producers, 4 workers, 30000 streams\n"
+              << "  filter   run only benchmarks whose name contains one of the filters\n";
+}
+
+/**
+ * @brief Main function for the microbenchmark suite.
+ *
+ * @return 0 if the program exits successfully.
+ */
+int main(int argc, char** argv) {
+    int cpu = -1;
+    int64_t target_ms = 200;
+    std::vector<std::string> filters;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-c" || arg == "-t") && i + 1 < argc) {
+            if (arg == "-c") {
+                cpu = atoi(argv[++i]);
+            } else {
+                target_ms = atoll(argv[++i]);
+            }
+        } else if (arg == "-s") {
+            return check_pipeline_order(3, 4, 30000, 20) ? 0 : 2;
+        } else if (arg[0] == '-') {
+            usage();
+            return 1;
+        } else {
+            filters.push_back(arg);
+        }
+    }
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            std::cerr << "Error: Could not pin to CPU " << cpu << std::endl;
+            return 1;
+        }
+    }
+
+    print_hints(cpu >= 0);
+    double tsc_ghz = measure_tsc_ghz();
+    if (tsc_ghz > 0.0) {
+        printf("TSC %.3f GHz; bytes/cycle counts TSC cycles, which equal core cycles only at the nominal clock\n",
+               tsc_ghz);
+    }
+    Bench bench(filters, target_ms * 1000000, tsc_ghz);
+
+    // NMEA and NTRIP request primitives
+    std::string gga = generage_gga_message(31.167692767, 121.216608817, 10.0);
+    bench.Run("gga/generate", gga.size(), [] {
+        std::string message = generage_gga_message(31.167692767, 121.216608817, 10.0);
+        do_not_optimize(message);
+    });
+    std::string gga_out;
+    generage_gga_message(31.167692767, 121.216608817, 10.0, &gga_out);
+    bench.Run("gga/generate_out", gga_out.size(), [&gga_out] {
+        generage_gga_message(31.167692767, 121.216608817, 10.0, &gga_out);
+        do_not_optimize(gga_out);
+    });
+    size_t star = gga.find('*');
+    bench.Run("nmea/checksum", star - 1, [&gga, star] {
+        uint8_t checksum = nmea_checksum(gga.data() + 1, star - 1);
+        do_not_optimize(checksum);
+    });
+    std::string credentials = "csha6912:umt6n5hu";
+    bench.Run("base64/credentials", credentials.size(), [&credentials] {
+        std::string encoded = base64_encode(credentials);
+        do_not_optimize(encoded);
+    });
+    std::string block(1024, 'x');
+    for (size_t i = 0; i < block.size(); i++) {
+        block[i] = static_cast<char>(i * 131 + 7);
+    }
+    bench.Run("base64/1k", block.size(), [&block] {
+        std::string encoded = base64_encode(block);
+        do_not_optimize(encoded);
+    });
+
+    // a realistic RTCM3 stream: one MSM7 station per constellation plus ephemerides
+    SyntheticOptions options;
+    options.num_stations = 1;
+    SyntheticNetwork network(options);
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> epoch(synthetic_max_epoch_bytes);
+    for (int e = 0; e < 60; e++) {
+        network.SetEpoch((2300ll * 604800 + 3600 + e) * 1000);
+        size_t size = network.EncodeStation(0, epoch.data());
+        stream.insert(stream.end(), epoch.begin(), epoch.begin() + size);
+    }
+    // the first GPS MSM7 frame
+    const uint8_t* msm7 = nullptr;
+    size_t msm7_size = 0;
+    for (size_t pos = 0; pos + rtcm3_header_size < stream.size();) {
+        size_t size = rtcm3_header_size + rtcm3_payload_length(stream.data() + pos) + rtcm3_crc_size;
+        if (rtcm3_message_type(stream.data() + pos, size) == 1077) {
+            msm7 = stream.data() + pos;
+            msm7_size = size;
+            break;
+        }
+        pos += size;
+    }
+
+    std::vector<uint8_t> frame_200(stream.begin(), stream.begin() + 200);
+    bench.Run("crc24q/200", frame_200.size(), [&frame_200] {
+        uint32_t crc = crc24q(frame_200.data(), frame_200.size());
+        do_not_optimize(crc);
+    });
+    std::vector<uint8_t> frame_1k(stream.begin(), stream.begin() + rtcm3_max_frame_size);
+    bench.Run("crc24q/1029", frame_1k.size(), [&frame_1k] {
+        uint32_t crc = crc24q(frame_1k.data(), frame_1k.size());
+        do_not_optimize(crc);
+    });
+
+    // the field widths met in MSM and ephemeris messages
+    static const int widths[] = {12, 12, 30, 1, 3, 7, 2, 2, 1, 3, 8, 4, 10, 14, 20, 24, 10, 1, 10, 15, 22, 6};
+    int pattern_bits = 0;
+    for (int width : widths) {
+        pattern_bits += width;
+    }
+    const int field_bits = (static_cast<int>(frame_1k.size()) * 8 / pattern_bits) * pattern_bits;
+    bench.Run("bits/getbitu", field_bits / 8, [&frame_1k, field_bits] {
+        uint32_t sum = 0;
+        int pos = 0;
+        while (pos < field_bits) {
+            for (int width : widths) {
+                sum += getbitu(frame_1k.data(), pos, width);
+                pos += width;
+            }
+        }
+        do_not_optimize(sum);
+    });
+    bench.Run("bits/getbits", field_bits / 8, [&frame_1k, field_bits] {
+        int32_t sum = 0;
+        int pos = 0;
+        while (pos < field_bits) {
+            for (int width : widths) {
+                sum += getbits(frame_1k.data(), pos, width);
+                pos += width;
+            }
+        }
+        do_not_optimize(sum);
+    });
+
+    // parsers
+    Rtcm3Framer framer;
+    uint64_t framed = 0;
+    Rtcm3Framer::FrameCallback count = [&framed](const uint8_t*, size_t) { framed++; };
+    bench.Run("framer/push_4k_reads", stream.size(), [&] {
+        for (size_t pos = 0; pos < stream.size(); pos += 4096) {
+            framer.Push(stream.data() + pos, std::min<size_t>(4096, stream.size() - pos), count);
+        }
+        do_not_optimize(framed);
+    });
+    // the same stream through format detection: probing, the replay and the locked parser
+    StreamFramer stream_framer;
+    bench.Run("framer/detect_push_4k_reads", stream.size(), [&] {
+        stream_framer.Reset();
+        for (size_t pos = 0; pos < stream.size(); pos += 4096) {
+            stream_framer.Push(stream.data() + pos, std::min<size_t>(4096, stream.size() - pos), count);
+        }
+        do_not_optimize(framed);
+    });
+    // an RTCM 2.3 stream of the same size: type 1 corrections for 12 satellites (20 words) and a type 3
+    std::vector<uint8_t> rtcm2_stream;
+    uint8_t rtcm2_words[rtcm2_max_data_words * rtcm2_word_size];
+    uint8_t rtcm2_message[(rtcm2_header_words + rtcm2_max_data_words) * 5];
+    uint32_t rtcm2_last = 0;
+    for (int m = 0; rtcm2_stream.size() < stream.size(); m++) {
+        size_t words = (m % 10 == 0) ? 4 : 20;
+        for (size_t i = 0; i < words * rtcm2_word_size; i++) {
+            rtcm2_words[i] = static_cast<uint8_t>(m * 31 + i * 7);
+        }
+        size_t size = encode_rtcm2_message(m % 10 == 0 ? 3 : 1, 100, m % 6000, m, rtcm2_words, words,
+                                           rtcm2_message, &rtcm2_last);
+        rtcm2_stream.insert(rtcm2_stream.end(), rtcm2_message, rtcm2_message + size);
+    }
+    Rtcm2Framer rtcm2_framer;
+    bench.Run("framer/rtcm2_push_4k_reads", rtcm2_stream.size(), [&] {
+        for (size_t pos = 0; pos < rtcm2_stream.size(); pos += 4096) {
+            rtcm2_framer.Push(rtcm2_stream.data() + pos, std::min<size_t>(4096, rtcm2_stream.size() - pos), count);
+        }
+        do_not_optimize(framed);
+    });
+
+    // frame dispatch at a high message rate: 20 byte frames in 4 KiB reads through NtripClient, to
+    // a frame callback against a batch callback, into a sink that only counts or writes every frame
+    if (bench.Selected("dispatch/")) {
+        std::vector<uint8_t> small_stream;
+        uint8_t small[rtcm3_max_frame_size] = {};
+        for (int m = 0; small_stream.size() + 20 <= stream.size(); m++) {
+            setbitu(small, 24, 12, 4095);
+            setbitu(small, 36, 32, static_cast<uint32_t>(m));
+            size_t size = rtcm3_finish_frame(small, 14 * 8);
+            small_stream.insert(small_stream.end(), small, small + size);
+        }
+        int sink_fd = open("/dev/null", O_WRONLY);
+        uint64_t sink_bytes = 0;
+        std::vector<iovec> runs;
+        auto count_frame = [&sink_bytes](const uint8_t* frame, size_t size) { sink_bytes += size + frame[size - 1]; };
+        auto count_batch = [&sink_bytes](const FrameBatch& batch) {
+            for (size_t f = 0; f < batch.count; f++) {
+                sink_bytes += batch.frames[f].size + batch.frames[f].data[batch.frames[f].size - 1];
+            }
+        };
+        auto write_frame = [sink_fd, &sink_bytes](const uint8_t* frame, size_t size) {
+            sink_bytes += static_cast<uint64_t>(write(sink_fd, frame, size));
+        };
+        auto write_batch = [sink_fd, &sink_bytes, &runs](const FrameBatch& batch) {
+            sink_bytes += static_cast<uint64_t>(write_frames(sink_fd, batch, &runs));
+        };
+        struct DispatchCase {
+            const char* name;
+            Rtcm3Framer::FrameCallback frame;
+            FrameBatcher::BatchCallback batch;
+            bool writes;
+        };
+        const DispatchCase cases[] = {
+            {"dispatch/frame_count_20b", count_frame, nullptr, false},
+            {"dispatch/batch_count_20b", nullptr, count_batch, false},
+            {"dispatch/frame_write_20b", write_frame, nullptr, true},
+            {"dispatch/batch_write_20b", nullptr, write_batch, true},
+        };
+        for (const DispatchCase& c : cases) {
+            if (c.writes && sink_fd < 0) {
+                continue;
+            }
+            VirtualClock clock;
+            LoopbackTransport transport(small_stream, 4096);
+            NtripClient client;
+            client.Init("bench", "2101", "BENCH", "", "");
+            client.SetQuiet(true);
+            client.SetEnvironment(&clock, &transport);
+            if (c.frame) {
+                client.SetFrameCallback(c.frame);
+            } else {
+                client.SetBatchCallback(c.batch);
+            }
+            client.Start();
+            for (int i = 0; i < 8 && client.state() != NtripClient::State::kStreaming; i++) {
+                client.Step();
+            }
+            bench.Run(c.name, 4096, [&] {
+                client.Step();
+                do_not_optimize(sink_bytes);
+            });
+        }
+        if (sink_fd >= 0) {
+            close(sink_fd);
+        }
+    }
+    MsmMessage msm;
+    if (msm7 != nullptr) {
+        bench.Run("msm/decode_msm7", msm7_size, [&msm, msm7, msm7_size] {
+            bool ok = decode_rtcm3_msm(msm7, msm7_size, &msm);
+            do_not_optimize(ok);
+        });
+        decode_rtcm3_msm(msm7, msm7_size, &msm);
+        std::vector<uint8_t> out(rtcm3_max_frame_size);
+        bench.Run("msm/encode_msm7", msm7_size, [&msm, &out] {
+            size_t size = encode_rtcm3_msm(msm, out.data());
+            do_not_optimize(size);
+        });
+    }
+
+    // positioning a network of 1000 stations for one epoch, orbits shared by all of them
+    if (bench.Selected("spp/")) {
+        SyntheticOptions network_options;
+        network_options.num_stations = 1000;
+        SyntheticNetwork spp_network(network_options);
+        SppEngine engine;
+        std::vector<std::vector<uint8_t>> station_epochs(spp_network.num_stations());
+        for (int station = 0; station < spp_network.num_stations(); station++) {
+            engine.AddStation(std::to_string(station));
+        }
+        // two epochs deliver every ephemeris and position, the frames of the last are replayed
+        for (int e = 0; e < 2; e++) {
+            spp_network.SetEpoch((2300ll * 604800 + 3600 + e) * 1000);
+            for (int station = 0; station < spp_network.num_stations(); station++) {
+                size_t size = spp_network.EncodeStation(station, epoch.data());
+                station_epochs[station].assign(epoch.begin(), epoch.begin() + size);
+                for (size_t pos = 0; pos + rtcm3_header_size < size;) {
+                    size_t frame_size = rtcm3_header_size + rtcm3_payload_length(epoch.data() + pos) + rtcm3_crc_size;
+                    engine.OnFrame(station, epoch.data() + pos, frame_size);
+                    pos += frame_size;
+                }
+            }
+            engine.Solve(nullptr);
+        }
+        size_t network_bytes = 0;
+        for (const std::vector<uint8_t>& frames : station_epochs) {
+            network_bytes += frames.size();
+        }
+        bench.Run("spp/decode_solve_1000", network_bytes, [&] {
+            for (int station = 0; station < spp_network.num_stations(); station++) {
+                const std::vector<uint8_t>& frames = station_epochs[station];
+                for (size_t pos = 0; pos + rtcm3_header_size < frames.size();) {
+                    size_t frame_size = rtcm3_header_size + rtcm3_payload_length(frames.data() + pos) + rtcm3_crc_size;
+                    engine.OnFrame(station, frames.data() + pos, frame_size);
+                    pos += frame_size;
+                }
+            }
+            do_not_optimize(engine.Solve(nullptr));
+        });
+    }
+
+    // MSM decoding of 1000 streams on the decode pipeline, from one worker to one per core
+    if (bench.Selected("pipeline/")) {
+        std::vector<std::pair<const uint8_t*, size_t>> msm_frames;
+        while (msm_frames.size() < 4000) {
+            for (size_t pos = 0; pos + rtcm3_header_size < stream.size();) {
+                size_t size = rtcm3_header_size + rtcm3_payload_length(stream.data() + pos) + rtcm3_crc_size;
+                GnssSystem system;
+                int level;
+                if (rtcm3_msm_info(rtcm3_message_type(stream.data() + pos, size), &system, &level)) {
+                    msm_frames.emplace_back(stream.data() + pos, size);
+                }
+                pos += size;
+            }
+        }
+        size_t msm_bytes = 0;
+        for (const auto& frame : msm_frames) {
+            msm_bytes += frame.second;
+        }
+        int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        std::vector<int> worker_counts;
+        for (int workers = 1; workers < cores; workers *= 2) {
+            worker_counts.push_back(workers);
+        }
+        worker_counts.push_back(cores);
+        for (int workers : worker_counts) {
+            std::vector<MsmMessage> decoded(workers);
+            DecodePipeline pipeline(workers, [&decoded](int worker, const PipelineFrame& frame) {
+                bool ok = decode_rtcm3_msm(frame.data, frame.size, &decoded[worker]);
+                do_not_optimize(ok);
+            });
+            DecodePipeline::Producer* producer = pipeline.AddProducer();
+            bench.Run("pipeline/msm_decode_w" + std::to_string(workers), msm_bytes, [&] {
+                for (size_t i = 0; i < msm_frames.size(); i++) {
+                    producer->Submit(static_cast<uint32_t>(i % 1000), msm_frames[i].first, msm_frames[i].second);
+                }
+                producer->Flush();
+                pipeline.Drain();
+            });
+        }
+    }
+
+    // the hex dump NtripClient prints without a frame callback
+    std::vector<uint8_t> chunk(stream.begin(), stream.begin() + 256);
+    bench.Run("hex/ostream_256", chunk.size(), [&chunk] {
+        std::ostringstream out;
+        out << "Data received: ";
+        for (size_t i = 0; i < chunk.size(); i++) {
+            out << std::hex << (int)chunk[i];
+        }
+        out << std::dec << std::endl;
+        do_not_optimize(out);
+    });
+
+    // per frame arrival statistics: 6 message types per 1 s epoch, frames 2 ms apart
+    ArrivalStats arrival;
+    const int types[] = {1006, 1019, 1077, 1087, 1097, 1127};
+    int64_t arrival_us = 0;
+    uint64_t arrival_frame = 0;
+    bench.Run("arrival/on_frame", 0, [&] {
+        int index = static_cast<int>(arrival_frame++ % 6);
+        arrival_us += index == 0 ? 990000 : 2000;
+        arrival.OnFrame(types[index], 300, arrival_us);
+    });
+
+    // per frame timestamp sources
+    const TscClock& tsc = TscClock::Get();
+    if (bench.Selected("clock/")) {
+        printf("  (TscClock %s, %.3f GHz)\n", tsc.uses_tsc() ? "on the TSC" : "on CLOCK_MONOTONIC",
+               tsc.cycles_per_second() / 1e9);
+    }
+    bench.Run("clock/tsc_ticks", 0, [&tsc] {
+        do_not_optimize(tsc.Ticks());
+    });
+    bench.Run("clock/tsc_monotonic_ns", 0, [&tsc] {
+        do_not_optimize(tsc.MonotonicNs());
+    });
+    bench.Run("clock/clock_gettime", 0, [] {
+        do_not_optimize(TscClock::SystemMonotonicNs());
+    });
+    bench.Run("clock/steady_clock", 0, [] {
+        do_not_optimize(std::chrono::steady_clock::now());
+    });
+
+    // a connection log line, binary against formatted text
+    std::string mountpoint = "RTCM33_GRCEJ";
+    std::string reason = "Remote socket closed";
+    int attempt = 3;
+    double retry = 4.125;
+    if (event_log_open("/dev/null", 1 << 20)) {
+        bench.Run("log/event_log", 0, [&] {
+            EVENT_LOG(LogLevel::kWarning, "%s failed: %s, attempt %d, retry in %.3f s", mountpoint, reason, attempt,
+                      retry);
+        });
+        event_log_close();
+        if (event_log_dropped() > 0) {
+            printf("  (event log dropped %llu events, buffer full)\n",
+                   static_cast<unsigned long long>(event_log_dropped()));
+        }
+    }
+    bench.Run("log/ostream_endl", 0, [&] {
+        std::ostringstream out;
+        out << mountpoint << " failed: " << reason << ", attempt " << attempt << ", retry in " << retry << " s"
+            << std::endl;
+        do_not_optimize(out);
+    });
+    return 0;
+}
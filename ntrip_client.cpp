@@ -23,54 +23,40 @@ SOFTWARE.
 */
 #include "ntrip_client.h"
 
+#include "base64.h"
+#include "event_log.h"
+
 #include <sys/types.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <netinet/tcp.h>
-#include <arpa/inet.h>
-#include <netdb.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <errno.h>
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <string>
-#include <list>
 #include <memory>
 #include <iostream>
 
 
-constexpr int buffer_size = 4096;
-constexpr int socket_timeout = 50;  // 100 * ms
-constexpr int reporting_interval_ms = 1000;  // ms
-
-static const std::string b = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";   // =
-
-/**
- * @brief Encodes a string to base64.
- * 
- * @param in The input string to encode.
- * @return The base64 encoded string.
- */
-static std::string base64_encode(const std::string &in) {
-    std::string out;
-
-    int val = 0, valb = -6;
-    for (u_char c : in) {
-        val = (val << 8) + c;
-        valb += 8;
-        while (valb >= 0) {
-            out.push_back(b[(val >> valb) & 0x3F]);
-            valb -= 6;
-        }
-    }
-    if (valb > -6) out.push_back(b[((val << 8) >> (valb + 8)) & 0x3F]);
-    while (out.size()%4) out.push_back('=');
-    return out;
-}
+constexpr int handshake_read_size = 4096;
+constexpr int stream_read_size = 65536;  // on the stack, so one read takes a whole epoch of a network stream
+constexpr int max_reads_per_step = 16;  // bounds the time one stream holds a shared event loop
+constexpr int64_t handshake_timeout_us = 5000000;  // connect plus caster response
+constexpr int64_t idle_timeout_us = 30000000;  // reconnect when no data arrives for this long
+constexpr int64_t reporting_interval_us = 1000000;
+constexpr int64_t backoff_min_us = 1000000;
+constexpr int64_t backoff_max_us = 60000000;
+constexpr int64_t run_poll_us = 100000;  // client thread wake up to notice Stop()
+constexpr int64_t status_interval_us = 250000;  // republish the status while streaming
+constexpr int64_t burst_gap_us = 20000;  // reads closer together than this belong to one burst
+constexpr int receive_sizing_bursts = 8;  // bursts seen before the first resize
+constexpr size_t receive_headroom = 2;  // peak bursts the requested buffer holds; the kernel doubles it again
+constexpr size_t min_receive_buffer = 4096;
+constexpr size_t max_receive_buffer = 1 << 20;  // the kernel caps requests at net.core.rmem_max anyway
+constexpr size_t frame_batch_max_bytes = 65536;  // a batch is passed once it holds this much, epoch or not
+constexpr int64_t never = std::numeric_limits<int64_t>::max();
 
 /**
  * @brief Creates an NtripClient object with the provided connection details.
@@ -88,6 +74,7 @@ NtripClient::NtripClient(const std::string& host, const std::string& port, const
     username_(username),
     password_(password) {
     initialized_ = true;
+    backoff_seed_ = std::hash<std::string>()(host_ + ":" + port_ + "/" + mountpoint_) | 1;
 }
 
 /**
@@ -116,6 +103,7 @@ bool NtripClient::Init(const std::string& host, const std::string& port, const s
     username_ = username;
     password_ = password;
     initialized_ = true;
+    backoff_seed_ = std::hash<std::string>()(host_ + ":" + port_ + "/" + mountpoint_) | 1;
     return true;
 }
 
@@ -124,13 +112,9 @@ bool NtripClient::Init(const std::string& host, const std::string& port, const s
  * 
  * This function performs the following steps:
  * - Stops the client if it is already running.
- * - Sets up the network structure for the socket connection.
- * - Creates a socket and connects to the server.
- * - Sets the socket to non-blocking mode.
- * - Authenticates the NTRIP connection using the provided credentials.
+ * - Connects to the server and authenticates the NTRIP connection using the provided credentials.
  * - Sends GGA data if available.
- * - Configures TCP socket keepalive options if enabled.
- * - Starts the client thread to handle incoming data.
+ * - Starts the client thread, which streams the data and reconnects with backoff on failures.
  * 
  * @return true if the client successfully connects and authenticates with the server, false otherwise.
  */
@@ -138,122 +122,30 @@ bool NtripClient::Run() {
     if (IsRunning()) {
         Stop();
     }
-
-    // set up network struct for socket connection
-    struct sockaddr_in serv_addr;
-    memset(&serv_addr, '0', sizeof(serv_addr));
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(std::stoi(port_));
-
-    // using the host_ variable, resolve the ip address for the server
-    addrinfo hints, *res;
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    int status = getaddrinfo(host_.c_str(), port_.c_str(), &hints, &res);
-    if (status != 0) {
-        std::cerr << "Error: Could not resolve host address" << std::endl;
-        return false;
-    }
-
-    serv_addr.sin_addr.s_addr = inet_addr(inet_ntoa(((struct sockaddr_in *)(res->ai_addr))->sin_addr));
-
-    // create socket
-    sockfd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd_ < 0) {
-        std::cerr << "Error: Could not create socket" << std::endl;
-        return false;
-    }
-
-    // connect to server
-    if (connect(sockfd_, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) {
-        std::cerr << "Error: Could not connect to server" << std::endl;
-        close(sockfd_);
-        return false;
-    }
-
-    connected_ = true;
-
-    // set socket to non-blocking
-    int flags = fcntl(sockfd_, F_GETFL);
-    fcntl(sockfd_, F_SETFL, flags | O_NONBLOCK);
-
-    // authenticate ntrip connection
-    int ret = -1;
-    std::string user_pass = username_ + ":" + password_;
-    std::string user_pass_b64 = base64_encode(user_pass);
-    std::string request = "GET /" + mountpoint_ + " HTTP/1.1\r\n";
-    // std::string user_agent = "User-Agent: NTRIP Client/1.0\r\n";
-    std::string user_agent = "User-Agent: NTRIP NTRIPClient/1.2.0.b431661\r\n";
-    std::string authorization = "Authorization: Basic " + user_pass_b64 + "\r\n";
-    std::string request_end = "\r\n";
-    std::string full_request = request + user_agent + authorization + request_end;
-    ret = send(sockfd_, full_request.c_str(), full_request.length(), 0);
-    if (ret <= 0) {
-        std::cerr << "Error: Could not send request to server" << std::endl;
-        close(sockfd_);
+    if (!initialized_) {
+        EVENT_LOG(LogLevel::kError, "NtripClient not initialized");
+        std::cerr << "Error: NtripClient not initialized" << std::endl;
         return false;
     }
 
-    int timeout = 0;
-    std::unique_ptr<char[]> buffer_(new char[buffer_size], std::default_delete<char[]>());
-    while (timeout < socket_timeout) {
-        ret = recv(sockfd_, buffer_.get(), buffer_size, 0);
-        if (ret > 0) {
-            std::string result(buffer_.get(), ret);
-            if ((result.find("HTTP/1.1 200 OK") != std::string::npos) ||
-                (result.find("ICY 200 OK") != std::string::npos)) {
-                authenticated_ = true;
-                if (!gga_buffer_.empty()) {
-                    ret = send(sockfd_, gga_buffer_.c_str(), gga_buffer_.size(), 0);
-                    if (ret <= 0) {
-                        std::cerr << "Error: Could not send GGA data to server" << std::endl;
-                        close(sockfd_);
-                        return false;
-                    } else {
-                        std::cout << "send gga sucess\n";
-                    }
-                    // send was successful so break out of loop
-                    break;
-                } else {
-                    std::cout << "gga buff empty\n";
-                    // nothing in the buffer to send. go next i guess
-                    break;
-                }
-            } else {
-                std::cerr << "Error: Request result: " << result << std::endl;
-            }
-        } else if (ret == 0) {
-            std::cerr << "Error: Remote socket closed" << std::endl;
-            close(sockfd_);
-            return false;
-        } else {
-            std::cout << "ret:" << ret << std::endl;
+    // step the connection until it streams or the first attempt fails
+    Start();
+    std::vector<int> ready;
+    while (state_ == State::kConnecting || state_ == State::kHandshake) {
+        int64_t next = Step();
+        if (state_ != State::kConnecting && state_ != State::kHandshake) {
+            break;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        transport_->Wait(std::min(next - clock_->Now(), run_poll_us), &ready);
     }
-
-    if (timeout >= socket_timeout) {
-        std::cout << "Error: NtripCaster[" << host_ << ":" << port_ << " " << username_ << " " << password_ << " " << mountpoint_ << "] access failed" << std::endl;
-        close(sockfd_);
+    if (state_ != State::kStreaming) {
+        Cleanup();
         return false;
     }
 
-    // TCP socket keepalive.
-#if defined(ENABLE_TCP_KEEPALIVE)
-    int keepalive = 1;  // Enable keepalive attributes.
-    int keepidle = 30;  // Time out for starting detection.
-    int keepinterval = 5;  // Time interval for sending packets during detection.
-    int keepcount = 3;  // Max times for sending packets during detection.
-    setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive));
-    setsockopt(sockfd_, SOL_TCP, TCP_KEEPIDLE, &keepidle, sizeof(keepidle));
-    setsockopt(sockfd_, SOL_TCP, TCP_KEEPINTVL, &keepinterval, sizeof(keepinterval));
-    setsockopt(sockfd_, SOL_TCP, TCP_KEEPCNT, &keepcount, sizeof(keepcount));
-#endif  // defined(ENABLE_TCP_KEEPALIVE)
-    running_ = true;
     // all the setup is done, start the thread
+    running_ = true;
     thread_ = std::thread(&NtripClient::ThreadHandler, this);
-
     return true;
 }
 
@@ -264,8 +156,8 @@ void NtripClient::Stop() {
     if (running_) {
         running_ = false;
         thread_.join();
-        close(sockfd_);
     }
+    Cleanup();
 }
 
 /**
@@ -283,102 +175,746 @@ bool NtripClient::IsRunning() {
  * @param gga The GGA message to update the buffer with.
  */
 void NtripClient::UpdateGGA(std::string gga) {
+    std::lock_guard<std::mutex> lock(gga_mutex_);
     gga_buffer_ = gga;
 }
 
 /**
- * @brief Cleans up the NtripClient, closing the socket if it is still open.
+ * @brief Sets the callback invoked with every checked frame received from the server.
+ * 
+ * @param callback The callback, called from the client thread.
  */
-void NtripClient::Cleanup() {
-    if (sockfd_ > 0) {
-        close(sockfd_);
-        sockfd_ = -1;
-    }
+void NtripClient::SetFrameCallback(Rtcm3Framer::FrameCallback callback) {
+    frame_callback_ = std::move(callback);
 }
 
 /**
- * @brief The main thread handler for the NtripClient.
+ * @brief Sets a callback invoked with the checked frames in batches instead of one at a time.
  * 
- * This function is responsible for handling the main body of the NtripClient service.
- * It receives data from the NTRIP server and sends GGA data at regular intervals.
+ * @param callback The callback, called from the client thread.
+ * @param mode When to pass a batch.
+ */
+void NtripClient::SetBatchCallback(FrameBatcher::BatchCallback callback, BatchMode mode) {
+    batch_callback_ = std::move(callback);
+    batch_mode_ = mode;
+}
+
+/**
+ * @brief Fixes the format of the correction stream instead of detecting it.
  * 
- * @return true if the thread handler completes successfully, false otherwise.
+ * @param format The format, kUnknown to detect it from the data (the default).
  */
-bool NtripClient::ThreadHandler() {
-    // confirm the module has been initialized
-    if (!initialized_) {
-        std::cerr << "Error: NtripClient not initialized" << std::endl;
-        Cleanup();
-        return false;
+void NtripClient::SetStreamFormat(StreamFormat format) {
+    framer_.SetFormat(format);
+}
+
+/**
+ * @brief Starts recording inter-arrival and burst statistics of the received frames.
+ * 
+ * @param burst_gap_us Arrival gap that starts a new burst of frames.
+ */
+void NtripClient::EnableArrivalStats(int64_t burst_gap_us) {
+    arrival_stats_.reset(new ArrivalStats(burst_gap_us));
+}
+
+/**
+ * @brief Uses an external clock and transport instead of the system clock and sockets.
+ * 
+ * @param clock The time source for timeouts, GGA cadence and backoff.
+ * @param transport The network used for the caster connection.
+ */
+void NtripClient::SetEnvironment(Clock* clock, Transport* transport) {
+    clock_ = clock;
+    transport_ = transport;
+}
+
+/**
+ * @brief Asks a gate before every connection attempt, e.g. for per-caster admission control.
+ */
+void NtripClient::SetConnectGate(ConnectGate gate) {
+    connect_gate_ = std::move(gate);
+}
+
+/**
+ * @brief Ends a running backoff at another time, e.g. when admission control paces the retries.
+ */
+void NtripClient::RetryAt(int64_t time) {
+    if (state_ == State::kBackoff) {
+        deadline_ = time;
     }
+}
 
-    // if initialized, confirm the connection has been made
-    if (!connected_) {
-        std::cerr << "Error: NtripClient not connected" << std::endl;
-        Cleanup();
-        return false;
+/**
+ * @brief Suppresses the informational and error output.
+ */
+void NtripClient::SetQuiet(bool quiet) {
+    quiet_ = quiet;
+}
+
+/**
+ * @brief Returns the bytes held by the client waiting for more data: a partial frame or response.
+ */
+size_t NtripClient::BufferedBytes() const {
+    return framer_.staged() + response_.size();
+}
+
+/**
+ * @brief Returns the approximate memory owned by the client, including its buffers.
+ */
+size_t NtripClient::MemoryUsage() const {
+    size_t bytes = sizeof(NtripClient) + host_.capacity() + port_.capacity() + mountpoint_.capacity() +
+                   username_.capacity() + password_.capacity() + response_.capacity();
+    std::lock_guard<std::mutex> lock(gga_mutex_);
+    return bytes + gga_buffer_.capacity();
+}
+
+/**
+ * @brief Starts connecting without a client thread; the owner then calls Step().
+ */
+void NtripClient::Start() {
+    if (clock_ == nullptr) {
+        own_clock_.reset(new SystemClock());
+        clock_ = own_clock_.get();
+    }
+    if (transport_ == nullptr) {
+        own_transport_.reset(new SocketTransport());
+        transport_ = own_transport_.get();
+    }
+    Cleanup();
+    if (restored_) {
+        ReplayStationFrames();
+    } else {
+        failures_ = 0;
     }
+    TryConnect(clock_->Now());
+}
 
-    // if connected, confirm the client has been authenticated
-    if (!authenticated_) {
-        std::cerr << "Error: NtripClient not authenticated" << std::endl;
-        Cleanup();
+/**
+ * @brief Gives up a streaming connection with the state to resume it, for a binary upgrade.
+ *
+ * @return false, leaving the client as it was, unless it is streaming.
+ */
+bool NtripClient::HandOver(HandedStream* stream) {
+    if (state_ != State::kStreaming) {
         return false;
     }
-
-    // confirm the socket has not been broken or lost since the thread was created
-    if (sockfd_ < 0) {
-        std::cerr << "Error: Socket not created" << std::endl;
-        Cleanup();
+    int fd = transport_->Release(handle_);
+    if (fd < 0) {
         return false;
     }
+    SaveCheckpoint(&stream->checkpoint);
+    stream->fd = fd;
+    stream->pending = framer_.Pending();
+    stream->bytes_received = bytes_received_;
+    EVENT_LOG(LogLevel::kInfo, "%s handed over with %zu pending bytes", mountpoint_, stream->pending.size());
+    handle_ = -1;
+    receive_buffer_ = 0;
+    Cleanup();
+    return true;
+}
 
-    // if all checks are ok, we can go ahead with the main body
-    std::unique_ptr<char[]> buffer_(new char[buffer_size], std::default_delete<char[]>());
-    int ret = 0;
-    auto start_time = std::chrono::steady_clock::now();
-    auto end_time = start_time;
-    std::cout << "NtripClient service running..." << std::endl;
-    while (running_) {
-        ret = recv(sockfd_, buffer_.get(), buffer_size, 0);
-        if (ret == 0) {
-            std::cerr << "Remote socket closed" << std::endl;
-            // Cleanup();
-            // return false;
-        } else if (ret < 0) {
-            if ((errno != 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
-                std::cerr << "Remote socket error, errno=" << errno << std::endl;
-                Cleanup();
-                return false;
+/**
+ * @brief Continues a stream handed over by another process, in place of Start().
+ */
+void NtripClient::Resume(int handle, const HandedStream& stream) {
+    if (clock_ == nullptr) {
+        own_clock_.reset(new SystemClock());
+        clock_ = own_clock_.get();
+    }
+    if (transport_ == nullptr) {
+        own_transport_.reset(new SocketTransport());
+        transport_ = own_transport_.get();
+    }
+    Cleanup();
+    RestoreCheckpoint(stream.checkpoint);
+    ReplayStationFrames();
+    int64_t now = clock_->Now();
+    handle_ = handle;
+    burst_bytes_ = 0;
+    receive_buffer_ = receive_request_ > 0 ? transport_->SetReceiveBuffer(handle_, receive_request_)
+                                           : transport_->DefaultReceiveBuffer();
+    bytes_received_ = stream.bytes_received;
+    SetState(State::kStreaming, now);
+    last_data_ = now;
+    next_gga_ = now + reporting_interval_us;
+    EVENT_LOG(LogLevel::kInfo, "%s resumed with %zu pending bytes", mountpoint_, stream.pending.size());
+    if (!stream.pending.empty() && (frame_callback_ || batch_callback_ || arrival_stats_)) {
+        // the bytes were counted by the previous process, only the framer sees them again
+        frame_timing_.arrival = tsc_->Ticks();
+        PushFrames(reinterpret_cast<const uint8_t*>(stream.pending.data()), stream.pending.size());
+    }
+    Publish(now);
+}
+
+/**
+ * @brief Delivers the cached station description frames to the frame callbacks, once after a restore.
+ */
+void NtripClient::ReplayStationFrames() {
+    restored_ = false;
+    if (!frame_callback_ && !batch_callback_) {
+        return;
+    }
+    // replay the station description of the last run, framed like live data
+    const uint8_t* frames = reinterpret_cast<const uint8_t*>(station_frames_.data());
+    for (size_t pos = 0; pos + rtcm3_header_size <= station_frames_.size();) {
+        size_t size = std::min(rtcm3_header_size + rtcm3_payload_length(frames + pos) + rtcm3_crc_size,
+                               station_frames_.size() - pos);
+        if (frame_callback_) {
+            frame_callback_(frames + pos, size);
+        }
+        if (batch_callback_) {
+            batcher_.Add(frames + pos, size);
+        }
+        pos += size;
+    }
+    batcher_.Flush(batch_callback_);
+}
+
+/**
+ * @brief Copies the state worth keeping across a process restart; the owner adds the address.
+ */
+void NtripClient::SaveCheckpoint(StreamCheckpoint* checkpoint) const {
+    checkpoint->format = static_cast<uint8_t>(framer_.hint());
+    checkpoint->failures = failures_;
+    checkpoint->receive_request = static_cast<uint32_t>(receive_request_);
+    checkpoint->peak_burst = static_cast<uint32_t>(peak_burst_);
+    checkpoint->metadata_size = static_cast<uint16_t>(std::min(station_frames_.size(), checkpoint_metadata_size));
+    memcpy(checkpoint->metadata, station_frames_.data(), checkpoint->metadata_size);
+}
+
+/**
+ * @brief Restores state saved by SaveCheckpoint(), before Start().
+ */
+void NtripClient::RestoreCheckpoint(const StreamCheckpoint& checkpoint) {
+    if (checkpoint.format < num_stream_formats) {
+        framer_.SetHint(static_cast<StreamFormat>(checkpoint.format));
+    }
+    failures_ = std::max(checkpoint.failures, 0);
+    receive_request_ = checkpoint.receive_request;
+    peak_burst_ = checkpoint.peak_burst;
+    bursts_ = receive_request_ > 0 ? receive_sizing_bursts : 0;
+    station_frames_.assign(reinterpret_cast<const char*>(checkpoint.metadata),
+                           std::min<size_t>(checkpoint.metadata_size, checkpoint_metadata_size));
+    restored_ = true;
+}
+
+/**
+ * @brief Advances the connection state machine without blocking.
+ * 
+ * @return The clock time in microseconds the client next needs to run, INT64_MAX if idle.
+ */
+int64_t NtripClient::Step() {
+    int64_t now = clock_->Now();
+    if (state_ == State::kBackoff && now >= deadline_) {
+        TryConnect(now);
+    }
+
+    if (state_ == State::kConnecting) {
+        int result = transport_->ConnectResult(handle_);
+        if (result < 0) {
+            Fail(now, Failure::kConnect, "Could not connect to server");
+        } else if (result > 0) {
+            if (SendRequest()) {
+                EVENT_LOG(LogLevel::kDebug, "%s connected, request sent", mountpoint_);
+                SetState(State::kHandshake, now);
             } else {
-                // std::cout << "aaaa \n";
+                Fail(now, Failure::kConnect, "Could not send request to server");
             }
-        } else {
+        }
+    }
+
+    if (state_ == State::kHandshake) {
+        ReadHandshake(now);
+    }
+
+    if ((state_ == State::kConnecting || state_ == State::kHandshake) && now >= deadline_) {
+        Fail(now, Failure::kTimeout,
+             "NtripCaster[" + host_ + ":" + port_ + " " + username_ + " " + mountpoint_ + "] access failed");
+    }
+
+    if (state_ == State::kStreaming) {
+        ReadStream(now);
+    }
+    if (state_ == State::kStreaming) {
+        if (now - last_data_ >= idle_timeout_us) {
+            Fail(now, Failure::kStream, "No data received, reconnecting");
+        } else if (now >= next_gga_) {
+            if (!SendGGA()) {
+                Fail(now, Failure::kStream, "Could not send GGA data to server");
+            } else {
+                // keep a fixed cadence instead of drifting by the loop latency
+                next_gga_ += reporting_interval_us;
+                if (next_gga_ <= now) {
+                    next_gga_ = now + reporting_interval_us;
+                }
+            }
+        }
+    }
+
+    if (status_dirty_ || now - published_at_ >= status_interval_us) {
+        Publish(now);
+    }
+
+    switch (state_) {
+        case State::kStreaming:
+            return std::min(next_gga_, last_data_ + idle_timeout_us);
+        case State::kConnecting:
+        case State::kHandshake:
+        case State::kBackoff:
+            return deadline_;
+        default:
+            return never;
+    }
+}
+
+/**
+ * @brief Opens the connection and arms the handshake timeout.
+ */
+void NtripClient::Connect(int64_t now) {
+    framer_.Reset();
+    response_.clear();
+    SetState(State::kConnecting, now);
+    deadline_ = now + handshake_timeout_us;
+    // a reconnect reuses the size learned on the previous connection, set before the SYN goes out
+    handle_ = transport_->Connect(host_, port_, receive_request_);
+    EVENT_LOG(LogLevel::kDebug, "%s connecting to %s:%s, handle %d", mountpoint_, host_, port_, handle_);
+    if (handle_ < 0) {
+        Fail(now, Failure::kConnect, "Could not start connection");
+        return;
+    }
+    burst_bytes_ = 0;
+    receive_buffer_ = transport_->ReceiveBuffer(handle_);
+}
+
+/**
+ * @brief Connects if the connect gate lets the client, otherwise waits in kBackoff.
+ */
+void NtripClient::TryConnect(int64_t now) {
+    int64_t retry = connect_gate_ ? connect_gate_(now) : now;
+    if (retry <= now) {
+        Connect(now);
+        return;
+    }
+    if (state_ != State::kBackoff) {
+        SetState(State::kBackoff, now);
+    }
+    deadline_ = retry;
+}
+
+/**
+ * @brief Sends the NTRIP request once the connection is established.
+ */
+bool NtripClient::SendRequest() {
+    // authenticate ntrip connection
+    std::string user_pass = username_ + ":" + password_;
+    std::string user_pass_b64 = base64_encode(user_pass);
+    std::string request = "GET /" + mountpoint_ + " HTTP/1.1\r\n";
+    // std::string user_agent = "User-Agent: NTRIP Client/1.0\r\n";
+    std::string user_agent = "User-Agent: NTRIP NTRIPClient/1.2.0.b431661\r\n";
+    std::string authorization = "Authorization: Basic " + user_pass_b64 + "\r\n";
+    std::string request_end = "\r\n";
+    std::string full_request = request + user_agent + authorization + request_end;
+    ssize_t ret = transport_->Send(handle_, full_request.c_str(), full_request.length());
+    return ret == static_cast<ssize_t>(full_request.length());
+}
+
+/**
+ * @brief Reads the caster response, switching to streaming on success.
+ */
+void NtripClient::ReadHandshake(int64_t now) {
+    char buffer[handshake_read_size];
+    ssize_t ret = transport_->Recv(handle_, buffer, sizeof(buffer));
+    if (ret == 0) {
+        Fail(now, Failure::kConnect, "Error: Remote socket closed");
+        return;
+    } else if (ret == Transport::kError) {
+        Fail(now, Failure::kConnect, "Remote socket error");
+        return;
+    } else if (ret < 0) {
+        return;
+    }
+    response_.append(buffer, ret);
+
+    size_t status_end = response_.find("\r\n");
+    if (status_end == std::string::npos) {
+        return;
+    }
+    bool icy = response_.compare(0, 10, "ICY 200 OK") == 0;
+    bool http = response_.compare(0, 15, "HTTP/1.1 200 OK") == 0 || response_.compare(0, 15, "HTTP/1.0 200 OK") == 0;
+    if (!icy && !http) {
+        // "HTTP/1.1 503 Service Unavailable" or "ICY 401 Unauthorized"
+        size_t code_start = response_.find(' ');
+        response_code_ = code_start < status_end ? atoi(response_.c_str() + code_start + 1) : 0;
+        Fail(now, Failure::kRejected, "Error: Request result: " + response_.substr(0, status_end));
+        return;
+    }
+
+    // the data starts after the headers; ICY casters may send none
+    size_t data_start;
+    size_t headers_end = response_.find("\r\n\r\n");
+    if (headers_end != std::string::npos) {
+        data_start = headers_end + 4;
+    } else if (icy) {
+        data_start = status_end + 2;
+    } else {
+        return;  // wait for the rest of the HTTP headers
+    }
+
+    SetState(State::kStreaming, now);
+    if (failures_ != 0) {
+        failures_ = 0;
+        checkpoint_version_++;
+    }
+    last_data_ = now;
+    next_gga_ = now + reporting_interval_us;
+    if (!SendGGA()) {
+        Fail(now, Failure::kStream, "Error: Could not send GGA data to server");
+        return;
+    }
+    EVENT_LOG(LogLevel::kInfo, "%s streaming, %s", mountpoint_, response_.substr(0, status_end));
+    if (!quiet_ && !event_log_enabled()) {
+        std::cout << "NtripClient service running..." << std::endl;
+    }
+    if (data_start < response_.size()) {
+        last_received_ = now;
+        frame_timing_.arrival = tsc_->Ticks();
+        HandleData(response_.data() + data_start, response_.size() - data_start);
+    }
+    response_.clear();
+    response_.shrink_to_fit();
+}
+
+/**
+ * @brief Reads correction data until the transport has none left.
+ */
+void NtripClient::ReadStream(int64_t now) {
+    char buffer[stream_read_size];
+    for (int i = 0; i < max_reads_per_step; i++) {
+        ssize_t ret = transport_->Recv(handle_, buffer, sizeof(buffer));
+        if (ret == 0) {
+            Fail(now, Failure::kStream, "Remote socket closed");
+            return;
+        } else if (ret == Transport::kError) {
+            Fail(now, Failure::kStream, "Remote socket error");
+            return;
+        } else if (ret < 0) {
+            return;
+        }
+        if (burst_bytes_ > 0 && now - burst_last_ > burst_gap_us) {
+            SizeReceiveBuffer(burst_bytes_);
+            burst_bytes_ = 0;
+        }
+        burst_bytes_ += ret;
+        burst_last_ = now;
+        last_data_ = now;
+        last_received_ = now;
+        frame_timing_.arrival = tsc_->Ticks();
+        HandleData(buffer, ret);
+        if (ret < stream_read_size) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Passes received correction data to the framer or prints it.
+ */
+void NtripClient::HandleData(const char* data, size_t size) {
+    bytes_received_ += size;
+    if (!frame_callback_ && !batch_callback_ && !arrival_stats_) {
+        if (!quiet_) {
             // do something with the data
             // alternative methods can be created here to move it to a queue or whatever
             std::cout << "Data received: ";
-            for (int i = 0; i < ret; i++) {
-                std::cout << std::hex << (int)static_cast<uint8_t>(buffer_[i]);
+            for (size_t i = 0; i < size; i++) {
+                std::cout << std::hex << (int)static_cast<uint8_t>(data[i]);
             }
-            std::cout << std::endl;
+            std::cout << std::dec << std::endl;
         }
-        end_time = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() >= reporting_interval_ms) {
-            start_time = std::chrono::steady_clock::now();
-            // send some data
-            if (!gga_buffer_.empty()) {
-                ret = send(sockfd_, gga_buffer_.c_str(), gga_buffer_.size(), 0);
-                if (ret < 0) {
-                    std::cerr << "Error: Could not send GGA data to server" << std::endl;
-                    Cleanup();
-                    return false;
-                }
+        return;
+    }
+
+    // hand complete frames to the consumer
+    StreamFormat format = framer_.format();
+    PushFrames(reinterpret_cast<const uint8_t*>(data), size);
+    if (framer_.format() != format) {
+        status_dirty_ = true;
+        checkpoint_version_++;
+        EVENT_LOG(LogLevel::kInfo, "%s format %s", mountpoint_, stream_format_name(framer_.format()));
+    }
+}
+
+/**
+ * @brief Counts a burst of received data and resizes the kernel receive buffer to fit the recent peak.
+ *
+ * The peak decays by 1/16 per burst, so a buffer grows on the first large burst and shrinks
+ * only after many small ones, and only once it is four times larger than needed.
+ */
+void NtripClient::SizeReceiveBuffer(size_t burst) {
+    peak_burst_ = std::max(burst, peak_burst_ - peak_burst_ / 16);
+    if (++bursts_ < receive_sizing_bursts || handle_ < 0) {
+        return;
+    }
+    size_t target = min_receive_buffer;
+    while (target < peak_burst_ * receive_headroom && target < max_receive_buffer) {
+        target *= 2;
+    }
+    if (receive_request_ != 0 && target <= receive_request_ && target * 4 > receive_request_) {
+        return;
+    }
+    receive_request_ = target;
+    checkpoint_version_++;
+    size_t size = transport_->SetReceiveBuffer(handle_, target);
+    if (size > 0) {
+        receive_buffer_ = size;
+    }
+    EVENT_LOG(LogLevel::kDebug, "%s receive buffer %d bytes for bursts of %d", mountpoint_, static_cast<int>(size),
+              static_cast<int>(peak_burst_));
+}
+
+/**
+ * @brief Frames received bytes; batching, passes the batch at the end of the read unless an epoch is open.
+ */
+void NtripClient::PushFrames(const uint8_t* data, size_t size) {
+    if (!batch_callback_) {
+        framer_.Push(data, size, deliver_frame_);
+        return;
+    }
+    // frames within the read are only referenced; those the batch keeps past it are copied by Detach()
+    batcher_.Attach(data, size);
+    framer_.Push(data, size, frame_callback_ || arrival_stats_ ? deliver_frame_ : collect_frame_);
+    if (batch_mode_ == BatchMode::kPerRead || !epoch_open_) {
+        FlushBatch();
+    }
+    batcher_.Detach();
+}
+
+/**
+ * @brief Passes one frame from the framer to the frame callback, timing the dispatch, then collects it.
+ */
+void NtripClient::DeliverFrame(const uint8_t* frame, size_t size) {
+    frame_timing_.dispatch = tsc_->Ticks();
+    if (arrival_stats_) {
+        arrival_stats_->OnFrame(framer_.MessageType(frame, size), size, tsc_->ToNs(frame_timing_.arrival) / 1000);
+    }
+    if (frame_callback_) {
+        frame_callback_(frame, size);
+    }
+    uint64_t done = tsc_->Ticks();
+    framing_ns_max_ = std::max(framing_ns_max_, tsc_->ElapsedNs(frame_timing_.arrival, frame_timing_.dispatch));
+    int64_t delivery = tsc_->ElapsedNs(frame_timing_.dispatch, done);
+    delivery_ns_max_ = std::max(delivery_ns_max_, delivery);
+    delivery_ns_total_ += delivery;
+    CollectFrame(frame, size);
+}
+
+/**
+ * @brief Keeps the station description frames and adds the frame to the batch, if batching.
+ *
+ * With only a batch callback installed, the framer calls this directly: the frame costs no
+ * clock reads or per frame statistics, FlushBatch() times the batch as a whole.
+ */
+void NtripClient::CollectFrame(const uint8_t* frame, size_t size) {
+    bool epoch_end = false;
+    if (framer_.format() == StreamFormat::kRtcm3) {
+        int type = rtcm3_message_type(frame, size);
+        if ((type >= 1005 && type <= 1008) || type == 1033) {
+            CacheStationFrame(type, frame, size);
+        } else if (batch_mode_ == BatchMode::kPerEpoch && batch_callback_ && type >= 1071 && type <= 1137) {
+            epoch_open_ = rtcm3_msm_multiple(frame, size);
+            epoch_end = !epoch_open_;
+        }
+    }
+    if (!batch_callback_) {
+        return;
+    }
+    batcher_.Add(frame, size);
+    if (epoch_end || batcher_.bytes() >= frame_batch_max_bytes) {
+        FlushBatch();
+    }
+}
+
+/**
+ * @brief Passes the batch of a connection that ended; the rest of an open epoch is not coming.
+ */
+void NtripClient::EndEpoch() {
+    FlushBatch();
+    epoch_open_ = false;
+}
+
+/**
+ * @brief Passes the frames collected for the batch callback, timing the dispatch.
+ */
+void NtripClient::FlushBatch() {
+    if (batcher_.empty()) {
+        return;
+    }
+    uint64_t start = tsc_->Ticks();
+    framing_ns_max_ = std::max(framing_ns_max_, tsc_->ElapsedNs(frame_timing_.arrival, start));
+    batcher_.Flush(batch_callback_);
+    int64_t delivery = tsc_->ElapsedNs(start, tsc_->Ticks());
+    delivery_ns_max_ = std::max(delivery_ns_max_, delivery);
+    delivery_ns_total_ += delivery;
+}
+
+/**
+ * @brief Keeps the latest frame of each station description message for the checkpoint.
+ *
+ * Casters repeat these every few seconds, mostly unchanged, so an identical frame costs
+ * one comparison and only a changed one rebuilds the cache.
+ */
+void NtripClient::CacheStationFrame(int type, const uint8_t* frame, size_t size) {
+    const uint8_t* cached = reinterpret_cast<const uint8_t*>(station_frames_.data());
+    std::string frames;
+    for (size_t pos = 0; pos + rtcm3_header_size <= station_frames_.size();) {
+        size_t cached_size = rtcm3_header_size + rtcm3_payload_length(cached + pos) + rtcm3_crc_size;
+        if (pos + cached_size > station_frames_.size()) {
+            break;
+        }
+        if (rtcm3_message_type(cached + pos, cached_size) == type) {
+            if (cached_size == size && memcmp(cached + pos, frame, size) == 0) {
+                return;
             }
+        } else {
+            frames.append(reinterpret_cast<const char*>(cached + pos), cached_size);
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        pos += cached_size;
+    }
+    if (frames.size() + size > checkpoint_metadata_size) {
+        return;
     }
+    frames.append(reinterpret_cast<const char*>(frame), size);
+    station_frames_.swap(frames);
+    checkpoint_version_++;
+}
 
-    Cleanup();
-    std::cout << "NtripClient service done." << std::endl;
+/**
+ * @brief Sends the latest GGA message, if any.
+ * 
+ * @return false if the connection failed; a full send buffer skips this report.
+ */
+bool NtripClient::SendGGA() {
+    std::string gga;
+    {
+        std::lock_guard<std::mutex> lock(gga_mutex_);
+        gga = gga_buffer_;
+    }
+    if (gga.empty()) {
+        return true;
+    }
+    ssize_t ret = transport_->Send(handle_, gga.c_str(), gga.size());
+    if (ret == Transport::kError) {
+        return false;
+    }
+    gga_sent_ += ret > 0 ? 1 : 0;
+    EVENT_LOG(LogLevel::kDebug, "%s GGA %s, %zd bytes", mountpoint_, ret > 0 ? "sent" : "skipped", ret);
+    return true;
+}
+
+/**
+ * @brief Closes the connection and schedules a reconnect after the backoff time.
+ * 
+ * The backoff doubles with every consecutive failure, with up to 25% deterministic jitter so
+ * that streams dropped together by an outage do not reconnect in lockstep.
+ */
+void NtripClient::Fail(int64_t now, Failure failure, const std::string& reason) {
+    if (!quiet_ && !event_log_enabled()) {
+        std::cerr << reason << std::endl;
+    }
+    transport_->Close(handle_);
+    handle_ = -1;
+    receive_buffer_ = 0;
+    EndEpoch();
+    int64_t backoff = std::min(backoff_max_us, backoff_min_us << std::min(failures_, 16));
+    backoff_seed_ ^= backoff_seed_ << 13;
+    backoff_seed_ ^= backoff_seed_ >> 7;
+    backoff_seed_ ^= backoff_seed_ << 17;
+    backoff += static_cast<int64_t>(backoff_seed_ % static_cast<uint64_t>(backoff / 4 + 1));
+    failures_++;
+    reconnects_++;
+    last_failure_ = failure;
+    checkpoint_version_++;
+    SetState(State::kBackoff, now);
+    deadline_ = now + backoff;
+    last_error_at_ = now;
+    last_error_ = reason.compare(0, 7, "Error: ") == 0 ? reason.substr(7) : reason;
+    EVENT_LOG(LogLevel::kWarning, "%s failed: %s, attempt %d, retry in %.3f s", mountpoint_, last_error_, failures_,
+              backoff / 1e6);
+}
+
+/**
+ * @brief Cleans up the NtripClient, closing the socket if it is still open.
+ */
+void NtripClient::Cleanup() {
+    if (handle_ >= 0) {
+        transport_->Close(handle_);
+        handle_ = -1;
+        receive_buffer_ = 0;
+    }
+    EndEpoch();
+    if (state_ != State::kIdle) {
+        int64_t now = clock_->Now();
+        SetState(State::kIdle, now);
+        Publish(now);
+    }
+}
+
+/**
+ * @brief Changes the connection state, marking the status for publication.
+ */
+void NtripClient::SetState(State state, int64_t now) {
+    if (state != state_) {
+        state_ = state;
+        state_since_ = now;
+        status_dirty_ = true;
+    }
+}
+
+/**
+ * @brief Publishes the status snapshot for monitoring threads.
+ */
+void NtripClient::Publish(int64_t now) {
+    Status status;
+    status.state = state_;
+    status.failures = failures_;
+    status.state_since_us = state_since_;
+    status.deadline_us = state_ == State::kStreaming ? last_data_ + idle_timeout_us : deadline_;
+    status.last_data_us = last_received_;
+    status.last_error_us = last_error_at_;
+    status.published_us = now;
+    status.bytes_received = bytes_received_;
+    status.format = framer_.format();
+    status.frames = framer_.frames();
+    status.crc_errors = framer_.errors();
+    status.reconnects = reconnects_;
+    status.gga_sent = gga_sent_;
+    status.framing_ns_max = framing_ns_max_;
+    status.delivery_ns_max = delivery_ns_max_;
+    status.delivery_ns_total = delivery_ns_total_;
+    strncpy(status.last_error, last_error_.c_str(), sizeof(status.last_error) - 1);
+    status_.Write(status);
+    published_at_ = now;
+    status_dirty_ = false;
+}
+
+/**
+ * @brief The main thread handler for the NtripClient.
+ * 
+ * This function is responsible for handling the main body of the NtripClient service.
+ * It steps the connection whenever data arrives or a timer is due: receiving data,
+ * sending GGA data at regular intervals and reconnecting after failures.
+ * 
+ * @return true if the thread handler completes successfully, false otherwise.
+ */
+bool NtripClient::ThreadHandler() {
+    std::vector<int> ready;
+    while (running_) {
+        int64_t next = Step();
+        transport_->Wait(std::min(next - clock_->Now(), run_poll_us), &ready);
+    }
+    EVENT_LOG(LogLevel::kInfo, "%s client thread done", mountpoint_);
+    if (!quiet_ && !event_log_enabled()) {
+        std::cout << "NtripClient service done." << std::endl;
+    }
     return true;
 }
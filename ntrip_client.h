@@ -21,13 +21,87 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
+#pragma once
 
+#include "arrival_stats.h"
+#include "clock.h"
+#include "rtcm3.h"
+#include "seqlock.h"
+#include "stream_checkpoint.h"
+#include "stream_framer.h"
+#include "stream_handover.h"
+#include "transport.h"
+#include "tsc_clock.h"
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 
 class NtripClient {
 public:
 
+    /**
+     * @brief Connection state of the client.
+     */
+    enum class State { kIdle, kConnecting, kHandshake, kStreaming, kBackoff };
+
+    /**
+     * @brief Why the last connection attempt or stream ended.
+     */
+    enum class Failure : uint8_t {
+        kNone,
+        kConnect,  // the connection could not be opened or broke before the caster answered
+        kTimeout,  // connecting plus the caster response took longer than the handshake timeout
+        kRejected,  // the caster answered with an error status, see response_code()
+        kStream,  // the stream broke or went idle after it started
+    };
+
+    /**
+     * @brief Decides whether a connection attempt may start at a clock time.
+     *
+     * Returns that time or an earlier one to go ahead, or a later time to ask again at.
+     */
+    using ConnectGate = std::function<int64_t(int64_t now)>;
+
+    /**
+     * @brief When the batch callback is called, see SetBatchCallback().
+     */
+    enum class BatchMode : uint8_t {
+        kPerRead,  // once per socket read that completed frames
+        kPerEpoch,  // once per complete MSM epoch; other frames per read while no epoch is open
+    };
+
+    /**
+     * @brief Snapshot of the connection health, published by the client for monitoring threads.
+     *
+     * Times are clock microseconds. The snapshot is republished on every state change and
+     * at least every status_interval_us while the client is stepped.
+     */
+    struct Status {
+        State state = State::kIdle;
+        StreamFormat format = StreamFormat::kUnknown;
+        int failures = 0;  // consecutive failed attempts
+        int64_t state_since_us = 0;  // time of the last state change
+        int64_t deadline_us = 0;  // handshake timeout or end of the backoff
+        int64_t last_data_us = -1;  // time correction data was last received, -1 if never
+        int64_t last_error_us = -1;  // time of the last failure, -1 if none
+        int64_t published_us = 0;
+        uint64_t bytes_received = 0;
+        uint64_t frames = 0;
+        uint64_t crc_errors = 0;  // CRC, parity or checksum failures of the detected format
+        uint64_t reconnects = 0;
+        uint64_t gga_sent = 0;
+        int64_t framing_ns_max = 0;  // longest time from the read completing a frame to its dispatch
+        int64_t delivery_ns_max = 0;  // longest frame or batch callback
+        uint64_t delivery_ns_total = 0;
+        char last_error[128] = {};  // cause of the last failure, truncated
+    };
+
     /**
      * @brief Default constructor for NtripClient.
      */
@@ -93,35 +167,372 @@ public:
      */
     void UpdateGGA(std::string gga);
 
+    /**
+     * @brief Sets the callback invoked with every checked frame received from the server.
+     * 
+     * The stream format is detected from the data (see StreamFramer) and format() tells which
+     * it is. Frames are passed whole, RTCM 2 messages as their parity stripped words.
+     * Without a callback the received data is printed as hex.
+     * 
+     * @param callback The callback, called from the client thread.
+     */
+    void SetFrameCallback(Rtcm3Framer::FrameCallback callback);
+
+    /**
+     * @brief Sets a callback invoked with the checked frames in batches instead of one at a time.
+     * 
+     * The frames are valid during the call. Those that lie within one read point into the
+     * receive buffer; only a frame split across reads, or held by a batch past its read, is
+     * copied. Per read, a batch holds every frame the read completed; per epoch, the frames up
+     * to and including the MSM message that ends an epoch, so an epoch is never split, while
+     * frames arriving outside an epoch are still passed at the end of their read. A batch is
+     * also passed once it holds 64 KiB. Without a frame callback or arrival statistics, frames
+     * skip the per frame dispatch timing, which is then taken once per batch. May be combined
+     * with the frame callback, which sees each frame first.
+     * 
+     * @param callback The callback, called from the client thread.
+     * @param mode When to pass a batch.
+     */
+    void SetBatchCallback(FrameBatcher::BatchCallback callback, BatchMode mode = BatchMode::kPerRead);
+
+    /**
+     * @brief Fixes the format of the correction stream instead of detecting it.
+     * 
+     * @param format The format, kUnknown to detect it from the data (the default).
+     */
+    void SetStreamFormat(StreamFormat format);
+
+    /**
+     * @brief Starts recording inter-arrival and burst statistics of the received frames.
+     * 
+     * Must be called before Run() or Start(). Costs about 20 KB per client.
+     * 
+     * @param burst_gap_us Arrival gap that starts a new burst of frames.
+     */
+    void EnableArrivalStats(int64_t burst_gap_us = 100000);
+
+    /**
+     * @brief Returns the arrival statistics, nullptr unless enabled; readable from any thread.
+     */
+    const ArrivalStats* arrival_stats() const { return arrival_stats_.get(); }
+
+    /**
+     * @brief Uses an external clock and transport instead of the system clock and sockets.
+     * 
+     * Must be called before Run() or Start(). Both objects must outlive the client.
+     * 
+     * @param clock The time source for timeouts, GGA cadence and backoff.
+     * @param transport The network used for the caster connection.
+     */
+    void SetEnvironment(Clock* clock, Transport* transport);
+
+    /**
+     * @brief Suppresses the informational and error output, e.g. for large simulations.
+     */
+    void SetQuiet(bool quiet);
+
+    /**
+     * @brief Asks a gate before every connection attempt, e.g. for per-caster admission control.
+     *
+     * While the gate holds a client back it stays in kBackoff.
+     */
+    void SetConnectGate(ConnectGate gate);
+
+    /**
+     * @brief Ends a running backoff at another time, e.g. when admission control paces the retries.
+     */
+    void RetryAt(int64_t time);
+
+    /**
+     * @brief Copies the state worth keeping across a process restart; the owner adds the address.
+     */
+    void SaveCheckpoint(StreamCheckpoint* checkpoint) const;
+
+    /**
+     * @brief Restores state saved by SaveCheckpoint(), before Start().
+     *
+     * The stream format becomes a hint that its first checked frame confirms, the learned
+     * receive buffer is applied to the first connection and the backoff continues where it
+     * was. Start() then delivers the cached station description frames to the frame callback
+     * so the consumer knows the station before the caster repeats them.
+     */
+    void RestoreCheckpoint(const StreamCheckpoint& checkpoint);
+
+    /**
+     * @brief Gives up a streaming connection with the state to resume it, for a binary upgrade.
+     *
+     * The socket is released from the transport without being closed and the client goes idle.
+     * The owner adds the key.
+     *
+     * @return false, leaving the client as it was, unless it is streaming.
+     */
+    bool HandOver(HandedStream* stream);
+
+    /**
+     * @brief Continues a stream handed over by another process, in place of Start().
+     *
+     * The client streams on the adopted connection without a handshake, its framer resumes
+     * from the handed pending bytes and the checkpointed state is restored as by
+     * RestoreCheckpoint(), station frames included.
+     *
+     * @param handle The transport handle of the adopted socket.
+     */
+    void Resume(int handle, const HandedStream& stream);
+
+    /**
+     * @brief Starts connecting without a client thread; the owner then calls Step().
+     * 
+     * Used by an event loop such as NtripManager that drives many clients.
+     */
+    void Start();
+
+    /**
+     * @brief Advances the connection state machine without blocking.
+     * 
+     * Call when the transport reports the connection handle as ready or when the returned
+     * time has been reached. Calling early is harmless.
+     * 
+     * @return The clock time in microseconds the client next needs to run, INT64_MAX if idle.
+     */
+    int64_t Step();
+
+    /**
+     * @brief Returns the bytes held by the client waiting for more data: a partial frame or response.
+     */
+    size_t BufferedBytes() const;
+
+    /**
+     * @brief Returns the approximate memory owned by the client, including its buffers.
+     */
+    size_t MemoryUsage() const;
+
+    /**
+     * @brief Returns the kernel receive buffer of the connection, 0 without one.
+     *
+     * Starts at the kernel default and is then sized from the largest recent bursts of data,
+     * so a 1 Hz base station holds a few KiB while a network stream gets room for its epochs.
+     */
+    size_t receive_buffer() const { return receive_buffer_; }
+
+    /**
+     * @brief TscClock ticks of a received frame.
+     */
+    struct FrameTiming {
+        uint64_t arrival = 0;  // the read that completed the frame returned
+        uint64_t dispatch = 0;  // the framer handed the frame to the callback
+    };
+
+    /**
+     * @brief Returns the timing of the frame being delivered; valid inside the frame callback.
+     */
+    const FrameTiming& frame_timing() const { return frame_timing_; }
+
+    /**
+     * @brief Returns the latest published status; lock-free and safe to call from any thread.
+     */
+    Status status() const { return status_.Read(); }
+
+    State state() const { return state_; }
+    StreamFormat format() const { return framer_.format(); }
+    const std::string& host() const { return host_; }
+    const std::string& port() const { return port_; }
+    const std::string& mountpoint() const { return mountpoint_; }
+    int handle() const { return handle_; }
+    uint64_t bytes_received() const { return bytes_received_; }
+    uint64_t reconnects() const { return reconnects_; }
+    uint64_t gga_sent() const { return gga_sent_; }
+    Failure last_failure() const { return last_failure_; }
+    int response_code() const { return response_code_; }  // of the last rejection, 0 if unknown
+    uint64_t checkpoint_version() const { return checkpoint_version_; }  // changes with the checkpointed state
+    const std::string& station_frames() const { return station_frames_; }  // latest RTCM3 1005 to 1008 and 1033
+    const StreamFramer& framer() const { return framer_; }
+
 private:
 
     /**
-     * @brief Cleans up the NtripClient, closing the socket if it is still open.
+     * @brief The client thread started by Run(), stepping the client until Stop().
      */
     bool ThreadHandler();
 
+    /**
+     * @brief Opens the connection and arms the handshake timeout.
+     */
+    void Connect(int64_t now);
+
+    /**
+     * @brief Connects if the connect gate lets the client, otherwise waits in kBackoff.
+     */
+    void TryConnect(int64_t now);
+
+    /**
+     * @brief Sends the NTRIP request once the connection is established.
+     */
+    bool SendRequest();
+
+    /**
+     * @brief Reads the caster response, switching to streaming on success.
+     */
+    void ReadHandshake(int64_t now);
+
+    /**
+     * @brief Reads correction data until the transport has none left.
+     */
+    void ReadStream(int64_t now);
+
+    /**
+     * @brief Passes received correction data to the framer or prints it.
+     */
+    void HandleData(const char* data, size_t size);
+
+    /**
+     * @brief Counts a burst of received data and resizes the kernel receive buffer to fit the recent peak.
+     */
+    void SizeReceiveBuffer(size_t burst);
+
+    /**
+     * @brief Frames received bytes; batching, passes the batch at the end of the read unless an epoch is open.
+     */
+    void PushFrames(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Passes one frame from the framer to the frame callback, timing the dispatch, then collects it.
+     */
+    void DeliverFrame(const uint8_t* frame, size_t size);
+
+    /**
+     * @brief Keeps the station description frames and adds the frame to the batch, if batching.
+     */
+    void CollectFrame(const uint8_t* frame, size_t size);
+
+    /**
+     * @brief Keeps the latest frame of each station description message for the checkpoint.
+     */
+    void CacheStationFrame(int type, const uint8_t* frame, size_t size);
+
+    /**
+     * @brief Passes the frames collected for the batch callback, timing the dispatch.
+     */
+    void FlushBatch();
+
+    /**
+     * @brief Passes the batch of a connection that ended; the rest of an open epoch is not coming.
+     */
+    void EndEpoch();
+
+    /**
+     * @brief Delivers the cached station description frames to the frame callbacks, once after a restore.
+     */
+    void ReplayStationFrames();
+
+    /**
+     * @brief Sends the latest GGA message, if any.
+     */
+    bool SendGGA();
+
+    /**
+     * @brief Closes the connection and schedules a reconnect after the backoff time.
+     */
+    void Fail(int64_t now, Failure failure, const std::string& reason);
+
     /**
      * @brief Cleans up the NtripClient, closing the socket if it is still open.
      */
     void Cleanup();
 
+    /**
+     * @brief Changes the connection state, marking the status for publication.
+     */
+    void SetState(State state, int64_t now);
+
+    /**
+     * @brief Publishes the status snapshot for monitoring threads.
+     */
+    void Publish(int64_t now);
+
     //connection details
     std::string host_;
     std::string port_;
     std::string mountpoint_;
     std::string username_;
     std::string password_;
-    int sockfd_ = -1;
+
+    //time source and network, owned by the client unless injected
+    Clock* clock_ = nullptr;
+    Transport* transport_ = nullptr;
+    std::unique_ptr<Clock> own_clock_;
+    std::unique_ptr<Transport> own_transport_;
+    int handle_ = -1;
 
     //buffer to hold the latest gga message
     std::string gga_buffer_;
+    mutable std::mutex gga_mutex_;
+
+    //connection state machine, times in clock microseconds
+    State state_ = State::kIdle;
+    int64_t deadline_ = 0;  // handshake timeout or end of the backoff
+    int64_t next_gga_ = 0;
+    int64_t last_data_ = 0;
+    int failures_ = 0;  // consecutive failed attempts, drives the backoff
+    Failure last_failure_ = Failure::kNone;
+    int response_code_ = 0;
+    ConnectGate connect_gate_;
+    uint64_t backoff_seed_ = 0;
+    std::string response_;
+    bool quiet_ = false;
+
+    //kernel receive buffer sizing, kept across reconnects
+    size_t burst_bytes_ = 0;  // data read since the last gap
+    int64_t burst_last_ = -1;
+    size_t peak_burst_ = 0;  // largest recent burst, decaying
+    int bursts_ = 0;
+    size_t receive_request_ = 0;  // 0 while the kernel default applies
+    size_t receive_buffer_ = 0;  // in effect on the current connection
+
+    //published health, written only by the thread stepping the client
+    int64_t state_since_ = 0;
+    int64_t last_received_ = -1;
+    int64_t last_error_at_ = -1;
+    std::string last_error_;
+    int64_t published_at_ = 0;
+    bool status_dirty_ = true;
+    SeqLock<Status> status_;
+
+    //counters
+    uint64_t bytes_received_ = 0;
+    uint64_t reconnects_ = 0;
+    uint64_t gga_sent_ = 0;
+
+    //splits the received byte stream into frames of the detected protocol
+    StreamFramer framer_;
+    Rtcm3Framer::FrameCallback frame_callback_;
+    Rtcm3Framer::FrameCallback deliver_frame_ = [this](const uint8_t* frame, size_t size) {
+        DeliverFrame(frame, size);
+    };
+    Rtcm3Framer::FrameCallback collect_frame_ = [this](const uint8_t* frame, size_t size) {
+        CollectFrame(frame, size);
+    };
+    FrameBatcher::BatchCallback batch_callback_;
+    BatchMode batch_mode_ = BatchMode::kPerRead;
+    FrameBatcher batcher_;
+    bool epoch_open_ = false;  // the last MSM frame announced more for its epoch
+    std::unique_ptr<ArrivalStats> arrival_stats_;
+
+    //per frame timestamps, ticks of the calibrated counter
+    const TscClock* tsc_ = &TscClock::Get();
+    FrameTiming frame_timing_;
+    int64_t framing_ns_max_ = 0;
+    int64_t delivery_ns_max_ = 0;
+    uint64_t delivery_ns_total_ = 0;
+
+    //state kept across process restarts
+    std::string station_frames_;  // back to back, one per message type
+    uint64_t checkpoint_version_ = 0;
+    bool restored_ = false;  // until Start(), which keeps the restored backoff
 
     //thread to handle the main body of the client
     std::thread thread_;
 
     //flags to track the state of the client
     bool initialized_ = false;
-    bool connected_ = false;
-    bool authenticated_ = false;
-    bool running_ = false;
+    std::atomic<bool> running_{false};
 };
@@ -0,0 +1,267 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+constexpr int default_port = 2110;
+constexpr int64_t default_timeout_ms = 3000;  // a node that sends nothing for this long has left
+constexpr int poll_ms = 100;
+constexpr size_t max_line = 1024;
+
+bool run = true;
+
+/**
+ * @brief Signal handler for SIGINT.
+ *
+ * @param signal The signal number.
+ */
+void signal_handler(int signal) {
+    run = false;
+}
+
+/**
+ * @brief Returns the monotonic time in milliseconds.
+ */
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: ntrip_coord [options]\n"
+              << "  -l port     listen for hub nodes on this port (default 2110)\n"
+              << "  -t ms       drop a node that sent nothing for this long (default 3000)\n"
+              << "\n"
+              << "Keeps the member list of an ntrip_hub cluster. Nodes send 'HELLO name', 'PING',\n"
+              << "'UP key', 'LEAVE' and 'SYNC' lines; every node gets 'MEMBERS epoch name...' when the\n"
+              << "list changes or it asks with SYNC, and 'UP name key' when another node has taken over\n"
+              << "a stream. A node that sent LEAVE is no member but still hears and sends UP lines.\n";
+}
+
+/**
+ * @brief A connected hub node.
+ */
+struct Node {
+    int fd = -1;
+    std::string name;  // empty until HELLO
+    bool member = false;  // named and not leaving
+    std::string in;
+    std::string out;
+    int64_t last_seen_ms = 0;
+};
+
+/**
+ * @brief Queues a line for every named node except one.
+ */
+static void broadcast(std::vector<Node>& nodes, const std::string& line, const Node* except) {
+    for (Node& node : nodes) {
+        if (&node != except && !node.name.empty() && node.fd >= 0) {
+            node.out += line;
+        }
+    }
+}
+
+/**
+ * @brief Returns the member list line of the current epoch.
+ */
+static std::string members_line(const std::vector<Node>& nodes, uint64_t epoch) {
+    std::vector<std::string> names;
+    for (const Node& node : nodes) {
+        if (node.member && node.fd >= 0) {
+            names.push_back(node.name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    std::string line = "MEMBERS " + std::to_string(epoch);
+    for (const std::string& name : names) {
+        line += " " + name;
+    }
+    return line + "\n";
+}
+
+/**
+ * @brief Handles one line from a node.
+ *
+ * @return true if the member list changed.
+ */
+static bool handle_line(std::vector<Node>& nodes, Node& node, const std::string& line, uint64_t epoch) {
+    if (line.compare(0, 6, "HELLO ") == 0 && node.name.empty()) {
+        std::string name = line.substr(6);
+        bool taken = name.empty() || name.find(' ') != std::string::npos;
+        for (const Node& other : nodes) {
+            taken = taken || (other.fd >= 0 && other.name == name);
+        }
+        if (taken) {
+            node.out += "ERROR name missing or in use\n";
+            return false;
+        }
+        node.name = name;
+        node.member = true;
+        return true;
+    }
+    if (node.name.empty()) {
+        return false;
+    }
+    if (line.compare(0, 3, "UP ") == 0) {
+        broadcast(nodes, "UP " + node.name + " " + line.substr(3) + "\n", &node);
+    } else if (line == "LEAVE" && node.member) {
+        std::cout << node.name << " leaving" << std::endl;
+        node.member = false;
+        return true;
+    } else if (line == "SYNC") {
+        node.out += members_line(nodes, epoch);  // e.g. for a hub that took over the connection
+    }
+    return false;  // PING only keeps the node alive
+}
+
+/**
+ * @brief Main function for the hub cluster coordinator.
+ *
+ * @return 0 if the program exits successfully.
+ */
+int main(int argc, char** argv) {
+    int port = default_port;
+    int64_t timeout_ms = default_timeout_ms;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "-l") {
+            port = atoi(argv[++i]);
+        } else if (arg == "-t") {
+            timeout_ms = atoll(argv[++i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 64) < 0) {
+        std::cerr << "Error: Could not listen on port " << port << std::endl;
+        return 1;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::cout << "Coordinator listening on port " << port << std::endl;
+
+    std::vector<Node> nodes;
+    uint64_t epoch = 0;
+    while (run) {
+        std::vector<struct pollfd> fds;
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const Node& node : nodes) {
+            fds.push_back({node.fd, static_cast<short>(POLLIN | (node.out.empty() ? 0 : POLLOUT)), 0});
+        }
+        poll(fds.data(), fds.size(), poll_ms);
+        int64_t now = now_ms();
+
+        bool changed = false;
+        for (size_t i = 1; i < fds.size(); i++) {
+            Node& node = nodes[i - 1];
+            bool alive = now - node.last_seen_ms < timeout_ms;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buf[4096];
+                ssize_t ret = recv(node.fd, buf, sizeof(buf), MSG_DONTWAIT);
+                if (ret == 0 || (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    alive = false;
+                } else if (ret > 0) {
+                    node.last_seen_ms = now;
+                    node.in.append(buf, ret);
+                    size_t end;
+                    while ((end = node.in.find('\n')) != std::string::npos) {
+                        changed = handle_line(nodes, node, node.in.substr(0, end), epoch) || changed;
+                        node.in.erase(0, end + 1);
+                    }
+                    alive = node.in.size() <= max_line;
+                }
+            }
+            if (alive && !node.out.empty()) {
+                ssize_t ret = send(node.fd, node.out.data(), node.out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (ret > 0) {
+                    node.out.erase(0, ret);
+                } else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    alive = false;
+                }
+            }
+            if (!alive) {
+                if (!node.name.empty()) {
+                    std::cout << node.name << " left" << std::endl;
+                    changed = changed || node.member;
+                }
+                close(node.fd);
+                node.fd = -1;
+            }
+        }
+        nodes.erase(std::remove_if(nodes.begin(), nodes.end(), [](const Node& node) { return node.fd < 0; }),
+                    nodes.end());
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                Node node;
+                node.fd = fd;
+                node.last_seen_ms = now;
+                nodes.push_back(node);
+            }
+        }
+
+        if (changed) {
+            std::string line = members_line(nodes, ++epoch);
+            broadcast(nodes, line, nullptr);
+            std::cout << line << std::flush;
+        }
+    }
+    for (Node& node : nodes) {
+        close(node.fd);
+    }
+    close(listen_fd);
+    return 0;
+}
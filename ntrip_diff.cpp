@@ -0,0 +1,281 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "clock.h"
+#include "nmea.h"
+#include "ntrip_manager.h"
+#include "stream_checkpoint.h"
+#include "stream_diff.h"
+#include "transport.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+constexpr int64_t loop_wait_us = 100000;
+constexpr int64_t expire_interval_us = 100000;
+
+std::atomic<bool> run{true};
+
+/**
+ * @brief Signal handler for SIGINT and SIGTERM.
+ * 
+ * @param signal The signal number.
+ */
+void signal_handler(int signal) {
+    run = false;
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: ntrip_diff -s copies.txt [options]\n"
+              << "  -s file          one 'station host port mountpoint [username [password]]' per line;\n"
+              << "                   the lines of one station are copies of it on different casters\n"
+              << "  -i seconds       print the comparison this often (default 10, 0 only on exit)\n"
+              << "  -w ms            how long a message waits for its other copies (default 5000)\n"
+              << "  -d               list only the stations whose copies diverged\n"
+              << "  -a               admission control: limit concurrent handshakes per caster\n"
+              << "  -g lat,lon,alt   position reported to the casters as GGA\n"
+              << "  -q               quiet, no per stream messages\n";
+}
+
+/**
+ * @brief One copy of a station, as read from the list.
+ */
+struct CopySpec {
+    std::string station;
+    std::string host;
+    std::string port;
+    std::string mountpoint;
+    std::string username;
+    std::string password;
+};
+
+/**
+ * @brief The copies of one station and their comparison.
+ */
+struct Station {
+    std::string name;
+    std::vector<const CopySpec*> copies;
+    std::unique_ptr<StreamDiff> diff;
+};
+
+/**
+ * @brief Reads the list of station copies.
+ *
+ * @return false if the file cannot be read or a line is malformed.
+ */
+static bool load_copies(const std::string& path, std::vector<CopySpec>* specs) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(file, line)) {
+        number++;
+        std::istringstream fields(line);
+        CopySpec spec;
+        if (!(fields >> spec.station) || spec.station[0] == '#') {
+            continue;
+        }
+        if (!(fields >> spec.host >> spec.port >> spec.mountpoint)) {
+            std::cerr << "Error: " << path << ":" << number << ": expected station host port mountpoint" << std::endl;
+            return false;
+        }
+        fields >> spec.username >> spec.password;
+        specs->push_back(spec);
+    }
+    return true;
+}
+
+/**
+ * @brief Raises the open file limit to the hard limit, one socket per copy.
+ */
+static void raise_file_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/**
+ * @brief Prints the comparison of every station, or only of those that diverged.
+ */
+static void print_report(const std::vector<Station>& stations, bool diverged_only) {
+    size_t diverged = 0;
+    std::string out;
+    for (const Station& station : stations) {
+        bool differs = station.diff->diverged();
+        diverged += differs ? 1 : 0;
+        if (differs || !diverged_only) {
+            out += "== " + station.name + (differs ? " (diverged)" : "") + ": " + station.diff->Report();
+        }
+    }
+    std::cout << out << diverged << " of " << stations.size() << " stations diverged" << std::endl;
+}
+
+/**
+ * @brief Main function for the cross-caster stream comparer.
+ *
+ * @return 0 if the program exits successfully.
+ */
+int main(int argc, char** argv) {
+    std::string copy_file;
+    int64_t report_us = 10000000;
+    int64_t window_us = diff_window_us;
+    bool diverged_only = false;
+    bool admission = false;
+    bool quiet = false;
+    std::string gga;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-d") {
+            diverged_only = true;
+            continue;
+        } else if (arg == "-a") {
+            admission = true;
+            continue;
+        } else if (arg == "-q") {
+            quiet = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-s") {
+            copy_file = value;
+        } else if (arg == "-i") {
+            report_us = static_cast<int64_t>(atof(value.c_str()) * 1000000);
+        } else if (arg == "-w") {
+            window_us = static_cast<int64_t>(atof(value.c_str()) * 1000);
+        } else if (arg == "-g") {
+            double lat, lon, alt;
+            if (sscanf(value.c_str(), "%lf,%lf,%lf", &lat, &lon, &alt) != 3) {
+                usage();
+                return 1;
+            }
+            gga = generage_gga_message(lat, lon, alt);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (copy_file.empty() || window_us <= 0) {
+        usage();
+        return 1;
+    }
+
+    raise_file_limit();
+    std::vector<CopySpec> specs;
+    if (!load_copies(copy_file, &specs)) {
+        return 1;
+    }
+    std::vector<Station> stations;
+    for (const CopySpec& spec : specs) {
+        auto found = std::find_if(stations.begin(), stations.end(),
+                                  [&spec](const Station& station) { return station.name == spec.station; });
+        if (found == stations.end()) {
+            stations.emplace_back();
+            stations.back().name = spec.station;
+            found = stations.end() - 1;
+        }
+        if (found->copies.size() >= static_cast<size_t>(diff_max_copies)) {
+            std::cerr << "Error: " << spec.station << " has more than " << diff_max_copies << " copies" << std::endl;
+            return 1;
+        }
+        found->copies.push_back(&spec);
+    }
+
+    SystemClock clock;
+    SocketTransport transport;
+    NtripManager manager(&clock, &transport);
+    if (admission) {
+        manager.EnableAdmissionControl();
+    }
+    for (Station& station : stations) {
+        if (station.copies.size() < 2) {
+            std::cerr << "Warning: " << station.name << " has one copy, nothing to compare it with" << std::endl;
+        }
+        std::vector<std::string> names;
+        for (const CopySpec* spec : station.copies) {
+            names.push_back(stream_key(spec->host, spec->port, spec->mountpoint));
+        }
+        station.diff.reset(new StreamDiff(names, window_us));
+        StreamDiff* diff = station.diff.get();
+        for (size_t copy = 0; copy < station.copies.size(); copy++) {
+            const CopySpec& spec = *station.copies[copy];
+            int id = manager.AddStream(spec.host, spec.port, spec.mountpoint, spec.username, spec.password);
+            NtripClient& client = manager.stream(id);
+            client.SetQuiet(quiet);
+            int index = static_cast<int>(copy);
+            client.SetFrameCallback([diff, index, &clock](const uint8_t* frame, size_t size) {
+                diff->OnFrame(index, frame, size, clock.Now());
+            });
+            if (!gga.empty()) {
+                client.UpdateGGA(gga);
+            }
+        }
+    }
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    manager.StartAll();
+    std::cout << "Comparing " << stations.size() << " stations from " << specs.size()
+              << " streams. Press Ctrl+C to stop." << std::endl;
+
+    int64_t next_expire = clock.Now() + expire_interval_us;
+    int64_t next_report = report_us > 0 ? clock.Now() + report_us : INT64_MAX;
+    while (run) {
+        manager.RunOnce(loop_wait_us);
+        int64_t now = clock.Now();
+        if (now >= next_expire) {
+            for (Station& station : stations) {
+                station.diff->Expire(now);
+            }
+            next_expire = now + expire_interval_us;
+        }
+        if (now >= next_report) {
+            print_report(stations, diverged_only);
+            next_report += report_us;
+        }
+    }
+    print_report(stations, diverged_only);
+    return 0;
+}
@@ -0,0 +1,903 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "archive_writer.h"
+#include "clock.h"
+#include "cluster_client.h"
+#include "cpu_topology.h"
+#include "event_log.h"
+#include "metrics_server.h"
+#include "nmea.h"
+#include "ntrip_manager.h"
+#include "shard_ring.h"
+#include "stream_handover.h"
+#include "stream_health.h"
+#include "stream_rollup.h"
+#include "stream_usage.h"
+#include "transport.h"
+#include "tsc_clock.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+constexpr int64_t loop_wait_us = 100000;
+constexpr int64_t gga_update_us = 1000000;
+constexpr int64_t traffic_sample_us = 1000000;
+constexpr int handover_poll_ms = 100;
+constexpr double default_load_bound = 0.25;  // cluster nodes run at most 25% more streams than the average
+constexpr int64_t max_drain_us = 30000000;  // a stream that moved away runs until its new owner streams, or this long
+
+std::atomic<bool> run{true};
+std::atomic<bool> workers_run{true};  // cleared by the main thread once the streams may stop
+std::atomic<bool> handing_over{false};  // a new process asked for the streams
+
+/**
+ * @brief Signal handler for SIGINT and SIGTERM.
+ * 
+ * @param signal The signal number.
+ */
+void signal_handler(int signal) {
+    run = false;
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: ntrip_hub -s streams.txt [options]\n"
+              << "  -s file          stream list, one 'host port mountpoint [username [password]]' per line\n"
+              << "  -m port          serve /metrics, /top, /health, /arrival, /workers, /archive and /trend\n"
+              << "  -w workers       event loop threads, each pinned to a CPU with its streams (default 1)\n"
+              << "  -c cpus          CPUs for the workers, e.g. 0-3,8-11 (default all); pins a single worker too\n"
+              << "  -a               admission control: limit concurrent handshakes per caster\n"
+              << "  -j gap_ms        record frame inter-arrival and burst statistics, bursts split at this gap\n"
+              << "  -g lat,lon,alt   position reported to the casters as GGA\n"
+              << "  -C file          checkpoint file: streams resume from the state saved by the last run\n"
+              << "  -U path          upgrade socket: take over the live streams of the hub listening there,\n"
+              << "                   then listen there for the next upgrade\n"
+              << "  -K host:port     cluster mode: share the stream list with the other hubs of this ntrip_coord\n"
+              << "  -N name          node name in the cluster (default the host name)\n"
+              << "  -B bound         cluster load bound above the average, e.g. 0.25 (default)\n"
+              << "  -A prefix        record every frame into archive files prefix-YYYYMMDD-HHMMSS-N.arc\n"
+              << "  -Y sync_ms       archive durability interval, one fdatasync for all streams (default 1000, 0 off)\n"
+              << "  -R s[,MiB]       start a new archive file after this many seconds or MiB (default 3600,1024)\n"
+              << "  -T file          per stream 1 s / 1 min / 1 h rollups of correction age, throughput and gaps,\n"
+              << "                   kept in this file across restarts and served on /trend\n"
+              << "  -L file          binary event log, read it with ntrip_logdump\n"
+              << "  -r n             streams in the usage report printed on exit (default 10)\n"
+              << "  -q               quiet, no per stream messages\n";
+}
+
+/**
+ * @brief One line of the stream list.
+ */
+struct StreamSpec {
+    std::string host;
+    std::string port;
+    std::string mountpoint;
+    std::string username;
+    std::string password;
+};
+
+/**
+ * @brief Settings shared by every worker.
+ */
+struct HubOptions {
+    bool quiet = false;
+    bool admission = false;
+    CheckpointFile* checkpoint = nullptr;
+    std::unordered_map<std::string, HandedStream>* handed = nullptr;  // by stream key, from the previous process
+    ArchiveWriter* archive = nullptr;
+    RollupFile* rollups = nullptr;
+    int num_workers = 1;
+    int64_t burst_gap_us = 0;
+    bool have_position = false;
+    double lat = 0.0;
+    double lon = 0.0;
+    double alt = 0.0;
+};
+
+/**
+ * @brief An event loop thread with its own transport, manager and streams.
+ *
+ * The thread pins itself before it creates anything, so its sockets' buffers, clients and
+ * frame sinks are allocated on the node of its CPU by first touch and processed there.
+ * Stream g of the list runs on worker g % workers as local stream g / workers.
+ */
+struct HubWorker {
+    int index = 0;
+    int cpu = -1;  // -1 when not pinned
+    int node = -1;  // NUMA node of the CPU, -1 when not pinned
+    std::vector<const StreamSpec*> specs;
+    std::unique_ptr<SocketTransport> transport;
+    std::unique_ptr<NtripManager> manager;
+    std::vector<uint64_t> frames;
+    std::vector<uint64_t> bytes_seen;  // per stream, at the last traffic sample
+    std::vector<HandedStream> handing;  // the streams to hand to the next process, once stopped
+    std::unique_ptr<std::atomic<bool>[]> wanted;  // per stream, whether it should run; set by the main thread
+    std::atomic<uint64_t> wanted_version{0};  // bumped after wanted changed
+    // bytes whose packets the kernel processed on the worker's node, another node, or an unknown CPU
+    std::atomic<uint64_t> local_bytes{0};
+    std::atomic<uint64_t> remote_bytes{0};
+    std::atomic<uint64_t> unknown_bytes{0};
+    std::thread thread;
+};
+
+using HubWorkers = std::vector<std::unique_ptr<HubWorker>>;
+
+/**
+ * @brief Reads the stream list; blank lines and lines starting with '#' are skipped.
+ *
+ * @return false if the file cannot be read or a line has fewer than three fields.
+ */
+static bool load_streams(const std::string& path, std::vector<StreamSpec>* specs) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(file, line)) {
+        number++;
+        std::istringstream fields(line);
+        StreamSpec spec;
+        if (!(fields >> spec.host) || spec.host[0] == '#') {
+            continue;
+        }
+        if (!(fields >> spec.port >> spec.mountpoint)) {
+            std::cerr << "Error: " << path << ":" << number << ": expected host port mountpoint" << std::endl;
+            return false;
+        }
+        fields >> spec.username >> spec.password;
+        specs->push_back(spec);
+    }
+    return true;
+}
+
+/**
+ * @brief Raises the open file limit to its hard maximum so thousands of streams fit.
+ */
+static void raise_file_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/**
+ * @brief Adds to a counter that only the worker thread writes, without a locked instruction.
+ */
+static void add_relaxed(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Attributes the bytes received since the last sample to the node that processed them.
+ *
+ * The kernel records on each socket the CPU that handled its last packet (SO_INCOMING_CPU);
+ * a sample per second is cheap and close enough for long lived streams.
+ */
+static void sample_traffic(HubWorker* worker, const CpuTopology& topology) {
+    for (int id = 0; id < worker->manager->num_streams(); id++) {
+        const NtripClient& client = worker->manager->stream(id);
+        uint64_t bytes = client.bytes_received();
+        uint64_t delta = bytes - worker->bytes_seen[id];
+        worker->bytes_seen[id] = bytes;
+        if (delta == 0) {
+            continue;
+        }
+        int cpu = worker->transport->IncomingCpu(client.handle());
+        if (cpu < 0 || worker->node < 0) {
+            add_relaxed(worker->unknown_bytes, delta);
+        } else if (topology.Node(cpu) == worker->node) {
+            add_relaxed(worker->local_bytes, delta);
+        } else {
+            add_relaxed(worker->remote_bytes, delta);
+        }
+    }
+}
+
+/**
+ * @brief Body of a worker thread: sets up its streams, then runs their event loop until stopped.
+ */
+static void run_worker(HubWorker* worker, const HubOptions& options, const CpuTopology& topology,
+                       std::atomic<int>* ready) {
+    if (worker->cpu >= 0 && pin_current_thread(worker->cpu)) {
+        worker->node = topology.Node(worker->cpu);
+    }
+    SystemClock clock;
+    worker->transport.reset(new SocketTransport());
+    worker->transport->SetIncomingCpu(worker->node >= 0 ? worker->cpu : -1);
+    worker->manager.reset(new NtripManager(&clock, worker->transport.get()));
+    NtripManager& manager = *worker->manager;
+    if (options.admission) {
+        manager.EnableAdmissionControl();
+    }
+    for (const StreamSpec* spec : worker->specs) {
+        manager.AddStream(spec->host, spec->port, spec->mountpoint, spec->username, spec->password);
+    }
+    if (options.checkpoint != nullptr) {
+        manager.EnableCheckpoint(options.checkpoint);
+    }
+    worker->frames.assign(manager.num_streams(), 0);
+    worker->bytes_seen.assign(manager.num_streams(), 0);
+    ArchiveWriter::Producer* producer = options.archive != nullptr ? options.archive->AddProducer() : nullptr;
+    for (int id = 0; id < manager.num_streams(); id++) {
+        NtripClient& client = manager.stream(id);
+        client.SetQuiet(options.quiet);
+        uint64_t* count = &worker->frames[id];
+        RollupFile* rollups = options.rollups;
+        if (producer != nullptr || rollups != nullptr) {
+            const StreamSpec& spec = *worker->specs[id];
+            uint32_t stream = static_cast<uint32_t>(id * options.num_workers + worker->index);
+            int slot = rollups != nullptr ? rollups->Slot(stream_key(spec.host, spec.port, spec.mountpoint)) : -1;
+            client.SetFrameCallback([count, producer, stream, rollups, slot, &client](const uint8_t* frame,
+                                                                                     size_t size) {
+                (*count)++;
+                // the arrival stamp the client took for the read, like the other per frame metrics
+                int64_t unix_us = TscClock::Get().ToRealtimeNs(client.frame_timing().arrival) / 1000;
+                if (producer != nullptr) {
+                    producer->Append(stream, unix_us, frame, size);
+                }
+                if (rollups != nullptr && client.format() == StreamFormat::kRtcm3) {
+                    rollups->Add(slot, unix_us, frame, size);
+                }
+            });
+        } else {
+            client.SetFrameCallback([count](const uint8_t*, size_t) { (*count)++; });
+        }
+        if (options.burst_gap_us > 0) {
+            client.EnableArrivalStats(options.burst_gap_us);
+        }
+    }
+    std::vector<bool> running(manager.num_streams(), false);
+    for (int id = 0; id < manager.num_streams(); id++) {
+        HandedStream* handed = nullptr;
+        if (options.handed != nullptr) {
+            const StreamSpec& spec = *worker->specs[id];
+            auto found = options.handed->find(stream_key(spec.host, spec.port, spec.mountpoint));
+            if (found != options.handed->end() && found->second.fd >= 0) {
+                handed = &found->second;
+            }
+        }
+        if (handed != nullptr && manager.Resume(id, *handed)) {
+            handed->fd = -1;  // owned by the worker's transport now
+            running[id] = true;
+        } else if (worker->wanted[id].load(std::memory_order_relaxed)) {
+            manager.Start(id);
+            running[id] = true;
+        }
+    }
+    uint64_t applied = worker->wanted_version.load(std::memory_order_acquire);
+    ready->fetch_add(1);
+
+    int64_t next_gga = clock.Now();
+    int64_t next_sample = clock.Now() + traffic_sample_us;
+    while (workers_run) {
+        uint64_t version = worker->wanted_version.load(std::memory_order_acquire);
+        if (version != applied) {
+            applied = version;
+            for (int id = 0; id < manager.num_streams(); id++) {
+                bool wanted = worker->wanted[id].load(std::memory_order_relaxed);
+                if (wanted != running[id]) {
+                    if (wanted) {
+                        manager.Start(id);
+                    } else {
+                        manager.Stop(id);
+                    }
+                    running[id] = wanted;
+                }
+            }
+        }
+        int64_t now = clock.Now();
+        if (options.have_position && now >= next_gga) {
+            std::string gga = generage_gga_message(options.lat, options.lon, options.alt);
+            for (int id = 0; id < manager.num_streams(); id++) {
+                manager.stream(id).UpdateGGA(gga);
+            }
+            next_gga += gga_update_us;
+        }
+        if (now >= next_sample) {
+            sample_traffic(worker, topology);
+            next_sample += traffic_sample_us;
+        }
+        manager.RunOnce(loop_wait_us);
+    }
+    if (handing_over) {
+        manager.HandOver(&worker->handing);
+    }
+    manager.SaveCheckpoints();
+}
+
+/**
+ * @brief Copies the usage of every stream of every worker, with stream ids of the list.
+ */
+static void sample_usage(const HubWorkers& workers, std::vector<StreamUsageSample>* samples) {
+    samples->clear();
+    std::vector<StreamUsageSample> local;
+    for (const auto& worker : workers) {
+        worker->manager->SampleUsage(&local);
+        for (StreamUsageSample& sample : local) {
+            sample.id = sample.id * static_cast<int>(workers.size()) + worker->index;
+            samples->push_back(std::move(sample));
+        }
+    }
+}
+
+/**
+ * @brief Copies the status of every stream of every worker, with stream ids of the list.
+ */
+static void sample_status(const HubWorkers& workers, std::vector<StreamStatusSample>* samples) {
+    samples->clear();
+    std::vector<StreamStatusSample> local;
+    for (const auto& worker : workers) {
+        worker->manager->SampleStatus(&local);
+        for (StreamStatusSample& sample : local) {
+            sample.id = sample.id * static_cast<int>(workers.size()) + worker->index;
+            samples->push_back(std::move(sample));
+        }
+    }
+}
+
+/**
+ * @brief Formats the placement and traffic locality of every worker as a text table.
+ */
+static std::string format_worker_report(const HubWorkers& workers) {
+    std::string out = "worker   cpu  node  streams          bytes  local%  remote%  unknown%\n";
+    char line[160];
+    for (const auto& worker : workers) {
+        uint64_t local = worker->local_bytes.load(std::memory_order_relaxed);
+        uint64_t remote = worker->remote_bytes.load(std::memory_order_relaxed);
+        uint64_t unknown = worker->unknown_bytes.load(std::memory_order_relaxed);
+        double total = static_cast<double>(local + remote + unknown);
+        double scale = total > 0 ? 100.0 / total : 0.0;
+        snprintf(line, sizeof(line), "%6d %5d %5d %8d %14llu %7.1f %8.1f %9.1f\n", worker->index, worker->cpu,
+                 worker->node, worker->manager->num_streams(), static_cast<unsigned long long>(local + remote + unknown),
+                 local * scale, remote * scale, unknown * scale);
+        out += line;
+    }
+    return out;
+}
+
+/**
+ * @brief Where one stream of the list stands in the cluster, from this node's point of view.
+ */
+struct ShardStream {
+    bool owned = false;  // the ring assigns it to this node
+    bool announced = false;  // the other nodes were told that this node streams it
+    int64_t drain_until = 0;  // moved to another node, runs until that one streams it or this time; 0 if not
+};
+
+/**
+ * @brief This hub's membership in a cluster of hubs sharing one stream list.
+ */
+struct HubCluster {
+    ClusterClient client;
+    ShardRing ring;
+    double epsilon = default_load_bound;
+    std::vector<std::string> keys;  // stream_key() of every stream of the list
+    std::unordered_map<std::string, size_t> index;  // stream id of the list by key
+    std::vector<ShardStream> streams;
+    uint64_t handed_off = 0;  // streams released after their new owner announced them
+    uint64_t drain_timeouts = 0;  // streams released because their new owner did not stream in time
+};
+
+/**
+ * @brief Follows the member list and announcements of the cluster and tells the workers which
+ *        streams to run.
+ *
+ * A stream that moves away keeps running here until the new owner announces that it streams,
+ * so there is no gap; a node that does not belong to the list any more owns nothing.
+ *
+ * @return The number of streams still draining to another node.
+ */
+static size_t follow_cluster(HubCluster* cluster, const HubWorkers& workers, int64_t now) {
+    bool changed = false;
+    if (cluster->client.Poll(now)) {
+        const std::vector<std::string>& members = cluster->client.members();
+        cluster->ring.SetNodes(members);
+        std::vector<int> owners;
+        cluster->ring.Assign(cluster->keys, cluster->epsilon, &owners);
+        auto self = std::find(members.begin(), members.end(), cluster->client.name());
+        int self_index = self != members.end() ? static_cast<int>(self - members.begin()) : -1;
+        size_t gained = 0;
+        size_t running = 0;
+        for (size_t g = 0; g < cluster->streams.size(); g++) {
+            ShardStream& stream = cluster->streams[g];
+            bool owned = self_index >= 0 && owners[g] == self_index;
+            if (owned && !stream.owned) {
+                stream.announced = false;
+                stream.drain_until = 0;
+                gained++;
+            } else if (!owned && stream.owned) {
+                // with no other node to take it, the stream stops right away
+                stream.drain_until = owners[g] >= 0 ? now + max_drain_us : 0;
+            }
+            stream.owned = owned;
+            running += owned ? 1 : 0;
+        }
+        size_t draining = 0;
+        for (const ShardStream& stream : cluster->streams) {
+            draining += stream.drain_until > 0 ? 1 : 0;
+        }
+        std::cout << "Cluster epoch " << cluster->client.epoch() << ": " << members.size() << " nodes, running "
+                  << running << " of " << cluster->streams.size() << " streams (gained " << gained << ", draining "
+                  << draining << ")" << std::endl;
+        changed = true;
+    }
+
+    std::vector<std::string> announced;
+    cluster->client.TakeAnnounced(&announced);
+    for (const std::string& key : announced) {
+        auto found = cluster->index.find(key);
+        if (found != cluster->index.end() && cluster->streams[found->second].drain_until > 0) {
+            cluster->streams[found->second].drain_until = 0;
+            cluster->handed_off++;
+            changed = true;
+        }
+    }
+    size_t draining = 0;
+    for (ShardStream& stream : cluster->streams) {
+        if (stream.drain_until > 0 && now >= stream.drain_until) {
+            stream.drain_until = 0;
+            cluster->drain_timeouts++;
+            changed = true;
+        }
+        draining += stream.drain_until > 0 ? 1 : 0;
+    }
+
+    std::vector<StreamStatusSample> samples;
+    sample_status(workers, &samples);
+    for (const StreamStatusSample& sample : samples) {
+        ShardStream& stream = cluster->streams[sample.id];
+        if (stream.owned && !stream.announced && sample.status.state == NtripClient::State::kStreaming) {
+            cluster->client.Announce(cluster->keys[sample.id]);
+            stream.announced = true;
+        }
+    }
+
+    if (changed) {
+        size_t num_workers = workers.size();
+        for (size_t g = 0; g < cluster->streams.size(); g++) {
+            const ShardStream& stream = cluster->streams[g];
+            workers[g % num_workers]->wanted[g / num_workers].store(stream.owned || stream.drain_until > 0,
+                                                                     std::memory_order_relaxed);
+        }
+        for (const auto& worker : workers) {
+            worker->wanted_version.fetch_add(1, std::memory_order_release);
+        }
+    }
+    return draining;
+}
+
+/**
+ * @brief Main function for the multi-stream NTRIP hub, driving the streams from one event loop per worker.
+ * 
+ * @return 0 if the program exits successfully.
+ */
+int main(int argc, char** argv) {
+    std::string stream_file;
+    int metrics_port = 0;
+    HubOptions options;
+    size_t report = 10;
+    std::string log_file;
+    std::string checkpoint_file;
+    std::string handover_path;
+    ArchiveOptions archive_options;
+    std::string rollup_file;
+    int num_workers = 1;
+    std::string cpu_list;
+    std::string coordinator;
+    std::string node_name;
+    HubCluster cluster;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-q") {
+            options.quiet = true;
+            continue;
+        } else if (arg == "-a") {
+            options.admission = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-s") {
+            stream_file = value;
+        } else if (arg == "-m") {
+            metrics_port = atoi(value.c_str());
+        } else if (arg == "-w") {
+            num_workers = atoi(value.c_str());
+        } else if (arg == "-c") {
+            cpu_list = value;
+        } else if (arg == "-g") {
+            if (sscanf(value.c_str(), "%lf,%lf,%lf", &options.lat, &options.lon, &options.alt) != 3) {
+                usage();
+                return 1;
+            }
+            options.have_position = true;
+        } else if (arg == "-j") {
+            options.burst_gap_us = static_cast<int64_t>(atof(value.c_str()) * 1000);
+        } else if (arg == "-C") {
+            checkpoint_file = value;
+        } else if (arg == "-U") {
+            handover_path = value;
+        } else if (arg == "-K") {
+            coordinator = value;
+        } else if (arg == "-N") {
+            node_name = value;
+        } else if (arg == "-B") {
+            cluster.epsilon = atof(value.c_str());
+        } else if (arg == "-A") {
+            archive_options.prefix = value;
+        } else if (arg == "-Y") {
+            archive_options.sync_interval_us = static_cast<int64_t>(atof(value.c_str()) * 1000);
+        } else if (arg == "-R") {
+            double seconds = 0.0;
+            double mib = 0.0;
+            int fields = sscanf(value.c_str(), "%lf,%lf", &seconds, &mib);
+            if (fields < 1) {
+                usage();
+                return 1;
+            }
+            archive_options.rotate_us = static_cast<int64_t>(seconds * 1000000);
+            if (fields == 2) {
+                archive_options.rotate_bytes = static_cast<uint64_t>(mib * 1048576);
+            }
+        } else if (arg == "-T") {
+            rollup_file = value;
+        } else if (arg == "-L") {
+            log_file = value;
+        } else if (arg == "-r") {
+            report = static_cast<size_t>(atoi(value.c_str()));
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    size_t colon = coordinator.rfind(':');
+    if (stream_file.empty() || num_workers < 1 || cluster.epsilon <= 0.0 ||
+        (!coordinator.empty() && (colon == std::string::npos || colon == 0))) {
+        usage();
+        return 1;
+    }
+    bool cluster_mode = !coordinator.empty();
+    if (cluster_mode && node_name.empty()) {
+        char host[256] = {};
+        gethostname(host, sizeof(host) - 1);
+        node_name = host;
+    }
+
+    raise_file_limit();
+    std::vector<StreamSpec> specs;
+    if (!load_streams(stream_file, &specs)) {
+        return 1;
+    }
+    CpuTopology topology = load_cpu_topology();
+    std::vector<int> allowed;
+    if (!cpu_list.empty() && !parse_cpu_list(cpu_list, &allowed)) {
+        std::cerr << "Error: Could not parse the CPU list " << cpu_list << std::endl;
+        return 1;
+    }
+    std::vector<int> placement;
+    if (num_workers > 1 || !allowed.empty()) {
+        placement = place_workers(topology, allowed, num_workers);
+        if (placement.empty()) {
+            std::cerr << "Error: None of the CPUs " << cpu_list << " is usable" << std::endl;
+            return 1;
+        }
+    }
+
+    // take over the live streams of the hub being upgraded, then wait for our own successor
+    std::unordered_map<std::string, HandedStream> handed;
+    std::map<std::string, int> sockets;
+    HandoverServer handover;
+    if (!handover_path.empty()) {
+        std::vector<HandedStream> received;
+        if (receive_handover(handover_path, &received, &sockets)) {
+            std::cout << "Took over " << received.size() << " streams from the running hub" << std::endl;
+        }
+        for (HandedStream& stream : received) {
+            std::string key = stream.key;
+            handed[key] = std::move(stream);
+        }
+        options.handed = &handed;
+        if (!handover.Listen(handover_path)) {
+            return 1;
+        }
+    }
+    CheckpointFile checkpoint;
+    if (!checkpoint_file.empty()) {
+        if (!checkpoint.Open(checkpoint_file, specs.size())) {
+            return 1;
+        }
+        options.checkpoint = &checkpoint;
+    }
+    if (!log_file.empty() && !event_log_open(log_file)) {
+        return 1;
+    }
+    ArchiveWriter archive;
+    if (!archive_options.prefix.empty()) {
+        std::vector<std::string> names;
+        for (const StreamSpec& spec : specs) {
+            names.push_back(stream_key(spec.host, spec.port, spec.mountpoint));
+        }
+        if (!archive.Open(archive_options, names)) {
+            return 1;
+        }
+        options.archive = &archive;
+    }
+    RollupFile rollups;
+    if (!rollup_file.empty()) {
+        if (!rollups.Open(rollup_file, specs.size())) {
+            return 1;
+        }
+        options.rollups = &rollups;
+    }
+    options.num_workers = num_workers;
+    HubWorkers workers;
+    for (int w = 0; w < num_workers; w++) {
+        workers.emplace_back(new HubWorker());
+        workers[w]->index = w;
+        workers[w]->cpu = placement.empty() ? -1 : placement[w];
+    }
+    for (size_t g = 0; g < specs.size(); g++) {
+        workers[g % num_workers]->specs.push_back(&specs[g]);
+    }
+    for (auto& worker : workers) {
+        // in a cluster nothing runs until the first member list says which streams are ours
+        worker->wanted.reset(new std::atomic<bool>[worker->specs.size()]);
+        for (size_t id = 0; id < worker->specs.size(); id++) {
+            worker->wanted[id].store(!cluster_mode, std::memory_order_relaxed);
+        }
+    }
+    if (cluster_mode) {
+        for (size_t g = 0; g < specs.size(); g++) {
+            cluster.keys.push_back(stream_key(specs[g].host, specs[g].port, specs[g].mountpoint));
+            cluster.index[cluster.keys.back()] = g;
+        }
+        cluster.streams.resize(specs.size());
+        // streams handed over by an upgrade keep running until the member list arrives
+        for (const auto& stream : handed) {
+            auto found = cluster.index.find(stream.first);
+            if (found != cluster.index.end()) {
+                cluster.streams[found->second].owned = true;
+                cluster.streams[found->second].announced = true;
+            }
+        }
+    }
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    std::atomic<int> ready{0};
+    for (auto& worker : workers) {
+        worker->thread = std::thread(run_worker, worker.get(), std::cref(options), std::cref(topology), &ready);
+    }
+    while (ready.load() < num_workers) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (auto& stream : handed) {
+        if (stream.second.fd >= 0) {
+            close(stream.second.fd);  // no longer in the stream list
+        }
+    }
+
+    // every stream exists now, so the handlers may look them up while the workers run
+    MetricsServer metrics;
+    bool metrics_failed = false;
+    if (metrics_port > 0) {
+        metrics.AddHandler("/metrics", "text/plain; version=0.0.4", [&workers](const std::string& query) {
+            std::vector<StreamUsageSample> samples;
+            sample_usage(workers, &samples);
+            return format_usage_metrics(samples, atoi(query_value(query, "top", "20").c_str()));
+        });
+        metrics.AddHandler("/top", "text/plain", [&workers](const std::string& query) {
+            UsageKey key;
+            if (!parse_usage_key(query_value(query, "by", "cpu"), &key)) {
+                return std::string("by must be one of cpu, allocs, memory, buffered, bytes\n");
+            }
+            std::vector<StreamUsageSample> samples;
+            sample_usage(workers, &samples);
+            return format_usage_table(samples, atoi(query_value(query, "n", "20").c_str()), key);
+        });
+        metrics.AddHandler("/health", "application/json", [&workers](const std::string& query) {
+            std::vector<StreamStatusSample> samples;
+            sample_status(workers, &samples);
+            SystemClock clock;
+            return format_health_json(samples, clock.Now(), query_value(query, "state", ""));
+        });
+        metrics.AddHandler("/arrival", "text/plain", [&workers](const std::string& query) {
+            std::vector<StreamStatusSample> samples;
+            sample_status(workers, &samples);
+            std::string mountpoint = query_value(query, "mount", "");
+            int id = atoi(query_value(query, "id", "-1").c_str());
+            for (const StreamStatusSample& sample : samples) {
+                if (sample.id == id || sample.mountpoint == mountpoint) {
+                    const HubWorker& worker = *workers[sample.id % workers.size()];
+                    const ArrivalStats* stats = worker.manager->stream(sample.id / workers.size()).arrival_stats();
+                    if (stats == nullptr) {
+                        return std::string("arrival statistics are off, start with -j\n");
+                    }
+                    return sample.mountpoint + " " + state_name(sample.status.state) + "\n" + stats->Report();
+                }
+            }
+            return std::string("no such stream, use ?id=N or ?mount=NAME\n");
+        });
+        metrics.AddHandler("/workers", "text/plain", [&workers](const std::string&) {
+            return format_worker_report(workers);
+        });
+        metrics.AddHandler("/archive", "text/plain", [&options](const std::string&) {
+            if (options.archive == nullptr) {
+                return std::string("archiving is off, start with -A\n");
+            }
+            return options.archive->Report();
+        });
+        metrics.AddHandler("/trend", "text/plain", [&options](const std::string& query) {
+            if (options.rollups == nullptr) {
+                return std::string("rollups are off, start with -T\n");
+            }
+            int tier = parse_rollup_tier(query_value(query, "res", "1m"));
+            if (tier < 0) {
+                return std::string("res must be one of 1s, 1m, 1h\n");
+            }
+            int64_t now_s = static_cast<int64_t>(time(nullptr));
+            std::string mountpoint = query_value(query, "mount", "");
+            int count = atoi(query_value(query, "n", mountpoint.empty() ? "20" : "60").c_str());
+            if (mountpoint.empty()) {
+                return format_rollup_summary(*options.rollups, tier, now_s, count);
+            }
+            std::string suffix = "/" + mountpoint;
+            for (const auto& key : options.rollups->Keys()) {
+                const std::string& name = key.first;
+                if (name.size() > suffix.size() &&
+                    name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                    std::vector<RollupBucket> buckets;
+                    options.rollups->Read(key.second, tier, now_s + 1, count, &buckets);
+                    return format_rollup_series(name, tier, now_s + 1, buckets);
+                }
+            }
+            return std::string("no such stream, use ?mount=NAME\n");
+        });
+        auto listener = sockets.find("metrics");
+        bool serving = listener != sockets.end() ? metrics.Adopt(listener->second) : metrics.Start(metrics_port);
+        if (listener != sockets.end()) {
+            sockets.erase(listener);
+        }
+        if (!serving) {
+            metrics_failed = true;
+            run = false;
+        }
+    }
+
+    if (run) {
+        std::cout << "Running " << specs.size() << " streams on " << num_workers << " workers. Press Ctrl+C to stop."
+                  << std::endl;
+    }
+    SystemClock clock;
+    if (cluster_mode) {
+        auto connection = sockets.find("cluster");
+        if (connection != sockets.end()) {
+            cluster.client.Adopt(connection->second, clock.Now());
+            sockets.erase(connection);
+        }
+        cluster.client.Init(coordinator.substr(0, colon), coordinator.substr(colon + 1), node_name);
+    }
+    for (auto& socket : sockets) {
+        close(socket.second);
+    }
+    int64_t leave_until = 0;  // when leaving the cluster, the latest time to stop
+    while (true) {
+        if (handover.Accept(handover_poll_ms)) {
+            handing_over = true;
+            break;
+        }
+        if (!cluster_mode) {
+            if (!run) {
+                break;
+            }
+            continue;
+        }
+        int64_t now = clock.Now();
+        if (!run && leave_until == 0) {
+            // keep streaming until the remaining nodes took the streams over
+            cluster.client.Leave();
+            leave_until = now + max_drain_us;
+        }
+        size_t draining = follow_cluster(&cluster, workers, now);
+        if (leave_until > 0) {
+            const std::vector<std::string>& members = cluster.client.members();
+            bool member = std::find(members.begin(), members.end(), node_name) != members.end();
+            if (((!member || !cluster.client.connected()) && draining == 0) || now >= leave_until) {
+                break;
+            }
+        }
+    }
+    run = false;
+    workers_run = false;
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+    if (handing_over) {
+        // the workers have stopped reading, whatever arrives now waits in the sockets for the new hub
+        size_t count = 0;
+        for (auto& worker : workers) {
+            for (HandedStream& stream : worker->handing) {
+                count += handover.SendStream(stream) ? 1 : 0;
+                close(stream.fd);
+            }
+        }
+        if (metrics.listen_fd() >= 0) {
+            handover.SendSocket("metrics", metrics.listen_fd());
+        }
+        if (cluster.client.fd() >= 0) {
+            handover.SendSocket("cluster", cluster.client.fd());
+        }
+        if (handover.Finish()) {
+            std::cout << "Handed " << count << " streams over to the new hub" << std::endl;
+        }
+    }
+    metrics.Stop();
+    handover.Close();
+    checkpoint.Close();
+    archive.Close();
+    rollups.Close();
+    event_log_close();
+    if (metrics_failed) {
+        return 1;
+    }
+
+    if (cluster_mode && !handing_over) {
+        std::cout << "Handed off " << cluster.handed_off << " streams after their new owner streamed, "
+                  << cluster.drain_timeouts << " after the drain timeout" << std::endl;
+    }
+    if (report > 0) {
+        std::vector<StreamUsageSample> samples;
+        sample_usage(workers, &samples);
+        std::cout << format_usage_table(samples, report, UsageKey::kCpu);
+        std::cout << format_worker_report(workers);
+        if (options.archive != nullptr) {
+            std::cout << archive.Report();
+        }
+    }
+    return 0;
+}
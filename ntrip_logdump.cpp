@@ -0,0 +1,361 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "event_log.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: ntrip_logdump [-s] [-l debug|info|warning|error] FILE\n"
+              << "  -s        sort the events of every thread by time instead of file order\n"
+              << "  -l level  only print events at or above this level\n";
+}
+
+/**
+ * @brief A log site definition read from the file.
+ */
+struct SiteInfo {
+    LogLevel level = LogLevel::kDebug;
+    uint32_t line = 0;
+    std::string file;
+    std::string format;
+    std::string types;
+};
+
+/**
+ * @brief A decoded line with its timestamp, for sorting.
+ */
+struct Line {
+    int64_t time_ns;
+    std::string text;
+};
+
+/**
+ * @brief Reads binary values from the file contents with bounds checks.
+ */
+class Reader {
+public:
+    Reader(const std::string& data) : data_(data) {}
+
+    template <typename T>
+    bool Get(T* value) {
+        if (pos_ + sizeof(T) > data_.size()) {
+            return false;
+        }
+        memcpy(value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool GetString(std::string* value) {
+        uint16_t length;
+        if (!Get(&length) || pos_ + length > data_.size()) {
+            return false;
+        }
+        value->assign(data_.data() + pos_, length);
+        pos_ += length;
+        return true;
+    }
+
+    bool GetBytes(size_t size, const char** bytes) {
+        if (pos_ + size > data_.size()) {
+            return false;
+        }
+        *bytes = data_.data() + pos_;
+        pos_ += size;
+        return true;
+    }
+
+    bool AtEnd() const { return pos_ >= data_.size(); }
+
+private:
+    const std::string& data_;
+    size_t pos_ = 0;
+};
+
+static const char* level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::kDebug: return "DEBUG";
+        case LogLevel::kInfo: return "INFO ";
+        case LogLevel::kWarning: return "WARN ";
+        case LogLevel::kError: return "ERROR";
+    }
+    return "?    ";
+}
+
+/**
+ * @brief One decoded argument.
+ */
+struct Arg {
+    char type;
+    int64_t i;
+    uint64_t u;
+    double d;
+    std::string s;
+};
+
+/**
+ * @brief Formats an event with its site's printf format, one conversion at a time.
+ *
+ * Length modifiers in the format are replaced to match the stored 64-bit values, and an
+ * argument of the wrong kind is converted rather than passed to snprintf as is.
+ */
+static std::string format_event(const std::string& format, const std::vector<Arg>& args) {
+    std::string out;
+    size_t next = 0;
+    char buffer[1100];
+    for (size_t i = 0; i < format.size(); i++) {
+        if (format[i] != '%') {
+            out += format[i];
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '%') {
+            out += '%';
+            i++;
+            continue;
+        }
+        size_t start = i++;
+        std::string spec = "%";
+        while (i < format.size() && strchr("-+ #0123456789.", format[i]) != nullptr) {
+            spec += format[i++];
+        }
+        while (i < format.size() && strchr("hlLqjzt", format[i]) != nullptr) {
+            i++;
+        }
+        if (i >= format.size()) {
+            out += format.substr(start);
+            break;
+        }
+        char conversion = format[i];
+        if (next >= args.size()) {
+            out += "<missing>";
+            continue;
+        }
+        const Arg& arg = args[next++];
+        if (strchr("di", conversion) != nullptr) {
+            long long value = arg.type == 'i' ? arg.i : arg.type == 'u' ? static_cast<long long>(arg.u)
+                                                                       : static_cast<long long>(arg.d);
+            snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), value);
+        } else if (strchr("uxXoc", conversion) != nullptr) {
+            unsigned long long value = arg.type == 'u' ? arg.u : arg.type == 'i' ? static_cast<unsigned long long>(arg.i)
+                                                                                 : static_cast<unsigned long long>(arg.d);
+            if (conversion == 'c') {
+                snprintf(buffer, sizeof(buffer), (spec + "c").c_str(), static_cast<int>(value));
+            } else {
+                snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), value);
+            }
+        } else if (strchr("fFeEgGaA", conversion) != nullptr) {
+            double value = arg.type == 'd' ? arg.d : arg.type == 'i' ? arg.i : static_cast<double>(arg.u);
+            snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), value);
+        } else if (conversion == 's') {
+            std::string value = arg.type == 's' ? arg.s : arg.type == 'd' ? std::to_string(arg.d)
+                                                      : arg.type == 'i' ? std::to_string(arg.i)
+                                                                        : std::to_string(arg.u);
+            snprintf(buffer, sizeof(buffer), (spec + "s").c_str(), value.c_str());
+        } else {
+            snprintf(buffer, sizeof(buffer), "<bad %%%c>", conversion);
+        }
+        out += buffer;
+    }
+    return out;
+}
+
+/**
+ * @brief Formats a Unix time in nanoseconds as UTC with microseconds.
+ */
+static std::string format_time(int64_t time_ns) {
+    time_t seconds = static_cast<time_t>(time_ns / 1000000000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char buffer[64];
+    size_t n = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &utc);
+    snprintf(buffer + n, sizeof(buffer) - n, ".%06lld", static_cast<long long>(time_ns % 1000000000 / 1000));
+    return buffer;
+}
+
+/**
+ * @brief Main function for the event log decoder.
+ * 
+ * @return 0 if the log was decoded completely, 2 if it is truncated or corrupt.
+ */
+int main(int argc, char** argv) {
+    bool sort = false;
+    int min_level = 0;
+    std::string path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-s") {
+            sort = true;
+        } else if (arg == "-l" && i + 1 < argc) {
+            std::string level = argv[++i];
+            min_level = level == "debug" ? 0 : level == "info" ? 1 : level == "warning" ? 2 : level == "error" ? 3 : -1;
+            if (min_level < 0) {
+                usage();
+                return 1;
+            }
+        } else if (path.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        usage();
+        return 1;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    Reader reader(data);
+    const char* magic;
+    double rate;
+    uint64_t start_cycles;
+    int64_t start_ns;
+    if (!reader.GetBytes(sizeof(event_log_magic), &magic) || memcmp(magic, event_log_magic, sizeof(event_log_magic)) != 0 ||
+        !reader.Get(&rate) || !reader.Get(&start_cycles) || !reader.Get(&start_ns) || rate <= 0.0) {
+        std::cerr << "Error: " << path << " is not an event log" << std::endl;
+        return 1;
+    }
+
+    std::vector<SiteInfo> sites;
+    std::vector<Line> lines;
+    uint64_t events = 0;
+    bool corrupt = false;
+    while (!reader.AtEnd() && !corrupt) {
+        uint8_t kind;
+        reader.Get(&kind);
+        if (kind == 'F') {
+            uint32_t id;
+            uint8_t level;
+            SiteInfo site;
+            if (!reader.Get(&id) || !reader.Get(&level) || !reader.Get(&site.line) || !reader.GetString(&site.file) ||
+                !reader.GetString(&site.format) || !reader.GetString(&site.types) || id == 0) {
+                corrupt = true;
+                break;
+            }
+            site.level = static_cast<LogLevel>(level);
+            if (sites.size() < id) {
+                sites.resize(id);
+            }
+            sites[id - 1] = site;
+        } else if (kind == 'E') {
+            uint32_t thread;
+            uint16_t size;
+            const char* event;
+            if (!reader.Get(&thread) || !reader.Get(&size) || size < event_log_header_size ||
+                !reader.GetBytes(size - 2, &event)) {
+                corrupt = true;
+                break;
+            }
+            uint32_t id;
+            uint64_t cycles;
+            memcpy(&id, event + 2, 4);
+            memcpy(&cycles, event + 6, 8);
+            if (id == 0 || id > sites.size()) {
+                corrupt = true;
+                break;
+            }
+            const SiteInfo& site = sites[id - 1];
+            events++;
+            if (static_cast<int>(site.level) < min_level) {
+                continue;
+            }
+            std::vector<Arg> args;
+            size_t pos = event_log_header_size - 2;
+            for (char type : site.types) {
+                Arg arg{type, 0, 0, 0.0, std::string()};
+                if (type == 's') {
+                    uint16_t length;
+                    if (pos + 2 > size - 2u) {
+                        corrupt = true;
+                        break;
+                    }
+                    memcpy(&length, event + pos, 2);
+                    if (pos + 2 + length > size - 2u) {
+                        corrupt = true;
+                        break;
+                    }
+                    arg.s.assign(event + pos + 2, length);
+                    pos += 2 + length;
+                } else {
+                    if (pos + 8 > size - 2u) {
+                        corrupt = true;
+                        break;
+                    }
+                    memcpy(type == 'i' ? static_cast<void*>(&arg.i) : type == 'u' ? static_cast<void*>(&arg.u)
+                                                                                   : static_cast<void*>(&arg.d),
+                           event + pos, 8);
+                    pos += 8;
+                }
+                args.push_back(arg);
+            }
+            int64_t time_ns = start_ns + static_cast<int64_t>(static_cast<int64_t>(cycles - start_cycles) / rate * 1e9);
+            std::string base = site.file.substr(site.file.find_last_of('/') + 1);
+            std::string text = format_time(time_ns) + " [" + std::to_string(thread) + "] " + level_name(site.level) +
+                               " " + base + ":" + std::to_string(site.line) + " " + format_event(site.format, args);
+            lines.push_back(Line{time_ns, text});
+        } else if (kind == 'D') {
+            uint32_t thread;
+            uint64_t count;
+            if (!reader.Get(&thread) || !reader.Get(&count)) {
+                corrupt = true;
+                break;
+            }
+            int64_t time_ns = lines.empty() ? start_ns : lines.back().time_ns;
+            lines.push_back(Line{time_ns, "[" + std::to_string(thread) + "] " + std::to_string(count) +
+                                              " events dropped, buffer full"});
+        } else {
+            corrupt = true;
+        }
+    }
+
+    if (sort) {
+        std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) { return a.time_ns < b.time_ns; });
+    }
+    for (const Line& line : lines) {
+        std::cout << line.text << '\n';
+    }
+    std::cout.flush();
+    if (corrupt) {
+        std::cerr << "Error: " << path << " is truncated or corrupt after " << events << " events" << std::endl;
+        return 2;
+    }
+    return 0;
+}
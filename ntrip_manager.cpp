@@ -0,0 +1,494 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ntrip_manager.h"
+
+#include "alloc_counter.h"
+#include "event_log.h"
+#include "tsc_clock.h"
+
+#include <algorithm>
+#include <limits>
+
+constexpr int64_t never = std::numeric_limits<int64_t>::max();
+
+/**
+ * @brief Returns the lower case name of a scheduling class ("high", "normal", "low").
+ */
+const char* priority_name(StreamPriority priority) {
+    switch (priority) {
+        case StreamPriority::kHigh: return "high";
+        case StreamPriority::kNormal: return "normal";
+        case StreamPriority::kLow: return "low";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Constructor for NtripManager.
+ *
+ * @param clock The time source shared by every stream.
+ * @param transport The network shared by every stream.
+ */
+NtripManager::NtripManager(Clock* clock, Transport* transport) :
+    clock_(clock),
+    transport_(transport) {
+}
+
+/**
+ * @brief Adds a stream; it does not connect until Start() or StartAll().
+ *
+ * @return The stream id.
+ */
+int NtripManager::AddStream(const std::string& host, const std::string& port, const std::string& mountpoint,
+                            const std::string& username, const std::string& password) {
+    Stream stream;
+    stream.client.reset(new NtripClient(host, port, mountpoint, username, password));
+    stream.client->SetEnvironment(clock_, transport_);
+    stream.usage.reset(new StreamUsage());
+    stream.deadline = never;
+    stream.handle = -1;
+    stream.priority = StreamPriority::kNormal;
+    stream.queued = false;
+    stream.queued_since = 0;
+    auto caster = caster_ids_.emplace(host + ":" + port, static_cast<int>(casters_.size()));
+    if (caster.second) {
+        casters_.emplace_back();
+    }
+    stream.caster = caster.first->second;
+    stream.admitted = false;
+    stream.waiting = false;
+    stream.admitted_at = 0;
+    stream.checkpoint_slot = -1;
+    stream.saved_version = 0;
+    stream.checkpoint_due = 0;
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(streams_mutex_);
+        streams_.push_back(std::move(stream));
+        id = static_cast<int>(streams_.size()) - 1;
+    }
+    if (admission_control_) {
+        streams_[id].client->SetConnectGate([this, id](int64_t now) { return Admit(id, now); });
+    }
+    if (checkpoint_ != nullptr) {
+        RestoreStream(id);
+    }
+    return id;
+}
+
+/**
+ * @brief Sets the scheduling class of a stream (default kNormal).
+ */
+void NtripManager::SetPriority(int id, StreamPriority priority) {
+    streams_[id].priority = priority;
+}
+
+/**
+ * @brief Limits the steps of a class per loop iteration; 0 for no limit.
+ */
+void NtripManager::SetBudget(StreamPriority priority, int steps) {
+    budgets_[static_cast<int>(priority)] = std::max(steps, 0);
+}
+
+/**
+ * @brief Limits the handshakes in flight to each caster to what it has been seen to accept.
+ */
+void NtripManager::EnableAdmissionControl() {
+    admission_control_ = true;
+    for (int id = 0; id < num_streams(); id++) {
+        streams_[id].client->SetConnectGate([this, id](int64_t now) { return Admit(id, now); });
+    }
+}
+
+/**
+ * @brief Restores every stream from a checkpoint file and keeps its record up to date.
+ */
+void NtripManager::EnableCheckpoint(CheckpointFile* file) {
+    checkpoint_ = file;
+    for (int id = 0; id < num_streams(); id++) {
+        RestoreStream(id);
+    }
+}
+
+/**
+ * @brief Stores every changed checkpoint now, regardless of its interval; call before exiting.
+ */
+void NtripManager::SaveCheckpoints() {
+    int64_t now = clock_->Now();
+    for (int id = 0; id < num_streams(); id++) {
+        if (streams_[id].checkpoint_slot >= 0) {
+            SaveStream(id, now, true);
+        }
+    }
+}
+
+/**
+ * @brief Claims the checkpoint record of a stream and restores the stream from it.
+ *
+ * The saved address seeds the transport's resolver cache, so the first connect after a
+ * restart skips the DNS lookup.
+ */
+void NtripManager::RestoreStream(int id) {
+    Stream& stream = streams_[id];
+    NtripClient& client = *stream.client;
+    stream.checkpoint_slot = checkpoint_->Slot(stream_key(client.host(), client.port(), client.mountpoint()));
+    if (stream.checkpoint_slot < 0) {
+        return;
+    }
+    StreamCheckpoint checkpoint;
+    if (checkpoint_->Load(stream.checkpoint_slot, &checkpoint)) {
+        client.RestoreCheckpoint(checkpoint);
+        if (checkpoint.address != 0) {
+            transport_->SetResolvedAddress(client.host(), checkpoint.address);
+        }
+    }
+    stream.saved_version = client.checkpoint_version();
+}
+
+/**
+ * @brief Stores the checkpoint of a stream if it changed and its interval has passed or force is set.
+ */
+void NtripManager::SaveStream(int id, int64_t now, bool force) {
+    Stream& stream = streams_[id];
+    NtripClient& client = *stream.client;
+    if (client.checkpoint_version() == stream.saved_version || (!force && now < stream.checkpoint_due)) {
+        return;
+    }
+    StreamCheckpoint checkpoint;
+    client.SaveCheckpoint(&checkpoint);
+    checkpoint.address = transport_->ResolvedAddress(client.host());
+    checkpoint_->Store(stream.checkpoint_slot, checkpoint);
+    stream.saved_version = client.checkpoint_version();
+    stream.checkpoint_due = now + checkpoint_interval_us;
+}
+
+/**
+ * @brief Connect gate of a stream: admits it to its caster or returns when to ask again.
+ */
+int64_t NtripManager::Admit(int id, int64_t now) {
+    Stream& stream = streams_[id];
+    CasterAdmission& caster = casters_[stream.caster];
+    if (caster.TryAdmit(stream.waiting)) {
+        stream.waiting = false;
+        stream.admitted = true;
+        stream.admitted_at = now;
+        return now;
+    }
+    stream.waiting = true;
+    return now + RetryDelay(caster);
+}
+
+/**
+ * @brief Returns a randomized wait before a stream that was not admitted asks its caster again.
+ */
+int64_t NtripManager::RetryDelay(const CasterAdmission& caster) {
+    admission_seed_ ^= admission_seed_ << 13;
+    admission_seed_ ^= admission_seed_ >> 7;
+    admission_seed_ ^= admission_seed_ << 17;
+    return caster.RetryDelay(admission_seed_);
+}
+
+/**
+ * @brief Returns the caster slot of a stream whose handshake ended and learns from the outcome.
+ *
+ * A 429 or 5xx answer and a handshake timeout count as overload; other rejections, such as
+ * a wrong password, and refused connections say nothing about the caster's capacity.
+ * A stream turned away by overload goes back to the caster's queue instead of serving its
+ * exponential backoff, since the lowered limit already protects the caster.
+ *
+ * @return When the stream retries if it was sent back to the queue, otherwise INT64_MAX.
+ */
+int64_t NtripManager::FinishHandshake(int id, int64_t now) {
+    Stream& stream = streams_[id];
+    const NtripClient& client = *stream.client;
+    CasterAdmission::Outcome outcome = CasterAdmission::Outcome::kAborted;
+    if (client.state() == NtripClient::State::kStreaming) {
+        outcome = CasterAdmission::Outcome::kAccepted;
+    } else if (client.last_failure() == NtripClient::Failure::kTimeout ||
+               (client.last_failure() == NtripClient::Failure::kRejected &&
+                (client.response_code() == 429 || client.response_code() >= 500))) {
+        outcome = CasterAdmission::Outcome::kOverloaded;
+    }
+    stream.admitted = false;
+    CasterAdmission& caster = casters_[stream.caster];
+    if (caster.Finish(now, outcome, now - stream.admitted_at)) {
+        EVENT_LOG(LogLevel::kInfo, "%s:%s overloaded, admitting %d handshakes at once", client.host(),
+                  client.port(), caster.limit());
+    }
+    if (outcome != CasterAdmission::Outcome::kOverloaded) {
+        return never;
+    }
+    int64_t retry = now + RetryDelay(caster);
+    stream.client->RetryAt(retry);
+    return retry;
+}
+
+/**
+ * @brief Starts connecting one stream.
+ */
+void NtripManager::Start(int id) {
+    streams_[id].client->Start();
+    StepStream(id);
+}
+
+/**
+ * @brief Starts connecting every stream.
+ */
+void NtripManager::StartAll() {
+    for (int id = 0; id < num_streams(); id++) {
+        Start(id);
+    }
+}
+
+/**
+ * @brief Stops a stream and closes its connection; Start() connects it again.
+ *
+ * A handshake slot or a place in its caster's queue is given back without a verdict on
+ * the caster.
+ */
+void NtripManager::Stop(int id) {
+    Stream& stream = streams_[id];
+    stream.client->Stop();
+    CasterAdmission& caster = casters_[stream.caster];
+    int64_t now = clock_->Now();
+    if (stream.admitted) {
+        stream.admitted = false;
+        caster.Finish(now, CasterAdmission::Outcome::kAborted, now - stream.admitted_at);
+    }
+    if (stream.waiting) {
+        stream.waiting = false;
+        caster.Withdraw();
+    }
+    StepStream(id);
+}
+
+/**
+ * @brief Continues a stream on a connection handed over by the previous process, in place of Start().
+ *
+ * @return false if the transport cannot adopt the socket, which the caller then still owns.
+ */
+bool NtripManager::Resume(int id, const HandedStream& stream) {
+    int handle = transport_->Adopt(stream.fd);
+    if (handle < 0) {
+        return false;
+    }
+    streams_[id].client->Resume(handle, stream);
+    StepStream(id);
+    return true;
+}
+
+/**
+ * @brief Hands over the connection of every streaming stream; the loop must not run again.
+ */
+void NtripManager::HandOver(std::vector<HandedStream>* streams) {
+    for (int id = 0; id < num_streams(); id++) {
+        NtripClient& client = *streams_[id].client;
+        HandedStream stream;
+        if (client.HandOver(&stream)) {
+            stream.key = stream_key(client.host(), client.port(), client.mountpoint());
+            streams->push_back(std::move(stream));
+        }
+    }
+}
+
+/**
+ * @brief Runs one iteration: due timers, then a wait of at most max_wait_us for the transport.
+ */
+void NtripManager::RunOnce(int64_t max_wait_us) {
+    int64_t now = clock_->Now();
+    while (!timers_.empty() && timers_.top().first <= now) {
+        Timer timer = timers_.top();
+        timers_.pop();
+        // entries superseded by a later reschedule are skipped
+        if (streams_[timer.second].deadline == timer.first) {
+            streams_[timer.second].deadline = never;  // the popped timer is gone, always reschedule
+            Enqueue(timer.second, timer.first);
+        }
+    }
+
+    int64_t wait = max_wait_us;
+    if (queued_ > 0) {
+        wait = 0;  // only poll while streams wait for their turn
+    } else if (!timers_.empty()) {
+        wait = std::min(wait, timers_.top().first - now);
+    }
+    transport_->Wait(wait, &ready_);
+    now = clock_->Now();
+    for (int handle : ready_) {
+        if (handle >= 0 && static_cast<size_t>(handle) < by_handle_.size() && by_handle_[handle] >= 0) {
+            Enqueue(by_handle_[handle], now);
+        }
+    }
+    for (int priority = 0; priority < num_stream_priorities; priority++) {
+        Dispatch(priority);
+    }
+}
+
+/**
+ * @brief Queues a due or ready stream in its class, once.
+ */
+void NtripManager::Enqueue(int id, int64_t since) {
+    Stream& stream = streams_[id];
+    if (stream.queued) {
+        return;
+    }
+    stream.queued = true;
+    stream.queued_since = since;
+    queues_[static_cast<int>(stream.priority)].push_back(id);
+    queued_++;
+}
+
+/**
+ * @brief Steps the queued streams of a class up to its budget.
+ */
+void NtripManager::Dispatch(int priority) {
+    std::deque<int>& queue = queues_[priority];
+    size_t count = queue.size();
+    if (budgets_[priority] > 0) {
+        count = std::min(count, static_cast<size_t>(budgets_[priority]));
+    }
+    for (size_t i = 0; i < count; i++) {
+        int id = queue.front();
+        queue.pop_front();
+        queued_--;
+        Stream& stream = streams_[id];
+        stream.queued = false;
+        int64_t delay = clock_->Now() - stream.queued_since;
+        dispatch_delay_[priority].Record(static_cast<uint64_t>(std::max<int64_t>(delay, 0)));
+        StepStream(id);
+    }
+}
+
+/**
+ * @brief Runs iterations until the clock reaches a time.
+ */
+void NtripManager::RunUntil(int64_t time) {
+    int64_t now;
+    while ((now = clock_->Now()) < time) {
+        RunOnce(time - now);
+    }
+}
+
+/**
+ * @brief Copies the usage of every stream; safe to call from any thread.
+ */
+void NtripManager::SampleUsage(std::vector<StreamUsageSample>* samples) const {
+    std::lock_guard<std::mutex> lock(streams_mutex_);
+    samples->resize(streams_.size());
+    for (size_t id = 0; id < streams_.size(); id++) {
+        const NtripClient& client = *streams_[id].client;
+        const StreamUsage& usage = *streams_[id].usage;
+        StreamUsageSample& sample = (*samples)[id];
+        sample.id = static_cast<int>(id);
+        sample.host = client.host();
+        sample.mountpoint = client.mountpoint();
+        sample.cycles = usage.cycles.load(std::memory_order_relaxed);
+        sample.dispatches = usage.dispatches.load(std::memory_order_relaxed);
+        sample.allocations = usage.allocations.load(std::memory_order_relaxed);
+        sample.allocated_bytes = usage.allocated_bytes.load(std::memory_order_relaxed);
+        sample.bytes_received = usage.bytes_received.load(std::memory_order_relaxed);
+        sample.buffered_bytes = usage.buffered_bytes.load(std::memory_order_relaxed);
+        sample.memory_bytes = usage.memory_bytes.load(std::memory_order_relaxed);
+        sample.receive_buffer_bytes = usage.receive_buffer_bytes.load(std::memory_order_relaxed);
+        sample.default_receive_buffer_bytes = usage.default_receive_buffer_bytes.load(std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Copies the published status of every stream; safe to call from any thread.
+ */
+void NtripManager::SampleStatus(std::vector<StreamStatusSample>* samples) const {
+    std::lock_guard<std::mutex> lock(streams_mutex_);
+    samples->resize(streams_.size());
+    for (size_t id = 0; id < streams_.size(); id++) {
+        const NtripClient& client = *streams_[id].client;
+        StreamStatusSample& sample = (*samples)[id];
+        sample.id = static_cast<int>(id);
+        sample.host = client.host();
+        sample.mountpoint = client.mountpoint();
+        sample.status = client.status();
+    }
+}
+
+/**
+ * @brief Adds to a counter that only the loop thread writes, without a locked instruction.
+ */
+static void add_relaxed(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Steps a stream and reschedules its timer and handle mapping.
+ */
+void NtripManager::StepStream(int id) {
+    Stream& stream = streams_[id];
+    AllocCounter allocations = thread_allocations;
+    uint64_t start = read_cycles();
+    int64_t next = stream.client->Step();
+    uint64_t cycles = read_cycles() - start;
+    steps_++;
+    if (stream.admitted) {
+        NtripClient::State state = stream.client->state();
+        if (state != NtripClient::State::kConnecting && state != NtripClient::State::kHandshake) {
+            next = std::min(next, FinishHandshake(id, clock_->Now()));
+        }
+    }
+    if (stream.checkpoint_slot >= 0) {
+        SaveStream(id, clock_->Now(), false);
+    }
+
+    StreamUsage& usage = *stream.usage;
+    add_relaxed(usage.cycles, cycles);
+    add_relaxed(usage.dispatches, 1);
+    add_relaxed(usage.allocations, thread_allocations.count - allocations.count);
+    add_relaxed(usage.allocated_bytes, thread_allocations.bytes - allocations.bytes);
+    usage.bytes_received.store(stream.client->bytes_received(), std::memory_order_relaxed);
+    usage.buffered_bytes.store(stream.client->BufferedBytes(), std::memory_order_relaxed);
+    usage.memory_bytes.store(stream.client->MemoryUsage(), std::memory_order_relaxed);
+    size_t receive_buffer = stream.client->receive_buffer();
+    usage.receive_buffer_bytes.store(receive_buffer, std::memory_order_relaxed);
+    usage.default_receive_buffer_bytes.store(receive_buffer > 0 ? transport_->DefaultReceiveBuffer() : 0,
+                                             std::memory_order_relaxed);
+
+    int handle = stream.client->handle();
+    if (handle != stream.handle) {
+        if (stream.handle >= 0 && by_handle_[stream.handle] == id) {
+            by_handle_[stream.handle] = -1;
+        }
+        if (handle >= 0) {
+            if (static_cast<size_t>(handle) >= by_handle_.size()) {
+                by_handle_.resize(handle + 1, -1);
+            }
+            by_handle_[handle] = id;
+        }
+        stream.handle = handle;
+    }
+
+    if (next != stream.deadline) {
+        stream.deadline = next;
+        if (next != never) {
+            timers_.push(Timer(next, id));
+        }
+    }
+}
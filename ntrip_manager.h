@@ -0,0 +1,280 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "arrival_stats.h"
+#include "caster_admission.h"
+#include "clock.h"
+#include "ntrip_client.h"
+#include "stream_checkpoint.h"
+#include "stream_handover.h"
+#include "stream_health.h"
+#include "stream_usage.h"
+#include "transport.h"
+
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Scheduling class of a stream in NtripManager, highest first.
+ */
+enum class StreamPriority : uint8_t { kHigh, kNormal, kLow, kCount };
+
+constexpr int num_stream_priorities = static_cast<int>(StreamPriority::kCount);
+
+/**
+ * @brief Returns the lower case name of a scheduling class ("high", "normal", "low").
+ */
+const char* priority_name(StreamPriority priority);
+
+/**
+ * @brief Single threaded event loop driving many NtripClient streams.
+ *
+ * Streams are stepped when the transport reports their connection ready or when their next
+ * timer (GGA report, handshake timeout, backoff) is due. Timers live in a min-heap, so an
+ * iteration costs O(log n) per due stream rather than a scan of every stream.
+ *
+ * Due and ready streams are queued per priority class. Every iteration steps all queued
+ * high priority streams first, then at most the budget of each lower class; the rest stay
+ * queued for the next iteration, which polls the transport without waiting. After a
+ * reconnect storm the backlog of low priority streams therefore delays a high priority
+ * stream by at most one budget's worth of steps.
+ *
+ * With admission control enabled, the streams of a caster (host and port) also share a
+ * CasterAdmission that limits their handshakes in flight, so a restarted caster is not
+ * overrun by every stream reconnecting in the same second.
+ *
+ * With a checkpoint file, a stream's learned state is restored when it is added and stored
+ * again at most once per checkpoint_interval_us after it changes.
+ */
+class NtripManager {
+public:
+
+    /**
+     * @brief Constructor for NtripManager.
+     *
+     * @param clock The time source shared by every stream.
+     * @param transport The network shared by every stream.
+     */
+    NtripManager(Clock* clock, Transport* transport);
+
+    /**
+     * @brief Adds a stream; it does not connect until Start() or StartAll().
+     *
+     * @return The stream id.
+     */
+    int AddStream(const std::string& host, const std::string& port, const std::string& mountpoint,
+                  const std::string& username, const std::string& password);
+
+    /**
+     * @brief Sets the scheduling class of a stream (default kNormal).
+     */
+    void SetPriority(int id, StreamPriority priority);
+
+    /**
+     * @brief Limits the steps of a class per loop iteration; 0 for no limit.
+     *
+     * By default only kLow is limited, to default_low_budget steps.
+     */
+    void SetBudget(StreamPriority priority, int steps);
+
+    /**
+     * @brief Limits the handshakes in flight to each caster to what it has been seen to accept.
+     *
+     * Applies to the streams added before and after the call.
+     */
+    void EnableAdmissionControl();
+
+    /**
+     * @brief Restores every stream from a checkpoint file and keeps its record up to date.
+     *
+     * Applies to the streams added before and after the call; the file must outlive the
+     * manager. Streams restored here must not have been started yet.
+     */
+    void EnableCheckpoint(CheckpointFile* file);
+
+    /**
+     * @brief Stores every changed checkpoint now, regardless of its interval; call before exiting.
+     */
+    void SaveCheckpoints();
+
+    /**
+     * @brief Starts connecting one stream.
+     */
+    void Start(int id);
+
+    /**
+     * @brief Starts connecting every stream.
+     */
+    void StartAll();
+
+    /**
+     * @brief Stops a stream and closes its connection; Start() connects it again.
+     */
+    void Stop(int id);
+
+    /**
+     * @brief Continues a stream on a connection handed over by the previous process, in place of Start().
+     *
+     * @return false if the transport cannot adopt the socket, which the caller then still owns.
+     */
+    bool Resume(int id, const HandedStream& stream);
+
+    /**
+     * @brief Hands over the connection of every streaming stream; the loop must not run again.
+     *
+     * The other streams keep their connections until the manager is destroyed.
+     */
+    void HandOver(std::vector<HandedStream>* streams);
+
+    /**
+     * @brief Runs one iteration: due timers, then a wait of at most max_wait_us for the transport.
+     */
+    void RunOnce(int64_t max_wait_us);
+
+    /**
+     * @brief Runs iterations until the clock reaches a time.
+     */
+    void RunUntil(int64_t time);
+
+    /**
+     * @brief Copies the usage of every stream; safe to call from any thread.
+     */
+    void SampleUsage(std::vector<StreamUsageSample>* samples) const;
+
+    /**
+     * @brief Copies the published status of every stream; safe to call from any thread.
+     *
+     * Only the stream list lock is taken, which the event loop never holds; each status is
+     * read from its stream's sequence lock, so sampling never delays a dispatch.
+     */
+    void SampleStatus(std::vector<StreamStatusSample>* samples) const;
+
+    NtripClient& stream(int id) { return *streams_[id].client; }
+    const StreamUsage& usage(int id) const { return *streams_[id].usage; }
+    int num_streams() const { return static_cast<int>(streams_.size()); }
+    StreamPriority priority(int id) const { return streams_[id].priority; }
+    const CasterAdmission& admission(int id) const { return casters_[streams_[id].caster]; }
+
+    /**
+     * @brief Returns the delays in microseconds from a stream of the class becoming due or
+     *        ready until it was stepped; readable from any thread.
+     */
+    const LogHistogram& dispatch_delay(StreamPriority priority) const {
+        return dispatch_delay_[static_cast<int>(priority)];
+    }
+
+    static constexpr int default_low_budget = 32;
+    static constexpr int64_t checkpoint_interval_us = 1000000;
+    uint64_t steps() const { return steps_; }
+
+private:
+
+    /**
+     * @brief Queues a due or ready stream in its class, once.
+     */
+    void Enqueue(int id, int64_t since);
+
+    /**
+     * @brief Steps the queued streams of a class up to its budget.
+     */
+    void Dispatch(int priority);
+
+    /**
+     * @brief Steps a stream and reschedules its timer and handle mapping.
+     */
+    void StepStream(int id);
+
+    /**
+     * @brief Connect gate of a stream: admits it to its caster or returns when to ask again.
+     */
+    int64_t Admit(int id, int64_t now);
+
+    /**
+     * @brief Returns a randomized wait before a stream that was not admitted asks its caster again.
+     */
+    int64_t RetryDelay(const CasterAdmission& caster);
+
+    /**
+     * @brief Returns the caster slot of a stream whose handshake ended and learns from the outcome.
+     *
+     * @return When the stream retries if it was sent back to the queue, otherwise INT64_MAX.
+     */
+    int64_t FinishHandshake(int id, int64_t now);
+
+    /**
+     * @brief Claims the checkpoint record of a stream and restores the stream from it.
+     */
+    void RestoreStream(int id);
+
+    /**
+     * @brief Stores the checkpoint of a stream if it changed and its interval has passed or force is set.
+     */
+    void SaveStream(int id, int64_t now, bool force);
+
+    struct Stream {
+        std::unique_ptr<NtripClient> client;
+        std::unique_ptr<StreamUsage> usage;
+        int64_t deadline;
+        int handle;
+        StreamPriority priority;
+        bool queued;
+        int64_t queued_since;  // when the stream became due or ready
+        int caster;  // index in casters_
+        bool admitted;  // holds a handshake slot of its caster
+        bool waiting;  // queued for a slot
+        int64_t admitted_at;
+        int checkpoint_slot;  // record in checkpoint_, -1 if none
+        uint64_t saved_version;  // client checkpoint_version() last stored
+        int64_t checkpoint_due;  // earliest time of the next store
+    };
+
+    using Timer = std::pair<int64_t, int>;  // deadline, stream id
+
+    Clock* clock_;
+    Transport* transport_;
+    std::vector<Stream> streams_;
+    mutable std::mutex streams_mutex_;  // held by AddStream() and the samplers, not by the loop
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::vector<int> by_handle_;  // stream id per transport handle, -1 if unused
+    std::vector<int> ready_;
+    std::deque<int> queues_[num_stream_priorities];
+    size_t queued_ = 0;
+    int budgets_[num_stream_priorities] = {0, 0, default_low_budget};
+    LogHistogram dispatch_delay_[num_stream_priorities];
+    uint64_t steps_ = 0;
+    bool admission_control_ = false;
+    std::vector<CasterAdmission> casters_;
+    std::unordered_map<std::string, int> caster_ids_;  // "host:port" to index in casters_
+    uint64_t admission_seed_ = 0x9E3779B97F4A7C15ULL;  // spreads the admission retries
+    CheckpointFile* checkpoint_ = nullptr;
+};
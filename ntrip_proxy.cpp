@@ -0,0 +1,629 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+constexpr size_t read_size = 16384;
+constexpr size_t max_queued = 4 << 20;  // per direction backlog before the source is no longer read
+constexpr int64_t max_poll_us = 100000;
+
+bool run = true;
+
+/**
+ * @brief Signal handler for SIGINT.
+ *
+ * @param signal The signal number.
+ */
+void signal_handler(int signal) {
+    run = false;
+}
+
+/**
+ * @brief Returns the monotonic time in microseconds.
+ */
+static int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Impairments applied to one direction of every proxied connection.
+ */
+struct Impairment {
+    int64_t delay_us = 0;  // added to every chunk
+    int64_t jitter_us = 0;  // uniform +- spread around delay_us, never reordering bytes
+    int64_t rate = 0;  // bytes per second, 0 for unlimited
+    size_t split = 0;  // maximum bytes per send, 0 for no splitting
+    int64_t split_gap_us = 0;  // pause between split segments
+    int64_t stall_until = 0;  // nothing is forwarded before this time
+};
+
+/**
+ * @brief Data read from one side, waiting to be released to the other.
+ */
+struct Chunk {
+    int64_t release;
+    std::string data;
+    size_t offset = 0;
+};
+
+/**
+ * @brief One direction of a proxied connection.
+ */
+struct Pipe {
+    std::deque<Chunk> chunks;
+    size_t queued = 0;
+    int64_t last_release = 0;
+    double tokens = 0.0;
+    int64_t last_refill = 0;
+    int64_t next_send = 0;
+    uint64_t bytes = 0;
+    bool eof = false;
+};
+
+/**
+ * @brief A client connection and its upstream counterpart.
+ */
+struct Connection {
+    int id;
+    int client_fd = -1;
+    int upstream_fd = -1;
+    bool connecting = true;
+    int64_t opened = 0;
+    Pipe up;  // client to upstream
+    Pipe down;  // upstream to client
+};
+
+/**
+ * @brief A scripted change, applied when the proxy has run for at_us.
+ */
+struct ScriptEvent {
+    int64_t at_us;
+    std::string command;
+};
+
+/**
+ * @brief Proxy state shared by the event loop and the script commands.
+ */
+struct Proxy {
+    int64_t start = 0;
+    Impairment up;
+    Impairment down;
+    int64_t refuse_until = 0;
+    std::vector<Connection> connections;
+    std::vector<ScriptEvent> events;
+    std::mt19937_64 random;
+    int next_id = 1;
+};
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: ntrip_proxy -l port -u host:port [options]\n"
+              << "  -l port       local port NtripClient connects to\n"
+              << "  -u host:port  upstream caster\n"
+              << "  -d ms         delay, both directions\n"
+              << "  -j ms         jitter, both directions\n"
+              << "  -b bytes/s    bandwidth cap, both directions\n"
+              << "  -p bytes      split sends into segments of at most this size\n"
+              << "  -f script     timed commands, - for stdin\n"
+              << "  -S seed       jitter random seed\n"
+              << "script lines: <seconds> <command> [value] [up|down], commands:\n"
+              << "  delay ms | jitter ms | rate bytes/s | split bytes [gap_ms] | stall seconds\n"
+              << "  reset (RST every connection) | close (FIN every connection) | refuse seconds\n";
+}
+
+/**
+ * @brief Prints a timestamped line so runs can be correlated with client logs.
+ */
+static void log_event(const Proxy& proxy, const std::string& text) {
+    printf("%10.3f %s\n", (now_us() - proxy.start) / 1e6, text.c_str());
+    fflush(stdout);
+}
+
+/**
+ * @brief Applies one script command.
+ *
+ * @return false if the command is not understood.
+ */
+static bool apply_command(Proxy& proxy, const std::string& line) {
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+    std::vector<std::string> args;
+    std::string arg;
+    while (in >> arg) {
+        args.push_back(arg);
+    }
+    bool apply_up = true;
+    bool apply_down = true;
+    if (!args.empty() && (args.back() == "up" || args.back() == "down")) {
+        apply_up = args.back() == "up";
+        apply_down = !apply_up;
+        args.pop_back();
+    }
+    double value = args.empty() ? 0.0 : atof(args[0].c_str());
+    int64_t now = now_us();
+
+    auto each = [&](auto&& change) {
+        if (apply_up) {
+            change(proxy.up);
+        }
+        if (apply_down) {
+            change(proxy.down);
+        }
+    };
+    if (command == "delay") {
+        each([&](Impairment& imp) { imp.delay_us = static_cast<int64_t>(value * 1000); });
+    } else if (command == "jitter") {
+        each([&](Impairment& imp) { imp.jitter_us = static_cast<int64_t>(value * 1000); });
+    } else if (command == "rate") {
+        each([&](Impairment& imp) { imp.rate = static_cast<int64_t>(value); });
+    } else if (command == "split") {
+        int64_t gap = args.size() > 1 ? static_cast<int64_t>(atof(args[1].c_str()) * 1000) : 0;
+        each([&](Impairment& imp) {
+            imp.split = static_cast<size_t>(value);
+            imp.split_gap_us = gap;
+        });
+    } else if (command == "stall") {
+        each([&](Impairment& imp) { imp.stall_until = now + static_cast<int64_t>(value * 1e6); });
+    } else if (command == "refuse") {
+        proxy.refuse_until = now + static_cast<int64_t>(value * 1e6);
+    } else if (command == "reset" || command == "close") {
+        for (Connection& conn : proxy.connections) {
+            if (command == "reset") {
+                // a zero linger time turns close() into a RST
+                struct linger lin = {1, 0};
+                setsockopt(conn.client_fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+                setsockopt(conn.upstream_fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+            }
+            close(conn.client_fd);
+            close(conn.upstream_fd);
+            conn.client_fd = -1;
+            conn.upstream_fd = -1;
+        }
+    } else {
+        return false;
+    }
+    std::string text = command;
+    for (const std::string& value_text : args) {
+        text += " " + value_text;
+    }
+    log_event(proxy, text + (apply_up && apply_down ? "" : apply_up ? " up" : " down"));
+    return true;
+}
+
+/**
+ * @brief Parses script lines of the form "<seconds> <command> ...", ignoring comments.
+ */
+static void parse_script(Proxy& proxy, const std::string& text) {
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        std::istringstream fields(line);
+        double at;
+        if (!(fields >> at)) {
+            continue;
+        }
+        std::string rest;
+        std::getline(fields, rest);
+        proxy.events.push_back({static_cast<int64_t>(at * 1e6), rest});
+    }
+    std::stable_sort(proxy.events.begin(), proxy.events.end(),
+                     [](const ScriptEvent& a, const ScriptEvent& b) { return a.at_us < b.at_us; });
+}
+
+/**
+ * @brief Queues bytes read from one side with their release time.
+ */
+static void enqueue(Proxy& proxy, Pipe& pipe, const Impairment& imp, const char* data, size_t size) {
+    int64_t release = now_us() + imp.delay_us;
+    if (imp.jitter_us > 0) {
+        std::uniform_int_distribution<int64_t> spread(-imp.jitter_us, imp.jitter_us);
+        release += spread(proxy.random);
+    }
+    // TCP is a byte stream: jitter may bunch chunks but never reorders them
+    release = std::max(release, pipe.last_release);
+    pipe.last_release = release;
+    pipe.chunks.push_back({release, std::string(data, size)});
+    pipe.queued += size;
+}
+
+/**
+ * @brief Sends the chunks of a pipe that are due, honoring stalls, the rate cap and splitting.
+ *
+ * @param wake Lowered to the time the pipe next has work.
+ * @return false if the destination failed.
+ */
+static bool drain(Pipe& pipe, const Impairment& imp, int fd, int64_t now, int64_t* wake) {
+    if (imp.rate > 0) {
+        // at most a tenth of a second of burst
+        double burst = std::max(static_cast<double>(imp.rate) / 10.0, 1.0);
+        pipe.tokens = std::min(burst, pipe.tokens + (now - pipe.last_refill) * imp.rate / 1e6);
+    }
+    pipe.last_refill = now;
+    while (!pipe.chunks.empty()) {
+        Chunk& chunk = pipe.chunks.front();
+        int64_t due = std::max({chunk.release, imp.stall_until, pipe.next_send});
+        if (due > now) {
+            *wake = std::min(*wake, due);
+            return true;
+        }
+        size_t size = chunk.data.size() - chunk.offset;
+        if (imp.split > 0) {
+            size = std::min(size, imp.split);
+        }
+        if (imp.rate > 0) {
+            if (pipe.tokens < 1.0) {
+                *wake = std::min(*wake, now + static_cast<int64_t>((1.0 - pipe.tokens) * 1e6 / imp.rate) + 1);
+                return true;
+            }
+            size = std::min(size, static_cast<size_t>(pipe.tokens));
+        }
+        ssize_t ret = send(fd, chunk.data.data() + chunk.offset, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        chunk.offset += ret;
+        pipe.queued -= ret;
+        pipe.bytes += ret;
+        if (imp.rate > 0) {
+            pipe.tokens -= ret;
+        }
+        if (imp.split > 0 && imp.split_gap_us > 0) {
+            pipe.next_send = now + imp.split_gap_us;
+        }
+        if (chunk.offset == chunk.data.size()) {
+            pipe.chunks.pop_front();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads whatever a side has available into the opposite pipe.
+ *
+ * @return false on EOF or error.
+ */
+static bool pump(Proxy& proxy, int fd, Pipe& pipe, const Impairment& imp) {
+    char buffer[read_size];
+    ssize_t ret = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (ret > 0) {
+        enqueue(proxy, pipe, imp, buffer, ret);
+        return true;
+    }
+    return ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+}
+
+/**
+ * @brief Starts a non-blocking connection to the upstream caster.
+ */
+static int connect_upstream(const struct sockaddr_storage& addr, socklen_t addr_len) {
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, (const struct sockaddr*)&addr, addr_len) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Main function for the network impairment proxy.
+ *
+ * @return 0 if the program exits successfully.
+ */
+int main(int argc, char** argv) {
+    Proxy proxy;
+    int port = 0;
+    std::string upstream;
+    std::string script_path;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-l") {
+            port = atoi(value.c_str());
+        } else if (arg == "-u") {
+            upstream = value;
+        } else if (arg == "-d") {
+            proxy.up.delay_us = proxy.down.delay_us = static_cast<int64_t>(atof(value.c_str()) * 1000);
+        } else if (arg == "-j") {
+            proxy.up.jitter_us = proxy.down.jitter_us = static_cast<int64_t>(atof(value.c_str()) * 1000);
+        } else if (arg == "-b") {
+            proxy.up.rate = proxy.down.rate = atoll(value.c_str());
+        } else if (arg == "-p") {
+            proxy.up.split = proxy.down.split = static_cast<size_t>(atoll(value.c_str()));
+        } else if (arg == "-f") {
+            script_path = value;
+        } else if (arg == "-S") {
+            seed = strtoull(value.c_str(), nullptr, 10);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    size_t colon = upstream.rfind(':');
+    if (port <= 0 || colon == std::string::npos) {
+        usage();
+        return 1;
+    }
+    proxy.random.seed(seed);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(upstream.substr(0, colon).c_str(), upstream.substr(colon + 1).c_str(), &hints, &result) != 0) {
+        std::cerr << "Error: Could not resolve " << upstream << std::endl;
+        return 1;
+    }
+    struct sockaddr_storage upstream_addr;
+    socklen_t upstream_len = result->ai_addrlen;
+    memcpy(&upstream_addr, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 128) < 0) {
+        std::cerr << "Error: Could not listen on port " << port << std::endl;
+        return 1;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+
+    // a script from stdin is read as it arrives, so commands can also be typed live
+    int script_fd = -1;
+    std::string script_partial;
+    if (script_path == "-") {
+        script_fd = STDIN_FILENO;
+        fcntl(script_fd, F_SETFL, fcntl(script_fd, F_GETFL) | O_NONBLOCK);
+    } else if (!script_path.empty()) {
+        FILE* file = fopen(script_path.c_str(), "r");
+        if (file == nullptr) {
+            std::cerr << "Error: Could not open " << script_path << std::endl;
+            return 1;
+        }
+        std::string text;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+            text.append(buf, n);
+        }
+        fclose(file);
+        parse_script(proxy, text);
+    }
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGPIPE, SIG_IGN);
+    proxy.start = now_us();
+    size_t next_event = 0;
+    log_event(proxy, "listening on " + std::to_string(port) + " for " + upstream);
+
+    std::vector<struct pollfd> fds;
+    while (run) {
+        int64_t now = now_us();
+        while (next_event < proxy.events.size() && proxy.start + proxy.events[next_event].at_us <= now) {
+            if (!apply_command(proxy, proxy.events[next_event].command)) {
+                std::cerr << "Error: Unknown command:" << proxy.events[next_event].command << std::endl;
+            }
+            next_event++;
+        }
+
+        // forward due data and drop finished connections
+        int64_t wake = now + max_poll_us;
+        if (next_event < proxy.events.size()) {
+            wake = std::min(wake, proxy.start + proxy.events[next_event].at_us);
+        }
+        for (Connection& conn : proxy.connections) {
+            if (conn.client_fd < 0) {
+                continue;
+            }
+            bool ok = true;
+            if (!conn.connecting) {
+                ok = drain(conn.up, proxy.up, conn.upstream_fd, now, &wake) &&
+                     drain(conn.down, proxy.down, conn.client_fd, now, &wake);
+            }
+            bool finished = (conn.up.eof && conn.up.chunks.empty()) || (conn.down.eof && conn.down.chunks.empty());
+            if (!ok || finished) {
+                close(conn.client_fd);
+                close(conn.upstream_fd);
+                conn.client_fd = -1;
+                conn.upstream_fd = -1;
+            }
+        }
+        for (size_t i = 0; i < proxy.connections.size();) {
+            Connection& conn = proxy.connections[i];
+            if (conn.client_fd < 0) {
+                char text[160];
+                snprintf(text, sizeof(text), "closed #%d after %.3f s, down %llu bytes, up %llu bytes",
+                         conn.id, (now - conn.opened) / 1e6, static_cast<unsigned long long>(conn.down.bytes),
+                         static_cast<unsigned long long>(conn.up.bytes));
+                log_event(proxy, text);
+                proxy.connections[i] = std::move(proxy.connections.back());
+                proxy.connections.pop_back();
+            } else {
+                i++;
+            }
+        }
+
+        fds.clear();
+        fds.push_back({listen_fd, POLLIN, 0});
+        fds.push_back({script_fd, POLLIN, 0});
+        for (const Connection& conn : proxy.connections) {
+            short client_events = conn.up.queued < max_queued ? POLLIN : 0;
+            short upstream_events = conn.down.queued < max_queued ? POLLIN : 0;
+            if (!conn.down.chunks.empty()) {
+                client_events |= POLLOUT;
+            }
+            if (conn.connecting || !conn.up.chunks.empty()) {
+                upstream_events |= POLLOUT;
+            }
+            fds.push_back({conn.client_fd, client_events, 0});
+            fds.push_back({conn.upstream_fd, upstream_events, 0});
+        }
+        int64_t wait = wake - now_us();
+        poll(fds.data(), fds.size(), wait > 0 ? static_cast<int>((wait + 999) / 1000) : 0);
+        now = now_us();
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0) {
+                if (now < proxy.refuse_until) {
+                    struct linger lin = {1, 0};
+                    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+                    close(fd);
+                    log_event(proxy, "refused connection");
+                    continue;
+                }
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                Connection conn;
+                conn.id = proxy.next_id++;
+                conn.client_fd = fd;
+                conn.upstream_fd = connect_upstream(upstream_addr, upstream_len);
+                conn.opened = now;
+                if (conn.upstream_fd < 0) {
+                    close(fd);
+                    log_event(proxy, "upstream connect failed");
+                    continue;
+                }
+                log_event(proxy, "accepted #" + std::to_string(conn.id));
+                proxy.connections.push_back(std::move(conn));
+            }
+        }
+        if (fds[1].revents & (POLLIN | POLLHUP)) {
+            char buf[1024];
+            ssize_t ret = read(script_fd, buf, sizeof(buf));
+            if (ret <= 0 && !(ret < 0 && errno == EAGAIN)) {
+                script_fd = -1;
+            } else if (ret > 0) {
+                // live lines without a time are applied at once
+                script_partial.append(buf, ret);
+                size_t eol;
+                while ((eol = script_partial.find('\n')) != std::string::npos) {
+                    std::string line = script_partial.substr(0, eol);
+                    script_partial.erase(0, eol + 1);
+                    double at;
+                    std::istringstream fields(line);
+                    if (fields >> at) {
+                        std::string rest;
+                        std::getline(fields, rest);
+                        proxy.events.push_back({static_cast<int64_t>(at * 1e6), rest});
+                        std::stable_sort(proxy.events.begin() + next_event, proxy.events.end(),
+                                         [](const ScriptEvent& a, const ScriptEvent& b) { return a.at_us < b.at_us; });
+                    } else if (line.find_first_not_of(" \t\r") != std::string::npos && line[0] != '#') {
+                        if (!apply_command(proxy, line)) {
+                            std::cerr << "Error: Unknown command: " << line << std::endl;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < proxy.connections.size(); i++) {
+            Connection& conn = proxy.connections[i];
+            const struct pollfd& client = fds[2 + 2 * i];
+            const struct pollfd& upstream = fds[3 + 2 * i];
+            if (conn.client_fd < 0) {
+                continue;
+            }
+            if (conn.connecting && (upstream.revents & (POLLOUT | POLLERR | POLLHUP))) {
+                int error = 0;
+                socklen_t len = sizeof(error);
+                getsockopt(conn.upstream_fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                if (error != 0) {
+                    log_event(proxy, "upstream connect failed for #" + std::to_string(conn.id) + ": " + strerror(error));
+                    close(conn.client_fd);
+                    close(conn.upstream_fd);
+                    conn.client_fd = -1;
+                    conn.upstream_fd = -1;
+                    continue;
+                }
+                conn.connecting = false;
+            }
+            if (client.revents & (POLLIN | POLLHUP | POLLERR)) {
+                conn.up.eof = conn.up.eof || !pump(proxy, conn.client_fd, conn.up, proxy.up);
+            }
+            if (!conn.connecting && (upstream.revents & (POLLIN | POLLHUP | POLLERR))) {
+                bool had_data = conn.down.bytes > 0 || !conn.down.chunks.empty();
+                conn.down.eof = conn.down.eof || !pump(proxy, conn.upstream_fd, conn.down, proxy.down);
+                if (!had_data && !conn.down.chunks.empty()) {
+                    char text[96];
+                    snprintf(text, sizeof(text), "first upstream data for #%d after %.3f s",
+                             conn.id, (now - conn.opened) / 1e6);
+                    log_event(proxy, text);
+                }
+            }
+        }
+    }
+
+    for (Connection& conn : proxy.connections) {
+        close(conn.client_fd);
+        close(conn.upstream_fd);
+    }
+    close(listen_fd);
+    return 0;
+}
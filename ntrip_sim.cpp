@@ -0,0 +1,327 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "arrival_stats.h"
+#include "clock.h"
+#include "event_log.h"
+#include "ntrip_manager.h"
+#include "sim_transport.h"
+#include "stream_usage.h"
+
+#include <stdio.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr int64_t second_us = 1000000;
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: ntrip_sim [options]\n"
+              << "  -n streams       simulated streams (default 1000)\n"
+              << "  -t seconds       simulated duration (default 3600)\n"
+              << "  -i ms            correction interval (default 1000)\n"
+              << "  -f bytes         frame size (default 200)\n"
+              << "  -k frames        frames per interval (default 4)\n"
+              << "  -o start:len[:s] outage window in seconds, :s for a silent outage (repeatable)\n"
+              << "  -H requests      caster handshake capacity, further requests get 503 (default unlimited)\n"
+              << "  -a               admission control: limit concurrent handshakes per caster\n"
+              << "  -p high[:low]    the first high streams get high priority, the last low streams low priority\n"
+              << "  -b steps         low priority steps per loop iteration, 0 for no limit (default 32)\n"
+              << "  -x us            simulated processing time per frame, to overload the loop\n"
+              << "  -B               batch dispatch: frames reach the consumer once per read instead of one by one\n"
+              << "  -L file          binary event log of the first run, read it with ntrip_logdump\n"
+              << "  -r n             print the n most expensive streams\n"
+              << "  -c               check: run twice and compare the results for determinism\n";
+}
+
+/**
+ * @brief Result of one simulation run.
+ */
+struct SimResult {
+    SimStats stats;
+    uint64_t frames = 0;
+    uint64_t reconnects = 0;
+    uint64_t steps = 0;
+    std::vector<int64_t> recovery_us;  // per outage, from its end until every stream streams again
+    int admission_limit = 0;  // handshakes the manager learned the caster accepts at once
+    uint64_t overloads = 0;  // handshakes that ended in 429, 5xx or a timeout
+    double wall_seconds = 0.0;
+    std::vector<StreamUsageSample> usage;
+    // per priority class: streams, frame delivery latency from the caster send and dispatch delay
+    int class_streams[num_stream_priorities] = {};
+    std::unique_ptr<LogHistogram[]> latency{new LogHistogram[num_stream_priorities]};
+    std::unique_ptr<LogHistogram[]> dispatch_delay{new LogHistogram[num_stream_priorities]};
+};
+
+/**
+ * @brief Scheduling settings of a simulation run.
+ */
+struct SimScheduling {
+    int high_streams = 0;
+    int low_streams = 0;
+    int low_budget = NtripManager::default_low_budget;
+    int64_t frame_cost_us = 0;
+    bool admission = false;
+    bool batch = false;  // frames passed per read through the batch callback
+};
+
+/**
+ * @brief Runs one scenario in virtual time.
+ */
+static SimResult simulate(int streams, int64_t duration_us, const SimCasterProfile& profile,
+                          const std::vector<SimOutage>& outages, const SimScheduling& scheduling) {
+    SimResult result;
+    VirtualClock clock;
+    SimTransport transport(&clock, profile);
+    for (const SimOutage& outage : outages) {
+        transport.AddOutage(outage);
+    }
+    NtripManager manager(&clock, &transport);
+    manager.SetBudget(StreamPriority::kLow, scheduling.low_budget);
+    if (scheduling.admission) {
+        manager.EnableAdmissionControl();
+    }
+    std::string gga = "$GPGGA,000000.00,3110.0615,N,12112.9965,E,1,08,0.9,10.0,M,0.0,M,,*5C\r\n";
+    for (int i = 0; i < streams; i++) {
+        char mountpoint[32];
+        snprintf(mountpoint, sizeof(mountpoint), "SIM%05d", i);
+        int id = manager.AddStream("sim.caster", "2101", mountpoint, "user", "pass");
+        NtripClient& client = manager.stream(id);
+        client.SetQuiet(true);
+        client.UpdateGGA(gga);
+        StreamPriority priority = i < scheduling.high_streams ? StreamPriority::kHigh :
+                                  i >= streams - scheduling.low_streams ? StreamPriority::kLow : StreamPriority::kNormal;
+        manager.SetPriority(id, priority);
+        result.class_streams[static_cast<int>(priority)]++;
+        LogHistogram* latency = &result.latency[static_cast<int>(priority)];
+        int64_t cost = scheduling.frame_cost_us;
+        if (scheduling.batch) {
+            client.SetBatchCallback([&result, &clock, &transport, &client, latency, cost](const FrameBatch& batch) {
+                result.frames += batch.count;
+                clock.AdvanceTo(clock.Now() + cost * static_cast<int64_t>(batch.count));
+                int64_t sent = transport.DataTime(client.handle());
+                for (size_t f = 0; f < batch.count && sent >= 0; f++) {
+                    latency->Record(static_cast<uint64_t>(clock.Now() - sent));
+                }
+            });
+        } else {
+            client.SetFrameCallback([&result, &clock, &transport, &client, latency, cost](const uint8_t*, size_t) {
+                result.frames++;
+                // the work a real consumer does per frame takes loop time
+                clock.AdvanceTo(clock.Now() + cost);
+                int64_t sent = transport.DataTime(client.handle());
+                if (sent >= 0) {
+                    latency->Record(static_cast<uint64_t>(clock.Now() - sent));
+                }
+            });
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    manager.StartAll();
+    std::vector<int64_t> recovered(outages.size(), -1);
+    for (int64_t t = second_us; t <= duration_us; t += second_us) {
+        manager.RunUntil(t);
+        // recovery is sampled once per simulated second
+        for (size_t o = 0; o < outages.size(); o++) {
+            if (recovered[o] >= 0 || t < outages[o].end_us) {
+                continue;
+            }
+            bool all = true;
+            for (int id = 0; id < manager.num_streams() && all; id++) {
+                all = manager.stream(id).state() == NtripClient::State::kStreaming;
+            }
+            if (all) {
+                recovered[o] = t - outages[o].end_us;
+            }
+        }
+    }
+    result.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.stats = transport.stats();
+    result.steps = manager.steps();
+    for (int id = 0; id < manager.num_streams(); id++) {
+        result.reconnects += manager.stream(id).reconnects();
+    }
+    result.recovery_us = recovered;
+    if (streams > 0) {
+        result.admission_limit = manager.admission(0).limit();
+        result.overloads = manager.admission(0).overloads();
+    }
+    manager.SampleUsage(&result.usage);
+    for (int p = 0; p < num_stream_priorities; p++) {
+        const LogHistogram& delay = manager.dispatch_delay(static_cast<StreamPriority>(p));
+        result.dispatch_delay[p].Merge(delay);
+    }
+    return result;
+}
+
+/**
+ * @brief Main function for the virtual time NtripClient simulator.
+ *
+ * @return 0 if the program exits successfully, 2 if a determinism check fails.
+ */
+int main(int argc, char** argv) {
+    int streams = 1000;
+    int64_t duration_us = 3600 * second_us;
+    SimCasterProfile profile;
+    std::vector<SimOutage> outages;
+    bool check = false;
+    size_t report = 0;
+    std::string log_file;
+    SimScheduling scheduling;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-c") {
+            check = true;
+            continue;
+        } else if (arg == "-a") {
+            scheduling.admission = true;
+            continue;
+        } else if (arg == "-B") {
+            scheduling.batch = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-n") {
+            streams = atoi(value.c_str());
+        } else if (arg == "-t") {
+            duration_us = static_cast<int64_t>(atof(value.c_str()) * second_us);
+        } else if (arg == "-i") {
+            profile.data_interval_us = static_cast<int64_t>(atof(value.c_str()) * 1000);
+        } else if (arg == "-f") {
+            profile.frame_size = static_cast<size_t>(atoi(value.c_str()));
+        } else if (arg == "-k") {
+            profile.frames_per_interval = atoi(value.c_str());
+        } else if (arg == "-H") {
+            profile.handshake_capacity = atoi(value.c_str());
+        } else if (arg == "-L") {
+            log_file = value;
+        } else if (arg == "-p") {
+            if (sscanf(value.c_str(), "%d:%d", &scheduling.high_streams, &scheduling.low_streams) < 1) {
+                usage();
+                return 1;
+            }
+        } else if (arg == "-b") {
+            scheduling.low_budget = atoi(value.c_str());
+        } else if (arg == "-x") {
+            scheduling.frame_cost_us = static_cast<int64_t>(atof(value.c_str()));
+        } else if (arg == "-r") {
+            report = static_cast<size_t>(atoi(value.c_str()));
+        } else if (arg == "-o") {
+            double start = 0.0;
+            double length = 0.0;
+            char mode = 0;
+            if (sscanf(value.c_str(), "%lf:%lf:%c", &start, &length, &mode) < 2) {
+                usage();
+                return 1;
+            }
+            outages.push_back({static_cast<int64_t>(start * second_us),
+                               static_cast<int64_t>((start + length) * second_us), mode == 's'});
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (streams <= 0 || duration_us <= 0 || profile.data_interval_us <= 0) {
+        usage();
+        return 1;
+    }
+
+    if (!log_file.empty() && !event_log_open(log_file)) {
+        return 1;
+    }
+    SimResult result = simulate(streams, duration_us, profile, outages, scheduling);
+    event_log_close();
+    const SimStats& stats = result.stats;
+    printf("streams %d, simulated %.0f s in %.3f s wall (%.0fx), %llu steps (%.0f steps/s)\n",
+           streams, duration_us / 1e6, result.wall_seconds, duration_us / 1e6 / result.wall_seconds,
+           static_cast<unsigned long long>(result.steps), result.steps / result.wall_seconds);
+    printf("connects %llu, failed %llu, resets %llu, client reconnects %llu\n",
+           static_cast<unsigned long long>(stats.connects), static_cast<unsigned long long>(stats.failed_connects),
+           static_cast<unsigned long long>(stats.resets), static_cast<unsigned long long>(result.reconnects));
+    printf("requests %llu, rejected %llu\n", static_cast<unsigned long long>(stats.requests),
+           static_cast<unsigned long long>(stats.rejected));
+    printf("delivered %llu bytes, %llu frames\n",
+           static_cast<unsigned long long>(stats.bytes_delivered), static_cast<unsigned long long>(result.frames));
+    if (stats.gga_intervals > 0) {
+        printf("gga %llu, interval min %.3f ms, mean %.3f ms, max %.3f ms\n",
+               static_cast<unsigned long long>(stats.gga_received), stats.gga_interval_min / 1e3,
+               stats.gga_interval_sum / 1e3 / stats.gga_intervals, stats.gga_interval_max / 1e3);
+    }
+    if (scheduling.admission) {
+        printf("admission limit %d handshakes, %llu overloads\n", result.admission_limit,
+               static_cast<unsigned long long>(result.overloads));
+    }
+    for (size_t o = 0; o < outages.size(); o++) {
+        if (result.recovery_us[o] >= 0) {
+            printf("outage %zu (%s): all streams back %.0f s after it ended\n", o,
+                   outages[o].silent ? "silent" : "reset", result.recovery_us[o] / 1e6);
+        } else {
+            printf("outage %zu (%s): not every stream recovered\n", o, outages[o].silent ? "silent" : "reset");
+        }
+    }
+
+    if (scheduling.high_streams > 0 || scheduling.low_streams > 0 || scheduling.frame_cost_us > 0) {
+        printf("class    streams     frames  latency p50 ms  p99 ms  max ms  dispatch p99 ms  max ms\n");
+        for (int p = 0; p < num_stream_priorities; p++) {
+            const LogHistogram& latency = result.latency[p];
+            const LogHistogram& delay = result.dispatch_delay[p];
+            if (result.class_streams[p] == 0) {
+                continue;
+            }
+            printf("%-8s %7d %10llu %15.1f %7.1f %7.1f %16.1f %7.1f\n", priority_name(static_cast<StreamPriority>(p)),
+                   result.class_streams[p], static_cast<unsigned long long>(latency.count()),
+                   latency.Percentile(50) / 1e3, latency.Percentile(99) / 1e3, latency.max() / 1e3,
+                   delay.Percentile(99) / 1e3, delay.max() / 1e3);
+        }
+    }
+
+    if (report > 0) {
+        printf("%s", format_usage_table(result.usage, report, UsageKey::kCpu).c_str());
+    }
+
+    if (check) {
+        SimResult again = simulate(streams, duration_us, profile, outages, scheduling);
+        bool same = again.frames == result.frames && again.steps == result.steps &&
+                    again.reconnects == result.reconnects &&
+                    again.stats.bytes_delivered == stats.bytes_delivered &&
+                    again.stats.rejected == stats.rejected &&
+                    again.stats.gga_interval_sum == stats.gga_interval_sum &&
+                    again.recovery_us == result.recovery_us;
+        printf("determinism check: %s\n", same ? "identical" : "DIFFERENT");
+        return same ? 0 : 2;
+    }
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "clock.h"
+#include "ntrip_manager.h"
+#include "spp_engine.h"
+#include "stream_checkpoint.h"
+#include "transport.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+constexpr int64_t loop_wait_us = 100000;
+constexpr int64_t solve_interval_us = 200000;  // epochs of every station arrive within this, solved as one batch
+
+std::atomic<bool> run{true};
+
+/**
+ * @brief Signal handler for SIGINT and SIGTERM.
+ * 
+ * @param signal The signal number.
+ */
+void signal_handler(int signal) {
+    run = false;
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: ntrip_spp -s streams.txt [options]\n"
+              << "  -s file          one 'host port mountpoint [username [password]]' per line, one station each\n"
+              << "  -b mountpoint    DGNSS base: correct the other stations with this station's errors\n"
+              << "  -i seconds       print the station table this often (default 10, 0 only on exit)\n"
+              << "  -m degrees       elevation mask (default 10)\n"
+              << "  -l h,v           horizontal and vertical offset in m that flags a station (default 1,2)\n"
+              << "  -n epochs        epochs averaged before comparing with the limits (default 60)\n"
+              << "  -t               no troposphere model\n"
+              << "  -f               list only flagged stations\n"
+              << "  -a               admission control: limit concurrent handshakes per caster\n"
+              << "  -q               quiet, no per stream messages\n";
+}
+
+/**
+ * @brief One stream of the list.
+ */
+struct StreamSpec {
+    std::string host;
+    std::string port;
+    std::string mountpoint;
+    std::string username;
+    std::string password;
+};
+
+/**
+ * @brief Reads the stream list.
+ *
+ * @return false if the file cannot be read or a line is malformed.
+ */
+static bool load_streams(const std::string& path, std::vector<StreamSpec>* specs) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(file, line)) {
+        number++;
+        std::istringstream fields(line);
+        StreamSpec spec;
+        if (!(fields >> spec.host) || spec.host[0] == '#') {
+            continue;
+        }
+        if (!(fields >> spec.port >> spec.mountpoint)) {
+            std::cerr << "Error: " << path << ":" << number << ": expected host port mountpoint" << std::endl;
+            return false;
+        }
+        fields >> spec.username >> spec.password;
+        specs->push_back(spec);
+    }
+    return true;
+}
+
+/**
+ * @brief Raises the open file limit to the hard limit, one socket per station.
+ */
+static void raise_file_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/**
+ * @brief Prints the station table and the number of flagged stations.
+ */
+static void print_report(const SppEngine& engine, bool flagged_only) {
+    std::cout << engine.Report(flagged_only) << engine.moved() << " of " << engine.num_stations()
+              << " stations moved" << std::endl;
+}
+
+/**
+ * @brief Main function for the base station position monitor.
+ *
+ * @return 0 if the program exits successfully.
+ */
+int main(int argc, char** argv) {
+    std::string stream_file;
+    std::string base_mountpoint;
+    int64_t report_us = 10000000;
+    SppOptions options;
+    bool flagged_only = false;
+    bool admission = false;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-t") {
+            options.troposphere = false;
+            continue;
+        } else if (arg == "-f") {
+            flagged_only = true;
+            continue;
+        } else if (arg == "-a") {
+            admission = true;
+            continue;
+        } else if (arg == "-q") {
+            quiet = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-s") {
+            stream_file = value;
+        } else if (arg == "-b") {
+            base_mountpoint = value;
+        } else if (arg == "-i") {
+            report_us = static_cast<int64_t>(atof(value.c_str()) * 1000000);
+        } else if (arg == "-m") {
+            options.elevation_mask = atof(value.c_str());
+        } else if (arg == "-l") {
+            if (sscanf(value.c_str(), "%lf,%lf", &options.horizontal_limit, &options.vertical_limit) != 2) {
+                usage();
+                return 1;
+            }
+        } else if (arg == "-n") {
+            options.smoothing_epochs = atoi(value.c_str());
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (stream_file.empty()) {
+        usage();
+        return 1;
+    }
+
+    raise_file_limit();
+    std::vector<StreamSpec> specs;
+    if (!load_streams(stream_file, &specs)) {
+        return 1;
+    }
+    SystemClock clock;
+    SocketTransport transport;
+    NtripManager manager(&clock, &transport);
+    if (admission) {
+        manager.EnableAdmissionControl();
+    }
+    SppEngine engine(options);
+    for (const StreamSpec& spec : specs) {
+        int station = engine.AddStation(stream_key(spec.host, spec.port, spec.mountpoint));
+        if (spec.mountpoint == base_mountpoint) {
+            engine.SetBase(station);
+        }
+        int id = manager.AddStream(spec.host, spec.port, spec.mountpoint, spec.username, spec.password);
+        NtripClient& client = manager.stream(id);
+        client.SetQuiet(quiet);
+        client.SetFrameCallback([&engine, station](const uint8_t* frame, size_t size) {
+            engine.OnFrame(station, frame, size);
+        });
+    }
+    if (!base_mountpoint.empty() && std::find_if(specs.begin(), specs.end(), [&base_mountpoint](const StreamSpec& spec) {
+            return spec.mountpoint == base_mountpoint;
+        }) == specs.end()) {
+        std::cerr << "Error: base " << base_mountpoint << " is not in " << stream_file << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    manager.StartAll();
+    std::cout << "Monitoring " << specs.size() << " stations. Press Ctrl+C to stop." << std::endl;
+
+    int64_t next_solve = clock.Now() + solve_interval_us;
+    int64_t next_report = report_us > 0 ? clock.Now() + report_us : INT64_MAX;
+    while (run) {
+        manager.RunOnce(loop_wait_us);
+        int64_t now = clock.Now();
+        if (now >= next_solve) {
+            engine.Solve(nullptr);
+            next_solve = now + solve_interval_us;
+        }
+        if (now >= next_report) {
+            print_report(engine, flagged_only);
+            next_report += report_us;
+        }
+    }
+    engine.Solve(nullptr);
+    print_report(engine, flagged_only);
+    return 0;
+}
@@ -0,0 +1,969 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "rinex_converter.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iostream>
+
+constexpr int64_t gps_epoch_unix = 315964800;  // 1980-01-06 00:00:00 UTC
+constexpr int64_t gps_epoch_days = 3657;  // days from 1970-01-01 to the GPS epoch
+constexpr int64_t leap_seconds = 18;  // GPS - UTC
+constexpr int64_t bds_gps_offset_ms = 14000;  // GPS - BDT
+constexpr int64_t bds_week_offset = 1356;  // GPS week of the BDT epoch
+constexpr int64_t day_ms = 86400000;
+constexpr int64_t week_ms = 7 * day_ms;
+constexpr int64_t hour_ms = 3600000;
+constexpr int num_systems = static_cast<int>(GnssSystem::kCount);
+constexpr int max_header_signals = 8;  // signals per system listed in an observation header
+
+/**
+ * @brief Calendar representation of a GPS (or constellation) time.
+ */
+struct Calendar {
+    int year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int64_t ms;  // milliseconds within the minute
+    int day_of_year;
+};
+
+/**
+ * @brief Converts days since 1970-01-01 to a civil date (Hinnant's algorithm).
+ */
+static void civil_from_days(int64_t z, int* year, int* month, int* day) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    *day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    *month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    *year = static_cast<int>(yoe + era * 400 + (*month <= 2));
+}
+
+/**
+ * @brief Converts milliseconds since the GPS epoch to a calendar date in the same time scale.
+ */
+static Calendar gps_ms_to_calendar(int64_t gps_ms) {
+    Calendar cal;
+    int64_t days = gps_ms / day_ms;
+    int64_t ms_of_day = gps_ms - days * day_ms;
+    civil_from_days(days + gps_epoch_days, &cal.year, &cal.month, &cal.day);
+    static const int cumulative[] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    bool leap = (cal.year % 4 == 0 && cal.year % 100 != 0) || cal.year % 400 == 0;
+    cal.day_of_year = cumulative[cal.month - 1] + cal.day + ((leap && cal.month > 2) ? 1 : 0);
+    cal.hour = static_cast<int>(ms_of_day / hour_ms);
+    cal.minute = static_cast<int>((ms_of_day % hour_ms) / 60000);
+    cal.ms = ms_of_day % 60000;
+    return cal;
+}
+
+/**
+ * @brief Picks the time of week closest to the reference time.
+ */
+static int64_t resolve_tow(int64_t tow_ms, int64_t reference_ms) {
+    int64_t week = reference_ms / week_ms;
+    int64_t t = week * week_ms + tow_ms;
+    if (t - reference_ms > week_ms / 2) {
+        t -= week_ms;
+    } else if (t - reference_ms < -week_ms / 2) {
+        t += week_ms;
+    }
+    return t;
+}
+
+/**
+ * @brief Converts a GLONASS time of day (Moscow time) to GPS time near the reference time.
+ */
+static int64_t resolve_glonass_tod(int64_t tod_ms, int64_t reference_ms) {
+    int64_t utc_tod = tod_ms - 3 * hour_ms;
+    if (utc_tod < 0) {
+        utc_tod += day_ms;
+    }
+    int64_t reference_utc = reference_ms - leap_seconds * 1000;
+    int64_t t = (reference_utc / day_ms) * day_ms + utc_tod;
+    if (t - reference_utc > day_ms / 2) {
+        t -= day_ms;
+    } else if (t - reference_utc < -day_ms / 2) {
+        t += day_ms;
+    }
+    return t + leap_seconds * 1000;
+}
+
+/**
+ * @brief Expands a truncated week number to the full week closest to the reference week.
+ */
+static int64_t resolve_week(int64_t week, int bits, int64_t reference_week) {
+    int64_t modulus = int64_t(1) << bits;
+    int64_t delta = reference_week - week;
+    int64_t cycles = (delta >= 0 ? delta + modulus / 2 : delta - modulus / 2 + 1) / modulus;
+    return week + cycles * modulus;
+}
+
+/**
+ * @brief Writes an unsigned integer right-aligned in a fixed width field.
+ */
+static char* put_uint(char* p, uint64_t value, int width, char pad) {
+    char* end = p + width;
+    char* q = end;
+    do {
+        *--q = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0 && q > p);
+    while (q > p) {
+        *--q = pad;
+    }
+    return end;
+}
+
+/**
+ * @brief Writes a fixed-point number right-aligned in a Fortran Fw.d style field.
+ */
+static char* put_fixed(char* p, double value, int width, int decimals) {
+    static const double scale[] = {1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    char* end = p + width;
+    bool negative = value < 0.0;
+    double magnitude = negative ? -value : value;
+    if (!(magnitude < 9e17 / scale[decimals])) {
+        memset(p, '*', width);
+        return end;
+    }
+    uint64_t scaled = static_cast<uint64_t>(magnitude * scale[decimals] + 0.5);
+    negative = negative && scaled != 0;
+    char* q = end;
+    for (int i = 0; i < decimals; i++) {
+        *--q = static_cast<char>('0' + scaled % 10);
+        scaled /= 10;
+    }
+    if (decimals > 0) {
+        *--q = '.';
+    }
+    do {
+        *--q = static_cast<char>('0' + scaled % 10);
+        scaled /= 10;
+    } while (scaled != 0 && q > p);
+    if (negative && q > p) {
+        *--q = '-';
+    }
+    if (scaled != 0 || q < p) {
+        memset(p, '*', width);
+        return end;
+    }
+    while (q > p) {
+        *--q = ' ';
+    }
+    return end;
+}
+
+/**
+ * @brief Writes a number in the 19 character E19.12 layout used by RINEX navigation files.
+ */
+static char* put_sci(char* p, double value) {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    char* end = p + 19;
+    double magnitude = fabs(value);
+    int exponent = 0;
+    uint64_t mantissa = 0;
+    if (magnitude > 0.0 && isfinite(magnitude)) {
+        exponent = static_cast<int>(floor(log10(magnitude)));
+        int shift = 12 - exponent;
+        double scaled;
+        if (shift >= 0) {
+            scaled = shift <= 22 ? magnitude * powers[shift] : magnitude * pow(10.0, shift);
+        } else {
+            scaled = -shift <= 22 ? magnitude / powers[-shift] : magnitude / pow(10.0, -shift);
+        }
+        mantissa = static_cast<uint64_t>(scaled + 0.5);
+        if (mantissa >= 10000000000000ull) {
+            mantissa = (mantissa + 5) / 10;
+            exponent++;
+        } else if (mantissa < 1000000000000ull) {
+            mantissa *= 10;
+            exponent--;
+        }
+    }
+    p[0] = (value < 0.0 && mantissa != 0) ? '-' : ' ';
+    p[1] = static_cast<char>('0' + mantissa / 1000000000000ull);
+    p[2] = '.';
+    put_uint(p + 3, mantissa % 1000000000000ull, 12, '0');
+    p[15] = 'E';
+    p[16] = exponent < 0 ? '-' : '+';
+    put_uint(p + 17, static_cast<uint64_t>(exponent < 0 ? -exponent : exponent), 2, '0');
+    return end;
+}
+
+/**
+ * @brief Appends a header record, padding the content to 60 columns before the label.
+ */
+static void header_line(std::string& out, const std::string& content, const char* label) {
+    std::string line = content.substr(0, 60);
+    line.resize(60, ' ');
+    out += line;
+    out += label;
+    out += '\n';
+}
+
+/**
+ * @brief Converts a GPS URA index to meters.
+ */
+static double ura_meters(int index) {
+    static const double table[] = {
+        2.4, 3.4, 4.85, 6.85, 9.65, 13.65, 24.0, 48.0, 96.0, 192.0, 384.0, 768.0, 1536.0, 3072.0, 6144.0
+    };
+    return (index >= 0 && index < 15) ? table[index] : 6144.0;
+}
+
+/**
+ * @brief Converts a Galileo SISA index to meters.
+ */
+static double sisa_meters(int index) {
+    if (index < 50) return index * 0.01;
+    if (index < 75) return 0.5 + (index - 50) * 0.02;
+    if (index < 100) return 1.0 + (index - 75) * 0.04;
+    if (index < 126) return 2.0 + (index - 100) * 0.16;
+    return -1.0;
+}
+
+/**
+ * @brief Staged output for one RINEX file.
+ */
+struct RinexConverter::OutputFile {
+    std::string path;
+    std::string buffer;
+    int64_t hour = -1;
+    bool created = false;
+    bool failed = false;
+};
+
+/**
+ * @brief Observation cell waiting for its epoch to complete.
+ */
+struct PendingCell {
+    uint8_t system;
+    uint8_t prn;
+    uint8_t signal_id;
+    uint8_t valid;
+    bool half_cycle;
+    uint32_t lock_ms;
+    double pseudorange;
+    double phase_range;
+    double range_rate;
+    double cnr;
+};
+
+/**
+ * @brief Per stream conversion state.
+ */
+struct RinexConverter::Stream {
+    std::string name;
+    Rtcm3Station station;
+    bool have_station = false;
+    int64_t reference_ms = 0;  // last decoded epoch, GPS ms
+
+    int64_t epoch_ms = -1;
+    std::vector<PendingCell> pending;
+
+    OutputFile obs;
+    OutputFile nav;
+
+    // observation types of the current obs file
+    uint8_t signals[num_systems][max_header_signals];
+    int num_signals[num_systems];
+    bool doppler[num_systems];
+    int8_t column_of[num_systems][33];  // first column of a signal id, -1 if not in the header
+    uint32_t last_lock[num_systems][64][max_header_signals];
+    int8_t glo_channel[65];
+
+    // ephemerides already written to the current nav file
+    uint64_t written_eph[num_systems][64];
+
+    uint64_t epochs_written = 0;
+    uint64_t ephemerides_written = 0;
+    uint64_t dropped_signals = 0;
+    uint64_t bytes_written = 0;
+
+    Stream() {
+        memset(num_signals, 0, sizeof(num_signals));
+        memset(doppler, 0, sizeof(doppler));
+        memset(column_of, -1, sizeof(column_of));
+        memset(last_lock, 0, sizeof(last_lock));
+        memset(glo_channel, -128, sizeof(glo_channel));
+        memset(written_eph, 0, sizeof(written_eph));
+        pending.reserve(256);
+    }
+};
+
+/**
+ * @brief Constructor for RinexConverter.
+ *
+ * @param options The output settings.
+ */
+RinexConverter::RinexConverter(const RinexOptions& options) : options_(options) {
+    if (options_.version != 400) {
+        options_.version = 304;
+    }
+    SetReferenceTime(time(nullptr));
+}
+
+/**
+ * @brief Destructor for RinexConverter, flushing every stream.
+ */
+RinexConverter::~RinexConverter() {
+    Flush();
+}
+
+/**
+ * @brief Registers a stream.
+ *
+ * @param name The marker name, also used as the file name prefix.
+ * @return The stream handle to pass to OnFrame().
+ */
+int RinexConverter::AddStream(const std::string& name) {
+    std::unique_ptr<Stream> stream(new Stream());
+    for (char c : name) {
+        stream->name.push_back((isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_') ? c : '_');
+    }
+    if (stream->name.empty()) {
+        stream->name = "STREAM";
+    }
+    stream->reference_ms = reference_gps_ms_;
+    streams_.push_back(std::move(stream));
+    return static_cast<int>(streams_.size() - 1);
+}
+
+/**
+ * @brief Seeds the time used to resolve GNSS week numbers until the first epoch is decoded.
+ *
+ * @param unix_seconds Approximate UTC time of the data.
+ */
+void RinexConverter::SetReferenceTime(int64_t unix_seconds) {
+    reference_gps_ms_ = (unix_seconds - gps_epoch_unix + leap_seconds) * 1000;
+    for (auto& stream : streams_) {
+        stream->reference_ms = reference_gps_ms_;
+    }
+}
+
+/**
+ * @brief Converts one RTCM3 frame of a stream.
+ *
+ * @param stream The handle returned by AddStream().
+ * @param frame The complete frame, including header and CRC.
+ * @param size The frame size in bytes.
+ */
+void RinexConverter::OnFrame(int stream, const uint8_t* frame, size_t size) {
+    if (stream < 0 || stream >= static_cast<int>(streams_.size())) {
+        return;
+    }
+    Stream& s = *streams_[stream];
+    int type = rtcm3_message_type(frame, size);
+    GnssSystem system;
+    int level;
+    if (rtcm3_msm_info(type, &system, &level)) {
+        MsmMessage msm;
+        if (decode_rtcm3_msm(frame, size, &msm)) {
+            HandleMsm(s, msm);
+        }
+    } else if (type == 1005 || type == 1006) {
+        s.have_station = decode_rtcm3_station(frame, size, &s.station) || s.have_station;
+    } else if (type == 1019 || type == 1042 || type == 1045 || type == 1046) {
+        Rtcm3Ephemeris eph;
+        if (decode_rtcm3_ephemeris(frame, size, &eph)) {
+            HandleEphemeris(s, eph);
+        }
+    }
+}
+
+/**
+ * @brief Adds the cells of an MSM message to the stream's pending epoch.
+ */
+void RinexConverter::HandleMsm(Stream& stream, const MsmMessage& msm) {
+    int64_t epoch;
+    switch (msm.system) {
+        case GnssSystem::kGlonass:
+            epoch = resolve_glonass_tod(msm.epoch_ms, stream.reference_ms);
+            break;
+        case GnssSystem::kBeidou:
+            epoch = resolve_tow(msm.epoch_ms + bds_gps_offset_ms, stream.reference_ms);
+            break;
+        default:
+            epoch = resolve_tow(msm.epoch_ms, stream.reference_ms);
+            break;
+    }
+
+    if (stream.epoch_ms >= 0 && epoch != stream.epoch_ms) {
+        FlushEpoch(stream);
+    }
+    stream.epoch_ms = epoch;
+    stream.reference_ms = epoch;
+
+    if (msm.system == GnssSystem::kGlonass && (msm.msm_level == 5 || msm.msm_level == 7)) {
+        for (int i = 0; i < msm.num_sats; i++) {
+            if (msm.sat_ext_info[i] <= 13) {
+                stream.glo_channel[msm.sat_prn[i]] = static_cast<int8_t>(msm.sat_ext_info[i] - 7);
+            }
+        }
+    }
+    for (int i = 0; i < msm.num_cells; i++) {
+        const MsmCell& cell = msm.cells[i];
+        PendingCell pending;
+        pending.system = static_cast<uint8_t>(msm.system);
+        pending.prn = cell.prn;
+        pending.signal_id = cell.signal_id;
+        pending.valid = cell.valid;
+        pending.half_cycle = cell.half_cycle;
+        pending.lock_ms = cell.lock_ms;
+        pending.pseudorange = cell.pseudorange;
+        pending.phase_range = cell.phase_range;
+        pending.range_rate = cell.range_rate;
+        pending.cnr = cell.cnr;
+        stream.pending.push_back(pending);
+    }
+    if (!msm.multiple) {
+        FlushEpoch(stream);
+    }
+}
+
+/**
+ * @brief Writes the stream's pending epoch to its observation file.
+ */
+void RinexConverter::FlushEpoch(Stream& stream) {
+    if (stream.pending.empty()) {
+        stream.epoch_ms = -1;
+        return;
+    }
+    int64_t hour = stream.epoch_ms / hour_ms;
+    if (hour != stream.obs.hour) {
+        OpenObsFile(stream, hour);
+    }
+
+    std::sort(stream.pending.begin(), stream.pending.end(), [](const PendingCell& a, const PendingCell& b) {
+        if (a.system != b.system) return a.system < b.system;
+        if (a.prn != b.prn) return a.prn < b.prn;
+        return a.signal_id < b.signal_id;
+    });
+
+    // count satellites with at least one listed signal
+    int num_sats = 0;
+    int last_key = -1;
+    for (const PendingCell& cell : stream.pending) {
+        if (stream.column_of[cell.system][cell.signal_id] < 0) {
+            continue;
+        }
+        int key = cell.system * 256 + cell.prn;
+        if (key != last_key) {
+            num_sats++;
+            last_key = key;
+        }
+    }
+
+    std::string& out = stream.obs.buffer;
+    Calendar cal = gps_ms_to_calendar(stream.epoch_ms);
+    char line[40];
+    char* p = line;
+    *p++ = '>';
+    *p++ = ' ';
+    p = put_uint(p, cal.year, 4, '0');
+    *p++ = ' ';
+    p = put_uint(p, cal.month, 2, '0');
+    *p++ = ' ';
+    p = put_uint(p, cal.day, 2, '0');
+    *p++ = ' ';
+    p = put_uint(p, cal.hour, 2, '0');
+    *p++ = ' ';
+    p = put_uint(p, cal.minute, 2, '0');
+    p = put_fixed(p, cal.ms / 1000.0, 11, 7);
+    *p++ = ' ';
+    *p++ = ' ';
+    *p++ = '0';
+    p = put_uint(p, num_sats, 3, ' ');
+    *p++ = '\n';
+    out.append(line, p - line);
+
+    // one line per satellite, 16 columns (F14.3 + LLI + SSI) per observation type
+    char sat_line[3 + max_header_signals * 4 * 16 + 1];
+    size_t i = 0;
+    while (i < stream.pending.size()) {
+        const PendingCell& first = stream.pending[i];
+        const int sys = first.system;
+        const int columns = stream.num_signals[sys] * (stream.doppler[sys] ? 4 : 3);
+        size_t j = i;
+        char* q = sat_line;
+        bool any = false;
+        if (columns > 0) {
+            int prn = first.prn + (sys == static_cast<int>(GnssSystem::kSbas) ? 19 : 0);
+            sat_line[0] = gnss_system_char(static_cast<GnssSystem>(sys));
+            put_uint(sat_line + 1, prn, 2, '0');
+            memset(sat_line + 3, ' ', columns * 16);
+        }
+        for (; j < stream.pending.size() && stream.pending[j].system == first.system &&
+               stream.pending[j].prn == first.prn; j++) {
+            const PendingCell& cell = stream.pending[j];
+            int column = stream.column_of[sys][cell.signal_id];
+            if (column < 0) {
+                stream.dropped_signals++;
+                continue;
+            }
+            any = true;
+            int signal_index = column / (stream.doppler[sys] ? 4 : 3);
+            int glo_channel = stream.glo_channel[cell.prn];
+            double frequency = msm_signal_frequency(static_cast<GnssSystem>(sys), cell.signal_id, glo_channel);
+            int ssi = std::min(std::max(static_cast<int>(cell.cnr / 6.0), 1), 9);
+            char ssi_char = static_cast<char>('0' + ssi);
+            uint32_t& last_lock = stream.last_lock[sys][cell.prn - 1][signal_index];
+            int lli = (cell.lock_ms < last_lock || cell.lock_ms == 0) ? 1 : 0;
+            lli |= cell.half_cycle ? 2 : 0;
+            last_lock = cell.lock_ms;
+
+            char* field = sat_line + 3 + column * 16;
+            if (cell.valid & MsmCell::kPseudorange) {
+                put_fixed(field, cell.pseudorange, 14, 3);
+                field[15] = ssi_char;
+            }
+            field += 16;
+            if ((cell.valid & MsmCell::kPhase) && frequency > 0.0) {
+                put_fixed(field, cell.phase_range * frequency / speed_of_light, 14, 3);
+                if (lli) {
+                    field[14] = static_cast<char>('0' + lli);
+                }
+                field[15] = ssi_char;
+            }
+            field += 16;
+            if (stream.doppler[sys]) {
+                if ((cell.valid & MsmCell::kRate) && frequency > 0.0) {
+                    put_fixed(field, -cell.range_rate * frequency / speed_of_light, 14, 3);
+                    field[15] = ssi_char;
+                }
+                field += 16;
+            }
+            put_fixed(field, cell.cnr, 14, 3);
+        }
+        if (any) {
+            q = sat_line + 3 + columns * 16;
+            while (q > sat_line + 3 && q[-1] == ' ') {
+                q--;
+            }
+            *q++ = '\n';
+            out.append(sat_line, q - sat_line);
+        }
+        i = j;
+    }
+
+    stream.pending.clear();
+    stream.epoch_ms = -1;
+    stream.epochs_written++;
+    if (out.size() >= options_.flush_bytes) {
+        WriteOut(stream, stream.obs);
+    }
+}
+
+/**
+ * @brief Starts a new hourly observation file with a header built from the pending epoch.
+ */
+void RinexConverter::OpenObsFile(Stream& stream, int64_t hour) {
+    WriteOut(stream, stream.obs);
+
+    // observation types are taken from the signals present in the first epoch of the file
+    memset(stream.num_signals, 0, sizeof(stream.num_signals));
+    memset(stream.doppler, 0, sizeof(stream.doppler));
+    memset(stream.column_of, -1, sizeof(stream.column_of));
+    memset(stream.last_lock, 0, sizeof(stream.last_lock));
+    for (const PendingCell& cell : stream.pending) {
+        int sys = cell.system;
+        if (msm_signal_code(static_cast<GnssSystem>(sys), cell.signal_id) == nullptr) {
+            continue;
+        }
+        if (cell.valid & MsmCell::kRate) {
+            stream.doppler[sys] = true;
+        }
+        bool known = false;
+        for (int k = 0; k < stream.num_signals[sys]; k++) {
+            known = known || stream.signals[sys][k] == cell.signal_id;
+        }
+        if (!known && stream.num_signals[sys] < max_header_signals) {
+            stream.signals[sys][stream.num_signals[sys]++] = cell.signal_id;
+        }
+    }
+    for (int sys = 0; sys < num_systems; sys++) {
+        GnssSystem system = static_cast<GnssSystem>(sys);
+        std::sort(stream.signals[sys], stream.signals[sys] + stream.num_signals[sys], [system](uint8_t a, uint8_t b) {
+            return strcmp(msm_signal_code(system, a), msm_signal_code(system, b)) < 0;
+        });
+        for (int k = 0; k < stream.num_signals[sys]; k++) {
+            stream.column_of[sys][stream.signals[sys][k]] = static_cast<int8_t>(k * (stream.doppler[sys] ? 4 : 3));
+        }
+    }
+
+    Calendar cal = gps_ms_to_calendar(hour * hour_ms);
+    char name[64];
+    snprintf(name, sizeof(name), "_R_%04d%03d%02d00_01H_", cal.year, cal.day_of_year, cal.hour);
+    stream.obs.path = options_.output_dir + "/" + stream.name + name + options_.interval + "_MO.rnx";
+    stream.obs.hour = hour;
+    stream.obs.created = false;
+    stream.obs.failed = false;
+
+    char buf[96];
+    std::string& out = stream.obs.buffer;
+    snprintf(buf, sizeof(buf), "%9.2f           OBSERVATION DATA    M", options_.version / 100.0);
+    header_line(out, buf, "RINEX VERSION / TYPE");
+    time_t now = time(nullptr);
+    struct tm tm_now;
+    gmtime_r(&now, &tm_now);
+    char date[32];
+    strftime(date, sizeof(date), "%Y%m%d %H%M%S UTC", &tm_now);
+    snprintf(buf, sizeof(buf), "%-20.20s%-20.20s%-20.20s", options_.program.c_str(), "", date);
+    header_line(out, buf, "PGM / RUN BY / DATE");
+    header_line(out, stream.name, "MARKER NAME");
+    header_line(out, "NON_GEODETIC", "MARKER TYPE");
+    header_line(out, "", "OBSERVER / AGENCY");
+    header_line(out, "", "REC # / TYPE / VERS");
+    header_line(out, "", "ANT # / TYPE");
+    const double* xyz = stream.station.ecef;
+    snprintf(buf, sizeof(buf), "%14.4f%14.4f%14.4f", xyz[0], xyz[1], xyz[2]);
+    header_line(out, buf, "APPROX POSITION XYZ");
+    snprintf(buf, sizeof(buf), "%14.4f%14.4f%14.4f", stream.station.antenna_height, 0.0, 0.0);
+    header_line(out, buf, "ANTENNA: DELTA H/E/N");
+
+    for (int sys = 0; sys < num_systems; sys++) {
+        if (stream.num_signals[sys] == 0) {
+            continue;
+        }
+        GnssSystem system = static_cast<GnssSystem>(sys);
+        std::vector<std::string> types;
+        for (int k = 0; k < stream.num_signals[sys]; k++) {
+            const char* code = msm_signal_code(system, stream.signals[sys][k]);
+            types.push_back(std::string("C") + code);
+            types.push_back(std::string("L") + code);
+            if (stream.doppler[sys]) {
+                types.push_back(std::string("D") + code);
+            }
+            types.push_back(std::string("S") + code);
+        }
+        std::string line;
+        snprintf(buf, sizeof(buf), "%c  %3d", gnss_system_char(system), static_cast<int>(types.size()));
+        line = buf;
+        for (size_t k = 0; k < types.size(); k++) {
+            if (k > 0 && k % 13 == 0) {
+                header_line(out, line, "SYS / # / OBS TYPES");
+                line = "      ";
+            }
+            line += " " + types[k];
+        }
+        header_line(out, line, "SYS / # / OBS TYPES");
+    }
+    for (int sys = 0; sys < num_systems; sys++) {
+        if (stream.num_signals[sys] > 0) {
+            header_line(out, std::string(1, gnss_system_char(static_cast<GnssSystem>(sys))), "SYS / PHASE SHIFT");
+        }
+    }
+    if (stream.num_signals[static_cast<int>(GnssSystem::kGlonass)] > 0) {
+        std::vector<std::string> slots;
+        for (int prn = 1; prn <= 64; prn++) {
+            if (stream.glo_channel[prn] != -128) {
+                snprintf(buf, sizeof(buf), " R%02d %2d", prn, stream.glo_channel[prn]);
+                slots.push_back(buf);
+            }
+        }
+        snprintf(buf, sizeof(buf), "%3d", static_cast<int>(slots.size()));
+        std::string line = buf;
+        for (size_t k = 0; k < slots.size(); k++) {
+            if (k > 0 && k % 8 == 0) {
+                header_line(out, line, "GLONASS SLOT / FRQ #");
+                line = "   ";
+            }
+            line += slots[k];
+        }
+        header_line(out, line, "GLONASS SLOT / FRQ #");
+        header_line(out, " C1C    0.000 C1P    0.000 C2C    0.000 C2P    0.000", "GLONASS COD/PHS/BIS");
+    }
+    Calendar first = gps_ms_to_calendar(stream.epoch_ms);
+    snprintf(buf, sizeof(buf), "  %4d    %2d    %2d    %2d    %2d   %10.7f     GPS",
+             first.year, first.month, first.day, first.hour, first.minute, first.ms / 1000.0);
+    header_line(out, buf, "TIME OF FIRST OBS");
+    header_line(out, "", "END OF HEADER");
+}
+
+/**
+ * @brief Starts a new hourly navigation file.
+ */
+void RinexConverter::OpenNavFile(Stream& stream, int64_t hour) {
+    WriteOut(stream, stream.nav);
+    memset(stream.written_eph, 0, sizeof(stream.written_eph));
+
+    Calendar cal = gps_ms_to_calendar(hour * hour_ms);
+    char name[64];
+    snprintf(name, sizeof(name), "_R_%04d%03d%02d00_01H_MN.rnx", cal.year, cal.day_of_year, cal.hour);
+    stream.nav.path = options_.output_dir + "/" + stream.name + name;
+    stream.nav.hour = hour;
+    stream.nav.created = false;
+    stream.nav.failed = false;
+
+    char buf[96];
+    std::string& out = stream.nav.buffer;
+    snprintf(buf, sizeof(buf), "%9.2f           N: GNSS NAV DATA    M: MIXED", options_.version / 100.0);
+    header_line(out, buf, "RINEX VERSION / TYPE");
+    time_t now = time(nullptr);
+    struct tm tm_now;
+    gmtime_r(&now, &tm_now);
+    char date[32];
+    strftime(date, sizeof(date), "%Y%m%d %H%M%S UTC", &tm_now);
+    snprintf(buf, sizeof(buf), "%-20.20s%-20.20s%-20.20s", options_.program.c_str(), "", date);
+    header_line(out, buf, "PGM / RUN BY / DATE");
+    snprintf(buf, sizeof(buf), "%6d", static_cast<int>(leap_seconds));
+    header_line(out, buf, "LEAP SECONDS");
+    header_line(out, "", "END OF HEADER");
+}
+
+/**
+ * @brief Writes a new ephemeris to the stream's navigation file.
+ */
+void RinexConverter::HandleEphemeris(Stream& stream, const Rtcm3Ephemeris& eph) {
+    if (eph.prn < 1 || eph.prn > 64) {
+        return;
+    }
+    int64_t hour = stream.reference_ms / hour_ms;
+    if (hour != stream.nav.hour) {
+        OpenNavFile(stream, hour);
+    }
+    const int sys = static_cast<int>(eph.system);
+    uint64_t key = (static_cast<uint64_t>(eph.iode + 1) << 40) | (static_cast<uint64_t>(eph.toe) << 8) |
+                   static_cast<uint64_t>(eph.message_type & 0xFF);
+    if (stream.written_eph[sys][eph.prn - 1] == key) {
+        return;
+    }
+    stream.written_eph[sys][eph.prn - 1] = key;
+
+    // full week and time of the record in the constellation's own time scale
+    int64_t reference_week = stream.reference_ms / week_ms;
+    int64_t week;
+    int64_t transmit_ms;
+    int64_t calendar_base_ms;
+    if (eph.system == GnssSystem::kBeidou) {
+        week = resolve_week(eph.week, 13, reference_week - bds_week_offset);
+        calendar_base_ms = (week + bds_week_offset) * week_ms;
+        transmit_ms = (stream.reference_ms - bds_gps_offset_ms) % week_ms;
+    } else if (eph.system == GnssSystem::kGalileo) {
+        week = resolve_week(eph.week + 1024, 12, reference_week);
+        calendar_base_ms = week * week_ms;
+        transmit_ms = stream.reference_ms % week_ms;
+    } else {
+        week = resolve_week(eph.week, 10, reference_week);
+        calendar_base_ms = week * week_ms;
+        transmit_ms = stream.reference_ms % week_ms;
+    }
+    Calendar toc = gps_ms_to_calendar(calendar_base_ms + static_cast<int64_t>(eph.toc * 1000.0));
+
+    std::string& out = stream.nav.buffer;
+    char line[96];
+    char* p = line;
+    if (options_.version >= 400) {
+        const char* record = "LNAV";
+        if (eph.system == GnssSystem::kGalileo) {
+            record = eph.message_type == 1045 ? "FNAV" : "INAV";
+        } else if (eph.system == GnssSystem::kBeidou) {
+            record = (eph.prn <= 5 || eph.prn >= 59) ? "D2" : "D1";
+        }
+        p += snprintf(p, sizeof(line), "> EPH %c%02d %s\n", gnss_system_char(eph.system), eph.prn, record);
+        out.append(line, p - line);
+        p = line;
+    }
+    *p++ = gnss_system_char(eph.system);
+    p = put_uint(p, eph.prn, 2, '0');
+    *p++ = ' ';
+    p = put_uint(p, toc.year, 4, '0');
+    *p++ = ' ';
+    p = put_uint(p, toc.month, 2, '0');
+    *p++ = ' ';
+    p = put_uint(p, toc.day, 2, '0');
+    *p++ = ' ';
+    p = put_uint(p, toc.hour, 2, '0');
+    *p++ = ' ';
+    p = put_uint(p, toc.minute, 2, '0');
+    *p++ = ' ';
+    p = put_uint(p, toc.ms / 1000, 2, '0');
+    p = put_sci(p, eph.af0);
+    p = put_sci(p, eph.af1);
+    p = put_sci(p, eph.af2);
+    *p++ = '\n';
+    out.append(line, p - line);
+
+    double orbit[7][4];
+    double iod = eph.iode;
+    orbit[0][0] = iod; orbit[0][1] = eph.crs; orbit[0][2] = eph.delta_n; orbit[0][3] = eph.m0;
+    orbit[1][0] = eph.cuc; orbit[1][1] = eph.e; orbit[1][2] = eph.cus; orbit[1][3] = eph.sqrt_a;
+    orbit[2][0] = eph.toe; orbit[2][1] = eph.cic; orbit[2][2] = eph.omega0; orbit[2][3] = eph.cis;
+    orbit[3][0] = eph.i0; orbit[3][1] = eph.crc; orbit[3][2] = eph.omega; orbit[3][3] = eph.omega_dot;
+    int lines = 7;
+    if (eph.system == GnssSystem::kGps) {
+        orbit[4][0] = eph.idot; orbit[4][1] = eph.code_on_l2; orbit[4][2] = static_cast<double>(week);
+        orbit[4][3] = eph.l2p_flag;
+        orbit[5][0] = ura_meters(eph.accuracy); orbit[5][1] = eph.health; orbit[5][2] = eph.tgd[0];
+        orbit[5][3] = eph.iodc;
+        orbit[6][0] = transmit_ms / 1000.0; orbit[6][1] = eph.fit_interval;
+        orbit[6][2] = orbit[6][3] = NAN;
+    } else if (eph.system == GnssSystem::kGalileo) {
+        orbit[4][0] = eph.idot; orbit[4][1] = eph.message_type == 1045 ? 258 : 513;
+        orbit[4][2] = static_cast<double>(week); orbit[4][3] = NAN;
+        orbit[5][0] = sisa_meters(eph.accuracy); orbit[5][1] = eph.health; orbit[5][2] = eph.tgd[0];
+        orbit[5][3] = eph.tgd[1];
+        orbit[6][0] = transmit_ms / 1000.0;
+        orbit[6][1] = orbit[6][2] = orbit[6][3] = NAN;
+    } else {
+        orbit[4][0] = eph.idot; orbit[4][1] = NAN; orbit[4][2] = static_cast<double>(week); orbit[4][3] = NAN;
+        orbit[5][0] = ura_meters(eph.accuracy); orbit[5][1] = eph.health; orbit[5][2] = eph.tgd[0];
+        orbit[5][3] = eph.tgd[1];
+        orbit[6][0] = transmit_ms / 1000.0; orbit[6][1] = eph.iodc;
+        orbit[6][2] = orbit[6][3] = NAN;
+    }
+    for (int l = 0; l < lines; l++) {
+        p = line;
+        memset(p, ' ', 4);
+        p += 4;
+        int last = 4;
+        while (last > 0 && isnan(orbit[l][last - 1])) {
+            last--;
+        }
+        for (int k = 0; k < last; k++) {
+            if (isnan(orbit[l][k])) {
+                memset(p, ' ', 19);
+                p += 19;
+            } else {
+                p = put_sci(p, orbit[l][k]);
+            }
+        }
+        *p++ = '\n';
+        out.append(line, p - line);
+    }
+
+    stream.ephemerides_written++;
+    if (out.size() >= options_.flush_bytes) {
+        WriteOut(stream, stream.nav);
+    }
+}
+
+/**
+ * @brief Appends the staged bytes of a file to disk.
+ */
+void RinexConverter::WriteOut(Stream& stream, OutputFile& file) {
+    if (file.buffer.empty() || file.path.empty()) {
+        return;
+    }
+    if (!file.failed) {
+        int flags = O_WRONLY | O_CREAT | (file.created ? O_APPEND : O_TRUNC);
+        int fd = open(file.path.c_str(), flags, 0644);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open " << file.path << ", errno=" << errno << std::endl;
+            file.failed = true;
+        } else {
+            file.created = true;
+            const char* data = file.buffer.data();
+            size_t remaining = file.buffer.size();
+            while (remaining > 0) {
+                ssize_t ret = write(fd, data, remaining);
+                if (ret < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    std::cerr << "Error: Could not write " << file.path << ", errno=" << errno << std::endl;
+                    file.failed = true;
+                    break;
+                }
+                data += ret;
+                remaining -= ret;
+                stream.bytes_written += ret;
+            }
+            close(fd);
+        }
+    }
+    file.buffer.clear();
+}
+
+/**
+ * @brief Writes out pending epochs and staged output of every stream.
+ */
+void RinexConverter::Flush() {
+    for (auto& stream : streams_) {
+        FlushEpoch(*stream);
+        WriteOut(*stream, stream->obs);
+        WriteOut(*stream, stream->nav);
+    }
+}
+
+/**
+ * @brief Returns the number of observation epochs written across all streams.
+ */
+uint64_t RinexConverter::EpochsWritten() const {
+    uint64_t total = 0;
+    for (const auto& stream : streams_) {
+        total += stream->epochs_written;
+    }
+    return total;
+}
+
+/**
+ * @brief Returns the number of navigation records written across all streams.
+ */
+uint64_t RinexConverter::EphemeridesWritten() const {
+    uint64_t total = 0;
+    for (const auto& stream : streams_) {
+        total += stream->ephemerides_written;
+    }
+    return total;
+}
+
+/**
+ * @brief Returns the number of signals left out because the file header did not list them.
+ */
+uint64_t RinexConverter::DroppedSignals() const {
+    uint64_t total = 0;
+    for (const auto& stream : streams_) {
+        total += stream->dropped_signals;
+    }
+    return total;
+}
+
+/**
+ * @brief Returns the number of bytes written to disk across all streams.
+ */
+uint64_t RinexConverter::BytesWritten() const {
+    uint64_t total = 0;
+    for (const auto& stream : streams_) {
+        total += stream->bytes_written;
+    }
+    return total;
+}
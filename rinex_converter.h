@@ -0,0 +1,157 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "rtcm3.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Output settings for RinexConverter.
+ */
+struct RinexOptions {
+    std::string output_dir = ".";
+    int version = 304;  // 304 (RINEX 3.04) or 400 (RINEX 4.00)
+    std::string interval = "01S";  // sampling field of the long file name
+    std::string program = "ntrip_client";
+    size_t flush_bytes = 64 * 1024;  // per file staging size before a write() is issued
+};
+
+/**
+ * @brief Streaming RTCM3 to RINEX observation/navigation converter.
+ *
+ * Each stream (usually one mountpoint) gets its own hourly observation and mixed navigation
+ * files. Records are formatted straight into a per-file staging buffer with fixed-point
+ * formatting and written out in large appends, so no file descriptor is held open between
+ * flushes and thousands of streams can be converted in one process.
+ *
+ * A stream must only be fed from one thread at a time; different streams may be fed
+ * concurrently once all streams have been added.
+ */
+class RinexConverter {
+public:
+
+    /**
+     * @brief Constructor for RinexConverter.
+     *
+     * @param options The output settings.
+     */
+    explicit RinexConverter(const RinexOptions& options);
+
+    /**
+     * @brief Destructor for RinexConverter, flushing every stream.
+     */
+    ~RinexConverter();
+
+    /**
+     * @brief Registers a stream.
+     *
+     * @param name The marker name, also used as the file name prefix.
+     * @return The stream handle to pass to OnFrame().
+     */
+    int AddStream(const std::string& name);
+
+    /**
+     * @brief Seeds the time used to resolve GNSS week numbers until the first epoch is decoded.
+     *
+     * @param unix_seconds Approximate UTC time of the data.
+     */
+    void SetReferenceTime(int64_t unix_seconds);
+
+    /**
+     * @brief Converts one RTCM3 frame of a stream.
+     *
+     * @param stream The handle returned by AddStream().
+     * @param frame The complete frame, including header and CRC.
+     * @param size The frame size in bytes.
+     */
+    void OnFrame(int stream, const uint8_t* frame, size_t size);
+
+    /**
+     * @brief Writes out pending epochs and staged output of every stream.
+     */
+    void Flush();
+
+    /**
+     * @brief Returns the number of observation epochs written across all streams.
+     */
+    uint64_t EpochsWritten() const;
+
+    /**
+     * @brief Returns the number of navigation records written across all streams.
+     */
+    uint64_t EphemeridesWritten() const;
+
+    /**
+     * @brief Returns the number of signals left out because the file header did not list them.
+     */
+    uint64_t DroppedSignals() const;
+
+    /**
+     * @brief Returns the number of bytes written to disk across all streams.
+     */
+    uint64_t BytesWritten() const;
+
+private:
+    struct OutputFile;
+    struct Stream;
+
+    /**
+     * @brief Adds the cells of an MSM message to the stream's pending epoch.
+     */
+    void HandleMsm(Stream& stream, const MsmMessage& msm);
+
+    /**
+     * @brief Writes the stream's pending epoch to its observation file.
+     */
+    void FlushEpoch(Stream& stream);
+
+    /**
+     * @brief Writes a new ephemeris to the stream's navigation file.
+     */
+    void HandleEphemeris(Stream& stream, const Rtcm3Ephemeris& eph);
+
+    /**
+     * @brief Starts a new hourly observation file with a header built from the pending epoch.
+     */
+    void OpenObsFile(Stream& stream, int64_t hour);
+
+    /**
+     * @brief Starts a new hourly navigation file.
+     */
+    void OpenNavFile(Stream& stream, int64_t hour);
+
+    /**
+     * @brief Appends the staged bytes of a file to disk.
+     */
+    void WriteOut(Stream& stream, OutputFile& file);
+
+    RinexOptions options_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+    int64_t reference_gps_ms_ = 0;
+};
@@ -0,0 +1,225 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "rtcm2.h"
+
+#include <string.h>
+
+constexpr int rtcm2_word_bytes = 5;  // 6 bits of the word in each byte
+constexpr uint32_t rtcm2_data_mask = 0xFFFFFF;
+constexpr uint32_t rtcm2_d30_star = 0x40000000;
+
+/**
+ * @brief Per byte lookup tables for the word parity and the 6-of-8 bit order.
+ *
+ * Each parity bit is the XOR of D29* or D30* and a fixed subset of the data bits, so the
+ * parity of a word is the XOR of the contributions of its four bytes.
+ */
+struct Rtcm2Tables {
+    uint8_t parity[4][256];
+    uint8_t reverse[64];
+
+    constexpr Rtcm2Tables() : parity(), reverse() {
+        // D25..D30 over D29*, D30*, d1..d24 in bits 31..6 (ICD-GPS-200 table 20-XIV)
+        const uint32_t masks[6] = {0xBB1F3480, 0x5D8F9A40, 0xAEC7CD00, 0x5763E680, 0x6BB1F340, 0x8B7A89C0};
+        for (int b = 0; b < 4; b++) {
+            for (uint32_t v = 0; v < 256; v++) {
+                uint32_t word = v << (24 - 8 * b);
+                uint8_t bits = 0;
+                for (int p = 0; p < 6; p++) {
+                    uint32_t x = word & masks[p];
+                    int ones = 0;
+                    for (; x != 0; x &= x - 1) {
+                        ones++;
+                    }
+                    bits = static_cast<uint8_t>((bits << 1) | (ones & 1));
+                }
+                parity[b][v] = bits;
+            }
+        }
+        for (uint32_t v = 0; v < 64; v++) {
+            uint8_t r = 0;
+            for (int i = 0; i < 6; i++) {
+                r = static_cast<uint8_t>((r << 1) | ((v >> i) & 1));
+            }
+            reverse[v] = r;
+        }
+    }
+};
+
+static constexpr Rtcm2Tables rtcm2_tables;
+
+/**
+ * @brief Computes the 6 parity bits of an RTCM 2 (GPS ICD) word.
+ *
+ * @param word D29* and D30* of the previous word in bits 31-30, then the 24 source data
+ *             bits d1..d24 (corrected for D30*) in bits 29-6; the other bits are ignored.
+ * @return The expected parity D25..D30.
+ */
+uint32_t rtcm2_parity(uint32_t word) {
+    return rtcm2_tables.parity[0][word >> 24] ^ rtcm2_tables.parity[1][(word >> 16) & 0xFF] ^
+           rtcm2_tables.parity[2][(word >> 8) & 0xFF] ^ rtcm2_tables.parity[3][word & 0xC0];
+}
+
+/**
+ * @brief Returns the source data bits of a received word, undoing the D30* inversion.
+ */
+static inline uint32_t rtcm2_source_data(uint32_t word) {
+    uint32_t data = (word >> 6) & rtcm2_data_mask;
+    return (word & rtcm2_d30_star) ? data ^ rtcm2_data_mask : data;
+}
+
+/**
+ * @brief Checks the parity of a received word against its source data.
+ */
+static inline bool rtcm2_word_ok(uint32_t word, uint32_t data) {
+    return rtcm2_parity((word & 0xC0000000) | (data << 6)) == (word & 0x3F);
+}
+
+/**
+ * @brief Decodes the reference station position of an RTCM 2 type 3 message.
+ *
+ * @return true if the message holds a station position.
+ */
+bool decode_rtcm2_station(const uint8_t* frame, size_t size, Rtcm3Station* station) {
+    if (rtcm2_message_type(frame, size) != 3 || size < (rtcm2_header_words + 4) * rtcm2_word_size) {
+        return false;
+    }
+    station->station_id = static_cast<uint16_t>(rtcm2_station_id(frame));
+    for (int axis = 0; axis < 3; axis++) {
+        station->ecef[axis] = getbits(frame, 48 + axis * 32, 32) * 0.01;
+    }
+    station->antenna_height = 0.0;
+    return true;
+}
+
+/**
+ * @brief Encodes an RTCM 2 message into its 6-of-8 packed wire format.
+ *
+ * @return The number of bytes written.
+ */
+size_t encode_rtcm2_message(int type, int station_id, int zcount, int sequence, const uint8_t* data,
+                            size_t words, uint8_t* out, uint32_t* last) {
+    words = words > rtcm2_max_data_words ? rtcm2_max_data_words : words;
+    uint32_t header[2] = {
+        (static_cast<uint32_t>(rtcm2_preamble) << 16) | ((type & 0x3F) << 10) | (station_id & 0x3FF),
+        ((zcount & 0x1FFF) << 11) | ((sequence & 0x7) << 8) | (static_cast<uint32_t>(words) << 3),
+    };
+    size_t pos = 0;
+    for (size_t w = 0; w < rtcm2_header_words + words; w++) {
+        uint32_t source = header[w < 2 ? w : 0];
+        if (w >= 2) {
+            const uint8_t* bytes = data + (w - 2) * rtcm2_word_size;
+            source = (bytes[0] << 16) | (bytes[1] << 8) | bytes[2];
+        }
+        uint32_t parity = rtcm2_parity((*last << 30) | (source << 6));
+        uint32_t sent = (*last & 1) ? source ^ rtcm2_data_mask : source;
+        uint32_t word = (sent << 6) | parity;
+        for (int b = 0; b < rtcm2_word_bytes; b++) {
+            out[pos++] = static_cast<uint8_t>(0x40 | rtcm2_tables.reverse[(word >> (24 - 6 * b)) & 0x3F]);
+        }
+        *last = word & 3;
+    }
+    return pos;
+}
+
+/**
+ * @brief Drops any partially received message and the word synchronisation.
+ */
+void Rtcm2Framer::Reset() {
+    word_ = 0;
+    bytes_ = 0;
+    synced_ = false;
+    words_ = 0;
+    need_ = 0;
+}
+
+/**
+ * @brief Handles a complete 30 bit word held in word_.
+ */
+void Rtcm2Framer::OnWord(const Rtcm3Framer::FrameCallback& callback) {
+    bytes_ = 0;
+    uint32_t data = rtcm2_source_data(word_);
+    if (!rtcm2_word_ok(word_, data)) {
+        // keep the bits: the next preamble may start inside this word
+        parity_errors_++;
+        synced_ = false;
+        bytes_ = rtcm2_word_bytes;
+        words_ = 0;
+        return;
+    }
+    if (words_ == 0 && (data >> 16) != rtcm2_preamble) {
+        // the previous message ended but no new one starts here
+        synced_ = false;
+        bytes_ = rtcm2_word_bytes;
+        return;
+    }
+    uint8_t* out = stage_ + words_ * rtcm2_word_size;
+    out[0] = static_cast<uint8_t>(data >> 16);
+    out[1] = static_cast<uint8_t>(data >> 8);
+    out[2] = static_cast<uint8_t>(data);
+    words_++;
+    if (words_ == rtcm2_header_words) {
+        need_ = rtcm2_header_words + ((data >> 3) & 0x1F);
+    }
+    if (words_ >= rtcm2_header_words && words_ == need_) {
+        frames_++;
+        callback(stage_, words_ * rtcm2_word_size);
+        words_ = 0;
+    }
+}
+
+/**
+ * @brief Feeds received bytes and invokes the callback once per valid message.
+ *
+ * @param data The received bytes.
+ * @param size The number of received bytes.
+ * @param callback Called with each complete message, see the class description.
+ */
+void Rtcm2Framer::Push(const uint8_t* data, size_t size, const Rtcm3Framer::FrameCallback& callback) {
+    for (size_t i = 0; i < size; i++) {
+        uint8_t byte = data[i];
+        if ((byte & 0xC0) != 0x40) {
+            skipped_bytes_++;
+            continue;
+        }
+        word_ = (word_ << 6) | rtcm2_tables.reverse[byte & 0x3F];
+        if (synced_) {
+            if (++bytes_ == rtcm2_word_bytes) {
+                OnWord(callback);
+            }
+            continue;
+        }
+        // hunt for a preamble word on every byte boundary
+        skipped_bytes_++;
+        if (bytes_ < rtcm2_word_bytes && ++bytes_ < rtcm2_word_bytes) {
+            continue;
+        }
+        uint32_t source = rtcm2_source_data(word_);
+        if ((source >> 16) == rtcm2_preamble && rtcm2_word_ok(word_, source)) {
+            synced_ = true;
+            words_ = 0;
+            OnWord(callback);
+        }
+    }
+}
@@ -0,0 +1,150 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "rtcm3.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr uint8_t rtcm2_preamble = 0x66;
+constexpr size_t rtcm2_word_size = 3;  // data bytes of a 30 bit word, parity stripped
+constexpr size_t rtcm2_header_words = 2;
+constexpr size_t rtcm2_max_data_words = 31;
+constexpr size_t rtcm2_max_frame_size = (rtcm2_header_words + rtcm2_max_data_words) * rtcm2_word_size;
+
+/**
+ * @brief Computes the 6 parity bits of an RTCM 2 (GPS ICD) word.
+ *
+ * @param word D29* and D30* of the previous word in bits 31-30, then the 24 source data
+ *             bits d1..d24 (corrected for D30*) in bits 29-6; the other bits are ignored.
+ * @return The expected parity D25..D30.
+ */
+uint32_t rtcm2_parity(uint32_t word);
+
+/**
+ * @brief Returns the message type of a decoded RTCM 2 message (0 if incomplete).
+ */
+inline int rtcm2_message_type(const uint8_t* frame, size_t size) {
+    if (size < rtcm2_header_words * rtcm2_word_size) {
+        return 0;
+    }
+    return static_cast<int>(getbitu(frame, 8, 6));
+}
+
+/**
+ * @brief Returns the reference station id of a decoded RTCM 2 message.
+ */
+inline int rtcm2_station_id(const uint8_t* frame) {
+    return static_cast<int>(getbitu(frame, 14, 10));
+}
+
+/**
+ * @brief Returns the modified Z-count of a decoded RTCM 2 message in seconds of the hour.
+ */
+inline double rtcm2_zcount(const uint8_t* frame) {
+    return getbitu(frame, 24, 13) * 0.6;
+}
+
+/**
+ * @brief Returns the number of data words announced by the header of an RTCM 2 message.
+ */
+inline size_t rtcm2_data_words(const uint8_t* frame) {
+    return getbitu(frame, 40, 5);
+}
+
+/**
+ * @brief Decodes the reference station position of an RTCM 2 type 3 message.
+ *
+ * @return true if the message holds a station position.
+ */
+bool decode_rtcm2_station(const uint8_t* frame, size_t size, Rtcm3Station* station);
+
+/**
+ * @brief Encodes an RTCM 2 message into its 6-of-8 packed wire format.
+ *
+ * Used to produce test streams; the inverse of Rtcm2Framer.
+ *
+ * @param type The message type (1..63).
+ * @param station_id The reference station id (0..1023).
+ * @param zcount The modified Z-count in 0.6 s units (0..5999).
+ * @param sequence The 3 bit sequence number.
+ * @param data The data words, 3 bytes each, most significant first.
+ * @param words The number of data words (at most rtcm2_max_data_words).
+ * @param out Receives 5 bytes per word, (2 + words) * 5 bytes in total.
+ * @param last D29* and D30* of the previous word on the wire, updated for the next message.
+ * @return The number of bytes written.
+ */
+size_t encode_rtcm2_message(int type, int station_id, int zcount, int sequence, const uint8_t* data,
+                            size_t words, uint8_t* out, uint32_t* last);
+
+/**
+ * @brief Splits an RTCM 2 byte stream into parity checked messages.
+ *
+ * RTCM 2 carries 30 bit words (24 data bits and 6 parity bits) packed 6 bits per byte,
+ * least significant bit first, with 01 in the two top bits of every byte. A word therefore
+ * always occupies 5 whole bytes, so the framer only has to look for the preamble on byte
+ * boundaries. Messages are handed out as their header and data words with the parity
+ * stripped and the D30* inversion undone, 3 bytes per word, so the usual bit field helpers
+ * read them like an RTCM3 payload.
+ */
+class Rtcm2Framer {
+public:
+
+    /**
+     * @brief Feeds received bytes and invokes the callback once per valid message.
+     *
+     * @param data The received bytes.
+     * @param size The number of received bytes.
+     * @param callback Called with each complete message, see the class description.
+     */
+    void Push(const uint8_t* data, size_t size, const Rtcm3Framer::FrameCallback& callback);
+
+    /**
+     * @brief Drops any partially received message and the word synchronisation.
+     */
+    void Reset();
+
+    uint64_t frames() const { return frames_; }
+    uint64_t parity_errors() const { return parity_errors_; }
+    uint64_t skipped_bytes() const { return skipped_bytes_; }  // read while hunting for a preamble
+    size_t staged() const { return words_ * rtcm2_word_size; }
+
+private:
+
+    /**
+     * @brief Handles a complete 30 bit word held in word_.
+     */
+    void OnWord(const Rtcm3Framer::FrameCallback& callback);
+
+    uint32_t word_ = 0;  // D29*, D30* of the previous word and the 30 bits received since
+    int bytes_ = 0;  // bytes of the current word received, 5 when complete
+    bool synced_ = false;
+    size_t words_ = 0;  // words of the current message received
+    size_t need_ = 0;  // words of the current message, known once the second header word arrived
+    uint8_t stage_[rtcm2_max_frame_size];
+    uint64_t frames_ = 0;
+    uint64_t parity_errors_ = 0;
+    uint64_t skipped_bytes_ = 0;
+};
@@ -0,0 +1,278 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "decode_pipeline.h"
+#include "ntrip_client.h"
+#include "rinex_converter.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr size_t read_chunk = 1 << 20;
+
+bool run = true;
+
+/**
+ * @brief Signal handler for SIGINT.
+ *
+ * @param signal The signal number.
+ */
+void signal_handler(int signal) {
+    run = false;
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: rtcm2rinex [-d dir] [-v 3|4] [-t unix_time] [-j workers] NAME=FILE ...\n"
+              << "       rtcm2rinex [-d dir] [-v 3|4] -n host port mountpoint username password\n"
+              << "  -d dir        output directory (default .)\n"
+              << "  -v 3|4        RINEX 3.04 or 4.00 output (default 3)\n"
+              << "  -t unix_time  approximate UTC time of recorded files, for week resolution\n"
+              << "  -j workers    convert on this many threads, one stream per thread at a time; live streams\n"
+              << "                are converted on one worker instead of the network thread\n"
+              << "  -n ...        convert a live NTRIP stream until Ctrl+C\n";
+}
+
+/**
+ * @brief Converts one recorded RTCM3 file into a converter stream.
+ *
+ * @return true if the file could be read.
+ */
+static bool convert_file(RinexConverter& converter, int stream, const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return false;
+    }
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[read_chunk]);
+    Rtcm3Framer framer;
+    auto on_frame = [&converter, stream](const uint8_t* frame, size_t size) {
+        converter.OnFrame(stream, frame, size);
+    };
+    ssize_t ret;
+    while ((ret = read(fd, buffer.get(), read_chunk)) > 0) {
+        framer.Push(buffer.get(), ret, on_frame);
+    }
+    close(fd);
+    if (framer.crc_errors() > 0) {
+        std::cerr << path << ": " << framer.crc_errors() << " frames failed the CRC check" << std::endl;
+    }
+    return ret == 0;
+}
+
+/**
+ * @brief Converts recorded files on a pool of decode workers.
+ *
+ * The files are read in turns, a chunk of each at a time, so every worker has work while this
+ * thread frames the input; each file is one stream and keeps its order on its worker.
+ *
+ * @return true if every file could be read.
+ */
+static bool convert_files_parallel(RinexConverter& converter, const std::vector<int>& streams,
+                                   const std::vector<std::string>& paths, int workers) {
+    DecodePipeline pipeline(workers, [&converter, &streams](int, const PipelineFrame& frame) {
+        converter.OnFrame(streams[frame.stream], frame.data, frame.size);
+    });
+    DecodePipeline::Producer* producer = pipeline.AddProducer();
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[read_chunk]);
+    std::vector<int> fds;
+    std::vector<Rtcm3Framer> framers(paths.size());
+    bool ok = true;
+    for (const std::string& path : paths) {
+        fds.push_back(open(path.c_str(), O_RDONLY));
+        if (fds.back() < 0) {
+            std::cerr << "Error: Could not open " << path << std::endl;
+            ok = false;
+        }
+    }
+    uint64_t dropped = 0;
+    size_t open_files = fds.size();
+    while (open_files > 0) {
+        open_files = 0;
+        for (size_t i = 0; i < fds.size(); i++) {
+            if (fds[i] < 0) {
+                continue;
+            }
+            ssize_t ret = read(fds[i], buffer.get(), read_chunk);
+            if (ret <= 0) {
+                ok = ok && ret == 0;
+                close(fds[i]);
+                fds[i] = -1;
+                continue;
+            }
+            open_files++;
+            uint32_t stream = static_cast<uint32_t>(i);
+            framers[i].Push(buffer.get(), ret, [producer, stream, &dropped](const uint8_t* frame, size_t size) {
+                if (!producer->Submit(stream, frame, size)) {
+                    dropped++;
+                }
+            });
+            producer->Flush();
+        }
+    }
+    pipeline.Drain();
+    pipeline.Stop();
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (framers[i].crc_errors() > 0) {
+            std::cerr << paths[i] << ": " << framers[i].crc_errors() << " frames failed the CRC check" << std::endl;
+        }
+    }
+    if (dropped > 0) {
+        std::cerr << "Error: " << dropped << " frames could not be queued for decoding" << std::endl;
+        ok = false;
+    }
+    std::cout << pipeline.Report();
+    return ok;
+}
+
+/**
+ * @brief Main function for the RTCM3 to RINEX converter.
+ *
+ * @return 0 if the program exits successfully.
+ */
+int main(int argc, char** argv) {
+    RinexOptions options;
+    int64_t reference_time = 0;
+    int workers = 0;
+    std::vector<std::string> inputs;
+    std::vector<std::string> ntrip;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-d" && i + 1 < argc) {
+            options.output_dir = argv[++i];
+        } else if (arg == "-v" && i + 1 < argc) {
+            options.version = (std::atoi(argv[++i]) == 4) ? 400 : 304;
+        } else if (arg == "-t" && i + 1 < argc) {
+            reference_time = std::atoll(argv[++i]);
+        } else if (arg == "-j" && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        } else if (arg == "-n" && i + 5 < argc) {
+            ntrip.assign(argv + i + 1, argv + i + 6);
+            i += 5;
+        } else if (arg.find('=') != std::string::npos) {
+            inputs.push_back(arg);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (inputs.empty() == ntrip.empty()) {
+        usage();
+        return 1;
+    }
+
+    RinexConverter converter(options);
+    if (reference_time != 0) {
+        converter.SetReferenceTime(reference_time);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!ntrip.empty()) {
+        int stream = converter.AddStream(ntrip[2]);
+        NtripClient client(ntrip[0], ntrip[1], ntrip[2], ntrip[3], ntrip[4]);
+        // with -j the client thread only hands frames over and the conversion runs on a worker
+        std::unique_ptr<DecodePipeline> pipeline;
+        DecodePipeline::Producer* producer = nullptr;
+        if (workers > 0) {
+            pipeline.reset(new DecodePipeline(1, [&converter, stream](int, const PipelineFrame& frame) {
+                converter.OnFrame(stream, frame.data, frame.size);
+            }));
+        }
+        uint64_t dropped = 0;
+        // frames arrive a socket read at a time, so the pipeline is flushed once per read
+        client.SetBatchCallback([&converter, &client, &pipeline, &producer, &dropped, stream](const FrameBatch& batch) {
+            // only RTCM3 carries the MSM observations to convert
+            if (client.format() != StreamFormat::kRtcm3) {
+                return;
+            }
+            if (!pipeline) {
+                for (size_t i = 0; i < batch.count; i++) {
+                    converter.OnFrame(stream, batch.frames[i].data, batch.frames[i].size);
+                }
+                return;
+            }
+            if (producer == nullptr) {
+                producer = pipeline->AddProducer();
+            }
+            for (size_t i = 0; i < batch.count; i++) {
+                if (!producer->Submit(0, batch.frames[i].data, batch.frames[i].size)) {
+                    dropped++;
+                }
+            }
+            producer->Flush();
+        });
+        if (!client.Run()) {
+            return 1;
+        }
+        std::signal(SIGINT, signal_handler);
+        while (run && client.IsRunning()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        client.Stop();
+        if (pipeline) {
+            pipeline->Stop();
+        }
+        if (dropped > 0) {
+            std::cerr << "Error: " << dropped << " frames could not be queued for decoding" << std::endl;
+        }
+    } else {
+        std::vector<int> streams;
+        for (const std::string& input : inputs) {
+            streams.push_back(converter.AddStream(input.substr(0, input.find('='))));
+        }
+        std::vector<std::string> paths;
+        for (const std::string& input : inputs) {
+            paths.push_back(input.substr(input.find('=') + 1));
+        }
+        if (workers > 0) {
+            convert_files_parallel(converter, streams, paths, workers);
+        } else {
+            for (size_t i = 0; i < inputs.size(); i++) {
+                convert_file(converter, streams[i], paths[i]);
+            }
+        }
+    }
+    converter.Flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "epochs: " << converter.EpochsWritten()
+              << " ephemerides: " << converter.EphemeridesWritten()
+              << " dropped signals: " << converter.DroppedSignals()
+              << " bytes: " << converter.BytesWritten()
+              << " time: " << seconds << " s" << std::endl;
+    return 0;
+}
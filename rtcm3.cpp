@@ -0,0 +1,684 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "rtcm3.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+constexpr double range_ms = speed_of_light * 0.001;  // m per ms of light travel time
+constexpr uint32_t crc24q_poly = 0x1864CFB;
+
+/**
+ * @brief Builds the byte-wise lookup table for CRC-24Q.
+ */
+struct Crc24qTable {
+    uint32_t entries[256];
+    constexpr Crc24qTable() : entries() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i << 16;
+            for (int j = 0; j < 8; j++) {
+                crc <<= 1;
+                if (crc & 0x1000000) {
+                    crc ^= crc24q_poly;
+                }
+            }
+            entries[i] = crc & 0xFFFFFF;
+        }
+    }
+};
+
+static constexpr Crc24qTable crc_table;
+
+/**
+ * @brief Computes the CRC-24Q checksum used by RTCM3 frames.
+ *
+ * @param data The bytes to checksum.
+ * @param size The number of bytes.
+ * @return The 24 bit checksum.
+ */
+uint32_t crc24q(const uint8_t* data, size_t size) {
+    uint32_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc = ((crc << 8) & 0xFFFFFF) ^ crc_table.entries[(crc >> 16) ^ data[i]];
+    }
+    return crc;
+}
+
+/**
+ * @brief Checks the trailing CRC of a complete frame.
+ */
+static bool frame_crc_ok(const uint8_t* frame, size_t size) {
+    const uint8_t* tail = frame + size - rtcm3_crc_size;
+    uint32_t expected = (static_cast<uint32_t>(tail[0]) << 16) | (tail[1] << 8) | tail[2];
+    return crc24q(frame, size - rtcm3_crc_size) == expected;
+}
+
+/**
+ * @brief Returns the RINEX system identifier (G, R, E, S, J, C, I) for a constellation.
+ */
+char gnss_system_char(GnssSystem system) {
+    static const char ids[] = "GRESJCI";
+    size_t index = static_cast<size_t>(system);
+    return index < sizeof(ids) - 1 ? ids[index] : '?';
+}
+
+/**
+ * @brief Maps an MSM message number to its constellation and MSM level.
+ *
+ * @return true if the message number is an MSM1..MSM7 message.
+ */
+bool rtcm3_msm_info(int message_type, GnssSystem* system, int* level) {
+    if (message_type < 1071 || message_type > 1137) {
+        return false;
+    }
+    int group = (message_type - 1071) / 10;
+    int msm = (message_type - 1071) % 10 + 1;
+    if (msm > 7) {
+        return false;
+    }
+    static const GnssSystem systems[] = {
+        GnssSystem::kGps, GnssSystem::kGlonass, GnssSystem::kGalileo, GnssSystem::kSbas,
+        GnssSystem::kQzss, GnssSystem::kBeidou, GnssSystem::kNavic
+    };
+    *system = systems[group];
+    *level = msm;
+    return true;
+}
+
+/**
+ * @brief Signal id to RINEX code tables from RTCM 10403.3, indexed [system][signal id].
+ */
+struct SignalTable {
+    const char* codes[static_cast<int>(GnssSystem::kCount)][33];
+
+    SignalTable() : codes() {
+        struct Entry { GnssSystem system; int id; const char* code; };
+        static const Entry entries[] = {
+            {GnssSystem::kGps, 2, "1C"}, {GnssSystem::kGps, 3, "1P"}, {GnssSystem::kGps, 4, "1W"},
+            {GnssSystem::kGps, 8, "2C"}, {GnssSystem::kGps, 9, "2P"}, {GnssSystem::kGps, 10, "2W"},
+            {GnssSystem::kGps, 15, "2S"}, {GnssSystem::kGps, 16, "2L"}, {GnssSystem::kGps, 17, "2X"},
+            {GnssSystem::kGps, 22, "5I"}, {GnssSystem::kGps, 23, "5Q"}, {GnssSystem::kGps, 24, "5X"},
+            {GnssSystem::kGps, 30, "1S"}, {GnssSystem::kGps, 31, "1L"}, {GnssSystem::kGps, 32, "1X"},
+            {GnssSystem::kGlonass, 2, "1C"}, {GnssSystem::kGlonass, 3, "1P"},
+            {GnssSystem::kGlonass, 8, "2C"}, {GnssSystem::kGlonass, 9, "2P"},
+            {GnssSystem::kGalileo, 2, "1C"}, {GnssSystem::kGalileo, 3, "1A"}, {GnssSystem::kGalileo, 4, "1B"},
+            {GnssSystem::kGalileo, 5, "1X"}, {GnssSystem::kGalileo, 6, "1Z"}, {GnssSystem::kGalileo, 8, "6C"},
+            {GnssSystem::kGalileo, 9, "6A"}, {GnssSystem::kGalileo, 10, "6B"}, {GnssSystem::kGalileo, 11, "6X"},
+            {GnssSystem::kGalileo, 12, "6Z"}, {GnssSystem::kGalileo, 14, "7I"}, {GnssSystem::kGalileo, 15, "7Q"},
+            {GnssSystem::kGalileo, 16, "7X"}, {GnssSystem::kGalileo, 18, "8I"}, {GnssSystem::kGalileo, 19, "8Q"},
+            {GnssSystem::kGalileo, 20, "8X"}, {GnssSystem::kGalileo, 22, "5I"}, {GnssSystem::kGalileo, 23, "5Q"},
+            {GnssSystem::kGalileo, 24, "5X"},
+            {GnssSystem::kSbas, 2, "1C"}, {GnssSystem::kSbas, 22, "5I"}, {GnssSystem::kSbas, 23, "5Q"},
+            {GnssSystem::kSbas, 24, "5X"},
+            {GnssSystem::kQzss, 2, "1C"}, {GnssSystem::kQzss, 9, "6S"}, {GnssSystem::kQzss, 10, "6L"},
+            {GnssSystem::kQzss, 11, "6X"}, {GnssSystem::kQzss, 15, "2S"}, {GnssSystem::kQzss, 16, "2L"},
+            {GnssSystem::kQzss, 17, "2X"}, {GnssSystem::kQzss, 22, "5I"}, {GnssSystem::kQzss, 23, "5Q"},
+            {GnssSystem::kQzss, 24, "5X"}, {GnssSystem::kQzss, 30, "1S"}, {GnssSystem::kQzss, 31, "1L"},
+            {GnssSystem::kQzss, 32, "1X"},
+            {GnssSystem::kBeidou, 2, "2I"}, {GnssSystem::kBeidou, 3, "2Q"}, {GnssSystem::kBeidou, 4, "2X"},
+            {GnssSystem::kBeidou, 8, "6I"}, {GnssSystem::kBeidou, 9, "6Q"}, {GnssSystem::kBeidou, 10, "6X"},
+            {GnssSystem::kBeidou, 14, "7I"}, {GnssSystem::kBeidou, 15, "7Q"}, {GnssSystem::kBeidou, 16, "7X"},
+            {GnssSystem::kBeidou, 22, "5D"}, {GnssSystem::kBeidou, 23, "5P"}, {GnssSystem::kBeidou, 24, "5X"},
+            {GnssSystem::kBeidou, 25, "7D"}, {GnssSystem::kBeidou, 30, "1D"}, {GnssSystem::kBeidou, 31, "1P"},
+            {GnssSystem::kBeidou, 32, "1X"},
+            {GnssSystem::kNavic, 8, "9A"}, {GnssSystem::kNavic, 22, "5A"},
+        };
+        for (const Entry& entry : entries) {
+            codes[static_cast<int>(entry.system)][entry.id] = entry.code;
+        }
+    }
+};
+
+static const SignalTable signal_table;
+
+/**
+ * @brief Returns the RINEX 3 two character signal code ("1C", "2W", ...) of an MSM signal id.
+ *
+ * @return nullptr if the signal is not defined for the constellation.
+ */
+const char* msm_signal_code(GnssSystem system, int signal_id) {
+    if (system >= GnssSystem::kCount || signal_id < 1 || signal_id > 32) {
+        return nullptr;
+    }
+    return signal_table.codes[static_cast<int>(system)][signal_id];
+}
+
+/**
+ * @brief Returns the carrier frequency in Hz of an MSM signal.
+ *
+ * @param glo_channel The GLONASS frequency channel (-7..6), ignored for other systems.
+ * @return 0 if unknown.
+ */
+double msm_signal_frequency(GnssSystem system, int signal_id, int glo_channel) {
+    const char* code = msm_signal_code(system, signal_id);
+    if (code == nullptr) {
+        return 0.0;
+    }
+    char band = code[0];
+    switch (system) {
+        case GnssSystem::kGps:
+        case GnssSystem::kQzss:
+        case GnssSystem::kSbas:
+            if (band == '1') return 1575.42e6;
+            if (band == '2') return 1227.60e6;
+            if (band == '5') return 1176.45e6;
+            if (band == '6') return 1278.75e6;
+            break;
+        case GnssSystem::kGlonass:
+            if (glo_channel < -7 || glo_channel > 6) return 0.0;
+            if (band == '1') return 1602.0e6 + glo_channel * 0.5625e6;
+            if (band == '2') return 1246.0e6 + glo_channel * 0.4375e6;
+            break;
+        case GnssSystem::kGalileo:
+            if (band == '1') return 1575.42e6;
+            if (band == '5') return 1176.45e6;
+            if (band == '6') return 1278.75e6;
+            if (band == '7') return 1207.14e6;
+            if (band == '8') return 1191.795e6;
+            break;
+        case GnssSystem::kBeidou:
+            if (band == '1') return 1575.42e6;
+            if (band == '2') return 1561.098e6;
+            if (band == '5') return 1176.45e6;
+            if (band == '6') return 1268.52e6;
+            if (band == '7') return 1207.14e6;
+            break;
+        case GnssSystem::kNavic:
+            if (band == '5') return 1176.45e6;
+            if (band == '9') return 2492.028e6;
+            break;
+        default:
+            break;
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Converts an MSM4/5 lock time indicator (DF402) to milliseconds.
+ */
+static uint32_t msm_lock_time(uint32_t lock) {
+    return lock == 0 ? 0 : (16u << lock);
+}
+
+/**
+ * @brief Converts an MSM6/7 extended lock time indicator (DF407) to milliseconds.
+ */
+static uint32_t msm_lock_time_ext(uint32_t lock) {
+    if (lock < 64) {
+        return lock;
+    }
+    if (lock > 704) {
+        return 0;
+    }
+    // each group of 32 values above 64 doubles the resolution of the previous one
+    uint32_t group = lock / 32 - 1;
+    return (1u << group) * (lock - 32 * group);
+}
+
+/**
+ * @brief Decodes a 1005 or 1006 frame.
+ *
+ * @return true if the frame holds a station position.
+ */
+bool decode_rtcm3_station(const uint8_t* frame, size_t size, Rtcm3Station* station) {
+    int type = rtcm3_message_type(frame, size);
+    size_t payload = rtcm3_payload_length(frame);
+    if ((type != 1005 && type != 1006) || payload < (type == 1005 ? 19u : 21u)) {
+        return false;
+    }
+    int i = 24 + 12;
+    station->station_id = static_cast<uint16_t>(getbitu(frame, i, 12)); i += 12;
+    i += 6 + 4;  // ITRF year, GPS/GLONASS/Galileo indicators and reference station flag
+    station->ecef[0] = getbits64(frame, i, 38) * 0.0001; i += 38;
+    i += 2;  // single receiver oscillator, reserved
+    station->ecef[1] = getbits64(frame, i, 38) * 0.0001; i += 38;
+    i += 2;  // quarter cycle indicator
+    station->ecef[2] = getbits64(frame, i, 38) * 0.0001; i += 38;
+    station->antenna_height = 0.0;
+    if (type == 1006) {
+        station->antenna_height = getbitu(frame, i, 16) * 0.0001;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the constellation and epoch time of an MSM1..MSM7 frame without decoding the rest.
+ *
+ * @param epoch_ms Receives the time of week in ms, for GLONASS the time of day (Moscow).
+ * @return true if the frame is an MSM message.
+ */
+bool rtcm3_msm_epoch(const uint8_t* frame, size_t size, GnssSystem* system, uint32_t* epoch_ms) {
+    int level;
+    if (size < rtcm3_header_size + 7 || !rtcm3_msm_info(rtcm3_message_type(frame, size), system, &level)) {
+        return false;
+    }
+    if (*system == GnssSystem::kGlonass) {
+        *epoch_ms = getbitu(frame, 24 + 12 + 12 + 3, 27);
+    } else {
+        *epoch_ms = getbitu(frame, 24 + 12 + 12, 30);
+    }
+    return true;
+}
+
+/**
+ * @brief Returns true if an MSM1..MSM7 frame has its multiple message bit set: more MSM messages follow for its epoch.
+ */
+bool rtcm3_msm_multiple(const uint8_t* frame, size_t size) {
+    GnssSystem system;
+    int level;
+    if (size < rtcm3_header_size + 7 || !rtcm3_msm_info(rtcm3_message_type(frame, size), &system, &level)) {
+        return false;
+    }
+    return getbitu(frame, 24 + 12 + 12 + 30, 1) != 0;
+}
+
+/**
+ * @brief Decodes an MSM4, MSM5, MSM6 or MSM7 frame of any constellation.
+ *
+ * @return true if the frame is a complete MSM message.
+ */
+bool decode_rtcm3_msm(const uint8_t* frame, size_t size, MsmMessage* msm) {
+    int type = rtcm3_message_type(frame, size);
+    GnssSystem system;
+    int level;
+    if (!rtcm3_msm_info(type, &system, &level) || level < 4) {
+        return false;
+    }
+    size_t payload = rtcm3_payload_length(frame);
+    if (size != payload + rtcm3_header_size + rtcm3_crc_size || payload < 21) {
+        return false;
+    }
+    const int end = static_cast<int>(24 + payload * 8);
+
+    int i = 24 + 12;
+    msm->system = system;
+    msm->msm_level = level;
+    msm->station_id = static_cast<uint16_t>(getbitu(frame, i, 12)); i += 12;
+    if (system == GnssSystem::kGlonass) {
+        msm->glo_day_of_week = static_cast<uint8_t>(getbitu(frame, i, 3)); i += 3;
+        msm->epoch_ms = getbitu(frame, i, 27); i += 27;
+    } else {
+        msm->glo_day_of_week = 7;
+        msm->epoch_ms = getbitu(frame, i, 30); i += 30;
+    }
+    msm->multiple = getbitu(frame, i, 1) != 0; i += 1;
+    i += 3 + 7 + 2 + 2 + 1 + 3;  // IODS, reserved, clock steering, external clock, smoothing
+
+    int num_sats = 0;
+    for (int j = 0; j < 64; j++) {
+        if (getbitu(frame, i + j, 1)) {
+            msm->sat_prn[num_sats++] = static_cast<uint8_t>(j + 1);
+        }
+    }
+    i += 64;
+    uint8_t sig_ids[32];
+    int num_sigs = 0;
+    for (int j = 0; j < 32; j++) {
+        if (getbitu(frame, i + j, 1)) {
+            sig_ids[num_sigs++] = static_cast<uint8_t>(j + 1);
+        }
+    }
+    i += 32;
+    if (num_sats * num_sigs > 64) {
+        return false;
+    }
+    const int mask_bits = num_sats * num_sigs;
+    if (i + mask_bits > end) {
+        return false;
+    }
+
+    int num_cells = 0;
+    for (int s = 0; s < num_sats; s++) {
+        for (int g = 0; g < num_sigs; g++) {
+            if (getbitu(frame, i + s * num_sigs + g, 1)) {
+                MsmCell& cell = msm->cells[num_cells++];
+                cell.prn = static_cast<uint8_t>(s);  // satellite index until resolved below
+                cell.signal_id = sig_ids[g];
+            }
+        }
+    }
+    i += mask_bits;
+
+    const bool extended = (level == 5 || level == 7);
+    const bool high_res = (level >= 6);
+    const int sat_bits = 18 + (extended ? 18 : 0);
+    const int cell_bits = high_res ? (20 + 24 + 10 + 1 + 10) : (15 + 22 + 4 + 1 + 6);
+    if (i + num_sats * sat_bits + num_cells * (cell_bits + (extended ? 15 : 0)) > end) {
+        return false;
+    }
+
+    double rough_range[64];
+    double rough_rate[64];
+    bool range_ok[64];
+    bool rate_ok[64];
+    for (int s = 0; s < num_sats; s++) {
+        uint32_t ms = getbitu(frame, i, 8); i += 8;
+        range_ok[s] = (ms != 255);
+        rough_range[s] = ms * range_ms;
+    }
+    for (int s = 0; s < num_sats; s++) {
+        msm->sat_ext_info[s] = extended ? static_cast<uint8_t>(getbitu(frame, i, 4)) : 15;
+        i += extended ? 4 : 0;
+    }
+    for (int s = 0; s < num_sats; s++) {
+        rough_range[s] += getbitu(frame, i, 10) * ldexp(1.0, -10) * range_ms; i += 10;
+    }
+    for (int s = 0; s < num_sats; s++) {
+        rate_ok[s] = false;
+        rough_rate[s] = 0.0;
+        if (extended) {
+            int32_t rate = getbits(frame, i, 14); i += 14;
+            rate_ok[s] = (rate != -8192);
+            rough_rate[s] = rate;
+        }
+    }
+
+    const int pr_bits = high_res ? 20 : 15;
+    const int ph_bits = high_res ? 24 : 22;
+    const double pr_scale = ldexp(1.0, high_res ? -29 : -24) * range_ms;
+    const double ph_scale = ldexp(1.0, high_res ? -31 : -29) * range_ms;
+    for (int c = 0; c < num_cells; c++) {
+        MsmCell& cell = msm->cells[c];
+        int32_t pr = getbits(frame, i, pr_bits); i += pr_bits;
+        cell.valid = 0;
+        if (range_ok[cell.prn] && pr != -(1 << (pr_bits - 1))) {
+            cell.pseudorange = rough_range[cell.prn] + pr * pr_scale;
+            cell.valid |= MsmCell::kPseudorange;
+        }
+    }
+    for (int c = 0; c < num_cells; c++) {
+        MsmCell& cell = msm->cells[c];
+        int32_t ph = getbits(frame, i, ph_bits); i += ph_bits;
+        if (range_ok[cell.prn] && ph != -(1 << (ph_bits - 1))) {
+            cell.phase_range = rough_range[cell.prn] + ph * ph_scale;
+            cell.valid |= MsmCell::kPhase;
+        }
+    }
+    for (int c = 0; c < num_cells; c++) {
+        uint32_t lock = getbitu(frame, i, high_res ? 10 : 4); i += high_res ? 10 : 4;
+        msm->cells[c].lock_ms = high_res ? msm_lock_time_ext(lock) : msm_lock_time(lock);
+    }
+    for (int c = 0; c < num_cells; c++) {
+        msm->cells[c].half_cycle = getbitu(frame, i, 1) != 0; i += 1;
+    }
+    for (int c = 0; c < num_cells; c++) {
+        if (high_res) {
+            msm->cells[c].cnr = getbitu(frame, i, 10) * 0.0625; i += 10;
+        } else {
+            msm->cells[c].cnr = getbitu(frame, i, 6); i += 6;
+        }
+    }
+    for (int c = 0; c < num_cells; c++) {
+        MsmCell& cell = msm->cells[c];
+        cell.range_rate = 0.0;
+        if (extended) {
+            int32_t rate = getbits(frame, i, 15); i += 15;
+            if (rate_ok[cell.prn] && rate != -16384) {
+                cell.range_rate = rough_rate[cell.prn] + rate * 0.0001;
+                cell.valid |= MsmCell::kRate;
+            }
+        }
+    }
+
+    // cells carried the satellite index while the satellite arrays were being filled
+    for (int c = 0; c < num_cells; c++) {
+        msm->cells[c].prn = msm->sat_prn[msm->cells[c].prn];
+    }
+    msm->num_sats = num_sats;
+    msm->num_cells = num_cells;
+    return true;
+}
+
+/**
+ * @brief Decodes a GPS (1019), BeiDou (1042) or Galileo (1045/1046) ephemeris frame.
+ *
+ * @return true if the frame holds an ephemeris.
+ */
+bool decode_rtcm3_ephemeris(const uint8_t* frame, size_t size, Rtcm3Ephemeris* eph) {
+    int type = rtcm3_message_type(frame, size);
+    size_t payload = rtcm3_payload_length(frame);
+    const uint8_t* b = frame;
+    int i = 24 + 12;
+    *eph = Rtcm3Ephemeris();
+    eph->message_type = type;
+
+    if (type == 1019) {
+        if (payload < 61) return false;
+        eph->system = GnssSystem::kGps;
+        eph->prn = static_cast<uint8_t>(getbitu(b, i, 6)); i += 6;
+        eph->week = getbitu(b, i, 10); i += 10;
+        eph->accuracy = getbitu(b, i, 4); i += 4;
+        eph->code_on_l2 = getbitu(b, i, 2); i += 2;
+        eph->idot = getbits(b, i, 14) * ldexp(1.0, -43) * gnss_pi; i += 14;
+        eph->iode = getbitu(b, i, 8); i += 8;
+        eph->toc = getbitu(b, i, 16) * 16.0; i += 16;
+        eph->af2 = getbits(b, i, 8) * ldexp(1.0, -55); i += 8;
+        eph->af1 = getbits(b, i, 16) * ldexp(1.0, -43); i += 16;
+        eph->af0 = getbits(b, i, 22) * ldexp(1.0, -31); i += 22;
+        eph->iodc = getbitu(b, i, 10); i += 10;
+        eph->crs = getbits(b, i, 16) * ldexp(1.0, -5); i += 16;
+        eph->delta_n = getbits(b, i, 16) * ldexp(1.0, -43) * gnss_pi; i += 16;
+        eph->m0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->cuc = getbits(b, i, 16) * ldexp(1.0, -29); i += 16;
+        eph->e = getbitu(b, i, 32) * ldexp(1.0, -33); i += 32;
+        eph->cus = getbits(b, i, 16) * ldexp(1.0, -29); i += 16;
+        eph->sqrt_a = getbitu(b, i, 32) * ldexp(1.0, -19); i += 32;
+        eph->toe = getbitu(b, i, 16) * 16.0; i += 16;
+        eph->cic = getbits(b, i, 16) * ldexp(1.0, -29); i += 16;
+        eph->omega0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->cis = getbits(b, i, 16) * ldexp(1.0, -29); i += 16;
+        eph->i0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->crc = getbits(b, i, 16) * ldexp(1.0, -5); i += 16;
+        eph->omega = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->omega_dot = getbits(b, i, 24) * ldexp(1.0, -43) * gnss_pi; i += 24;
+        eph->tgd[0] = getbits(b, i, 8) * ldexp(1.0, -31); i += 8;
+        eph->health = getbitu(b, i, 6); i += 6;
+        eph->l2p_flag = getbitu(b, i, 1); i += 1;
+        eph->fit_interval = getbitu(b, i, 1) ? 6.0 : 4.0;
+        return true;
+    }
+
+    if (type == 1042) {
+        if (payload < 64) return false;
+        eph->system = GnssSystem::kBeidou;
+        eph->prn = static_cast<uint8_t>(getbitu(b, i, 6)); i += 6;
+        eph->week = getbitu(b, i, 13); i += 13;
+        eph->accuracy = getbitu(b, i, 4); i += 4;
+        eph->idot = getbits(b, i, 14) * ldexp(1.0, -43) * gnss_pi; i += 14;
+        eph->iode = getbitu(b, i, 5); i += 5;
+        eph->toc = getbitu(b, i, 17) * 8.0; i += 17;
+        eph->af2 = getbits(b, i, 11) * ldexp(1.0, -66); i += 11;
+        eph->af1 = getbits(b, i, 22) * ldexp(1.0, -50); i += 22;
+        eph->af0 = getbits(b, i, 24) * ldexp(1.0, -33); i += 24;
+        eph->iodc = getbitu(b, i, 5); i += 5;
+        eph->crs = getbits(b, i, 18) * ldexp(1.0, -6); i += 18;
+        eph->delta_n = getbits(b, i, 16) * ldexp(1.0, -43) * gnss_pi; i += 16;
+        eph->m0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->cuc = getbits(b, i, 18) * ldexp(1.0, -31); i += 18;
+        eph->e = getbitu(b, i, 32) * ldexp(1.0, -33); i += 32;
+        eph->cus = getbits(b, i, 18) * ldexp(1.0, -31); i += 18;
+        eph->sqrt_a = getbitu(b, i, 32) * ldexp(1.0, -19); i += 32;
+        eph->toe = getbitu(b, i, 17) * 8.0; i += 17;
+        eph->cic = getbits(b, i, 18) * ldexp(1.0, -31); i += 18;
+        eph->omega0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->cis = getbits(b, i, 18) * ldexp(1.0, -31); i += 18;
+        eph->i0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->crc = getbits(b, i, 18) * ldexp(1.0, -6); i += 18;
+        eph->omega = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->omega_dot = getbits(b, i, 24) * ldexp(1.0, -43) * gnss_pi; i += 24;
+        eph->tgd[0] = getbits(b, i, 10) * 1e-10; i += 10;
+        eph->tgd[1] = getbits(b, i, 10) * 1e-10; i += 10;
+        eph->health = getbitu(b, i, 1);
+        return true;
+    }
+
+    if (type == 1045 || type == 1046) {
+        if (payload < (type == 1045 ? 62u : 63u)) return false;
+        eph->system = GnssSystem::kGalileo;
+        eph->prn = static_cast<uint8_t>(getbitu(b, i, 6)); i += 6;
+        eph->week = getbitu(b, i, 12); i += 12;
+        eph->iode = getbitu(b, i, 10); i += 10;
+        eph->accuracy = getbitu(b, i, 8); i += 8;
+        eph->idot = getbits(b, i, 14) * ldexp(1.0, -43) * gnss_pi; i += 14;
+        eph->toc = getbitu(b, i, 14) * 60.0; i += 14;
+        eph->af2 = getbits(b, i, 6) * ldexp(1.0, -59); i += 6;
+        eph->af1 = getbits(b, i, 21) * ldexp(1.0, -46); i += 21;
+        eph->af0 = getbits(b, i, 31) * ldexp(1.0, -34); i += 31;
+        eph->crs = getbits(b, i, 16) * ldexp(1.0, -5); i += 16;
+        eph->delta_n = getbits(b, i, 16) * ldexp(1.0, -43) * gnss_pi; i += 16;
+        eph->m0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->cuc = getbits(b, i, 16) * ldexp(1.0, -29); i += 16;
+        eph->e = getbitu(b, i, 32) * ldexp(1.0, -33); i += 32;
+        eph->cus = getbits(b, i, 16) * ldexp(1.0, -29); i += 16;
+        eph->sqrt_a = getbitu(b, i, 32) * ldexp(1.0, -19); i += 32;
+        eph->toe = getbitu(b, i, 14) * 60.0; i += 14;
+        eph->cic = getbits(b, i, 16) * ldexp(1.0, -29); i += 16;
+        eph->omega0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->cis = getbits(b, i, 16) * ldexp(1.0, -29); i += 16;
+        eph->i0 = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->crc = getbits(b, i, 16) * ldexp(1.0, -5); i += 16;
+        eph->omega = getbits(b, i, 32) * ldexp(1.0, -31) * gnss_pi; i += 32;
+        eph->omega_dot = getbits(b, i, 24) * ldexp(1.0, -43) * gnss_pi; i += 24;
+        eph->tgd[0] = getbits(b, i, 10) * ldexp(1.0, -32); i += 10;
+        if (type == 1046) {
+            eph->tgd[1] = getbits(b, i, 10) * ldexp(1.0, -32); i += 10;
+            uint32_t e5b = getbitu(b, i, 3); i += 3;  // E5b health and data validity
+            uint32_t e1b = getbitu(b, i, 3);  // E1-B health and data validity
+            eph->health = static_cast<int>(((e5b >> 1) << 7) | ((e5b & 1) << 6) | ((e1b >> 1) << 1) | (e1b & 1));
+        } else {
+            uint32_t e5a = getbitu(b, i, 3);  // E5a health and data validity
+            eph->health = static_cast<int>(((e5a >> 1) << 4) | ((e5a & 1) << 3));
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Drops any partially received frame.
+ */
+void Rtcm3Framer::Reset() {
+    staged_ = 0;
+}
+
+/**
+ * @brief Discards the first staged byte and realigns on the next preamble.
+ */
+void Rtcm3Framer::Resync() {
+    const void* next = (staged_ > 1) ? memchr(stage_ + 1, rtcm3_preamble, staged_ - 1) : nullptr;
+    size_t offset = next ? static_cast<size_t>(static_cast<const uint8_t*>(next) - stage_) : staged_;
+    skipped_bytes_ += offset;
+    staged_ -= offset;
+    memmove(stage_, stage_ + offset, staged_);
+}
+
+/**
+ * @brief Feeds received bytes and invokes the callback once per valid frame.
+ *
+ * @param data The received bytes.
+ * @param size The number of received bytes.
+ * @param callback Called with each complete frame, including header and CRC.
+ */
+void Rtcm3Framer::Push(const uint8_t* data, size_t size, const FrameCallback& callback) {
+    while (true) {
+        if (staged_ > 0) {
+            // finish the frame that straddled the previous read
+            if (staged_ < rtcm3_header_size) {
+                size_t take = std::min(rtcm3_header_size - staged_, size);
+                memcpy(stage_ + staged_, data, take);
+                staged_ += take;
+                data += take;
+                size -= take;
+                if (staged_ < rtcm3_header_size) {
+                    return;
+                }
+            }
+            if (stage_[1] & 0xFC) {
+                Resync();
+                continue;
+            }
+            size_t need = rtcm3_payload_length(stage_) + rtcm3_header_size + rtcm3_crc_size;
+            if (staged_ < need) {
+                size_t take = std::min(need - staged_, size);
+                memcpy(stage_ + staged_, data, take);
+                staged_ += take;
+                data += take;
+                size -= take;
+                if (staged_ < need) {
+                    return;
+                }
+            }
+            if (frame_crc_ok(stage_, need)) {
+                frames_++;
+                callback(stage_, need);
+                staged_ -= need;
+                memmove(stage_, stage_ + need, staged_);
+            } else {
+                crc_errors_++;
+                Resync();
+            }
+            continue;
+        }
+
+        if (size == 0) {
+            return;
+        }
+        const uint8_t* start = static_cast<const uint8_t*>(memchr(data, rtcm3_preamble, size));
+        if (start == nullptr) {
+            skipped_bytes_ += size;
+            return;
+        }
+        skipped_bytes_ += start - data;
+        size -= start - data;
+        data = start;
+        if (size >= rtcm3_header_size) {
+            if (data[1] & 0xFC) {
+                skipped_bytes_++;
+                data++;
+                size--;
+                continue;
+            }
+            size_t need = rtcm3_payload_length(data) + rtcm3_header_size + rtcm3_crc_size;
+            if (size >= need) {
+                if (frame_crc_ok(data, need)) {
+                    frames_++;
+                    callback(data, need);
+                    data += need;
+                    size -= need;
+                } else {
+                    crc_errors_++;
+                    skipped_bytes_++;
+                    data++;
+                    size--;
+                }
+                continue;
+            }
+        }
+        memcpy(stage_, data, size);
+        staged_ = size;
+        return;
+    }
+}
@@ -0,0 +1,311 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+
+constexpr size_t rtcm3_header_size = 3;
+constexpr size_t rtcm3_crc_size = 3;
+constexpr size_t rtcm3_max_payload = 1023;
+constexpr size_t rtcm3_max_frame_size = rtcm3_header_size + rtcm3_max_payload + rtcm3_crc_size;
+constexpr uint8_t rtcm3_preamble = 0xD3;
+
+constexpr double speed_of_light = 299792458.0;  // m/s
+constexpr double gnss_pi = 3.1415926535897932;  // value used by the ICDs
+
+/**
+ * @brief GNSS constellations carried by RTCM3 MSM and ephemeris messages.
+ */
+enum class GnssSystem : uint8_t {
+    kGps = 0,
+    kGlonass,
+    kGalileo,
+    kSbas,
+    kQzss,
+    kBeidou,
+    kNavic,
+    kCount
+};
+
+/**
+ * @brief Returns the RINEX system identifier (G, R, E, S, J, C, I) for a constellation.
+ */
+char gnss_system_char(GnssSystem system);
+
+/**
+ * @brief Computes the CRC-24Q checksum used by RTCM3 frames.
+ *
+ * @param data The bytes to checksum.
+ * @param size The number of bytes.
+ * @return The 24 bit checksum.
+ */
+uint32_t crc24q(const uint8_t* data, size_t size);
+
+/**
+ * @brief Extracts an unsigned big-endian bit field (len <= 32) starting at bit pos.
+ */
+inline uint32_t getbitu(const uint8_t* buff, int pos, int len) {
+    uint64_t bits = 0;
+    int first = pos >> 3;
+    int last = (pos + len - 1) >> 3;
+    for (int i = first; i <= last; i++) {
+        bits = (bits << 8) | buff[i];
+    }
+    int tail = ((last + 1) << 3) - (pos + len);
+    return static_cast<uint32_t>((bits >> tail) & ((1ull << len) - 1));
+}
+
+/**
+ * @brief Extracts a two's complement bit field (len <= 32) starting at bit pos.
+ */
+inline int32_t getbits(const uint8_t* buff, int pos, int len) {
+    uint32_t bits = getbitu(buff, pos, len);
+    if (len <= 0 || len >= 32 || !(bits & (1u << (len - 1)))) {
+        return static_cast<int32_t>(bits);
+    }
+    return static_cast<int32_t>(bits | (~0u << len));
+}
+
+/**
+ * @brief Extracts a two's complement bit field of up to 56 bits (e.g. the 38 bit ECEF fields).
+ */
+inline int64_t getbits64(const uint8_t* buff, int pos, int len) {
+    uint64_t bits = 0;
+    int first = pos >> 3;
+    int last = (pos + len - 1) >> 3;
+    for (int i = first; i <= last; i++) {
+        bits = (bits << 8) | buff[i];
+    }
+    int tail = ((last + 1) << 3) - (pos + len);
+    bits = (bits >> tail) & ((1ull << len) - 1);
+    if (bits & (1ull << (len - 1))) {
+        bits |= ~0ull << len;
+    }
+    return static_cast<int64_t>(bits);
+}
+
+/**
+ * @brief Returns the payload length of a frame from its 3 byte header.
+ */
+inline size_t rtcm3_payload_length(const uint8_t* frame) {
+    return ((frame[1] & 0x03) << 8) | frame[2];
+}
+
+/**
+ * @brief Returns the message number of a complete frame (0 if the payload is empty).
+ */
+inline int rtcm3_message_type(const uint8_t* frame, size_t size) {
+    if (size < rtcm3_header_size + 2 + rtcm3_crc_size) {
+        return 0;
+    }
+    return static_cast<int>(getbitu(frame, 24, 12));
+}
+
+/**
+ * @brief Reference station position from message 1005 or 1006.
+ */
+struct Rtcm3Station {
+    uint16_t station_id = 0;
+    double ecef[3] = {0.0, 0.0, 0.0};  // m
+    double antenna_height = 0.0;  // m, 1006 only
+};
+
+/**
+ * @brief One satellite/signal cell of an MSM message, in physical units.
+ */
+struct MsmCell {
+    static constexpr uint8_t kPseudorange = 0x01;
+    static constexpr uint8_t kPhase = 0x02;
+    static constexpr uint8_t kRate = 0x04;
+
+    uint8_t prn = 0;
+    uint8_t signal_id = 0;
+    uint8_t valid = 0;  // mask of kPseudorange/kPhase/kRate
+    bool half_cycle = false;
+    double pseudorange = 0.0;  // m
+    double phase_range = 0.0;  // m, divide by the wavelength for cycles
+    double range_rate = 0.0;  // m/s
+    double cnr = 0.0;  // dB-Hz
+    uint32_t lock_ms = 0;  // minimum lock time
+};
+
+/**
+ * @brief A decoded MSM4..MSM7 message.
+ */
+struct MsmMessage {
+    GnssSystem system = GnssSystem::kGps;
+    int msm_level = 0;  // 4..7
+    uint16_t station_id = 0;
+    uint32_t epoch_ms = 0;  // time of week, GLONASS: time of day (Moscow)
+    uint8_t glo_day_of_week = 7;  // GLONASS only, 7 = unknown
+    bool multiple = false;  // more MSM messages follow for this epoch
+    int num_sats = 0;
+    int num_cells = 0;
+    uint8_t sat_prn[64];
+    uint8_t sat_ext_info[64];  // MSM5/7, GLONASS frequency channel + 7
+    MsmCell cells[64];
+};
+
+/**
+ * @brief Broadcast Keplerian ephemeris from messages 1019, 1042, 1045 and 1046.
+ *
+ * Angles are in radians and times in seconds of the constellation week, as written to RINEX.
+ */
+struct Rtcm3Ephemeris {
+    GnssSystem system = GnssSystem::kGps;
+    int message_type = 0;
+    uint8_t prn = 0;
+    int week = 0;  // as broadcast, not rollover corrected
+    int iode = 0;
+    int iodc = 0;
+    int accuracy = 0;  // URA index or SISA
+    int health = 0;
+    int code_on_l2 = 0;
+    int l2p_flag = 0;
+    double fit_interval = 0.0;
+    double toc = 0.0;
+    double toe = 0.0;
+    double af0 = 0.0;
+    double af1 = 0.0;
+    double af2 = 0.0;
+    double crs = 0.0;
+    double crc = 0.0;
+    double cus = 0.0;
+    double cuc = 0.0;
+    double cis = 0.0;
+    double cic = 0.0;
+    double delta_n = 0.0;
+    double m0 = 0.0;
+    double e = 0.0;
+    double sqrt_a = 0.0;
+    double omega0 = 0.0;
+    double i0 = 0.0;
+    double omega = 0.0;
+    double omega_dot = 0.0;
+    double idot = 0.0;
+    double tgd[2] = {0.0, 0.0};
+};
+
+/**
+ * @brief Decodes a 1005 or 1006 frame.
+ *
+ * @return true if the frame holds a station position.
+ */
+bool decode_rtcm3_station(const uint8_t* frame, size_t size, Rtcm3Station* station);
+
+/**
+ * @brief Decodes an MSM4, MSM5, MSM6 or MSM7 frame of any constellation.
+ *
+ * @return true if the frame is a complete MSM message.
+ */
+bool decode_rtcm3_msm(const uint8_t* frame, size_t size, MsmMessage* msm);
+
+/**
+ * @brief Reads the constellation and epoch time of an MSM1..MSM7 frame without decoding the rest.
+ *
+ * @param epoch_ms Receives the time of week in ms, for GLONASS the time of day (Moscow).
+ * @return true if the frame is an MSM message.
+ */
+bool rtcm3_msm_epoch(const uint8_t* frame, size_t size, GnssSystem* system, uint32_t* epoch_ms);
+
+/**
+ * @brief Returns true if an MSM1..MSM7 frame has its multiple message bit set: more MSM messages follow for its epoch.
+ */
+bool rtcm3_msm_multiple(const uint8_t* frame, size_t size);
+
+/**
+ * @brief Decodes a GPS (1019), BeiDou (1042) or Galileo (1045/1046) ephemeris frame.
+ *
+ * @return true if the frame holds an ephemeris.
+ */
+bool decode_rtcm3_ephemeris(const uint8_t* frame, size_t size, Rtcm3Ephemeris* eph);
+
+/**
+ * @brief Maps an MSM message number to its constellation and MSM level.
+ *
+ * @return true if the message number is an MSM1..MSM7 message.
+ */
+bool rtcm3_msm_info(int message_type, GnssSystem* system, int* level);
+
+/**
+ * @brief Returns the RINEX 3 two character signal code ("1C", "2W", ...) of an MSM signal id.
+ *
+ * @return nullptr if the signal is not defined for the constellation.
+ */
+const char* msm_signal_code(GnssSystem system, int signal_id);
+
+/**
+ * @brief Returns the carrier frequency in Hz of an MSM signal.
+ *
+ * @param glo_channel The GLONASS frequency channel (-7..6), ignored for other systems.
+ * @return 0 if unknown.
+ */
+double msm_signal_frequency(GnssSystem system, int signal_id, int glo_channel);
+
+/**
+ * @brief Splits a byte stream into CRC checked RTCM3 frames.
+ *
+ * Complete frames are handed out directly from the input buffer; only frames split across
+ * Push() calls are copied into the internal staging buffer.
+ */
+class Rtcm3Framer {
+public:
+    using FrameCallback = std::function<void(const uint8_t* frame, size_t size)>;
+
+    /**
+     * @brief Feeds received bytes and invokes the callback once per valid frame.
+     *
+     * @param data The received bytes.
+     * @param size The number of received bytes.
+     * @param callback Called with each complete frame, including header and CRC.
+     */
+    void Push(const uint8_t* data, size_t size, const FrameCallback& callback);
+
+    /**
+     * @brief Drops any partially received frame.
+     */
+    void Reset();
+
+    uint64_t frames() const { return frames_; }
+    uint64_t crc_errors() const { return crc_errors_; }
+    uint64_t skipped_bytes() const { return skipped_bytes_; }
+    size_t staged() const { return staged_; }
+    const uint8_t* staged_data() const { return stage_; }  // the partial frame, staged() bytes
+
+private:
+
+    /**
+     * @brief Discards the first staged byte and realigns on the next preamble.
+     */
+    void Resync();
+
+    uint8_t stage_[rtcm3_max_frame_size];
+    size_t staged_ = 0;
+    uint64_t frames_ = 0;
+    uint64_t crc_errors_ = 0;
+    uint64_t skipped_bytes_ = 0;
+};
@@ -0,0 +1,475 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "rtcm3_encoder.h"
+
+#include <math.h>
+#include <string.h>
+
+constexpr double range_ms = speed_of_light * 0.001;  // m per ms of light travel time
+
+/**
+ * @brief Rounds half away from zero like llround() without the libm call.
+ */
+static inline int64_t round_int(double value) {
+    return static_cast<int64_t>(value < 0.0 ? value - 0.5 : value + 0.5);
+}
+
+/**
+ * @brief Sequential field writer that packs bits in a register and stores 32-bit words.
+ *
+ * Writing front to back avoids the read-modify-write of setbitu() and the need for a zeroed
+ * frame buffer.
+ */
+struct BitWriter {
+    uint8_t* out;
+    uint64_t acc = 0;
+    int pending = 0;  // bits held in acc
+    int pos = 24;  // bits written since the start of the frame
+
+    explicit BitWriter(uint8_t* frame) : out(frame + rtcm3_header_size) {}
+
+    void U(int len, uint32_t value) {
+        acc = (acc << len) | (static_cast<uint64_t>(value) & ((1ull << len) - 1));
+        pending += len;
+        pos += len;
+        if (pending >= 32) {
+            pending -= 32;
+            uint32_t word = static_cast<uint32_t>(acc >> pending);
+            out[0] = static_cast<uint8_t>(word >> 24);
+            out[1] = static_cast<uint8_t>(word >> 16);
+            out[2] = static_cast<uint8_t>(word >> 8);
+            out[3] = static_cast<uint8_t>(word);
+            out += 4;
+        }
+    }
+    void S(int len, int32_t value) { U(len, static_cast<uint32_t>(value)); }
+    void S64(int len, int64_t value) {
+        U(len - 32, static_cast<uint32_t>(static_cast<uint64_t>(value) >> 32));
+        U(32, static_cast<uint32_t>(value));
+    }
+
+    /** @brief Writes round(value / scale) as a signed field. */
+    void Scaled(int len, double value, double scale) { S(len, static_cast<int32_t>(llround(value / scale))); }
+
+    /** @brief Writes round(value / scale) as an unsigned field. */
+    void ScaledU(int len, double value, double scale) { U(len, static_cast<uint32_t>(llround(value / scale))); }
+
+    /** @brief Stores the buffered bits, padding the last byte with zero bits. */
+    void Finish() {
+        while (pending >= 8) {
+            pending -= 8;
+            *out++ = static_cast<uint8_t>(acc >> pending);
+        }
+        if (pending > 0) {
+            *out++ = static_cast<uint8_t>(acc << (8 - pending));
+            pending = 0;
+        }
+    }
+};
+
+/**
+ * @brief Completes a frame whose payload has been written from bit 24 on.
+ *
+ * @param frame The frame buffer of at least rtcm3_max_frame_size bytes.
+ * @param payload_bits The number of payload bits written.
+ * @return The frame size in bytes, 0 if the payload is too long.
+ */
+size_t rtcm3_finish_frame(uint8_t* frame, int payload_bits) {
+    size_t payload = (payload_bits + 7) / 8;
+    if (payload > rtcm3_max_payload) {
+        return 0;
+    }
+    frame[0] = rtcm3_preamble;
+    frame[1] = static_cast<uint8_t>((payload >> 8) & 0x03);
+    frame[2] = static_cast<uint8_t>(payload & 0xFF);
+    size_t size = rtcm3_header_size + payload;
+    uint32_t crc = crc24q(frame, size);
+    frame[size] = static_cast<uint8_t>(crc >> 16);
+    frame[size + 1] = static_cast<uint8_t>(crc >> 8);
+    frame[size + 2] = static_cast<uint8_t>(crc);
+    return size + rtcm3_crc_size;
+}
+
+/**
+ * @brief Encodes a 1005 (type 1005) or 1006 (type 1006) station position frame.
+ *
+ * @return The frame size in bytes.
+ */
+size_t encode_rtcm3_station(const Rtcm3Station& station, int type, uint8_t* frame) {
+    BitWriter w(frame);
+    w.U(12, type == 1006 ? 1006 : 1005);
+    w.U(12, station.station_id);
+    w.U(6, 0);  // ITRF realization year
+    w.U(1, 1);  // GPS
+    w.U(1, 1);  // GLONASS
+    w.U(1, 1);  // Galileo
+    w.U(1, 0);  // reference station indicator
+    w.S64(38, llround(station.ecef[0] / 0.0001));
+    w.U(1, 0);  // single receiver oscillator
+    w.U(1, 0);
+    w.S64(38, llround(station.ecef[1] / 0.0001));
+    w.U(2, 0);  // quarter cycle indicator
+    w.S64(38, llround(station.ecef[2] / 0.0001));
+    if (type == 1006) {
+        w.ScaledU(16, station.antenna_height, 0.0001);
+    }
+    w.Finish();
+    return rtcm3_finish_frame(frame, w.pos - 24);
+}
+
+/**
+ * @brief Converts a lock time in ms to the MSM4/5 indicator (DF402).
+ */
+static uint32_t lock_indicator(uint32_t lock_ms) {
+    uint32_t indicator = 0;
+    while (indicator < 15 && (16u << (indicator + 1)) <= lock_ms) {
+        indicator++;
+    }
+    return indicator;
+}
+
+/**
+ * @brief Converts a lock time in ms to the MSM6/7 extended indicator (DF407).
+ */
+static uint32_t lock_indicator_ext(uint32_t lock_ms) {
+    if (lock_ms < 64) {
+        return lock_ms;
+    }
+    uint32_t group = 1;
+    while (group < 21 && (32u << (group + 1)) <= lock_ms) {
+        group++;
+    }
+    uint32_t indicator = (lock_ms >> group) + 32 * group;
+    return indicator > 704 ? 704 : indicator;
+}
+
+/**
+ * @brief Encodes an MSM4..MSM7 frame.
+ *
+ * @return The frame size in bytes, 0 if the message cannot be represented.
+ */
+size_t encode_rtcm3_msm(const MsmMessage& msm, uint8_t* frame) {
+    static const int base[] = {1070, 1080, 1090, 1100, 1110, 1120, 1130};
+    if (msm.msm_level < 4 || msm.msm_level > 7 || msm.system >= GnssSystem::kCount) {
+        return 0;
+    }
+    const int level = msm.msm_level;
+    const bool extended = (level == 5 || level == 7);
+    const bool high_res = (level >= 6);
+
+    // signal mask from the cells
+    uint32_t sig_mask = 0;
+    for (int c = 0; c < msm.num_cells; c++) {
+        int id = msm.cells[c].signal_id;
+        if (id < 1 || id > 32) {
+            return 0;
+        }
+        sig_mask |= 1u << (32 - id);
+    }
+    uint8_t sig_ids[32];
+    int num_sigs = 0;
+    for (int id = 1; id <= 32; id++) {
+        if (sig_mask & (1u << (32 - id))) {
+            sig_ids[num_sigs++] = static_cast<uint8_t>(id);
+        }
+    }
+    if (msm.num_sats * num_sigs > 64) {
+        return 0;
+    }
+
+    BitWriter w(frame);
+    w.U(12, base[static_cast<int>(msm.system)] + level);
+    w.U(12, msm.station_id);
+    if (msm.system == GnssSystem::kGlonass) {
+        w.U(3, msm.glo_day_of_week);
+        w.U(27, msm.epoch_ms);
+    } else {
+        w.U(30, msm.epoch_ms);
+    }
+    w.U(1, msm.multiple ? 1 : 0);
+    w.U(3, 0);  // IODS
+    w.U(7, 0);  // reserved
+    w.U(2, 0);  // clock steering
+    w.U(2, 0);  // external clock
+    w.U(1, 0);  // divergence free smoothing
+    w.U(3, 0);  // smoothing interval
+    uint64_t sat_mask = 0;
+    for (int s = 0; s < msm.num_sats; s++) {
+        int prn = msm.sat_prn[s];
+        if (prn < 1 || prn > 64) {
+            return 0;
+        }
+        sat_mask |= 1ull << (64 - prn);
+    }
+    w.U(32, static_cast<uint32_t>(sat_mask >> 32));
+    w.U(32, static_cast<uint32_t>(sat_mask));
+    w.U(32, sig_mask);
+
+    // cell mask and the cell index of every (satellite, signal) pair
+    int first_cell[64];
+    int c = 0;
+    for (int s = 0; s < msm.num_sats; s++) {
+        first_cell[s] = c;
+        for (int g = 0; g < num_sigs; g++) {
+            bool present = c < msm.num_cells && msm.cells[c].prn == msm.sat_prn[s] &&
+                           msm.cells[c].signal_id == sig_ids[g];
+            w.U(1, present ? 1 : 0);
+            c += present ? 1 : 0;
+        }
+    }
+    if (c != msm.num_cells) {
+        return 0;  // cells not in satellite/signal order or for unlisted satellites
+    }
+    first_cell[msm.num_sats] = c;
+
+    // rough range and rate from the first usable cell of each satellite
+    uint32_t rough_ms[64];
+    uint32_t rough_mod[64];
+    int32_t rough_rate[64];
+    double rough_m[64];
+    for (int s = 0; s < msm.num_sats; s++) {
+        rough_ms[s] = 255;
+        rough_mod[s] = 0;
+        rough_rate[s] = -8192;
+        rough_m[s] = 0.0;
+        for (int k = first_cell[s]; k < first_cell[s + 1]; k++) {
+            const MsmCell& cell = msm.cells[k];
+            double range = (cell.valid & MsmCell::kPseudorange) ? cell.pseudorange :
+                           (cell.valid & MsmCell::kPhase) ? cell.phase_range : -1.0;
+            if (range > 0.0 && rough_ms[s] == 255) {
+                int64_t units = round_int(range * (1024.0 / range_ms));
+                if (units / 1024 < 255) {
+                    rough_ms[s] = static_cast<uint32_t>(units / 1024);
+                    rough_mod[s] = static_cast<uint32_t>(units % 1024);
+                    rough_m[s] = units / 1024.0 * range_ms;
+                }
+            }
+            if ((cell.valid & MsmCell::kRate) && rough_rate[s] == -8192) {
+                int64_t rate = round_int(cell.range_rate);
+                if (rate > -8192 && rate < 8192) {
+                    rough_rate[s] = static_cast<int32_t>(rate);
+                }
+            }
+        }
+    }
+    for (int s = 0; s < msm.num_sats; s++) {
+        w.U(8, rough_ms[s]);
+    }
+    if (extended) {
+        for (int s = 0; s < msm.num_sats; s++) {
+            w.U(4, msm.sat_ext_info[s]);
+        }
+    }
+    for (int s = 0; s < msm.num_sats; s++) {
+        w.U(10, rough_mod[s]);
+    }
+    if (extended) {
+        for (int s = 0; s < msm.num_sats; s++) {
+            w.S(14, rough_rate[s]);
+        }
+    }
+
+    // the satellite index of each cell
+    uint8_t cell_sat[64];
+    for (int s = 0; s < msm.num_sats; s++) {
+        for (int k = first_cell[s]; k < first_cell[s + 1]; k++) {
+            cell_sat[k] = static_cast<uint8_t>(s);
+        }
+    }
+
+    const int pr_bits = high_res ? 20 : 15;
+    const int ph_bits = high_res ? 24 : 22;
+    // inverse resolutions so each cell costs a multiply instead of a divide
+    const double pr_units = (high_res ? 536870912.0 : 16777216.0) / range_ms;  // 2^29, 2^24
+    const double ph_units = (high_res ? 2147483648.0 : 536870912.0) / range_ms;  // 2^31, 2^29
+    const int64_t pr_limit = int64_t(1) << (pr_bits - 1);
+    const int64_t ph_limit = int64_t(1) << (ph_bits - 1);
+    for (int k = 0; k < msm.num_cells; k++) {
+        const MsmCell& cell = msm.cells[k];
+        int64_t fine = -pr_limit;
+        if ((cell.valid & MsmCell::kPseudorange) && rough_ms[cell_sat[k]] != 255) {
+            fine = round_int((cell.pseudorange - rough_m[cell_sat[k]]) * pr_units);
+            fine = (fine > -pr_limit && fine < pr_limit) ? fine : -pr_limit;
+        }
+        w.S(pr_bits, static_cast<int32_t>(fine));
+    }
+    for (int k = 0; k < msm.num_cells; k++) {
+        const MsmCell& cell = msm.cells[k];
+        int64_t fine = -ph_limit;
+        if ((cell.valid & MsmCell::kPhase) && rough_ms[cell_sat[k]] != 255) {
+            fine = round_int((cell.phase_range - rough_m[cell_sat[k]]) * ph_units);
+            fine = (fine > -ph_limit && fine < ph_limit) ? fine : -ph_limit;
+        }
+        w.S(ph_bits, static_cast<int32_t>(fine));
+    }
+    for (int k = 0; k < msm.num_cells; k++) {
+        uint32_t lock = msm.cells[k].lock_ms;
+        if (high_res) {
+            w.U(10, lock_indicator_ext(lock));
+        } else {
+            w.U(4, lock_indicator(lock));
+        }
+    }
+    for (int k = 0; k < msm.num_cells; k++) {
+        w.U(1, msm.cells[k].half_cycle ? 1 : 0);
+    }
+    for (int k = 0; k < msm.num_cells; k++) {
+        double cnr = msm.cells[k].cnr;
+        if (high_res) {
+            int64_t value = round_int(cnr * 16.0);
+            w.U(10, static_cast<uint32_t>(value < 0 ? 0 : value > 1023 ? 1023 : value));
+        } else {
+            int64_t value = round_int(cnr);
+            w.U(6, static_cast<uint32_t>(value < 0 ? 0 : value > 63 ? 63 : value));
+        }
+    }
+    if (extended) {
+        for (int k = 0; k < msm.num_cells; k++) {
+            const MsmCell& cell = msm.cells[k];
+            int64_t fine = -16384;
+            if ((cell.valid & MsmCell::kRate) && rough_rate[cell_sat[k]] != -8192) {
+                fine = round_int((cell.range_rate - rough_rate[cell_sat[k]]) * 10000.0);
+                fine = (fine > -16384 && fine < 16384) ? fine : -16384;
+            }
+            w.S(15, static_cast<int32_t>(fine));
+        }
+    }
+    w.Finish();
+    return rtcm3_finish_frame(frame, w.pos - 24);
+}
+
+/**
+ * @brief Encodes a GPS (1019), BeiDou (1042) or Galileo (1045/1046) ephemeris frame.
+ *
+ * @return The frame size in bytes, 0 for unsupported types.
+ */
+size_t encode_rtcm3_ephemeris(const Rtcm3Ephemeris& eph, uint8_t* frame) {
+    const double sc = gnss_pi;  // semicircles to radians
+    BitWriter w(frame);
+    w.U(12, eph.message_type);
+
+    if (eph.message_type == 1019) {
+        w.U(6, eph.prn);
+        w.U(10, eph.week % 1024);
+        w.U(4, eph.accuracy);
+        w.U(2, eph.code_on_l2);
+        w.Scaled(14, eph.idot, ldexp(1.0, -43) * sc);
+        w.U(8, eph.iode);
+        w.ScaledU(16, eph.toc, 16.0);
+        w.Scaled(8, eph.af2, ldexp(1.0, -55));
+        w.Scaled(16, eph.af1, ldexp(1.0, -43));
+        w.Scaled(22, eph.af0, ldexp(1.0, -31));
+        w.U(10, eph.iodc);
+        w.Scaled(16, eph.crs, ldexp(1.0, -5));
+        w.Scaled(16, eph.delta_n, ldexp(1.0, -43) * sc);
+        w.Scaled(32, eph.m0, ldexp(1.0, -31) * sc);
+        w.Scaled(16, eph.cuc, ldexp(1.0, -29));
+        w.ScaledU(32, eph.e, ldexp(1.0, -33));
+        w.Scaled(16, eph.cus, ldexp(1.0, -29));
+        w.ScaledU(32, eph.sqrt_a, ldexp(1.0, -19));
+        w.ScaledU(16, eph.toe, 16.0);
+        w.Scaled(16, eph.cic, ldexp(1.0, -29));
+        w.Scaled(32, eph.omega0, ldexp(1.0, -31) * sc);
+        w.Scaled(16, eph.cis, ldexp(1.0, -29));
+        w.Scaled(32, eph.i0, ldexp(1.0, -31) * sc);
+        w.Scaled(16, eph.crc, ldexp(1.0, -5));
+        w.Scaled(32, eph.omega, ldexp(1.0, -31) * sc);
+        w.Scaled(24, eph.omega_dot, ldexp(1.0, -43) * sc);
+        w.Scaled(8, eph.tgd[0], ldexp(1.0, -31));
+        w.U(6, eph.health);
+        w.U(1, eph.l2p_flag);
+        w.U(1, eph.fit_interval > 4.0 ? 1 : 0);
+    } else if (eph.message_type == 1042) {
+        w.U(6, eph.prn);
+        w.U(13, eph.week % 8192);
+        w.U(4, eph.accuracy);
+        w.Scaled(14, eph.idot, ldexp(1.0, -43) * sc);
+        w.U(5, eph.iode);
+        w.ScaledU(17, eph.toc, 8.0);
+        w.Scaled(11, eph.af2, ldexp(1.0, -66));
+        w.Scaled(22, eph.af1, ldexp(1.0, -50));
+        w.Scaled(24, eph.af0, ldexp(1.0, -33));
+        w.U(5, eph.iodc);
+        w.Scaled(18, eph.crs, ldexp(1.0, -6));
+        w.Scaled(16, eph.delta_n, ldexp(1.0, -43) * sc);
+        w.Scaled(32, eph.m0, ldexp(1.0, -31) * sc);
+        w.Scaled(18, eph.cuc, ldexp(1.0, -31));
+        w.ScaledU(32, eph.e, ldexp(1.0, -33));
+        w.Scaled(18, eph.cus, ldexp(1.0, -31));
+        w.ScaledU(32, eph.sqrt_a, ldexp(1.0, -19));
+        w.ScaledU(17, eph.toe, 8.0);
+        w.Scaled(18, eph.cic, ldexp(1.0, -31));
+        w.Scaled(32, eph.omega0, ldexp(1.0, -31) * sc);
+        w.Scaled(18, eph.cis, ldexp(1.0, -31));
+        w.Scaled(32, eph.i0, ldexp(1.0, -31) * sc);
+        w.Scaled(18, eph.crc, ldexp(1.0, -6));
+        w.Scaled(32, eph.omega, ldexp(1.0, -31) * sc);
+        w.Scaled(24, eph.omega_dot, ldexp(1.0, -43) * sc);
+        w.Scaled(10, eph.tgd[0], 1e-10);
+        w.Scaled(10, eph.tgd[1], 1e-10);
+        w.U(1, eph.health & 1);
+    } else if (eph.message_type == 1045 || eph.message_type == 1046) {
+        w.U(6, eph.prn);
+        w.U(12, eph.week % 4096);
+        w.U(10, eph.iode);
+        w.U(8, eph.accuracy);
+        w.Scaled(14, eph.idot, ldexp(1.0, -43) * sc);
+        w.ScaledU(14, eph.toc, 60.0);
+        w.Scaled(6, eph.af2, ldexp(1.0, -59));
+        w.Scaled(21, eph.af1, ldexp(1.0, -46));
+        w.Scaled(31, eph.af0, ldexp(1.0, -34));
+        w.Scaled(16, eph.crs, ldexp(1.0, -5));
+        w.Scaled(16, eph.delta_n, ldexp(1.0, -43) * sc);
+        w.Scaled(32, eph.m0, ldexp(1.0, -31) * sc);
+        w.Scaled(16, eph.cuc, ldexp(1.0, -29));
+        w.ScaledU(32, eph.e, ldexp(1.0, -33));
+        w.Scaled(16, eph.cus, ldexp(1.0, -29));
+        w.ScaledU(32, eph.sqrt_a, ldexp(1.0, -19));
+        w.ScaledU(14, eph.toe, 60.0);
+        w.Scaled(16, eph.cic, ldexp(1.0, -29));
+        w.Scaled(32, eph.omega0, ldexp(1.0, -31) * sc);
+        w.Scaled(16, eph.cis, ldexp(1.0, -29));
+        w.Scaled(32, eph.i0, ldexp(1.0, -31) * sc);
+        w.Scaled(16, eph.crc, ldexp(1.0, -5));
+        w.Scaled(32, eph.omega, ldexp(1.0, -31) * sc);
+        w.Scaled(24, eph.omega_dot, ldexp(1.0, -43) * sc);
+        w.Scaled(10, eph.tgd[0], ldexp(1.0, -32));
+        if (eph.message_type == 1046) {
+            w.Scaled(10, eph.tgd[1], ldexp(1.0, -32));
+            w.U(2, (eph.health >> 7) & 3);  // E5b signal health
+            w.U(1, (eph.health >> 6) & 1);  // E5b data validity
+            w.U(2, (eph.health >> 1) & 3);  // E1-B signal health
+            w.U(1, eph.health & 1);  // E1-B data validity
+            w.U(2, 0);
+        } else {
+            w.U(2, (eph.health >> 4) & 3);  // E5a signal health
+            w.U(1, (eph.health >> 3) & 1);  // E5a data validity
+            w.U(7, 0);
+        }
+    } else {
+        return 0;
+    }
+    w.Finish();
+    return rtcm3_finish_frame(frame, w.pos - 24);
+}
@@ -0,0 +1,107 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "rtcm3.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Writes an unsigned big-endian bit field (len <= 32) starting at bit pos.
+ *
+ * The destination bits must be zero; frames are built in zeroed buffers.
+ */
+inline void setbitu(uint8_t* buff, int pos, int len, uint32_t data) {
+    if (len <= 0) {
+        return;
+    }
+    uint64_t bits = static_cast<uint64_t>(data) & ((1ull << len) - 1);
+    int first = pos >> 3;
+    int last = (pos + len - 1) >> 3;
+    bits <<= ((last + 1) << 3) - (pos + len);
+    for (int i = last; i >= first; i--) {
+        buff[i] |= static_cast<uint8_t>(bits);
+        bits >>= 8;
+    }
+}
+
+/**
+ * @brief Writes a two's complement bit field (len <= 32) starting at bit pos.
+ */
+inline void setbits(uint8_t* buff, int pos, int len, int32_t data) {
+    setbitu(buff, pos, len, static_cast<uint32_t>(data));
+}
+
+/**
+ * @brief Writes a two's complement bit field of up to 56 bits starting at bit pos.
+ */
+inline void setbits64(uint8_t* buff, int pos, int len, int64_t data) {
+    uint64_t bits = static_cast<uint64_t>(data) & ((1ull << len) - 1);
+    int first = pos >> 3;
+    int last = (pos + len - 1) >> 3;
+    bits <<= ((last + 1) << 3) - (pos + len);
+    for (int i = last; i >= first; i--) {
+        buff[i] |= static_cast<uint8_t>(bits);
+        bits >>= 8;
+    }
+}
+
+/**
+ * @brief Completes a frame whose payload has been written from bit 24 on.
+ *
+ * Writes the preamble and length and appends the CRC. The padding bits of the last payload
+ * byte must already be zero.
+ *
+ * @param frame The frame buffer of at least rtcm3_max_frame_size bytes.
+ * @param payload_bits The number of payload bits written.
+ * @return The frame size in bytes, 0 if the payload is too long.
+ */
+size_t rtcm3_finish_frame(uint8_t* frame, int payload_bits);
+
+/**
+ * @brief Encodes a 1005 (type 1005) or 1006 (type 1006) station position frame.
+ *
+ * @return The frame size in bytes.
+ */
+size_t encode_rtcm3_station(const Rtcm3Station& station, int type, uint8_t* frame);
+
+/**
+ * @brief Encodes an MSM4..MSM7 frame.
+ *
+ * Satellites in msm.sat_prn must be ascending and cells ordered by satellite, then signal id.
+ * Values that do not fit the message resolution are sent as invalid.
+ *
+ * @return The frame size in bytes, 0 if the message cannot be represented.
+ */
+size_t encode_rtcm3_msm(const MsmMessage& msm, uint8_t* frame);
+
+/**
+ * @brief Encodes a GPS (1019), BeiDou (1042) or Galileo (1045/1046) ephemeris frame.
+ *
+ * The message number is taken from eph.message_type.
+ *
+ * @return The frame size in bytes, 0 for unsupported types.
+ */
+size_t encode_rtcm3_ephemeris(const Rtcm3Ephemeris& eph, uint8_t* frame);
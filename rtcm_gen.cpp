@@ -0,0 +1,425 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "rtcm3.h"
+#include "synthetic_network.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr int64_t gps_epoch_unix = 315964800;
+constexpr int64_t leap_seconds = 18;
+constexpr size_t write_batch = 1 << 20;
+constexpr size_t max_outbox = 1 << 20;  // per client backlog before epochs are dropped
+
+bool run = true;
+
+/**
+ * @brief Signal handler for SIGINT.
+ *
+ * @param signal The signal number.
+ */
+void signal_handler(int signal) {
+    run = false;
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void usage() {
+    std::cerr << "usage: rtcm_gen [options]\n"
+              << "  -s stations   number of reference stations (default 1)\n"
+              << "  -r hz         epoch rate (default 1)\n"
+              << "  -m 4|7        MSM level (default 7)\n"
+              << "  -c GREC       constellations (default GREC)\n"
+              << "  -t unix_time  start time (default now)\n"
+              << "  -n epochs     epochs to write in file mode (default 3600)\n"
+              << "  -o path       output file, - for stdout (default -)\n"
+              << "  -l port       act as a mock caster: mountpoints STA0000.. and ALL, paced in real time\n"
+              << "  -k clients    mock caster capacity, further requests get 503 (default unlimited)\n";
+}
+
+/**
+ * @brief Writes a whole buffer to a file descriptor.
+ */
+static bool write_all(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t ret = write(fd, data, size);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+/**
+ * @brief Generates epochs as fast as possible into a file and reports the throughput.
+ */
+static int generate_file(SyntheticNetwork& network, int64_t start_gps_ms, int64_t interval_ms,
+                         int64_t epochs, const std::string& path) {
+    int fd = (path == "-") ? STDOUT_FILENO : open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return 1;
+    }
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[write_batch + synthetic_max_epoch_bytes]);
+    size_t used = 0;
+    uint64_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t e = 0; e < epochs && run; e++) {
+        network.SetEpoch(start_gps_ms + e * interval_ms);
+        for (int s = 0; s < network.num_stations(); s++) {
+            used += network.EncodeStation(s, buffer.get() + used);
+            if (used >= write_batch) {
+                if (!write_all(fd, buffer.get(), used)) {
+                    std::cerr << "Error: Could not write output" << std::endl;
+                    return 1;
+                }
+                total += used;
+                used = 0;
+            }
+        }
+    }
+    write_all(fd, buffer.get(), used);
+    total += used;
+    if (fd != STDOUT_FILENO) {
+        close(fd);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%llu bytes, %lld station epochs in %.3f s: %.1f MB/s, %.0f station epochs/s\n",
+            static_cast<unsigned long long>(total), static_cast<long long>(epochs) * network.num_stations(),
+            seconds, total / seconds / 1e6, epochs * network.num_stations() / seconds);
+    return 0;
+}
+
+/**
+ * @brief Mock caster connection.
+ */
+struct CasterClient {
+    int fd = -1;
+    bool streaming = false;
+    int station = -1;  // -1 streams every station
+    std::string request;
+    std::string outbox;
+    uint64_t dropped_epochs = 0;
+    uint64_t frames = 0;  // queued for sending
+    uint64_t queued_bytes = 0;  // of the frames
+};
+
+/**
+ * @brief Correction data served to the clients of the mock caster, for loss accounting.
+ */
+struct CasterTotals {
+    uint64_t clients = 0;
+    uint64_t frames = 0;
+    uint64_t bytes = 0;  // sent
+    uint64_t unsent_bytes = 0;  // still queued when the client went away
+    uint64_t dropped_epochs = 0;
+
+    /**
+     * @brief Adds a streaming client that is going away.
+     */
+    void Add(const CasterClient& client) {
+        clients++;
+        frames += client.frames;
+        unsent_bytes += std::min<uint64_t>(client.outbox.size(), client.queued_bytes);
+        bytes += client.queued_bytes - std::min<uint64_t>(client.outbox.size(), client.queued_bytes);
+        dropped_epochs += client.dropped_epochs;
+    }
+};
+
+/**
+ * @brief Answers an NTRIP request, returning true if the client should be streamed to.
+ */
+static bool answer_request(CasterClient& client, const SyntheticNetwork& network, size_t streaming, int capacity) {
+    size_t start = client.request.find("GET /");
+    size_t end = client.request.find(' ', start + 5);
+    std::string mount = (start == std::string::npos || end == std::string::npos) ? "" :
+                        client.request.substr(start + 5, end - start - 5);
+    std::string response;
+    bool ok = false;
+    if (mount.empty()) {
+        response = "SOURCETABLE 200 OK\r\nContent-Type: text/plain\r\n\r\n";
+        char line[160];
+        for (int s = 0; s < network.num_stations(); s++) {
+            snprintf(line, sizeof(line), "STR;STA%04d;STA%04d;RTCM 3.3;;2;GREC;SYN;XXX;0.00;0.00;1;0;rtcm_gen;none;B;N;0;\r\n", s, s);
+            response += line;
+        }
+        response += "STR;ALL;ALL;RTCM 3.3;;2;GREC;SYN;XXX;0.00;0.00;0;0;rtcm_gen;none;B;N;0;\r\nENDSOURCETABLE\r\n";
+    } else if (capacity > 0 && static_cast<int>(streaming) >= capacity) {
+        response = "HTTP/1.1 503 Service Unavailable\r\n\r\n";
+    } else if (mount == "ALL") {
+        client.station = -1;
+        ok = true;
+    } else if (mount.size() == 7 && mount.compare(0, 3, "STA") == 0 && atoi(mount.c_str() + 3) < network.num_stations()) {
+        client.station = atoi(mount.c_str() + 3);
+        ok = true;
+    } else {
+        response = "HTTP/1.1 404 Not Found\r\n\r\n";
+    }
+    if (ok) {
+        response = "ICY 200 OK\r\n\r\n";
+    }
+    client.outbox += response;
+    return ok;
+}
+
+/**
+ * @brief Sends as much of a client's backlog as the socket accepts.
+ *
+ * @return false if the connection failed.
+ */
+static bool flush_outbox(CasterClient& client) {
+    while (!client.outbox.empty()) {
+        ssize_t ret = send(client.fd, client.outbox.data(), client.outbox.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        client.outbox.erase(0, ret);
+    }
+    return true;
+}
+
+/**
+ * @brief Serves the synthetic stations as NTRIP mountpoints, paced in real time.
+ */
+static int serve(SyntheticNetwork& network, int port, int64_t interval_ms, int capacity) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 1024) < 0) {
+        std::cerr << "Error: Could not listen on port " << port << std::endl;
+        return 1;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+    std::cout << "Mock caster listening on port " << port << std::endl;
+
+    std::vector<CasterClient> clients;
+    CasterTotals totals;
+    std::unique_ptr<uint8_t[]> epoch_buffer(new uint8_t[synthetic_max_epoch_bytes]);
+    auto now_ms = []() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+    };
+    int64_t next_epoch = (now_ms() / interval_ms + 1) * interval_ms;
+
+    while (run) {
+        std::vector<struct pollfd> fds;
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const CasterClient& client : clients) {
+            fds.push_back({client.fd, static_cast<short>(POLLIN | (client.outbox.empty() ? 0 : POLLOUT)), 0});
+        }
+        int64_t wait = next_epoch - now_ms();
+        poll(fds.data(), fds.size(), wait > 0 ? static_cast<int>(wait) : 0);
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                CasterClient client;
+                client.fd = fd;
+                clients.push_back(client);
+            }
+        }
+
+        size_t streaming = 0;
+        for (const CasterClient& client : clients) {
+            streaming += client.streaming ? 1 : 0;
+        }
+        for (size_t i = 1; i < fds.size(); i++) {
+            CasterClient& client = clients[i - 1];
+            bool alive = true;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buf[2048];
+                ssize_t ret = recv(client.fd, buf, sizeof(buf), MSG_DONTWAIT);
+                if (ret == 0 || (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    alive = false;
+                } else if (ret > 0 && !client.streaming) {
+                    // GGA sentences from streaming clients are read and ignored
+                    client.request.append(buf, ret);
+                    if (client.request.find("\r\n\r\n") != std::string::npos) {
+                        client.streaming = answer_request(client, network, streaming, capacity);
+                        streaming += client.streaming ? 1 : 0;
+                        alive = flush_outbox(client) && (client.streaming || !client.outbox.empty());
+                    }
+                }
+            }
+            if (alive && (fds[i].revents & POLLOUT)) {
+                alive = flush_outbox(client) && (client.streaming || !client.outbox.empty());
+            }
+            if (!alive) {
+                if (client.streaming) {
+                    totals.Add(client);
+                }
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+        for (size_t i = 0; i < clients.size();) {
+            if (clients[i].fd < 0) {
+                clients[i] = clients.back();
+                clients.pop_back();
+            } else {
+                i++;
+            }
+        }
+
+        int64_t now = now_ms();
+        if (now < next_epoch) {
+            continue;
+        }
+        int64_t gps_ms = next_epoch - gps_epoch_unix * 1000 + leap_seconds * 1000;
+        next_epoch += interval_ms;
+        if (next_epoch <= now) {
+            next_epoch = (now / interval_ms + 1) * interval_ms;
+        }
+        network.SetEpoch(gps_ms);
+        for (CasterClient& client : clients) {
+            if (!client.streaming) {
+                continue;
+            }
+            if (client.outbox.size() > max_outbox) {
+                client.dropped_epochs++;
+                continue;
+            }
+            int first = client.station < 0 ? 0 : client.station;
+            int last = client.station < 0 ? network.num_stations() : client.station + 1;
+            for (int s = first; s < last; s++) {
+                size_t size = network.EncodeStation(s, epoch_buffer.get());
+                client.outbox.append(reinterpret_cast<const char*>(epoch_buffer.get()), size);
+                client.queued_bytes += size;
+                for (size_t pos = 0; pos + rtcm3_header_size <= size; client.frames++) {
+                    pos += rtcm3_header_size + rtcm3_payload_length(epoch_buffer.get() + pos) + rtcm3_crc_size;
+                }
+            }
+            if (!flush_outbox(client)) {
+                totals.Add(client);
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+    }
+    for (CasterClient& client : clients) {
+        if (client.fd >= 0) {
+            if (client.streaming) {
+                flush_outbox(client);
+                totals.Add(client);
+            }
+            close(client.fd);
+        }
+    }
+    close(listen_fd);
+    std::cout << "Served " << totals.frames << " frames (" << totals.bytes << " bytes) to " << totals.clients
+              << " streaming clients, " << totals.unsent_bytes << " bytes unsent, " << totals.dropped_epochs
+              << " epochs dropped" << std::endl;
+    return 0;
+}
+
+/**
+ * @brief Main function for the synthetic RTCM3 stream generator.
+ *
+ * @return 0 if the program exits successfully.
+ */
+int main(int argc, char** argv) {
+    SyntheticOptions options;
+    double rate = 1.0;
+    int64_t start = time(nullptr);
+    int64_t epochs = 3600;
+    std::string path = "-";
+    int port = 0;
+    int capacity = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "-s") {
+            options.num_stations = atoi(argv[++i]);
+        } else if (arg == "-r") {
+            rate = atof(argv[++i]);
+        } else if (arg == "-m") {
+            options.msm_level = atoi(argv[++i]);
+        } else if (arg == "-c") {
+            options.constellations = argv[++i];
+        } else if (arg == "-t") {
+            start = atoll(argv[++i]);
+        } else if (arg == "-n") {
+            epochs = atoll(argv[++i]);
+        } else if (arg == "-o") {
+            path = argv[++i];
+        } else if (arg == "-l") {
+            port = atoi(argv[++i]);
+        } else if (arg == "-k") {
+            capacity = atoi(argv[++i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (rate <= 0.0 || rate > 100.0) {
+        usage();
+        return 1;
+    }
+    int64_t interval_ms = static_cast<int64_t>(1000.0 / rate);
+    options.station_interval = static_cast<int>(10 * rate);
+    SyntheticNetwork network(options);
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGPIPE, SIG_IGN);
+    if (port > 0) {
+        return serve(network, port, interval_ms, capacity);
+    }
+    int64_t start_gps_ms = (start - gps_epoch_unix + leap_seconds) * 1000;
+    return generate_file(network, start_gps_ms, interval_ms, epochs, path);
+}
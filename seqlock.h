@@ -0,0 +1,123 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+/**
+ * @brief Stores a value as relaxed atomic words, the writer half of a sequence lock over shared memory.
+ *
+ * For values a SeqLock cannot own, e.g. records of a mapped file: the caller bumps its own
+ * sequence around the store, as SeqLock::Write() does.
+ */
+template <typename T>
+inline void seqlock_store(T* target, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) % sizeof(uint64_t) == 0 &&
+                  alignof(T) >= alignof(uint64_t), "seqlock_store needs a trivially copyable value of whole words");
+    uint64_t words[sizeof(T) / sizeof(uint64_t)];
+    memcpy(words, &value, sizeof(T));
+    uint64_t* out = reinterpret_cast<uint64_t*>(target);
+    for (size_t i = 0; i < sizeof(T) / sizeof(uint64_t); i++) {
+        __atomic_store_n(&out[i], words[i], __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Loads a value stored by seqlock_store() as relaxed atomic words; the caller checks the sequence.
+ */
+template <typename T>
+inline T seqlock_load(const T* source) {
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) % sizeof(uint64_t) == 0 &&
+                  alignof(T) >= alignof(uint64_t), "seqlock_load needs a trivially copyable value of whole words");
+    uint64_t words[sizeof(T) / sizeof(uint64_t)];
+    const uint64_t* in = reinterpret_cast<const uint64_t*>(source);
+    for (size_t i = 0; i < sizeof(T) / sizeof(uint64_t); i++) {
+        words[i] = __atomic_load_n(&in[i], __ATOMIC_RELAXED);
+    }
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Single writer, many reader sequence lock around a trivially copyable value.
+ *
+ * The writer never waits: it bumps the sequence to odd, stores the value and bumps it to even.
+ * Readers copy the value and retry if the sequence was odd or changed meanwhile, so a reader
+ * cannot slow the writer down. The value is held in relaxed atomic words so that the
+ * concurrent copy is well defined.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable value");
+
+public:
+
+    SeqLock() { Write(T()); }
+
+    /**
+     * @brief Publishes a new value. Only one thread may write.
+     */
+    void Write(const T& value) {
+        uint64_t words[kWords] = {};
+        memcpy(words, &value, sizeof(T));
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; i++) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Returns a consistent copy of the latest value; safe from any thread.
+     */
+    T Read() const {
+        uint64_t words[kWords];
+        uint32_t before, after;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; i++) {
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> seq_{0};
+    std::atomic<uint64_t> words_[kWords];
+};
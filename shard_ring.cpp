@@ -0,0 +1,95 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "shard_ring.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+/**
+ * @brief Returns a 64 bit hash of a string that is the same in every process and build.
+ *
+ * FNV-1a followed by the splitmix64 finalizer, which spreads similar names such as
+ * STA0001 and STA0002 over the whole ring.
+ */
+uint64_t shard_hash(const std::string& text) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 0x100000001B3ULL;
+    }
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+/**
+ * @brief Replaces the members of the ring.
+ */
+void ShardRing::SetNodes(const std::vector<std::string>& nodes) {
+    nodes_ = nodes;
+    points_.clear();
+    for (size_t n = 0; n < nodes_.size(); n++) {
+        for (int v = 0; v < virtual_nodes; v++) {
+            points_.emplace_back(shard_hash(nodes_[n] + "#" + std::to_string(v)), static_cast<int>(n));
+        }
+    }
+    std::sort(points_.begin(), points_.end());
+}
+
+/**
+ * @brief Assigns every key to a node.
+ */
+void ShardRing::Assign(const std::vector<std::string>& keys, double epsilon, std::vector<int>* owners) const {
+    owners->assign(keys.size(), -1);
+    if (nodes_.empty()) {
+        return;
+    }
+    std::vector<std::pair<uint64_t, size_t>> order;
+    order.reserve(keys.size());
+    for (size_t k = 0; k < keys.size(); k++) {
+        order.emplace_back(shard_hash(keys[k]), k);
+    }
+    // ties broken by the key itself, so the order does not depend on the list order
+    std::sort(order.begin(), order.end(), [&keys](const std::pair<uint64_t, size_t>& a,
+                                                   const std::pair<uint64_t, size_t>& b) {
+        return a.first != b.first ? a.first < b.first : keys[a.second] < keys[b.second];
+    });
+
+    size_t capacity = static_cast<size_t>(ceil((1.0 + epsilon) * keys.size() / nodes_.size()));
+    capacity = std::max<size_t>(capacity, 1);
+    std::vector<size_t> loads(nodes_.size(), 0);
+    for (const auto& key : order) {
+        size_t point = std::lower_bound(points_.begin(), points_.end(), std::make_pair(key.first, 0)) -
+                       points_.begin();
+        // the bound leaves room for every key, so the walk ends within one turn
+        for (size_t step = 0; step < points_.size(); step++) {
+            int node = points_[(point + step) % points_.size()].second;
+            if (loads[node] < capacity) {
+                loads[node]++;
+                (*owners)[key.second] = node;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Returns a 64 bit hash of a string that is the same in every process and build.
+ */
+uint64_t shard_hash(const std::string& text);
+
+/**
+ * @brief Consistent hashing with bounded loads: spreads keys over nodes so that no node holds
+ *        more than (1 + epsilon) times the average and a node joining or leaving moves few keys.
+ *
+ * Every node sits on a 64 bit ring at virtual_nodes points. A key goes to the first node
+ * clockwise from its hash that is still below the load bound. Keys are placed in the order
+ * of their hashes, so every process that knows the same members and keys computes the same
+ * assignment without talking to the others.
+ */
+class ShardRing {
+public:
+    static constexpr int virtual_nodes = 64;
+
+    /**
+     * @brief Replaces the members of the ring.
+     */
+    void SetNodes(const std::vector<std::string>& nodes);
+
+    /**
+     * @brief Assigns every key to a node.
+     *
+     * @param keys The keys, in any order.
+     * @param epsilon The load bound above the average, e.g. 0.25 for 25%.
+     * @param owners Receives the index in nodes() of each key's node, -1 for all without nodes.
+     */
+    void Assign(const std::vector<std::string>& keys, double epsilon, std::vector<int>* owners) const;
+
+    const std::vector<std::string>& nodes() const { return nodes_; }
+
+private:
+    std::vector<std::string> nodes_;
+    std::vector<std::pair<uint64_t, int>> points_;  // ring position and node, sorted
+};
@@ -0,0 +1,361 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "sim_transport.h"
+
+#include "rtcm3.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * @brief Constructor for SimTransport.
+ *
+ * @param clock The virtual clock advanced by Wait().
+ * @param profile The behavior of every simulated caster.
+ */
+SimTransport::SimTransport(VirtualClock* clock, const SimCasterProfile& profile) :
+    clock_(clock),
+    profile_(profile) {
+    // a proprietary (4094) message padded to the requested size, with a valid CRC
+    size_t size = std::min(std::max<size_t>(profile_.frame_size, 8), rtcm3_max_frame_size);
+    size_t payload = size - rtcm3_header_size - rtcm3_crc_size;
+    frame_.assign(rtcm3_header_size + payload + rtcm3_crc_size, '\0');
+    uint8_t* frame = reinterpret_cast<uint8_t*>(&frame_[0]);
+    frame[0] = rtcm3_preamble;
+    frame[1] = static_cast<uint8_t>(payload >> 8);
+    frame[2] = static_cast<uint8_t>(payload);
+    frame[3] = 4094 >> 4;
+    frame[4] = (4094 & 0x0F) << 4;
+    uint32_t crc = crc24q(frame, rtcm3_header_size + payload);
+    frame[rtcm3_header_size + payload] = static_cast<uint8_t>(crc >> 16);
+    frame[rtcm3_header_size + payload + 1] = static_cast<uint8_t>(crc >> 8);
+    frame[rtcm3_header_size + payload + 2] = static_cast<uint8_t>(crc);
+}
+
+/**
+ * @brief Schedules a network failure window.
+ */
+void SimTransport::AddOutage(const SimOutage& outage) {
+    outages_.push_back(outage);
+    if (!outage.silent) {
+        events_.push({outage.start_us, -1, 0, EventType::kOutage});
+    }
+}
+
+/**
+ * @brief Returns true if an outage covers the given time.
+ */
+bool SimTransport::InOutage(int64_t time, bool* silent) const {
+    for (const SimOutage& outage : outages_) {
+        if (time >= outage.start_us && time < outage.end_us) {
+            *silent = outage.silent;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Starts a simulated connection; the host and port are not interpreted, the receive buffer only reported.
+ *
+ * @return The connection handle.
+ */
+int SimTransport::Connect(const std::string& /*host*/, const std::string& /*port*/, size_t receive_buffer) {
+    int handle;
+    if (!free_handles_.empty()) {
+        handle = free_handles_.back();
+        free_handles_.pop_back();
+    } else {
+        handle = static_cast<int>(connections_.size());
+        connections_.emplace_back();
+    }
+    Connection& conn = connections_[handle];
+    conn.generation++;
+    conn.state = ConnState::kPending;
+    conn.streaming = false;
+    conn.last_gga = -1;
+    conn.receive_buffer = receive_buffer > 0 ? SetReceiveBuffer(handle, receive_buffer) : DefaultReceiveBuffer();
+
+    int64_t now = clock_->Now();
+    bool silent = false;
+    if (InOutage(now, &silent)) {
+        if (!silent) {
+            // refused at once
+            conn.state = ConnState::kFailed;
+            stats_.failed_connects++;
+            MarkReady(handle);
+        }
+        // a silent outage leaves the connect hanging until the client times out
+        return handle;
+    }
+    events_.push({now + profile_.connect_delay_us, handle, conn.generation, EventType::kConnect});
+    return handle;
+}
+
+/**
+ * @brief Returns 1 once the connection is established, 0 while pending and -1 if it failed.
+ */
+int SimTransport::ConnectResult(int handle) {
+    switch (connections_[handle].state) {
+        case ConnState::kOpen:
+            return 1;
+        case ConnState::kPending:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Accepts bytes for the caster: the NTRIP request first, then GGA sentences.
+ */
+ssize_t SimTransport::Send(int handle, const void* data, size_t size) {
+    Connection& conn = connections_[handle];
+    if (conn.state != ConnState::kOpen) {
+        return kError;
+    }
+    int64_t now = clock_->Now();
+    const char* text = static_cast<const char*>(data);
+    if (!conn.streaming) {
+        conn.request.append(text, size);
+        if (conn.request.find("\r\n\r\n") != std::string::npos) {
+            stats_.requests++;
+            std::string().swap(conn.request);
+            if (profile_.handshake_capacity > 0 && handshakes_ >= profile_.handshake_capacity) {
+                stats_.rejected++;
+                events_.push({now + profile_.response_delay_us, handle, conn.generation, EventType::kReject});
+            } else {
+                conn.handshaking = true;
+                handshakes_++;
+                events_.push({now + profile_.response_delay_us, handle, conn.generation, EventType::kResponse});
+            }
+        }
+        return size;
+    }
+    bool silent = false;
+    if (InOutage(now, &silent)) {
+        return size;  // lost on the way
+    }
+    if (size > 6 && memmem(text, size, "GGA", 3) != nullptr) {
+        stats_.gga_received++;
+        if (conn.last_gga >= 0) {
+            int64_t interval = now - conn.last_gga;
+            stats_.gga_interval_min = stats_.gga_intervals == 0 ? interval : std::min(stats_.gga_interval_min, interval);
+            stats_.gga_interval_max = std::max(stats_.gga_interval_max, interval);
+            stats_.gga_interval_sum += interval;
+            stats_.gga_intervals++;
+        }
+        conn.last_gga = now;
+    }
+    return size;
+}
+
+/**
+ * @brief Reads the caster response, then correction frames.
+ *
+ * @return The number of bytes received, kWouldBlock or kError.
+ */
+ssize_t SimTransport::Recv(int handle, void* data, size_t size) {
+    Connection& conn = connections_[handle];
+    if (conn.state == ConnState::kPending) {
+        return kWouldBlock;
+    } else if (conn.state != ConnState::kOpen) {
+        return kError;
+    }
+    uint8_t* out = static_cast<uint8_t*>(data);
+    size_t copied = 0;
+    if (!conn.head.empty()) {
+        copied = std::min(size, conn.head.size());
+        memcpy(out, conn.head.data(), copied);
+        conn.head.erase(0, copied);
+    }
+    conn.read_sent = conn.unread_sent;
+    while (copied < size && conn.pending > 0) {
+        size_t position = static_cast<size_t>(conn.offset % frame_.size());
+        size_t count = std::min({size - copied, frame_.size() - position, static_cast<size_t>(conn.pending)});
+        memcpy(out + copied, frame_.data() + position, count);
+        copied += count;
+        conn.offset += count;
+        conn.pending -= count;
+    }
+    if (copied == 0) {
+        return kWouldBlock;
+    }
+    if (conn.pending > 0) {
+        MarkReady(handle);  // level triggered, like a socket with unread data
+    } else {
+        conn.unread_sent = -1;
+    }
+    stats_.bytes_delivered += copied;
+    return static_cast<ssize_t>(copied);
+}
+
+/**
+ * @brief Closes a connection and releases its handle.
+ */
+void SimTransport::Close(int handle) {
+    if (handle < 0 || static_cast<size_t>(handle) >= connections_.size()) {
+        return;
+    }
+    Connection& conn = connections_[handle];
+    if (conn.state == ConnState::kFree) {
+        return;
+    }
+    if (conn.handshaking) {
+        conn.handshaking = false;
+        handshakes_--;
+    }
+    conn.state = ConnState::kFree;
+    conn.generation++;
+    conn.streaming = false;
+    conn.pending = 0;
+    conn.offset = 0;
+    conn.unread_sent = -1;
+    std::string().swap(conn.head);
+    std::string().swap(conn.request);
+    free_handles_.push_back(handle);
+}
+
+/**
+ * @brief Advances the virtual clock to the next event that makes a connection ready.
+ *
+ * Never advances past now + timeout_us, so the caller's timers fire on time.
+ */
+void SimTransport::Wait(int64_t timeout_us, std::vector<int>* ready) {
+    ready->clear();
+    int64_t now = clock_->Now();
+    int64_t limit = timeout_us >= std::numeric_limits<int64_t>::max() - now ? std::numeric_limits<int64_t>::max() :
+                    now + std::max<int64_t>(timeout_us, 0);
+    // like epoll, report everything that happened while the caller was busy at once
+    while (!events_.empty() && events_.top().time <= now) {
+        Event event = events_.top();
+        events_.pop();
+        Process(event);
+    }
+    while (ready_.empty() && !events_.empty() && events_.top().time <= limit) {
+        int64_t time = events_.top().time;
+        clock_->AdvanceTo(time);
+        while (!events_.empty() && events_.top().time == time) {
+            Event event = events_.top();
+            events_.pop();
+            Process(event);
+        }
+    }
+    if (ready_.empty() && limit != std::numeric_limits<int64_t>::max()) {
+        clock_->AdvanceTo(limit);
+    }
+    ready->swap(ready_);
+    for (int handle : *ready) {
+        connections_[handle].ready = false;
+    }
+}
+
+/**
+ * @brief Applies one event, marking connections that became ready.
+ */
+void SimTransport::Process(const Event& event) {
+    if (event.type == EventType::kOutage) {
+        // a hard outage resets every connection
+        for (size_t handle = 0; handle < connections_.size(); handle++) {
+            Connection& conn = connections_[handle];
+            if (conn.state == ConnState::kOpen || conn.state == ConnState::kPending) {
+                conn.state = ConnState::kFailed;
+                stats_.resets++;
+                MarkReady(static_cast<int>(handle));
+            }
+        }
+        return;
+    }
+
+    Connection& conn = connections_[event.handle];
+    if (conn.generation != event.generation || conn.state == ConnState::kFree) {
+        return;  // the connection was closed since
+    }
+    bool silent = false;
+    bool outage = InOutage(event.time, &silent);
+    switch (event.type) {
+        case EventType::kConnect:
+            if (conn.state != ConnState::kPending || (outage && silent)) {
+                return;
+            }
+            if (outage) {
+                conn.state = ConnState::kFailed;
+                stats_.failed_connects++;
+            } else {
+                conn.state = ConnState::kOpen;
+                stats_.connects++;
+            }
+            MarkReady(event.handle);
+            break;
+        case EventType::kReject:
+            if (conn.state == ConnState::kOpen && !outage) {
+                conn.head = "HTTP/1.1 503 Service Unavailable\r\n\r\n";
+                MarkReady(event.handle);
+            }
+            break;
+        case EventType::kResponse: {
+            if (conn.state != ConnState::kOpen || outage) {
+                return;
+            }
+            conn.handshaking = false;
+            handshakes_--;
+            conn.head = profile_.response;
+            conn.streaming = true;
+            MarkReady(event.handle);
+            // casters send on epoch boundaries, spread over the first 100 ms by station
+            int64_t interval = profile_.data_interval_us;
+            int64_t first = (event.time / interval + 1) * interval + (event.handle * 7919LL) % 100000;
+            events_.push({first, event.handle, conn.generation, EventType::kData});
+            break;
+        }
+        case EventType::kData:
+            if (conn.state != ConnState::kOpen) {
+                return;
+            }
+            if (!outage) {
+                if (conn.pending == 0) {
+                    conn.unread_sent = event.time;
+                }
+                conn.pending += static_cast<uint64_t>(profile_.frames_per_interval) * frame_.size();
+                MarkReady(event.handle);
+            }
+            events_.push({event.time + profile_.data_interval_us, event.handle, conn.generation, EventType::kData});
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Adds a handle to the ready list once.
+ */
+void SimTransport::MarkReady(int handle) {
+    Connection& conn = connections_[handle];
+    if (!conn.ready) {
+        conn.ready = true;
+        ready_.push_back(handle);
+    }
+}
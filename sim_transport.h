@@ -0,0 +1,175 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "clock.h"
+#include "transport.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <queue>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Behavior of the simulated caster behind SimTransport.
+ */
+struct SimCasterProfile {
+    int64_t connect_delay_us = 20000;
+    int64_t response_delay_us = 30000;  // from the request to the caster response
+    int64_t data_interval_us = 1000000;  // correction epoch interval
+    int frames_per_interval = 4;
+    size_t frame_size = 200;  // bytes per RTCM3 frame, header and CRC included
+    std::string response = "ICY 200 OK\r\n\r\n";
+    int handshake_capacity = 0;  // requests the caster works on at once, more get 503; 0 for no limit
+};
+
+/**
+ * @brief A window of simulated network failure.
+ */
+struct SimOutage {
+    int64_t start_us;
+    int64_t end_us;
+    bool silent;  // true: packets vanish and connects hang; false: connections reset and connects are refused
+};
+
+/**
+ * @brief Totals observed by the simulated caster.
+ */
+struct SimStats {
+    uint64_t connects = 0;
+    uint64_t failed_connects = 0;
+    uint64_t resets = 0;
+    uint64_t requests = 0;
+    uint64_t rejected = 0;  // requests answered with 503 because the caster was at capacity
+    uint64_t bytes_delivered = 0;
+    uint64_t gga_received = 0;
+    int64_t gga_interval_min = 0;  // between consecutive GGA sentences of a connection
+    int64_t gga_interval_max = 0;
+    int64_t gga_interval_sum = 0;
+    uint64_t gga_intervals = 0;
+};
+
+/**
+ * @brief In-memory network with scripted casters, driven by a VirtualClock.
+ *
+ * Wait() advances the virtual clock straight to the next network event instead of sleeping,
+ * so hours of traffic for thousands of streams run in seconds and identically on every run.
+ * Correction data is generated lazily from a template frame at read time, which keeps the
+ * memory per connection constant however far a client falls behind.
+ */
+class SimTransport : public Transport {
+public:
+
+    /**
+     * @brief Constructor for SimTransport.
+     *
+     * @param clock The virtual clock advanced by Wait().
+     * @param profile The behavior of every simulated caster.
+     */
+    SimTransport(VirtualClock* clock, const SimCasterProfile& profile);
+
+    /**
+     * @brief Schedules a network failure window.
+     */
+    void AddOutage(const SimOutage& outage);
+
+    /**
+     * @brief Returns true if an outage covers the given time.
+     */
+    bool InOutage(int64_t time, bool* silent) const;
+
+    const SimStats& stats() const { return stats_; }
+
+    /**
+     * @brief Returns when the correction data returned by the last Recv() on a handle was
+     *        sent by the caster, for measuring delivery latency.
+     */
+    int64_t DataTime(int handle) const { return connections_[handle].read_sent; }
+
+    int Connect(const std::string& host, const std::string& port, size_t receive_buffer) override;
+    int ConnectResult(int handle) override;
+    ssize_t Send(int handle, const void* data, size_t size) override;
+    ssize_t Recv(int handle, void* data, size_t size) override;
+    void Close(int handle) override;
+    void Wait(int64_t timeout_us, std::vector<int>* ready) override;
+
+    /**
+     * @brief Reports sizes the way Linux does, twice the request, without limiting the pending data.
+     */
+    size_t SetReceiveBuffer(int /*handle*/, size_t bytes) override { return 2 * bytes; }
+    size_t DefaultReceiveBuffer() const override { return 131072; }  // Linux net.ipv4.tcp_rmem default
+    size_t ReceiveBuffer(int handle) const override { return connections_[handle].receive_buffer; }
+
+private:
+
+    enum class ConnState : uint8_t { kFree, kPending, kOpen, kFailed };
+    enum class EventType : uint8_t { kConnect, kResponse, kReject, kData, kOutage };
+
+    struct Connection {
+        ConnState state = ConnState::kFree;
+        uint32_t generation = 0;  // invalidates events of a closed handle that was reused
+        bool streaming = false;
+        bool ready = false;  // already listed for the next Wait()
+        bool handshaking = false;  // holds one of the caster's handshake slots
+        std::string request;
+        std::string head;  // response bytes not yet read
+        uint64_t pending = 0;  // correction bytes not yet read
+        uint64_t offset = 0;  // position in the endless frame stream
+        int64_t unread_sent = -1;  // send time of the oldest unread data
+        int64_t read_sent = -1;  // send time of the data returned by the last Recv()
+        int64_t last_gga = -1;
+        size_t receive_buffer = 0;  // as the kernel would report it
+    };
+
+    struct Event {
+        int64_t time;
+        int handle;
+        uint32_t generation;
+        EventType type;
+        bool operator>(const Event& other) const { return time > other.time; }
+    };
+
+    /**
+     * @brief Applies one event, marking connections that became ready.
+     */
+    void Process(const Event& event);
+
+    /**
+     * @brief Adds a handle to the ready list once.
+     */
+    void MarkReady(int handle);
+
+    VirtualClock* clock_;
+    SimCasterProfile profile_;
+    std::string frame_;  // template RTCM3 frame repeated as correction data
+    std::vector<SimOutage> outages_;
+    std::vector<Connection> connections_;
+    std::vector<int> free_handles_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    std::vector<int> ready_;
+    int handshakes_ = 0;  // requests the caster is working on
+    SimStats stats_;
+};
@@ -0,0 +1,709 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "spp_engine.h"
+#include "ephemeris.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+constexpr uint32_t week_ms = 604800000;
+constexpr uint32_t bds_offset_ms = 14000;  // GPS - BDT
+constexpr double reference_offset = 0.075;  // s before reception where orbits are evaluated, a typical travel time
+constexpr double converged = 1e-4;  // m, position update that ends the iterations
+constexpr int max_exclusions = 3;  // outliers removed per epoch
+constexpr int num_terms = 26;  // normal equation sums accumulated by the kernel
+
+// spp_lanes doubles handled as one value, mapped to SIMD registers by the compiler
+typedef double lane_vector __attribute__((vector_size(spp_lanes * sizeof(double))));
+
+/**
+ * @brief Loads spp_lanes consecutive doubles.
+ */
+static inline void load_lanes(const double* values, lane_vector* lanes) {
+    memcpy(lanes, values, sizeof(*lanes));
+}
+
+/**
+ * @brief Stores spp_lanes consecutive doubles.
+ */
+static inline void store_lanes(double* values, const lane_vector& lanes) {
+    memcpy(values, &lanes, sizeof(lanes));
+}
+
+/**
+ * @brief Returns the receiver clock index of a constellation, or -1 if it is not positioned.
+ */
+static int clock_index(GnssSystem system) {
+    switch (system) {
+        case GnssSystem::kGps:
+            return 0;
+        case GnssSystem::kGalileo:
+            return 1;
+        case GnssSystem::kBeidou:
+            return 2;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Factorizes a symmetric positive definite matrix in place into its lower Cholesky factor.
+ *
+ * @return false if the matrix is not positive definite.
+ */
+static bool cholesky_factor(double a[spp_num_unknowns][spp_num_unknowns]) {
+    for (int j = 0; j < spp_num_unknowns; j++) {
+        double d = a[j][j];
+        for (int k = 0; k < j; k++) {
+            d -= a[j][k] * a[j][k];
+        }
+        if (d <= 0.0) {
+            return false;
+        }
+        a[j][j] = sqrt(d);
+        for (int i = j + 1; i < spp_num_unknowns; i++) {
+            double s = a[i][j];
+            for (int k = 0; k < j; k++) {
+                s -= a[i][k] * a[j][k];
+            }
+            a[i][j] = s / a[j][j];
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Solves L L^T x = b in place with a factor from cholesky_factor().
+ */
+static void cholesky_solve(const double l[spp_num_unknowns][spp_num_unknowns], double b[spp_num_unknowns]) {
+    for (int i = 0; i < spp_num_unknowns; i++) {
+        for (int k = 0; k < i; k++) {
+            b[i] -= l[i][k] * b[k];
+        }
+        b[i] /= l[i][i];
+    }
+    for (int i = spp_num_unknowns - 1; i >= 0; i--) {
+        for (int k = i + 1; k < spp_num_unknowns; k++) {
+            b[i] -= l[k][i] * b[k];
+        }
+        b[i] /= l[i][i];
+    }
+}
+
+/**
+ * @brief Returns the zenith troposphere delay in meters of a standard atmosphere at a height.
+ */
+static double zenith_delay(double height) {
+    if (height < -500.0 || height > 9000.0) {
+        return 0.0;
+    }
+    return 2.3 * exp(-0.116e-3 * height);
+}
+
+/**
+ * @brief Constructor for SppEngine.
+ *
+ * @param options The solver and monitoring settings.
+ */
+SppEngine::SppEngine(const SppOptions& options) : options_(options) {
+    if (options_.max_iterations < 1) {
+        options_.max_iterations = 1;
+    }
+    if (options_.smoothing_epochs < 1) {
+        options_.smoothing_epochs = 1;
+    }
+    for (double& correction : corrections_) {
+        correction = NAN;
+    }
+}
+
+/**
+ * @brief Adds a station.
+ *
+ * @param name The name used in reports, e.g. the stream key.
+ * @return The station index passed to OnFrame().
+ */
+int SppEngine::AddStation(const std::string& name) {
+    stations_.emplace_back();
+    stations_.back().name = name;
+    return static_cast<int>(stations_.size()) - 1;
+}
+
+/**
+ * @brief Makes a station the DGNSS base: every other station is then corrected with its pseudorange errors.
+ *
+ * @param station The base station index, or -1 for stand-alone positioning.
+ */
+void SppEngine::SetBase(int station) {
+    base_ = station >= 0 && station < num_stations() ? station : -1;
+    corrections_tow_ms_ = UINT32_MAX;
+}
+
+/**
+ * @brief Takes one frame of a station: MSM observations, 1005/1006 position or an ephemeris.
+ */
+void SppEngine::OnFrame(int station, const uint8_t* frame, size_t size) {
+    if (station < 0 || station >= num_stations()) {
+        return;
+    }
+    int type = rtcm3_message_type(frame, size);
+    GnssSystem system;
+    int level;
+    if (rtcm3_msm_info(type, &system, &level)) {
+        if (decode_rtcm3_msm(frame, size, &msm_)) {
+            AddObservations(station, msm_);
+        }
+    } else if (type == 1005 || type == 1006) {
+        Rtcm3Station position;
+        if (!decode_rtcm3_station(frame, size, &position)) {
+            return;
+        }
+        Station& state = stations_[station];
+        double moved = 0.0;
+        for (int j = 0; j < 3; j++) {
+            moved = std::max(moved, fabs(position.ecef[j] - state.reference.ecef[j]));
+        }
+        if (state.has_reference && moved < 0.001) {
+            return;
+        }
+        // a new advertised position restarts the comparison
+        state.has_reference = true;
+        state.reference = position;
+        state.averaged = 0;
+        state.moved = false;
+        double lat, lon, height;
+        ecef_to_geodetic(position.ecef, &lat, &lon, &height);
+        const double rows[9] = {
+            -sin(lon), cos(lon), 0.0,
+            -sin(lat) * cos(lon), -sin(lat) * sin(lon), cos(lat),
+            cos(lat) * cos(lon), cos(lat) * sin(lon), sin(lat)
+        };
+        std::copy(rows, rows + 9, state.to_enu);
+    } else if (type == 1019 || type == 1042 || type == 1045 || type == 1046) {
+        Rtcm3Ephemeris eph;
+        if (!decode_rtcm3_ephemeris(frame, size, &eph)) {
+            return;
+        }
+        int clock = clock_index(eph.system);
+        if (clock < 0 || eph.prn < 1 || eph.prn > spp_max_sats) {
+            return;
+        }
+        Satellite& sat = satellites_[clock][eph.prn - 1];
+        if (sat.has_ephemeris && sat.eph.toe == eph.toe && sat.eph.iode == eph.iode) {
+            return;
+        }
+        sat.has_ephemeris = true;
+        sat.eph = eph;
+        sat.gps_tow_ms = UINT32_MAX;
+    }
+}
+
+/**
+ * @brief Adds an MSM message to a station's pending epoch.
+ */
+void SppEngine::AddObservations(int station, const MsmMessage& msm) {
+    Station& state = stations_[station];
+    int clock = clock_index(msm.system);
+    if (clock >= 0) {
+        uint32_t tow = msm.epoch_ms;
+        if (msm.system == GnssSystem::kBeidou) {
+            tow = (tow + bds_offset_ms) % week_ms;
+        }
+        if (state.open && state.pending.gps_tow_ms != tow) {
+            ready_.push_back(state.pending);
+            state.open = false;
+        }
+        if (!state.open) {
+            state.pending.station = station;
+            state.pending.gps_tow_ms = tow;
+            state.pending.num_sats = 0;
+            state.open = true;
+        }
+        Epoch& epoch = state.pending;
+        // cells are satellite major: combine the first two frequencies of each satellite iono-free
+        int cell = 0;
+        while (cell < msm.num_cells) {
+            const uint8_t prn = msm.cells[cell].prn;
+            double p1 = 0.0;
+            double f1 = 0.0;
+            double p2 = 0.0;
+            double f2 = 0.0;
+            for (; cell < msm.num_cells && msm.cells[cell].prn == prn; cell++) {
+                const MsmCell& obs = msm.cells[cell];
+                double f = msm_signal_frequency(msm.system, obs.signal_id, 0);
+                if (!(obs.valid & MsmCell::kPseudorange) || f <= 0.0) {
+                    continue;
+                }
+                if (f1 == 0.0) {
+                    p1 = obs.pseudorange;
+                    f1 = f;
+                } else if (f2 == 0.0 && fabs(f - f1) > 1e6) {
+                    p2 = obs.pseudorange;
+                    f2 = f;
+                }
+            }
+            if (f1 == 0.0 || prn < 1 || prn > spp_max_sats || epoch.num_sats >= spp_max_sats) {
+                continue;
+            }
+            bool duplicate = false;
+            for (int k = 0; k < epoch.num_sats; k++) {
+                duplicate = duplicate || (epoch.clock[k] == clock && epoch.prn[k] == prn);
+            }
+            if (duplicate) {
+                continue;
+            }
+            double pseudorange = p1;
+            if (f2 != 0.0) {
+                pseudorange = (f1 * f1 * p1 - f2 * f2 * p2) / (f1 * f1 - f2 * f2);
+            }
+            epoch.clock[epoch.num_sats] = static_cast<uint8_t>(clock);
+            epoch.prn[epoch.num_sats] = prn;
+            epoch.pseudorange[epoch.num_sats] = pseudorange;
+            epoch.num_sats++;
+        }
+    }
+    // constellations without an ephemeris still end the epoch
+    if (!msm.multiple && state.open) {
+        ready_.push_back(state.pending);
+        state.open = false;
+    }
+}
+
+/**
+ * @brief Returns a satellite with its state at an epoch, or nullptr if it has no usable ephemeris.
+ */
+const SppEngine::Satellite* SppEngine::SatelliteAt(int clock, int prn, uint32_t gps_tow_ms) {
+    Satellite& sat = satellites_[clock][prn - 1];
+    if (!sat.has_ephemeris) {
+        return nullptr;
+    }
+    if (sat.gps_tow_ms != gps_tow_ms) {
+        sat.gps_tow_ms = gps_tow_ms;
+        uint32_t system_ms = clock == 2 ? (gps_tow_ms + week_ms - bds_offset_ms) % week_ms : gps_tow_ms;
+        double t = system_ms / 1000.0 - reference_offset;
+        double age = remainder(t - sat.eph.toe, 604800.0);
+        sat.usable = fabs(age) <= spp_max_ephemeris_age;
+        if (sat.usable) {
+            double before[3];
+            double after[3];
+            double clock_before;
+            double clock_after;
+            ephemeris_position(sat.eph, t, sat.pos, &sat.clock_bias);
+            ephemeris_position(sat.eph, t - 0.5, before, &clock_before);
+            ephemeris_position(sat.eph, t + 0.5, after, &clock_after);
+            for (int j = 0; j < 3; j++) {
+                sat.vel[j] = after[j] - before[j];
+            }
+            sat.clock_drift = clock_after - clock_before;
+        }
+    }
+    return sat.usable ? &sat : nullptr;
+}
+
+/**
+ * @brief Runs the least-squares kernel on one station epoch.
+ *
+ * @param corrections Pseudorange corrections by clock and PRN (NaN if unavailable), or nullptr.
+ */
+bool SppEngine::SolveEpoch(const Epoch& epoch, const double* corrections, SppSolution* solution) {
+    // satellite positions at transmission time and corrected pseudoranges, structure of arrays
+    alignas(32) double sx[spp_max_sats];
+    alignas(32) double sy[spp_max_sats];
+    alignas(32) double sz[spp_max_sats];
+    alignas(32) double obs[spp_max_sats];
+    alignas(32) double weight[spp_max_sats];
+    alignas(32) double residual[spp_max_sats];
+    alignas(32) double system[spp_num_clocks][spp_max_sats];  // 1 for the satellite's own clock
+    int n = 0;
+    for (int k = 0; k < epoch.num_sats; k++) {
+        const Satellite* sat = SatelliteAt(epoch.clock[k], epoch.prn[k], epoch.gps_tow_ms);
+        if (sat == nullptr) {
+            continue;
+        }
+        double correction = 0.0;
+        if (corrections != nullptr) {
+            correction = corrections[epoch.clock[k] * spp_max_sats + epoch.prn[k] - 1];
+            if (isnan(correction)) {
+                continue;
+            }
+        }
+        double dt = reference_offset - (epoch.pseudorange[k] / speed_of_light + sat->clock_bias);
+        sx[n] = sat->pos[0] + sat->vel[0] * dt;
+        sy[n] = sat->pos[1] + sat->vel[1] * dt;
+        sz[n] = sat->pos[2] + sat->vel[2] * dt;
+        obs[n] = epoch.pseudorange[k] + speed_of_light * (sat->clock_bias + sat->clock_drift * dt) + correction;
+        weight[n] = 1.0;
+        for (int c = 0; c < spp_num_clocks; c++) {
+            system[c][n] = c == epoch.clock[k] ? 1.0 : 0.0;
+        }
+        n++;
+    }
+    if (n == 0) {
+        return false;
+    }
+    // pad to whole lanes with weightless copies of the first satellite
+    const int padded = (n + spp_lanes - 1) / spp_lanes * spp_lanes;
+    for (int k = n; k < padded; k++) {
+        sx[k] = sx[0];
+        sy[k] = sy[0];
+        sz[k] = sz[0];
+        obs[k] = obs[0];
+        weight[k] = 0.0;
+        for (int c = 0; c < spp_num_clocks; c++) {
+            system[c][k] = system[c][0];
+        }
+    }
+
+    Station& station = stations_[epoch.station];
+    double x[spp_num_unknowns] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    if (station.has_position) {
+        std::copy(station.position, station.position + 3, x);
+        std::copy(station.clocks, station.clocks + spp_num_clocks, x + 3);
+    } else if (station.has_reference) {
+        std::copy(station.reference.ecef, station.reference.ecef + 3, x);
+    }
+    const double sin_mask = sin(options_.elevation_mask * gnss_pi / 180.0);
+    const bool troposphere = options_.troposphere && corrections == nullptr;
+    double l[spp_num_unknowns][spp_num_unknowns];
+    double used = 0.0;
+    double sum_vv = 0.0;
+    int exclusions = 0;
+    int iterations = 0;
+    bool done = false;
+    while (!done) {
+        if (iterations++ >= options_.max_iterations) {
+            return false;
+        }
+        // the elevation mask and troposphere need a position near the ground
+        const double radius = sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+        const bool ground = radius > 6.0e6 && radius < 6.5e6;
+        double up[3] = {0.0, 0.0, 0.0};
+        double zenith = 0.0;
+        if (ground) {
+            for (int j = 0; j < 3; j++) {
+                up[j] = x[j] / radius;
+            }
+            if (troposphere) {
+                double lat, lon, height;
+                ecef_to_geodetic(x, &lat, &lon, &height);
+                zenith = zenith_delay(height);
+            }
+        }
+        const double limit = ground ? sin_mask : -2.0;
+        const double sagnac = earth_rotation_rate / speed_of_light;
+
+        // geometry kernel, spp_lanes satellites per step with independent partial sums per term
+        lane_vector acc[num_terms] = {};
+        for (int i = 0; i < padded; i += spp_lanes) {
+            lane_vector px, py, pz, g, e, c, measured, weights;
+            load_lanes(sx + i, &px);
+            load_lanes(sy + i, &py);
+            load_lanes(sz + i, &pz);
+            load_lanes(system[0] + i, &g);
+            load_lanes(system[1] + i, &e);
+            load_lanes(system[2] + i, &c);
+            load_lanes(obs + i, &measured);
+            load_lanes(weight + i, &weights);
+            const lane_vector dx = px - x[0];
+            const lane_vector dy = py - x[1];
+            const lane_vector dz = pz - x[2];
+            lane_vector r = dx * dx + dy * dy + dz * dz;
+            for (int lane = 0; lane < spp_lanes; lane++) {
+                r[lane] = sqrt(r[lane]);
+            }
+            const lane_vector ex = dx / r;
+            const lane_vector ey = dy / r;
+            const lane_vector ez = dz / r;
+            const lane_vector sin_el = ex * up[0] + ey * up[1] + ez * up[2];
+            lane_vector slant = 0.002001 + sin_el * sin_el;
+            for (int lane = 0; lane < spp_lanes; lane++) {
+                slant[lane] = zenith * 1.001 / sqrt(slant[lane]);
+            }
+            const lane_vector model = r + sagnac * (px * x[1] - py * x[0]) + g * x[3] + e * x[4] + c * x[5] + slant;
+            const lane_vector v = measured - model;
+            const lane_vector w = sin_el >= limit ? weights : 0.0 * v;  // 0 or 1
+            store_lanes(residual + i, w * v);
+            // partials are (-ex, -ey, -ez, g, e, c)
+            acc[0] += w * ex * ex;
+            acc[1] += w * ex * ey;
+            acc[2] += w * ex * ez;
+            acc[3] += w * ey * ey;
+            acc[4] += w * ey * ez;
+            acc[5] += w * ez * ez;
+            acc[6] -= w * ex * g;
+            acc[7] -= w * ex * e;
+            acc[8] -= w * ex * c;
+            acc[9] -= w * ey * g;
+            acc[10] -= w * ey * e;
+            acc[11] -= w * ey * c;
+            acc[12] -= w * ez * g;
+            acc[13] -= w * ez * e;
+            acc[14] -= w * ez * c;
+            acc[15] += w * g;
+            acc[16] += w * e;
+            acc[17] += w * c;
+            acc[18] -= w * ex * v;
+            acc[19] -= w * ey * v;
+            acc[20] -= w * ez * v;
+            acc[21] += w * g * v;
+            acc[22] += w * e * v;
+            acc[23] += w * c * v;
+            acc[24] += w * v * v;
+            acc[25] += w;
+        }
+        double sum[num_terms];
+        for (int t = 0; t < num_terms; t++) {
+            sum[t] = 0.0;
+            for (int lane = 0; lane < spp_lanes; lane++) {
+                sum[t] += acc[t][lane];
+            }
+        }
+        used = sum[25];
+        sum_vv = sum[24];
+
+        // normal equations; a constellation without satellites keeps its clock
+        const double n_matrix[spp_num_unknowns][spp_num_unknowns] = {
+            {sum[0], sum[1], sum[2], sum[6], sum[7], sum[8]},
+            {sum[1], sum[3], sum[4], sum[9], sum[10], sum[11]},
+            {sum[2], sum[4], sum[5], sum[12], sum[13], sum[14]},
+            {sum[6], sum[9], sum[12], sum[15], 0.0, 0.0},
+            {sum[7], sum[10], sum[13], 0.0, sum[16], 0.0},
+            {sum[8], sum[11], sum[14], 0.0, 0.0, sum[17]},
+        };
+        double b[spp_num_unknowns] = {sum[18], sum[19], sum[20], sum[21], sum[22], sum[23]};
+        int unknowns = 3;
+        for (int i = 0; i < spp_num_unknowns; i++) {
+            std::copy(n_matrix[i], n_matrix[i] + spp_num_unknowns, l[i]);
+        }
+        for (int c = 0; c < spp_num_clocks; c++) {
+            if (sum[15 + c] > 0.0) {
+                unknowns++;
+            } else {
+                l[3 + c][3 + c] = 1.0;
+            }
+        }
+        if (used < unknowns || !cholesky_factor(l)) {
+            return false;
+        }
+        cholesky_solve(l, b);
+        for (int j = 0; j < spp_num_unknowns; j++) {
+            x[j] += b[j];
+        }
+        if (sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]) >= converged) {
+            continue;
+        }
+        done = true;
+
+        // exclude the worst satellite if it is an outlier and enough remain
+        int worst = -1;
+        for (int k = 0; k < n; k++) {
+            if (fabs(residual[k]) > options_.outlier_limit && (worst < 0 || fabs(residual[k]) > fabs(residual[worst]))) {
+                worst = k;
+            }
+        }
+        if (worst >= 0 && exclusions < max_exclusions && used - 1.0 >= unknowns) {
+            weight[worst] = 0.0;
+            exclusions++;
+            iterations = 0;
+            done = false;
+        }
+    }
+
+    // position dilution from the diagonal of the inverse normal matrix
+    double pdop = 0.0;
+    for (int j = 0; j < 3; j++) {
+        double column[spp_num_unknowns] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        column[j] = 1.0;
+        cholesky_solve(l, column);
+        pdop += column[j];
+    }
+    if (sqrt(pdop) > options_.max_pdop) {
+        return false;
+    }
+    solution->valid = true;
+    solution->num_sats = static_cast<int>(used);
+    std::copy(x, x + 3, solution->ecef);
+    solution->rms = sqrt(sum_vv / used);
+    solution->pdop = sqrt(pdop);
+    station.has_position = true;
+    std::copy(x, x + 3, station.position);
+    std::copy(x + 3, x + spp_num_unknowns, station.clocks);
+    return true;
+}
+
+/**
+ * @brief Records the base station's pseudorange errors against its advertised position.
+ */
+void SppEngine::UpdateCorrections(const Epoch& epoch) {
+    const double* rx = stations_[epoch.station].reference.ecef;
+    for (double& correction : corrections_) {
+        correction = NAN;
+    }
+    corrections_tow_ms_ = epoch.gps_tow_ms;
+    for (int k = 0; k < epoch.num_sats; k++) {
+        const Satellite* sat = SatelliteAt(epoch.clock[k], epoch.prn[k], epoch.gps_tow_ms);
+        if (sat == nullptr) {
+            continue;
+        }
+        double dt = reference_offset - (epoch.pseudorange[k] / speed_of_light + sat->clock_bias);
+        double tx[3];
+        for (int j = 0; j < 3; j++) {
+            tx[j] = sat->pos[j] + sat->vel[j] * dt;
+        }
+        double d[3] = {tx[0] - rx[0], tx[1] - rx[1], tx[2] - rx[2]};
+        double expected = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) +
+                          earth_rotation_rate * (tx[0] * rx[1] - tx[1] * rx[0]) / speed_of_light;
+        double observed = epoch.pseudorange[k] + speed_of_light * (sat->clock_bias + sat->clock_drift * dt);
+        corrections_[epoch.clock[k] * spp_max_sats + epoch.prn[k] - 1] = expected - observed;
+    }
+}
+
+/**
+ * @brief Updates a station's monitoring state with a solution.
+ */
+void SppEngine::Monitor(Station& station, SppSolution& solution) {
+    if (!solution.valid) {
+        station.failed++;
+        station.last = solution;
+        return;
+    }
+    station.epochs++;
+    if (station.has_reference) {
+        double d[3];
+        for (int j = 0; j < 3; j++) {
+            d[j] = solution.ecef[j] - station.reference.ecef[j];
+        }
+        for (int j = 0; j < 3; j++) {
+            const double* row = station.to_enu + 3 * j;
+            solution.enu[j] = row[0] * d[0] + row[1] * d[1] + row[2] * d[2];
+        }
+        // running mean until the average spans smoothing_epochs, exponential after
+        station.averaged = std::min(station.averaged + 1, options_.smoothing_epochs);
+        double alpha = 1.0 / station.averaged;
+        for (int j = 0; j < 3; j++) {
+            station.offset[j] += alpha * (solution.enu[j] - station.offset[j]);
+        }
+        bool settled = station.averaged * 2 >= options_.smoothing_epochs;
+        station.moved = settled && (hypot(station.offset[0], station.offset[1]) > options_.horizontal_limit ||
+                                    fabs(station.offset[2]) > options_.vertical_limit);
+    }
+    station.last = solution;
+}
+
+/**
+ * @brief Solves every station epoch completed since the previous call.
+ *
+ * @param solutions Receives one solution per epoch, valid or not; may be nullptr.
+ * @return The number of epochs solved successfully.
+ */
+size_t SppEngine::Solve(std::vector<SppSolution>* solutions) {
+    // epoch by epoch, so each satellite state is computed once, and the base first within an epoch
+    order_.resize(ready_.size());
+    for (size_t i = 0; i < ready_.size(); i++) {
+        order_[i] = static_cast<uint32_t>(i);
+    }
+    const int base = base_;
+    std::sort(order_.begin(), order_.end(), [this, base](uint32_t a, uint32_t b) {
+        const Epoch& x = ready_[a];
+        const Epoch& y = ready_[b];
+        if (x.gps_tow_ms != y.gps_tow_ms) {
+            return x.gps_tow_ms < y.gps_tow_ms;
+        }
+        return (x.station == base) > (y.station == base);
+    });
+
+    size_t valid = 0;
+    for (uint32_t index : order_) {
+        const Epoch& epoch = ready_[index];
+        Station& station = stations_[epoch.station];
+        if (epoch.station == base_ && station.has_reference) {
+            UpdateCorrections(epoch);
+        }
+        SppSolution solution;
+        solution.station = epoch.station;
+        solution.gps_tow_ms = epoch.gps_tow_ms;
+        solution.differential = base_ >= 0 && epoch.station != base_ && corrections_tow_ms_ == epoch.gps_tow_ms;
+        // rovers too far from the base to share enough satellites are solved stand-alone
+        if (!solution.differential || !SolveEpoch(epoch, corrections_, &solution)) {
+            solution.differential = false;
+            SolveEpoch(epoch, nullptr, &solution);
+        }
+        Monitor(station, solution);
+        valid += solution.valid ? 1 : 0;
+        if (solutions != nullptr) {
+            solutions->push_back(solution);
+        }
+    }
+    ready_.clear();
+    return valid;
+}
+
+/**
+ * @brief Formats the monitoring state of every station as a text table.
+ *
+ * @param flagged_only Lists only the stations flagged as moved or without a position message.
+ */
+std::string SppEngine::Report(bool flagged_only) const {
+    char line[256];
+    std::string out = "station                            epochs  failed  sats  rms_m  pdop   east_m  north_m     up_m"
+                      "  avg_e_m  avg_n_m  avg_u_m  status\n";
+    for (const Station& station : stations_) {
+        const char* status = "ok";
+        if (!station.has_reference) {
+            status = "no 1005/1006";
+        } else if (station.moved) {
+            status = "MOVED";
+        } else if (station.epochs == 0) {
+            status = "no solution";
+        } else if (station.averaged * 2 < options_.smoothing_epochs) {
+            status = "settling";
+        }
+        if (flagged_only && station.has_reference && !station.moved) {
+            continue;
+        }
+        const SppSolution& last = station.last;
+        const double* offset = station.averaged > 0 ? station.offset : last.enu;
+        snprintf(line, sizeof(line), "%-32s %8llu %7llu %5d %6.2f %5.1f %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f  %s%s\n",
+                 station.name.c_str(), static_cast<unsigned long long>(station.epochs),
+                 static_cast<unsigned long long>(station.failed), last.num_sats, last.rms, last.pdop, last.enu[0],
+                 last.enu[1], last.enu[2], offset[0], offset[1], offset[2], status,
+                 last.differential ? ", dgnss" : "");
+        out += line;
+    }
+    return out;
+}
+
+/**
+ * @brief Returns the number of stations currently flagged as moved.
+ */
+int SppEngine::moved() const {
+    int count = 0;
+    for (const Station& station : stations_) {
+        count += station.moved ? 1 : 0;
+    }
+    return count;
+}
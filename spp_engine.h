@@ -0,0 +1,223 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "rtcm3.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+constexpr int spp_max_sats = 64;  // satellites of one station epoch, a multiple of spp_lanes
+constexpr int spp_lanes = 4;  // satellites the geometry kernel handles per step, one SIMD register of doubles
+constexpr int spp_num_clocks = 3;  // receiver clock offsets: GPS, Galileo, BeiDou
+constexpr int spp_num_unknowns = 3 + spp_num_clocks;
+constexpr double spp_max_ephemeris_age = 14400.0;  // s between the epoch and the ephemeris reference time
+
+/**
+ * @brief Settings for SppEngine.
+ */
+struct SppOptions {
+    double elevation_mask = 10.0;  // degrees
+    bool troposphere = true;  // subtract a standard atmosphere slant delay
+    double outlier_limit = 30.0;  // m, residuals above this exclude the satellite and solve again
+    double max_pdop = 10.0;  // weaker geometry gives no solution
+    int max_iterations = 10;
+    int smoothing_epochs = 60;  // time constant of the averaged offset from the advertised position
+    double horizontal_limit = 1.0;  // m, averaged offsets beyond these flag the station as moved
+    double vertical_limit = 2.0;  // m
+};
+
+/**
+ * @brief The position of one station at one epoch.
+ */
+struct SppSolution {
+    int station = 0;
+    uint32_t gps_tow_ms = 0;
+    bool valid = false;
+    bool differential = false;  // corrected with the base station's pseudorange corrections
+    int num_sats = 0;  // satellites used
+    double ecef[3] = {0.0, 0.0, 0.0};  // m
+    double enu[3] = {0.0, 0.0, 0.0};  // m, offset from the advertised position if one is known
+    double rms = 0.0;  // m, post-fit residuals
+    double pdop = 0.0;
+};
+
+/**
+ * @brief Single point (optionally DGNSS) positioning of many reference stations at once.
+ *
+ * The engine is fed the raw frames of every station. It assembles each station's MSM epoch
+ * from GPS, Galileo and BeiDou observations (GLONASS has no broadcast ephemeris decoder here
+ * and is skipped), keeps the newest ephemeris of every satellite from whichever stream
+ * carried it, and remembers the advertised 1005/1006 position. Solve() then positions every
+ * epoch completed since the previous call. Satellite orbits are evaluated once per epoch and
+ * shared by all stations, each station only extrapolating them linearly to its own signal
+ * transmission times, so the cost per station is the least-squares kernel alone: structure
+ * of arrays geometry over spp_lanes satellites per step and a fixed 6x6 Cholesky solve for
+ * position and one clock offset per constellation. Two frequencies are combined iono-free
+ * where the station tracks them. The solved position is compared with the advertised one in
+ * local east/north/up; an exponential average of the offset beyond the limits marks the
+ * station as moved or misconfigured.
+ */
+class SppEngine {
+public:
+
+    /**
+     * @brief Constructor for SppEngine.
+     *
+     * @param options The solver and monitoring settings.
+     */
+    explicit SppEngine(const SppOptions& options = SppOptions());
+
+    /**
+     * @brief Adds a station.
+     *
+     * @param name The name used in reports, e.g. the stream key.
+     * @return The station index passed to OnFrame().
+     */
+    int AddStation(const std::string& name);
+
+    /**
+     * @brief Makes a station the DGNSS base: every other station is then corrected with its pseudorange errors.
+     *
+     * The base itself is still solved stand-alone. Rover satellites the base did not observe in
+     * the same epoch are not used, and the troposphere model is left out as the correction
+     * contains it; rovers sharing too few satellites with the base are solved stand-alone.
+     *
+     * @param station The base station index, or -1 for stand-alone positioning.
+     */
+    void SetBase(int station);
+
+    /**
+     * @brief Takes one frame of a station: MSM observations, 1005/1006 position or an ephemeris.
+     */
+    void OnFrame(int station, const uint8_t* frame, size_t size);
+
+    /**
+     * @brief Solves every station epoch completed since the previous call.
+     *
+     * @param solutions Receives one solution per epoch, valid or not; may be nullptr.
+     * @return The number of epochs solved successfully.
+     */
+    size_t Solve(std::vector<SppSolution>* solutions);
+
+    /**
+     * @brief Formats the monitoring state of every station as a text table.
+     *
+     * @param flagged_only Lists only the stations flagged as moved or without a position message.
+     */
+    std::string Report(bool flagged_only = false) const;
+
+    /**
+     * @brief Returns the number of stations currently flagged as moved.
+     */
+    int moved() const;
+
+    int num_stations() const { return static_cast<int>(stations_.size()); }
+
+private:
+
+    /**
+     * @brief The observations of one station epoch, one pseudorange per satellite.
+     */
+    struct Epoch {
+        int station = -1;
+        uint32_t gps_tow_ms = 0;
+        int num_sats = 0;
+        uint8_t clock[spp_max_sats];  // receiver clock index, i.e. constellation
+        uint8_t prn[spp_max_sats];
+        double pseudorange[spp_max_sats];  // m, iono-free where two frequencies were tracked
+    };
+
+    /**
+     * @brief A satellite's state at the reference time of one epoch, shared by every station.
+     */
+    struct Satellite {
+        bool has_ephemeris = false;
+        Rtcm3Ephemeris eph;
+        uint32_t gps_tow_ms = UINT32_MAX;  // epoch the state below belongs to
+        bool usable = false;
+        double pos[3];  // m, ECEF at the reference time
+        double vel[3];  // m/s
+        double clock_bias;  // s
+        double clock_drift;  // s/s
+    };
+
+    struct Station {
+        std::string name;
+        bool has_reference = false;
+        Rtcm3Station reference;
+        double to_enu[9];  // rows east, north, up at the reference position
+        Epoch pending;  // epoch being assembled
+        bool open = false;
+        bool has_position = false;
+        double position[3];  // last valid solution, the starting point of the next
+        double clocks[spp_num_clocks];
+        uint64_t epochs = 0;
+        uint64_t failed = 0;
+        int averaged = 0;  // epochs in the offset average, up to smoothing_epochs
+        double offset[3] = {0.0, 0.0, 0.0};  // averaged east/north/up offset
+        SppSolution last;
+        bool moved = false;
+    };
+
+    /**
+     * @brief Adds an MSM message to a station's pending epoch.
+     */
+    void AddObservations(int station, const MsmMessage& msm);
+
+    /**
+     * @brief Returns a satellite with its state at an epoch, or nullptr if it has no usable ephemeris.
+     */
+    const Satellite* SatelliteAt(int clock, int prn, uint32_t gps_tow_ms);
+
+    /**
+     * @brief Runs the least-squares kernel on one station epoch.
+     *
+     * @param corrections Pseudorange corrections by clock and PRN (NaN if unavailable), or nullptr.
+     */
+    bool SolveEpoch(const Epoch& epoch, const double* corrections, SppSolution* solution);
+
+    /**
+     * @brief Records the base station's pseudorange errors against its advertised position.
+     */
+    void UpdateCorrections(const Epoch& epoch);
+
+    /**
+     * @brief Updates a station's monitoring state with a solution.
+     */
+    void Monitor(Station& station, SppSolution& solution);
+
+    SppOptions options_;
+    std::vector<Station> stations_;
+    std::vector<Epoch> ready_;  // completed epochs waiting for Solve()
+    std::vector<uint32_t> order_;  // indices into ready_ in solving order
+    MsmMessage msm_;  // decoding scratch
+    Satellite satellites_[spp_num_clocks][spp_max_sats];  // by clock and PRN - 1
+    int base_ = -1;
+    uint32_t corrections_tow_ms_ = UINT32_MAX;
+    double corrections_[spp_num_clocks * spp_max_sats];
+};
@@ -0,0 +1,199 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_checkpoint.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <new>
+
+static const char checkpoint_magic[8] = {'N', 'T', 'R', 'I', 'P', 'C', 'K', '1'};
+
+struct CheckpointFile::Header {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t slots;
+    uint8_t reserved[48];
+};
+
+struct CheckpointFile::Record {
+    uint32_t sequence;  // odd while the record is being written
+    uint32_t used;
+    char key[checkpoint_key_size];
+    StreamCheckpoint checkpoint;
+};
+
+/**
+ * @brief Destructor for CheckpointFile, closing the file.
+ */
+CheckpointFile::~CheckpointFile() {
+    Close();
+}
+
+/**
+ * @brief Opens or creates a checkpoint file with room for at least the given number of records.
+ *
+ * @return false if the file cannot be created or mapped.
+ */
+bool CheckpointFile::Open(const std::string& path, size_t slots) {
+    Close();
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return false;
+    }
+    Header header;
+    memset(&header, 0, sizeof(header));
+    struct stat info;
+    bool valid = fstat(fd_, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(header) &&
+                 pread(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                 memcmp(header.magic, checkpoint_magic, sizeof(checkpoint_magic)) == 0 &&
+                 header.record_size == sizeof(Record) &&
+                 static_cast<size_t>(info.st_size) >= sizeof(Header) + header.slots * sizeof(Record);
+    if (!valid) {
+        if (info.st_size > 0) {
+            std::cerr << "Warning: " << path << " is not a checkpoint of this version, starting over" << std::endl;
+        }
+        header.slots = 0;
+    }
+    slots_ = std::max<size_t>(slots, header.slots);
+    size_ = sizeof(Header) + slots_ * sizeof(Record);
+    if ((!valid && ftruncate(fd_, 0) < 0) || ftruncate(fd_, static_cast<off_t>(size_)) < 0) {
+        std::cerr << "Error: Could not size " << path << std::endl;
+        Close();
+        return false;
+    }
+    void* map = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "Error: Could not map " << path << std::endl;
+        Close();
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+    Header* mapped = reinterpret_cast<Header*>(map_);
+    memcpy(mapped->magic, checkpoint_magic, sizeof(checkpoint_magic));
+    mapped->record_size = sizeof(Record);
+    mapped->slots = static_cast<uint32_t>(slots_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    next_free_ = 0;
+    for (size_t slot = 0; slot < slots_; slot++) {
+        const Record* record = At(static_cast<int>(slot));
+        if (record->used) {
+            index_.emplace(std::string(record->key, strnlen(record->key, checkpoint_key_size)),
+                           static_cast<int>(slot));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns a record of the mapping.
+ */
+CheckpointFile::Record* CheckpointFile::At(int slot) const {
+    return reinterpret_cast<Record*>(map_ + sizeof(Header) + static_cast<size_t>(slot) * sizeof(Record));
+}
+
+/**
+ * @brief Returns the record of a key, claiming a free one for a new key; thread safe.
+ *
+ * @return The record index, -1 if the file is full or not open.
+ */
+int CheckpointFile::Slot(const std::string& key) {
+    std::string name = key.substr(0, checkpoint_key_size - 1);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto known = index_.find(name);
+    if (known != index_.end()) {
+        return known->second;
+    }
+    while (next_free_ < slots_ && At(static_cast<int>(next_free_))->used) {
+        next_free_++;
+    }
+    if (next_free_ >= slots_) {
+        return -1;
+    }
+    int slot = static_cast<int>(next_free_++);
+    Record* record = At(slot);
+    new (record) Record();  // all zero, like a record the file was extended with
+    memcpy(record->key, name.data(), name.size());
+    record->used = 1;
+    index_.emplace(name, slot);
+    return slot;
+}
+
+/**
+ * @brief Copies a record.
+ *
+ * @return false if the record was never written or was torn by a crash.
+ */
+bool CheckpointFile::Load(int slot, StreamCheckpoint* checkpoint) const {
+    if (slot < 0 || static_cast<size_t>(slot) >= slots_) {
+        return false;
+    }
+    const Record* record = At(slot);
+    uint32_t sequence = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+    if (sequence == 0 || (sequence & 1) != 0) {
+        return false;
+    }
+    memcpy(checkpoint, &record->checkpoint, sizeof(StreamCheckpoint));
+    return checkpoint->metadata_size <= checkpoint_metadata_size;
+}
+
+/**
+ * @brief Overwrites a record. Only one thread may store a given record.
+ */
+void CheckpointFile::Store(int slot, const StreamCheckpoint& checkpoint) {
+    if (slot < 0 || static_cast<size_t>(slot) >= slots_) {
+        return;
+    }
+    Record* record = At(slot);
+    uint32_t sequence = record->sequence | 1;  // a record torn by a crash stays odd until rewritten
+    __atomic_store_n(&record->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&record->checkpoint, &checkpoint, sizeof(StreamCheckpoint));
+    __atomic_store_n(&record->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Writes the records to disk and unmaps the file.
+ */
+void CheckpointFile::Close() {
+    if (map_ != nullptr) {
+        msync(map_, size_, MS_SYNC);
+        munmap(map_, size_);
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    slots_ = 0;
+}
@@ -0,0 +1,128 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+constexpr size_t checkpoint_key_size = 128;
+constexpr size_t checkpoint_metadata_size = 512;
+
+/**
+ * @brief Returns the key identifying a stream across processes, "host:port/mountpoint".
+ */
+inline std::string stream_key(const std::string& host, const std::string& port, const std::string& mountpoint) {
+    return host + ":" + port + "/" + mountpoint;
+}
+
+/**
+ * @brief What a stream keeps across a process restart.
+ */
+struct StreamCheckpoint {
+    uint32_t address = 0;  // IPv4 address of the host, network byte order; 0 if unknown
+    uint32_t receive_request = 0;  // learned socket receive buffer, 0 for the kernel default
+    uint32_t peak_burst = 0;
+    int32_t failures = 0;  // consecutive failed attempts, so a restart does not reset the backoff
+    uint8_t format = 0;  // StreamFormat locked last
+    uint8_t reserved = 0;
+    uint16_t metadata_size = 0;
+    uint8_t metadata[checkpoint_metadata_size] = {};  // latest station description frames, back to back
+};
+
+/**
+ * @brief Memory mapped file of fixed size StreamCheckpoint records, one per stream key.
+ *
+ * A record is written in place with a sequence number that is odd while it changes, so
+ * storing one is a copy into the page cache without a system call, and a record torn by a
+ * crash is skipped when it is loaded. The kernel writes the pages back on its own schedule;
+ * Close() syncs them. Different threads may store different records.
+ */
+class CheckpointFile {
+public:
+
+    CheckpointFile() = default;
+    CheckpointFile(const CheckpointFile&) = delete;
+    CheckpointFile& operator=(const CheckpointFile&) = delete;
+
+    /**
+     * @brief Destructor for CheckpointFile, closing the file.
+     */
+    ~CheckpointFile();
+
+    /**
+     * @brief Opens or creates a checkpoint file with room for at least the given number of records.
+     *
+     * A file with another layout is started over.
+     *
+     * @return false if the file cannot be created or mapped.
+     */
+    bool Open(const std::string& path, size_t slots);
+
+    /**
+     * @brief Returns the record of a key, claiming a free one for a new key; thread safe.
+     *
+     * @return The record index, -1 if the file is full or not open.
+     */
+    int Slot(const std::string& key);
+
+    /**
+     * @brief Copies a record.
+     *
+     * @return false if the record was never written or was torn by a crash.
+     */
+    bool Load(int slot, StreamCheckpoint* checkpoint) const;
+
+    /**
+     * @brief Overwrites a record. Only one thread may store a given record.
+     */
+    void Store(int slot, const StreamCheckpoint& checkpoint);
+
+    /**
+     * @brief Writes the records to disk and unmaps the file.
+     */
+    void Close();
+
+    size_t slots() const { return slots_; }
+
+private:
+    struct Header;
+    struct Record;
+
+    /**
+     * @brief Returns a record of the mapping.
+     */
+    Record* At(int slot) const;
+
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t size_ = 0;
+    size_t slots_ = 0;
+    std::mutex mutex_;  // guards index_ and claiming records
+    std::unordered_map<std::string, int> index_;
+    size_t next_free_ = 0;
+};
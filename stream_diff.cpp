@@ -0,0 +1,257 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_diff.h"
+
+#include "rtcm3.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+constexpr int msm_sat_mask_bit = 24 + 73;  // after the frame header and the MSM header fields
+
+/**
+ * @brief Constructor for StreamDiff.
+ *
+ * @param copies A name for each copy, at most diff_max_copies.
+ * @param window_us How long a message waits for its other copies.
+ */
+StreamDiff::StreamDiff(const std::vector<std::string>& copies, int64_t window_us) :
+    num_copies_(std::min<int>(static_cast<int>(copies.size()), diff_max_copies)),
+    window_us_(window_us),
+    stats_(new CopyStats[diff_max_copies]) {
+    for (int copy = 0; copy < num_copies_; copy++) {
+        stats_[copy].name = copies[copy];
+        all_ |= 1u << copy;
+    }
+}
+
+/**
+ * @brief Reads the masks of an MSM frame.
+ *
+ * @return false if the frame is too short for its masks.
+ */
+bool StreamDiff::ReadCells(const uint8_t* frame, size_t size, MsmCells* cells) {
+    const int bits = static_cast<int>(size - rtcm3_crc_size) * 8;
+    if (bits < msm_sat_mask_bit + 96) {
+        return false;
+    }
+    int pos = msm_sat_mask_bit;
+    cells->sats = static_cast<uint64_t>(getbitu(frame, pos, 32)) << 32 | getbitu(frame, pos + 32, 32);
+    cells->sigs = getbitu(frame, pos + 64, 32);
+    int num_cells = __builtin_popcountll(cells->sats) * __builtin_popcount(cells->sigs);
+    if (num_cells > 64 || bits < msm_sat_mask_bit + 96 + num_cells) {
+        return false;
+    }
+    cells->cells = 0;
+    for (int k = 0; k < num_cells; k++) {
+        cells->cells |= static_cast<uint64_t>(getbitu(frame, pos + 96 + k, 1)) << k;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the number of cells of a that b does not have.
+ */
+int StreamDiff::CountMissing(const MsmCells& a, const MsmCells& b) {
+    int b_sigs = __builtin_popcount(b.sigs);
+    int missing = 0;
+    int k = 0;
+    for (int sat = 0; sat < 64; sat++) {
+        uint64_t sat_bit = 1ULL << (63 - sat);
+        if ((a.sats & sat_bit) == 0) {
+            continue;
+        }
+        // the rank of the satellite in b, counted from PRN 1
+        int b_sat = -1;
+        if ((b.sats & sat_bit) != 0) {
+            b_sat = sat == 0 ? 0 : __builtin_popcountll(b.sats >> (64 - sat));
+        }
+        for (int sig = 0; sig < 32; sig++) {
+            uint32_t sig_bit = 1u << (31 - sig);
+            if ((a.sigs & sig_bit) == 0) {
+                continue;
+            }
+            if ((a.cells >> k++ & 1) == 0) {
+                continue;
+            }
+            bool found = false;
+            if (b_sat >= 0 && (b.sigs & sig_bit) != 0) {
+                int b_sig = sig == 0 ? 0 : __builtin_popcount(b.sigs >> (32 - sig));
+                found = (b.cells >> (b_sat * b_sigs + b_sig) & 1) != 0;
+            }
+            missing += found ? 0 : 1;
+        }
+    }
+    return missing;
+}
+
+/**
+ * @brief Adds a frame of one copy.
+ *
+ * @param arrival_us The arrival time in microseconds, from one clock for all copies.
+ */
+void StreamDiff::OnFrame(int copy, const uint8_t* frame, size_t size, int64_t arrival_us) {
+    if (copy < 0 || copy >= num_copies_ || size < rtcm3_header_size + rtcm3_crc_size) {
+        return;
+    }
+    stats_[copy].messages++;
+    if (stats_[copy].started_us < 0) {
+        stats_[copy].started_us = arrival_us;
+    }
+    Copy seen;
+    seen.arrival_us = arrival_us;
+    seen.crc = static_cast<uint32_t>(frame[size - 3]) << 16 | frame[size - 2] << 8 | frame[size - 1];
+    seen.type = static_cast<uint16_t>(rtcm3_message_type(frame, size));
+    GnssSystem system;
+    uint32_t epoch_ms;
+    int level;
+    uint64_t key;
+    if (rtcm3_msm_epoch(frame, size, &system, &epoch_ms) && rtcm3_msm_info(seen.type, &system, &level) &&
+        ReadCells(frame, size, &seen.cells)) {
+        seen.level = static_cast<uint8_t>(level);
+        uint64_t station = getbitu(frame, 24 + 12, 12);
+        key = 1ULL << 63 | static_cast<uint64_t>(system) << 56 | station << 40 | epoch_ms;
+    } else {
+        key = static_cast<uint64_t>(seen.type) << 40 | static_cast<uint64_t>(size & 0xffff) << 24 | seen.crc;
+    }
+
+    auto found = pending_.find(key);
+    if (found == pending_.end()) {
+        found = pending_.emplace(key, Entry()).first;
+        found->second.first_us = arrival_us;
+        order_.emplace_back(arrival_us, key);
+    }
+    Entry& entry = found->second;
+    if ((entry.seen & (1u << copy)) != 0) {
+        return;  // e.g. a further part of a multiple message epoch, compared by its first part
+    }
+    entry.seen |= 1u << copy;
+    entry.copies[copy] = seen;
+    if (entry.seen == all_) {
+        Evaluate(entry);
+        pending_.erase(found);
+    }
+}
+
+/**
+ * @brief Evaluates the messages whose window ran out, counting them as missing where they did not arrive.
+ */
+void StreamDiff::Expire(int64_t now_us) {
+    while (!order_.empty() && now_us - order_.front().first >= window_us_) {
+        auto found = pending_.find(order_.front().second);
+        // the entry may have been completed already, or completed and started over
+        if (found != pending_.end() && found->second.first_us == order_.front().first) {
+            Evaluate(found->second);
+            pending_.erase(found);
+        }
+        order_.pop_front();
+    }
+}
+
+/**
+ * @brief Compares the copies of a message and adds the outcome to the statistics.
+ */
+void StreamDiff::Evaluate(const Entry& entry) {
+    evaluated_++;
+    int reference = -1;  // the first copy that has the message
+    int64_t earliest = INT64_MAX;
+    for (int copy = 0; copy < num_copies_; copy++) {
+        if ((entry.seen & (1u << copy)) == 0) {
+            CopyStats& stats = stats_[copy];
+            // a copy that connected later did not miss what came before
+            stats.missing += stats.started_us >= 0 && stats.started_us <= entry.first_us ? 1 : 0;
+            continue;
+        }
+        reference = reference < 0 ? copy : reference;
+        earliest = std::min(earliest, entry.copies[copy].arrival_us);
+    }
+    const Copy& ref = entry.copies[reference];
+    for (int copy = 0; copy < num_copies_; copy++) {
+        if ((entry.seen & (1u << copy)) == 0) {
+            continue;
+        }
+        const Copy& other = entry.copies[copy];
+        CopyStats& stats = stats_[copy];
+        int64_t lag = other.arrival_us - earliest;
+        stats.lag_us.Record(static_cast<uint64_t>(lag));
+        stats.first += lag == 0 ? 1 : 0;
+        if (copy == reference) {
+            continue;
+        }
+        if (other.crc == ref.crc && other.type == ref.type) {
+            stats.identical++;
+            continue;
+        }
+        int missing = CountMissing(ref.cells, other.cells);
+        int extra = CountMissing(other.cells, ref.cells);
+        stats.cells_missing += missing;
+        stats.cells_extra += extra;
+        if (other.level != ref.level) {
+            stats.level_diff++;
+        } else if (missing == 0 && extra == 0) {
+            stats.value_diff++;
+        }
+    }
+}
+
+/**
+ * @brief Formats the comparison of every copy as a text table.
+ */
+std::string StreamDiff::Report() const {
+    char line[256];
+    snprintf(line, sizeof(line), "%llu messages compared, %zu waiting\n",
+             static_cast<unsigned long long>(evaluated_), pending_.size());
+    std::string out = line;
+    out += "copy                              messages  missing  identical  level  values  cells-  cells+  first%"
+           "  lag_p50_ms  lag_p95_ms  lag_max_ms\n";
+    for (int copy = 0; copy < num_copies_; copy++) {
+        const CopyStats& stats = stats_[copy];
+        uint64_t compared = stats.lag_us.count();
+        snprintf(line, sizeof(line), "%-32s %9llu %8llu %10llu %6llu %7llu %7llu %7llu %7.1f %11.1f %11.1f %11.1f\n",
+                 stats.name.c_str(), static_cast<unsigned long long>(stats.messages),
+                 static_cast<unsigned long long>(stats.missing), static_cast<unsigned long long>(stats.identical),
+                 static_cast<unsigned long long>(stats.level_diff), static_cast<unsigned long long>(stats.value_diff),
+                 static_cast<unsigned long long>(stats.cells_missing),
+                 static_cast<unsigned long long>(stats.cells_extra),
+                 compared > 0 ? 100.0 * stats.first / compared : 0.0, stats.lag_us.Percentile(50) / 1000.0,
+                 stats.lag_us.Percentile(95) / 1000.0, stats.lag_us.max() / 1000.0);
+        out += line;
+    }
+    return out;
+}
+
+/**
+ * @brief Returns true if any copy ever differed from the others or missed a message.
+ */
+bool StreamDiff::diverged() const {
+    for (int copy = 0; copy < num_copies_; copy++) {
+        const CopyStats& stats = stats_[copy];
+        if (stats.missing > 0 || stats.level_diff > 0 || stats.value_diff > 0 || stats.cells_missing > 0 ||
+            stats.cells_extra > 0) {
+            return true;
+        }
+    }
+    return false;
+}
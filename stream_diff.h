@@ -0,0 +1,157 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "arrival_stats.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr int diff_max_copies = 8;
+constexpr int64_t diff_window_us = 5000000;  // how long a message waits for its other copies
+
+/**
+ * @brief Compares several copies of one station's stream, as published by different casters.
+ *
+ * Messages are aligned by a 64 bit key: MSM messages by constellation, station and epoch, so
+ * copies at different MSM levels still line up, and every other message by its type, length
+ * and the CRC-24 it carries, which serves as the content hash. A message is evaluated once
+ * every copy has it, or when the window runs out, and then forgotten, so the memory is
+ * bounded by the window. Each copy is compared with the first copy that has the message:
+ * identical frames, a different MSM level, satellite signals missing or extra, or the same
+ * signals with different values. The delay of each copy is its lag behind the earliest
+ * arrival of the message. Every call is O(1) per frame apart from the MSM cell comparison.
+ */
+class StreamDiff {
+public:
+
+    /**
+     * @brief Constructor for StreamDiff.
+     *
+     * @param copies A name for each copy, at most diff_max_copies.
+     * @param window_us How long a message waits for its other copies.
+     */
+    explicit StreamDiff(const std::vector<std::string>& copies, int64_t window_us = diff_window_us);
+
+    /**
+     * @brief Adds a frame of one copy.
+     *
+     * @param arrival_us The arrival time in microseconds, from one clock for all copies.
+     */
+    void OnFrame(int copy, const uint8_t* frame, size_t size, int64_t arrival_us);
+
+    /**
+     * @brief Evaluates the messages whose window ran out, counting them as missing where they did not arrive.
+     */
+    void Expire(int64_t now_us);
+
+    /**
+     * @brief Formats the comparison of every copy as a text table.
+     */
+    std::string Report() const;
+
+    /**
+     * @brief Returns true if any copy ever differed from the others or missed a message.
+     */
+    bool diverged() const;
+
+    size_t pending() const { return pending_.size(); }
+
+private:
+
+    /**
+     * @brief The satellite, signal and cell masks of an MSM message.
+     */
+    struct MsmCells {
+        uint64_t sats = 0;  // bit 63 is PRN 1
+        uint32_t sigs = 0;  // bit 31 is signal 1
+        uint64_t cells = 0;  // bit k is the k-th cell, satellite major
+    };
+
+    /**
+     * @brief What one copy of a message looked like.
+     */
+    struct Copy {
+        int64_t arrival_us = 0;
+        uint32_t crc = 0;
+        uint16_t type = 0;
+        uint8_t level = 0;  // MSM level, 0 for other messages
+        MsmCells cells;
+    };
+
+    /**
+     * @brief A message waiting for its other copies.
+     */
+    struct Entry {
+        int64_t first_us = 0;
+        uint32_t seen = 0;  // bit per copy
+        Copy copies[diff_max_copies];
+    };
+
+    struct CopyStats {
+        std::string name;
+        uint64_t messages = 0;
+        uint64_t missing = 0;  // messages another copy had and this one did not, within the window
+        int64_t started_us = -1;  // arrival of the first frame; earlier messages are not missing
+        uint64_t identical = 0;
+        uint64_t level_diff = 0;
+        uint64_t value_diff = 0;  // same signals, different contents
+        uint64_t cells_missing = 0;  // signals the reference had and this copy did not
+        uint64_t cells_extra = 0;
+        uint64_t first = 0;  // messages this copy delivered first, ties included
+        LogHistogram lag_us;
+    };
+
+    /**
+     * @brief Reads the masks of an MSM frame.
+     *
+     * @return false if the frame is too short for its masks.
+     */
+    static bool ReadCells(const uint8_t* frame, size_t size, MsmCells* cells);
+
+    /**
+     * @brief Returns the number of cells of a that b does not have.
+     */
+    static int CountMissing(const MsmCells& a, const MsmCells& b);
+
+    /**
+     * @brief Compares the copies of a message and adds the outcome to the statistics.
+     */
+    void Evaluate(const Entry& entry);
+
+    int num_copies_;
+    int64_t window_us_;
+    uint32_t all_ = 0;  // bit per copy
+    std::unique_ptr<CopyStats[]> stats_;
+    uint64_t evaluated_ = 0;
+    std::unordered_map<uint64_t, Entry> pending_;
+    std::deque<std::pair<int64_t, uint64_t>> order_;  // first arrival and key, oldest first
+};
@@ -0,0 +1,539 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_framer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+/**
+ * @brief Returns the lower case name of a stream format ("rtcm3", "cmr", ...).
+ */
+const char* stream_format_name(StreamFormat format) {
+    switch (format) {
+        case StreamFormat::kUnknown: return "unknown";
+        case StreamFormat::kRtcm3: return "rtcm3";
+        case StreamFormat::kRtcm2: return "rtcm2";
+        case StreamFormat::kCmr: return "cmr";
+        case StreamFormat::kNmea: return "nmea";
+        case StreamFormat::kUbx: return "ubx";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Parses a stream format name as returned by stream_format_name().
+ *
+ * @return false if the name is unknown.
+ */
+bool parse_stream_format(const std::string& name, StreamFormat* format) {
+    for (int i = 0; i < num_stream_formats; i++) {
+        if (name == stream_format_name(static_cast<StreamFormat>(i))) {
+            *format = static_cast<StreamFormat>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Checks the CMR checksum (sum of status, type, length and data) and the trailing ETX.
+ */
+bool CmrRule::Check(const uint8_t* frame, size_t size) {
+    uint8_t sum = 0;
+    for (size_t i = 1; i < size - 2; i++) {
+        sum += frame[i];
+    }
+    return sum == frame[size - 2] && frame[size - 1] == 0x03;
+}
+
+/**
+ * @brief Checks the 8 bit Fletcher checksum over class, id, length and payload.
+ */
+bool UbxRule::Check(const uint8_t* frame, size_t size) {
+    uint8_t a = 0;
+    uint8_t b = 0;
+    for (size_t i = 2; i < size - 2; i++) {
+        a += frame[i];
+        b += a;
+    }
+    return a == frame[size - 2] && b == frame[size - 1];
+}
+
+/**
+ * @brief Discards the first staged byte and realigns on the next sync byte.
+ */
+template <typename Rule>
+void PacketFramer<Rule>::Resync() {
+    const void* next = (staged_ > 1) ? memchr(stage_ + 1, Rule::kSync, staged_ - 1) : nullptr;
+    size_t offset = next ? static_cast<size_t>(static_cast<const uint8_t*>(next) - stage_) : staged_;
+    skipped_bytes_ += offset;
+    staged_ -= offset;
+    memmove(stage_, stage_ + offset, staged_);
+}
+
+/**
+ * @brief Feeds received bytes and invokes the callback once per valid packet.
+ */
+template <typename Rule>
+void PacketFramer<Rule>::Push(const uint8_t* data, size_t size, const Rtcm3Framer::FrameCallback& callback) {
+    while (true) {
+        if (staged_ > 0) {
+            // finish the packet that straddled the previous read
+            if (staged_ < Rule::kHeaderSize) {
+                size_t take = std::min(Rule::kHeaderSize - staged_, size);
+                memcpy(stage_ + staged_, data, take);
+                staged_ += take;
+                data += take;
+                size -= take;
+                if (staged_ < Rule::kHeaderSize) {
+                    return;
+                }
+            }
+            size_t need = Rule::FrameSize(stage_);
+            if (need == 0) {
+                Resync();
+                continue;
+            }
+            if (staged_ < need) {
+                size_t take = std::min(need - staged_, size);
+                memcpy(stage_ + staged_, data, take);
+                staged_ += take;
+                data += take;
+                size -= take;
+                if (staged_ < need) {
+                    return;
+                }
+            }
+            if (Rule::Check(stage_, need)) {
+                frames_++;
+                callback(stage_, need);
+                staged_ -= need;
+                memmove(stage_, stage_ + need, staged_);
+            } else {
+                checksum_errors_++;
+                Resync();
+            }
+            continue;
+        }
+
+        if (size == 0) {
+            return;
+        }
+        const uint8_t* start = static_cast<const uint8_t*>(memchr(data, Rule::kSync, size));
+        if (start == nullptr) {
+            skipped_bytes_ += size;
+            return;
+        }
+        skipped_bytes_ += start - data;
+        size -= start - data;
+        data = start;
+        if (size >= Rule::kHeaderSize) {
+            size_t need = Rule::FrameSize(data);
+            if (need == 0) {
+                skipped_bytes_++;
+                data++;
+                size--;
+                continue;
+            }
+            if (size >= need) {
+                if (Rule::Check(data, need)) {
+                    frames_++;
+                    callback(data, need);
+                    data += need;
+                    size -= need;
+                } else {
+                    checksum_errors_++;
+                    skipped_bytes_++;
+                    data++;
+                    size--;
+                }
+                continue;
+            }
+        }
+        memcpy(stage_, data, size);
+        staged_ = size;
+        return;
+    }
+}
+
+template class PacketFramer<CmrRule>;
+template class PacketFramer<UbxRule>;
+
+/**
+ * @brief Returns the value of a hex digit, -1 if the character is none.
+ */
+static int hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/**
+ * @brief Checks a complete line and hands it out if the checksum matches.
+ */
+void NmeaFramer::Finish(const uint8_t* line, size_t size, const Rtcm3Framer::FrameCallback& callback) {
+    // "$" ... "*hh" then "\r\n" or "\n"
+    size_t end = size - 1;
+    if (end > 0 && line[end - 1] == '\r') {
+        end--;
+    }
+    if (end < 4 || line[end - 3] != '*') {
+        checksum_errors_++;
+        return;
+    }
+    uint8_t sum = 0;
+    for (size_t i = 1; i < end - 3; i++) {
+        sum ^= line[i];
+    }
+    int high = hex_value(line[end - 2]);
+    int low = hex_value(line[end - 1]);
+    if (high < 0 || low < 0 || sum != ((high << 4) | low)) {
+        checksum_errors_++;
+        return;
+    }
+    frames_++;
+    callback(line, size);
+}
+
+/**
+ * @brief Feeds received bytes and invokes the callback once per valid sentence.
+ */
+void NmeaFramer::Push(const uint8_t* data, size_t size, const Rtcm3Framer::FrameCallback& callback) {
+    while (size > 0) {
+        if (staged_ > 0) {
+            // finish the sentence that straddled the previous read
+            size_t room = std::min(kMaxSentence - staged_, size);
+            const uint8_t* eol = static_cast<const uint8_t*>(memchr(data, '\n', room));
+            size_t take = eol ? static_cast<size_t>(eol - data) + 1 : room;
+            memcpy(stage_ + staged_, data, take);
+            staged_ += take;
+            data += take;
+            size -= take;
+            if (eol) {
+                Finish(stage_, staged_, callback);
+                staged_ = 0;
+            } else if (staged_ == kMaxSentence) {
+                skipped_bytes_ += staged_;
+                staged_ = 0;
+            }
+            continue;
+        }
+        const uint8_t* start = static_cast<const uint8_t*>(memchr(data, '$', size));
+        if (start == nullptr) {
+            skipped_bytes_ += size;
+            return;
+        }
+        skipped_bytes_ += start - data;
+        size -= start - data;
+        data = start;
+        const uint8_t* eol = static_cast<const uint8_t*>(memchr(data, '\n', std::min(size, kMaxSentence)));
+        if (eol) {
+            size_t length = static_cast<size_t>(eol - data) + 1;
+            Finish(data, length, callback);
+            data += length;
+            size -= length;
+        } else if (size >= kMaxSentence) {
+            skipped_bytes_++;
+            data++;
+            size--;
+        } else {
+            memcpy(stage_, data, size);
+            staged_ = size;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Constructor for StreamFramer.
+ *
+ * @param probe_bytes Bytes inspected before settling for the best candidate.
+ * @param lock_frames Checked frames that lock a protocol before probe_bytes are seen.
+ */
+StreamFramer::StreamFramer(size_t probe_bytes, uint64_t lock_frames) :
+    probe_bytes_(probe_bytes), lock_frames_(lock_frames) {
+    for (int i = 0; i < num_stream_formats; i++) {
+        count_hit_[i] = [this, i](const uint8_t*, size_t) { hits_[i]++; };
+    }
+    deliver_ = [this](const uint8_t* frame, size_t size) {
+        frames_[static_cast<int>(format_)]++;
+        (*callback_)(frame, size);
+    };
+}
+
+/**
+ * @brief Returns the frames delivered over all protocols.
+ */
+uint64_t StreamFramer::frames() const {
+    uint64_t total = 0;
+    for (uint64_t count : frames_) {
+        total += count;
+    }
+    return total;
+}
+
+/**
+ * @brief Returns the checksum failures of the locked protocols since construction.
+ */
+uint64_t StreamFramer::errors() const {
+    if (format_ == StreamFormat::kUnknown) {
+        return errors_before_;
+    }
+    return errors_before_ + ParserErrors(format_) - errors_base_;
+}
+
+/**
+ * @brief Returns the bytes held waiting for more data.
+ */
+size_t StreamFramer::staged() const {
+    switch (format_) {
+        case StreamFormat::kRtcm3: return rtcm3_.staged();
+        case StreamFormat::kRtcm2: return rtcm2_.staged();
+        case StreamFormat::kCmr: return cmr_.staged();
+        case StreamFormat::kNmea: return nmea_.staged();
+        case StreamFormat::kUbx: return ubx_.staged();
+        default: return probe_.size();
+    }
+}
+
+/**
+ * @brief Returns the received bytes not yet delivered: a partial frame, or the probed bytes before a lock.
+ */
+std::string StreamFramer::Pending() const {
+    const uint8_t* data;
+    size_t size;
+    switch (format_) {
+        case StreamFormat::kRtcm3: data = rtcm3_.staged_data(); size = rtcm3_.staged(); break;
+        case StreamFormat::kCmr: data = cmr_.staged_data(); size = cmr_.staged(); break;
+        case StreamFormat::kNmea: data = nmea_.staged_data(); size = nmea_.staged(); break;
+        case StreamFormat::kUbx: data = ubx_.staged_data(); size = ubx_.staged(); break;
+        case StreamFormat::kUnknown: data = probe_.data(); size = probe_.size(); break;
+        default: return std::string();
+    }
+    return std::string(reinterpret_cast<const char*>(data), size);
+}
+
+/**
+ * @brief Returns the checksum failures counted by the parser of a protocol.
+ */
+uint64_t StreamFramer::ParserErrors(StreamFormat format) const {
+    switch (format) {
+        case StreamFormat::kRtcm3: return rtcm3_.crc_errors();
+        case StreamFormat::kRtcm2: return rtcm2_.parity_errors();
+        case StreamFormat::kCmr: return cmr_.checksum_errors();
+        case StreamFormat::kNmea: return nmea_.checksum_errors();
+        case StreamFormat::kUbx: return ubx_.checksum_errors();
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Returns the message number of a frame delivered by this framer.
+ */
+int StreamFramer::MessageType(const uint8_t* frame, size_t size) const {
+    switch (format_) {
+        case StreamFormat::kRtcm3: return rtcm3_message_type(frame, size);
+        case StreamFormat::kRtcm2: return rtcm2_message_type(frame, size);
+        case StreamFormat::kCmr: return CmrRule::MessageType(frame);
+        case StreamFormat::kUbx: return UbxRule::MessageType(frame);
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Drops any partial frame and, unless the format is fixed, starts probing again.
+ */
+void StreamFramer::Reset() {
+    rtcm3_.Reset();
+    rtcm2_.Reset();
+    cmr_.Reset();
+    nmea_.Reset();
+    ubx_.Reset();
+    if (fixed_) {
+        return;
+    }
+    errors_before_ = errors();
+    format_ = StreamFormat::kUnknown;
+    probe_.clear();
+    std::fill(hits_, hits_ + num_stream_formats, 0);
+}
+
+/**
+ * @brief Fixes the protocol instead of detecting it; kUnknown restores detection.
+ */
+void StreamFramer::SetFormat(StreamFormat format) {
+    fixed_ = false;
+    Reset();
+    if (format != StreamFormat::kUnknown) {
+        fixed_ = true;
+        format_ = format;
+        errors_base_ = ParserErrors(format);
+    }
+}
+
+/**
+ * @brief Passes bytes to the parser of a protocol.
+ */
+void StreamFramer::PushTo(StreamFormat format, const uint8_t* data, size_t size, const FrameCallback& callback) {
+    switch (format) {
+        case StreamFormat::kRtcm3: rtcm3_.Push(data, size, callback); break;
+        case StreamFormat::kRtcm2: rtcm2_.Push(data, size, callback); break;
+        case StreamFormat::kCmr: cmr_.Push(data, size, callback); break;
+        case StreamFormat::kNmea: nmea_.Push(data, size, callback); break;
+        case StreamFormat::kUbx: ubx_.Push(data, size, callback); break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Locks a protocol and replays the probed bytes through it.
+ */
+void StreamFramer::Lock(StreamFormat format) {
+    format_ = format;
+    hint_ = format;
+    errors_base_ = ParserErrors(format);
+    std::vector<uint8_t> probed;
+    probed.swap(probe_);  // releases the probe buffer once replayed
+    switch (format) {
+        case StreamFormat::kRtcm3: rtcm3_.Reset(); break;
+        case StreamFormat::kRtcm2: rtcm2_.Reset(); break;
+        case StreamFormat::kCmr: cmr_.Reset(); break;
+        case StreamFormat::kNmea: nmea_.Reset(); break;
+        case StreamFormat::kUbx: ubx_.Reset(); break;
+        default: break;
+    }
+    PushTo(format, probed.data(), probed.size(), deliver_);
+}
+
+/**
+ * @brief Feeds probe bytes to every parser and locks a protocol once one is convincing.
+ */
+void StreamFramer::Probe(const uint8_t* data, size_t size) {
+    probe_.insert(probe_.end(), data, data + size);
+    StreamFormat best = StreamFormat::kUnknown;
+    for (int i = 1; i < num_stream_formats; i++) {
+        StreamFormat format = static_cast<StreamFormat>(i);
+        PushTo(format, data, size, count_hit_[i]);
+        if (hits_[i] > hits_[static_cast<int>(best)]) {
+            best = format;
+        }
+    }
+    if (hint_ != StreamFormat::kUnknown && hits_[static_cast<int>(hint_)] > 0) {
+        Lock(hint_);
+    } else if (best != StreamFormat::kUnknown &&
+               (hits_[static_cast<int>(best)] >= lock_frames_ || probe_.size() >= probe_bytes_)) {
+        Lock(best);
+    } else if (probe_.size() >= probe_bytes_) {
+        // nothing recognisable yet: forget these bytes and keep looking
+        probe_.clear();
+    }
+}
+
+/**
+ * @brief Feeds received bytes and invokes the callback once per frame of the detected protocol.
+ *
+ * @param data The received bytes.
+ * @param size The number of received bytes.
+ * @param callback Called with each complete frame, including its header and checksum.
+ */
+void StreamFramer::Push(const uint8_t* data, size_t size, const FrameCallback& callback) {
+    callback_ = &callback;
+    if (format_ == StreamFormat::kUnknown) {
+        Probe(data, size);
+        return;
+    }
+    PushTo(format_, data, size, deliver_);
+}
+
+/**
+ * @brief Sets the receive buffer whose frames are referenced instead of copied.
+ */
+void FrameBatcher::Attach(const uint8_t* data, size_t size) {
+    buffer_ = data;
+    buffer_size_ = size;
+}
+
+/**
+ * @brief Adds a frame: a reference if it lies within the attached buffer, otherwise a copy.
+ */
+void FrameBatcher::Add(const uint8_t* frame, size_t size) {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(buffer_);
+    uintptr_t at = reinterpret_cast<uintptr_t>(frame);
+    Entry entry;
+    entry.size = static_cast<uint32_t>(size);
+    if (at >= begin && at + size <= begin + buffer_size_) {
+        entry.data = frame;
+        entry.offset = 0;
+    } else {
+        entry.data = nullptr;
+        entry.offset = static_cast<uint32_t>(owned_.size());
+        owned_.insert(owned_.end(), frame, frame + size);
+    }
+    entries_.push_back(entry);
+    bytes_ += size;
+}
+
+/**
+ * @brief Copies the frames still referencing the attached buffer, which is about to be reused.
+ */
+void FrameBatcher::Detach() {
+    for (Entry& entry : entries_) {
+        if (entry.data != nullptr) {
+            const uint8_t* frame = entry.data;
+            entry.data = nullptr;
+            entry.offset = static_cast<uint32_t>(owned_.size());
+            owned_.insert(owned_.end(), frame, frame + entry.size);
+        }
+    }
+    buffer_ = nullptr;
+    buffer_size_ = 0;
+}
+
+/**
+ * @brief Passes the collected frames to the callback, if there are any, and starts a new batch.
+ */
+void FrameBatcher::Flush(const BatchCallback& callback) {
+    if (entries_.empty()) {
+        return;
+    }
+    // copies are resolved only now, as owned_ may have moved while it grew
+    frames_.resize(entries_.size());
+    for (size_t i = 0; i < entries_.size(); i++) {
+        const Entry& entry = entries_[i];
+        frames_[i].data = entry.data != nullptr ? entry.data : owned_.data() + entry.offset;
+        frames_[i].size = entry.size;
+    }
+    FrameBatch batch;
+    batch.frames = frames_.data();
+    batch.count = frames_.size();
+    batch.bytes = bytes_;
+    if (callback) {
+        callback(batch);
+    }
+    entries_.clear();
+    owned_.clear();
+    bytes_ = 0;
+}
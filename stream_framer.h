@@ -0,0 +1,357 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "rtcm2.h"
+#include "rtcm3.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Wire protocols recognised in a correction stream.
+ */
+enum class StreamFormat : uint8_t { kUnknown, kRtcm3, kRtcm2, kCmr, kNmea, kUbx, kCount };
+
+constexpr int num_stream_formats = static_cast<int>(StreamFormat::kCount);
+
+/**
+ * @brief Returns the lower case name of a stream format ("rtcm3", "cmr", ...).
+ */
+const char* stream_format_name(StreamFormat format);
+
+/**
+ * @brief Parses a stream format name as returned by stream_format_name().
+ *
+ * @return false if the name is unknown.
+ */
+bool parse_stream_format(const std::string& name, StreamFormat* format);
+
+/**
+ * @brief Trimble CMR/CMR+ packets: STX, status, type, length, data, checksum, ETX.
+ */
+struct CmrRule {
+    static constexpr uint8_t kSync = 0x02;
+    static constexpr size_t kHeaderSize = 4;
+    static constexpr size_t kMaxFrameSize = kHeaderSize + 255 + 2;
+
+    static size_t FrameSize(const uint8_t* header) { return kHeaderSize + header[3] + 2; }
+    static bool Check(const uint8_t* frame, size_t size);
+    static int MessageType(const uint8_t* frame) { return frame[2]; }
+};
+
+/**
+ * @brief u-blox UBX packets: B5 62, class, id, little-endian length, payload, Fletcher checksum.
+ *
+ * Packets longer than kMaxFrameSize are skipped; the receivers' observation and
+ * navigation messages are far smaller.
+ */
+struct UbxRule {
+    static constexpr uint8_t kSync = 0xB5;
+    static constexpr size_t kHeaderSize = 6;
+    static constexpr size_t kMaxFrameSize = 8192;
+
+    static size_t FrameSize(const uint8_t* header) {
+        size_t size = kHeaderSize + (header[4] | (header[5] << 8)) + 2;
+        return header[1] == 0x62 && size <= kMaxFrameSize ? size : 0;
+    }
+    static bool Check(const uint8_t* frame, size_t size);
+    static int MessageType(const uint8_t* frame) { return (frame[2] << 8) | frame[3]; }
+};
+
+/**
+ * @brief Splits a byte stream into checksummed packets of a length-prefixed protocol.
+ *
+ * The same scheme as Rtcm3Framer: complete packets are handed out from the input buffer
+ * and only packets split across Push() calls are staged. The Rule gives the sync byte,
+ * the header size, the packet size from the header (0 if the header is invalid) and the
+ * checksum.
+ */
+template <typename Rule>
+class PacketFramer {
+public:
+
+    /**
+     * @brief Feeds received bytes and invokes the callback once per valid packet.
+     */
+    void Push(const uint8_t* data, size_t size, const Rtcm3Framer::FrameCallback& callback);
+
+    /**
+     * @brief Drops any partially received packet.
+     */
+    void Reset() { staged_ = 0; }
+
+    uint64_t frames() const { return frames_; }
+    uint64_t checksum_errors() const { return checksum_errors_; }
+    uint64_t skipped_bytes() const { return skipped_bytes_; }
+    size_t staged() const { return staged_; }
+    const uint8_t* staged_data() const { return stage_; }
+
+private:
+
+    /**
+     * @brief Discards the first staged byte and realigns on the next sync byte.
+     */
+    void Resync();
+
+    uint8_t stage_[Rule::kMaxFrameSize];
+    size_t staged_ = 0;
+    uint64_t frames_ = 0;
+    uint64_t checksum_errors_ = 0;
+    uint64_t skipped_bytes_ = 0;
+};
+
+/**
+ * @brief Splits a byte stream into checksummed NMEA 0183 sentences, "$...*hh" up to the line feed.
+ */
+class NmeaFramer {
+public:
+    static constexpr size_t kMaxSentence = 128;
+
+    /**
+     * @brief Feeds received bytes and invokes the callback once per valid sentence.
+     */
+    void Push(const uint8_t* data, size_t size, const Rtcm3Framer::FrameCallback& callback);
+
+    /**
+     * @brief Drops any partially received sentence.
+     */
+    void Reset() { staged_ = 0; }
+
+    uint64_t frames() const { return frames_; }
+    uint64_t checksum_errors() const { return checksum_errors_; }
+    uint64_t skipped_bytes() const { return skipped_bytes_; }
+    size_t staged() const { return staged_; }
+    const uint8_t* staged_data() const { return stage_; }
+
+private:
+
+    /**
+     * @brief Checks a complete line and hands it out if the checksum matches.
+     */
+    void Finish(const uint8_t* line, size_t size, const Rtcm3Framer::FrameCallback& callback);
+
+    uint8_t stage_[kMaxSentence];
+    size_t staged_ = 0;
+    uint64_t frames_ = 0;
+    uint64_t checksum_errors_ = 0;
+    uint64_t skipped_bytes_ = 0;
+};
+
+/**
+ * @brief Frames a correction stream of any supported protocol.
+ *
+ * The first bytes of a stream are probed: every parser sees them and counts the frames
+ * whose checksum matches. The first parser to reach lock_frames frames wins, or the one
+ * with the most frames once probe_bytes have been seen. The probed bytes are then replayed
+ * through the winner, so no frame is lost and no frame of a losing parser is delivered;
+ * after that only the winning parser runs. Data that matches nothing is dropped
+ * probe_bytes at a time while probing continues.
+ *
+ * The locked protocol is remembered as a hint across Reset(): on the next connection a
+ * single checked frame of that protocol locks it again.
+ */
+class StreamFramer {
+public:
+    using FrameCallback = Rtcm3Framer::FrameCallback;
+
+    /**
+     * @brief Constructor for StreamFramer.
+     *
+     * @param probe_bytes Bytes inspected before settling for the best candidate.
+     * @param lock_frames Checked frames that lock a protocol before probe_bytes are seen.
+     */
+    explicit StreamFramer(size_t probe_bytes = 4096, uint64_t lock_frames = 3);
+
+    /**
+     * @brief Feeds received bytes and invokes the callback once per frame of the detected protocol.
+     *
+     * @param data The received bytes.
+     * @param size The number of received bytes.
+     * @param callback Called with each complete frame, including its header and checksum.
+     */
+    void Push(const uint8_t* data, size_t size, const FrameCallback& callback);
+
+    /**
+     * @brief Drops any partial frame and, unless the format is fixed, starts probing again.
+     */
+    void Reset();
+
+    /**
+     * @brief Fixes the protocol instead of detecting it; kUnknown restores detection.
+     */
+    void SetFormat(StreamFormat format);
+
+    /**
+     * @brief Expects a protocol, e.g. one restored from a checkpoint, so its first checked frame locks it.
+     */
+    void SetHint(StreamFormat format) { hint_ = format; }
+
+    /**
+     * @brief Returns the message number of a frame delivered by this framer.
+     *
+     * RTCM3 and RTCM 2 message types, the CMR packet type or UBX class << 8 | id; 0 for NMEA.
+     */
+    int MessageType(const uint8_t* frame, size_t size) const;
+
+    /**
+     * @brief Returns the received bytes not yet delivered: a partial frame, or the probed bytes before a lock.
+     *
+     * A new framer given the same hint and these bytes resumes the stream where this one
+     * stopped. RTCM 2 stages decoded words rather than bytes, so its partial message is
+     * not returned.
+     */
+    std::string Pending() const;
+
+    StreamFormat format() const { return format_; }
+    StreamFormat hint() const { return hint_; }
+    uint64_t frames() const;
+    uint64_t frames(StreamFormat format) const { return frames_[static_cast<int>(format)]; }
+    uint64_t errors() const;
+    size_t staged() const;
+    const Rtcm3Framer& rtcm3() const { return rtcm3_; }
+    const Rtcm2Framer& rtcm2() const { return rtcm2_; }
+
+private:
+
+    /**
+     * @brief Passes bytes to the parser of a protocol.
+     */
+    void PushTo(StreamFormat format, const uint8_t* data, size_t size, const FrameCallback& callback);
+
+    /**
+     * @brief Returns the checksum failures counted by the parser of a protocol.
+     */
+    uint64_t ParserErrors(StreamFormat format) const;
+
+    /**
+     * @brief Feeds probe bytes to every parser and locks a protocol once one is convincing.
+     */
+    void Probe(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Locks a protocol and replays the probed bytes through it.
+     */
+    void Lock(StreamFormat format);
+
+    size_t probe_bytes_;
+    uint64_t lock_frames_;
+    bool fixed_ = false;  // set by SetFormat(), no probing
+    StreamFormat format_ = StreamFormat::kUnknown;
+    StreamFormat hint_ = StreamFormat::kUnknown;  // the protocol locked last
+
+    Rtcm3Framer rtcm3_;
+    Rtcm2Framer rtcm2_;
+    PacketFramer<CmrRule> cmr_;
+    NmeaFramer nmea_;
+    PacketFramer<UbxRule> ubx_;
+
+    //probing: the bytes seen so far and the frames each parser found in them
+    std::vector<uint8_t> probe_;
+    uint64_t hits_[num_stream_formats] = {};
+    FrameCallback count_hit_[num_stream_formats];
+
+    //delivery: per protocol counts of delivered frames and of checksum failures
+    const FrameCallback* callback_ = nullptr;
+    FrameCallback deliver_;
+    uint64_t frames_[num_stream_formats] = {};
+    uint64_t errors_before_ = 0;  // failures of earlier connections
+    uint64_t errors_base_ = 0;  // parser failures already counted when format_ was locked
+};
+
+/**
+ * @brief One frame of a FrameBatch.
+ */
+struct FrameRef {
+    const uint8_t* data;
+    uint32_t size;
+};
+
+/**
+ * @brief Frames delivered together, a descriptor each; valid during the batch callback.
+ *
+ * Consecutive frames are usually adjacent in memory, so a sink can write a batch with one
+ * writev() of the runs it finds.
+ */
+struct FrameBatch {
+    const FrameRef* frames = nullptr;
+    size_t count = 0;
+    size_t bytes = 0;  // of all the frames
+};
+
+/**
+ * @brief Collects frames so a consumer gets them in one call, copying as few as possible.
+ *
+ * A frame that lies within the attached receive buffer is only referenced. A frame from
+ * anywhere else, e.g. one a framer assembled across two reads, is copied, and Detach()
+ * copies the referenced frames a batch still holds before the buffer is reused. The
+ * buffers keep their capacity, so batching does not allocate once it has seen the largest
+ * batch.
+ */
+class FrameBatcher {
+public:
+    using BatchCallback = std::function<void(const FrameBatch& batch)>;
+
+    /**
+     * @brief Sets the receive buffer whose frames are referenced instead of copied.
+     */
+    void Attach(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Adds a frame: a reference if it lies within the attached buffer, otherwise a copy.
+     */
+    void Add(const uint8_t* frame, size_t size);
+
+    /**
+     * @brief Copies the frames still referencing the attached buffer, which is about to be reused.
+     */
+    void Detach();
+
+    /**
+     * @brief Passes the collected frames to the callback, if there are any, and starts a new batch.
+     */
+    void Flush(const BatchCallback& callback);
+
+    bool empty() const { return entries_.empty(); }
+    size_t count() const { return entries_.size(); }
+    size_t bytes() const { return bytes_; }
+
+private:
+    struct Entry {
+        const uint8_t* data;  // in the attached buffer, nullptr for a copy at offset in owned_
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    const uint8_t* buffer_ = nullptr;
+    size_t buffer_size_ = 0;
+    std::vector<Entry> entries_;
+    std::vector<uint8_t> owned_;
+    std::vector<FrameRef> frames_;
+    size_t bytes_ = 0;
+};
@@ -0,0 +1,299 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_handover.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <iostream>
+
+static const char handover_magic[4] = {'N', 'T', 'H', '1'};
+constexpr size_t handover_max_message = 65536;
+
+/**
+ * @brief What a handover message carries.
+ */
+enum class HandoverKind : uint8_t { kStream, kSocket, kEnd };
+
+/**
+ * @brief Start of every handover message; the key or socket name and the pending bytes follow.
+ */
+struct HandoverHeader {
+    char magic[4];
+    HandoverKind kind;
+    uint8_t reserved;
+    uint16_t key_size;
+    uint32_t pending_size;
+    uint64_t bytes_received;
+    StreamCheckpoint checkpoint;
+};
+
+/**
+ * @brief Fills in the address of a Unix socket path.
+ *
+ * @return false if the path does not fit.
+ */
+static bool unix_address(const std::string& path, struct sockaddr_un* address) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address->sun_path)) {
+        std::cerr << "Error: The handover path " << path << " is too long" << std::endl;
+        return false;
+    }
+    memcpy(address->sun_path, path.c_str(), path.size());
+    return true;
+}
+
+/**
+ * @brief Destructor for HandoverServer, closing the sockets.
+ */
+HandoverServer::~HandoverServer() {
+    Close();
+}
+
+/**
+ * @brief Listens on a path, replacing whatever socket file a predecessor left there.
+ *
+ * @return false if the socket cannot be bound.
+ */
+bool HandoverServer::Listen(const std::string& path) {
+    Close();
+    struct sockaddr_un address;
+    if (!unix_address(path, &address)) {
+        return false;
+    }
+    listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "Error: Could not create the handover socket" << std::endl;
+        return false;
+    }
+    unlink(path.c_str());
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd_, 1) < 0) {
+        std::cerr << "Error: Could not listen for a handover on " << path << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    path_ = path;
+    return true;
+}
+
+/**
+ * @brief Waits for a successor to connect; without a listening socket it only waits.
+ *
+ * @return true once one has connected; the caller then stops streaming and sends.
+ */
+bool HandoverServer::Accept(int timeout_ms) {
+    if (listen_fd_ < 0) {
+        poll(nullptr, 0, timeout_ms);
+        return false;
+    }
+    struct pollfd fd = {listen_fd_, POLLIN, 0};
+    if (poll(&fd, 1, timeout_ms) <= 0) {
+        return false;
+    }
+    peer_fd_ = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    return peer_fd_ >= 0;
+}
+
+/**
+ * @brief Sends one message with an optional socket attached.
+ */
+bool HandoverServer::Send(const void* header, size_t header_size, const std::string& body, int fd) {
+    if (peer_fd_ < 0 || header_size + body.size() > handover_max_message) {
+        return false;
+    }
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<void*>(header);
+    iov[0].iov_len = header_size;
+    iov[1].iov_base = const_cast<char*>(body.data());
+    iov[1].iov_len = body.size();
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    union {
+        struct cmsghdr align;
+        char data[CMSG_SPACE(sizeof(int))];
+    } control;
+    if (fd >= 0) {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.data;
+        msg.msg_controllen = sizeof(control.data);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+    ssize_t sent;
+    do {
+        sent = sendmsg(peer_fd_, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    return sent == static_cast<ssize_t>(header_size + body.size());
+}
+
+/**
+ * @brief Sends a stream and its socket to the successor; the caller closes its copy of the socket.
+ */
+bool HandoverServer::SendStream(const HandedStream& stream) {
+    HandoverHeader header = HandoverHeader();  // value-initialized, so the padding sent is zero too
+    memcpy(header.magic, handover_magic, sizeof(header.magic));
+    header.kind = HandoverKind::kStream;
+    header.key_size = static_cast<uint16_t>(stream.key.size());
+    header.pending_size = static_cast<uint32_t>(stream.pending.size());
+    header.bytes_received = stream.bytes_received;
+    header.checkpoint = stream.checkpoint;
+    return Send(&header, sizeof(header), stream.key + stream.pending, stream.fd);
+}
+
+/**
+ * @brief Sends another socket under a name, such as a listener; the caller closes its copy.
+ */
+bool HandoverServer::SendSocket(const std::string& name, int fd) {
+    HandoverHeader header = HandoverHeader();
+    memcpy(header.magic, handover_magic, sizeof(header.magic));
+    header.kind = HandoverKind::kSocket;
+    header.key_size = static_cast<uint16_t>(name.size());
+    return Send(&header, sizeof(header), name, fd);
+}
+
+/**
+ * @brief Tells the successor that everything has been sent.
+ */
+bool HandoverServer::Finish() {
+    HandoverHeader header = HandoverHeader();
+    memcpy(header.magic, handover_magic, sizeof(header.magic));
+    header.kind = HandoverKind::kEnd;
+    return Send(&header, sizeof(header), std::string(), -1);
+}
+
+/**
+ * @brief Closes the sockets, removing the path unless a successor took it over.
+ */
+void HandoverServer::Close() {
+    if (peer_fd_ >= 0) {
+        close(peer_fd_);
+        peer_fd_ = -1;
+    } else if (listen_fd_ >= 0) {
+        unlink(path_.c_str());
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+/**
+ * @brief The new side of a binary upgrade: takes over the sockets of the process listening on a path.
+ *
+ * @return false if no process listens on the path or the handover broke off; the sockets
+ *         received until then are returned either way.
+ */
+bool receive_handover(const std::string& path, std::vector<HandedStream>* streams,
+                      std::map<std::string, int>* sockets) {
+    struct sockaddr_un address;
+    if (!unix_address(path, &address)) {
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Error: Could not create the handover socket" << std::endl;
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return false;  // nothing runs there, start from scratch
+    }
+
+    std::vector<char> buffer(handover_max_message);
+    bool done = false;
+    while (!done) {
+        struct pollfd ready = {fd, POLLIN, 0};
+        if (poll(&ready, 1, handover_timeout_ms) <= 0) {
+            std::cerr << "Error: The running process did not hand over its streams in time" << std::endl;
+            break;
+        }
+        struct iovec iov = {buffer.data(), buffer.size()};
+        union {
+            struct cmsghdr align;
+            char data[CMSG_SPACE(sizeof(int))];
+        } control;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data;
+        msg.msg_controllen = sizeof(control.data);
+        ssize_t size = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        int received = -1;
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); size >= 0 && cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                memcpy(&received, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+
+        HandoverHeader header;
+        const char* body = buffer.data() + sizeof(header);
+        if (size > 0 && static_cast<size_t>(size) >= sizeof(header)) {
+            memcpy(&header, buffer.data(), sizeof(header));
+        }
+        if (size <= 0 || static_cast<size_t>(size) < sizeof(header) || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) ||
+            memcmp(header.magic, handover_magic, sizeof(header.magic)) != 0 ||
+            static_cast<size_t>(size) != sizeof(header) + header.key_size + header.pending_size) {
+            std::cerr << "Error: The handover broke off" << std::endl;
+            if (received >= 0) {
+                close(received);
+            }
+            break;
+        }
+        std::string key(body, header.key_size);
+        if (header.kind == HandoverKind::kStream && received >= 0) {
+            HandedStream stream;
+            stream.key = key;
+            stream.fd = received;
+            stream.checkpoint = header.checkpoint;
+            stream.pending.assign(body + header.key_size, header.pending_size);
+            stream.bytes_received = header.bytes_received;
+            streams->push_back(std::move(stream));
+        } else if (header.kind == HandoverKind::kSocket && received >= 0 && sockets->count(key) == 0) {
+            (*sockets)[key] = received;
+        } else {
+            if (received >= 0) {
+                close(received);
+            }
+            done = header.kind == HandoverKind::kEnd;
+        }
+    }
+    close(fd);
+    return done;
+}
@@ -0,0 +1,125 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "stream_checkpoint.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+constexpr int handover_timeout_ms = 10000;  // for the running process to stop and send its sockets
+
+/**
+ * @brief A live caster connection handed from a running process to its successor.
+ */
+struct HandedStream {
+    std::string key;  // stream_key() of the stream
+    int fd = -1;  // the connected socket, -1 once it has been taken over or closed
+    StreamCheckpoint checkpoint;  // learned state, as kept in a checkpoint file
+    std::string pending;  // received bytes the framer had not delivered as frames yet
+    uint64_t bytes_received = 0;
+};
+
+/**
+ * @brief The running side of a binary upgrade: a Unix socket a new process connects to.
+ *
+ * A new process started with the same path connects and the running one stops its event
+ * loops, then sends every streaming connection as one SOCK_SEQPACKET message with the
+ * socket attached (SCM_RIGHTS), its other sockets, such as listeners, the same way and an
+ * end message.
+ * Data arriving in between waits in the kernel socket buffers, so the successor carries on
+ * without a handshake and without losing a byte.
+ */
+class HandoverServer {
+public:
+
+    HandoverServer() = default;
+    HandoverServer(const HandoverServer&) = delete;
+    HandoverServer& operator=(const HandoverServer&) = delete;
+
+    /**
+     * @brief Destructor for HandoverServer, closing the sockets.
+     */
+    ~HandoverServer();
+
+    /**
+     * @brief Listens on a path, replacing whatever socket file a predecessor left there.
+     *
+     * @return false if the socket cannot be bound.
+     */
+    bool Listen(const std::string& path);
+
+    /**
+     * @brief Waits for a successor to connect.
+     *
+     * @return true once one has connected; the caller then stops streaming and sends.
+     */
+    bool Accept(int timeout_ms);
+
+    /**
+     * @brief Sends a stream and its socket to the successor; the caller closes its copy of the socket.
+     */
+    bool SendStream(const HandedStream& stream);
+
+    /**
+     * @brief Sends another socket under a name, such as a listener; the caller closes its copy.
+     */
+    bool SendSocket(const std::string& name, int fd);
+
+    /**
+     * @brief Tells the successor that everything has been sent.
+     */
+    bool Finish();
+
+    /**
+     * @brief Closes the sockets, removing the path unless a successor took it over.
+     */
+    void Close();
+
+private:
+
+    /**
+     * @brief Sends one message with an optional socket attached.
+     */
+    bool Send(const void* header, size_t header_size, const std::string& body, int fd);
+
+    std::string path_;
+    int listen_fd_ = -1;
+    int peer_fd_ = -1;  // the connected successor
+};
+
+/**
+ * @brief The new side of a binary upgrade: takes over the sockets of the process listening on a path.
+ *
+ * @param streams Receives the handed streams.
+ * @param sockets Receives the other handed sockets, such as listeners, by name.
+ * @return false if no process listens on the path or the handover broke off; the sockets
+ *         received until then are returned either way.
+ */
+bool receive_handover(const std::string& path, std::vector<HandedStream>* streams,
+                      std::map<std::string, int>* sockets);
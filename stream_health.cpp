@@ -0,0 +1,160 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_health.h"
+
+#include <stdio.h>
+
+constexpr int num_states = 5;
+
+/**
+ * @brief Returns the lower case name of a connection state, as used in the health report.
+ */
+const char* state_name(NtripClient::State state) {
+    switch (state) {
+        case NtripClient::State::kIdle: return "idle";
+        case NtripClient::State::kConnecting: return "connecting";
+        case NtripClient::State::kHandshake: return "handshake";
+        case NtripClient::State::kStreaming: return "streaming";
+        case NtripClient::State::kBackoff: return "backoff";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Appends a JSON string literal.
+ */
+static void append_json_string(std::string* out, const char* value) {
+    *out += '"';
+    for (const char* p = value; *p != '\0'; p++) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            *out += '\\';
+            *out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            *out += escaped;
+        } else {
+            *out += static_cast<char>(c);
+        }
+    }
+    *out += '"';
+}
+
+/**
+ * @brief Appends an age in seconds, or null for a time that never happened.
+ */
+static void append_age(std::string* out, int64_t now, int64_t time) {
+    if (time < 0) {
+        *out += "null";
+        return;
+    }
+    char number[32];
+    snprintf(number, sizeof(number), "%.3f", (now - time) / 1e6);
+    *out += number;
+}
+
+/**
+ * @brief Formats the health of every stream as JSON.
+ *
+ * @param samples The stream statuses.
+ * @param now The current clock time in microseconds, for the ages in the report.
+ * @param state_filter Only list streams in this state ("" for all, "none" for the summary only).
+ * @return The JSON document.
+ */
+std::string format_health_json(const std::vector<StreamStatusSample>& samples, int64_t now,
+                               const std::string& state_filter) {
+    size_t counts[num_states] = {};
+    size_t formats[num_stream_formats] = {};
+    for (const StreamStatusSample& sample : samples) {
+        counts[static_cast<int>(sample.status.state)]++;
+        formats[static_cast<int>(sample.status.format)]++;
+    }
+
+    std::string out;
+    char field[256];
+    snprintf(field, sizeof(field), "{\"healthy\":%s,\"streams\":%zu,\"states\":{",
+             counts[static_cast<int>(NtripClient::State::kStreaming)] == samples.size() ? "true" : "false",
+             samples.size());
+    out += field;
+    for (int s = 0; s < num_states; s++) {
+        snprintf(field, sizeof(field), "%s\"%s\":%zu", s > 0 ? "," : "", state_name(static_cast<NtripClient::State>(s)),
+                 counts[s]);
+        out += field;
+    }
+    out += "},\"formats\":{";
+    for (int f = 0; f < num_stream_formats; f++) {
+        snprintf(field, sizeof(field), "%s\"%s\":%zu", f > 0 ? "," : "", stream_format_name(static_cast<StreamFormat>(f)),
+                 formats[f]);
+        out += field;
+    }
+    out += "}";
+
+    if (state_filter != "none") {
+        out += ",\"stream_list\":[";
+        bool first = true;
+        for (const StreamStatusSample& sample : samples) {
+            const NtripClient::Status& status = sample.status;
+            if (!state_filter.empty() && state_filter != state_name(status.state)) {
+                continue;
+            }
+            out += first ? "\n{" : ",\n{";
+            first = false;
+            snprintf(field, sizeof(field), "\"id\":%d,\"host\":", sample.id);
+            out += field;
+            append_json_string(&out, sample.host.c_str());
+            out += ",\"mountpoint\":";
+            append_json_string(&out, sample.mountpoint.c_str());
+            snprintf(field, sizeof(field),
+                     ",\"state\":\"%s\",\"format\":\"%s\",\"failures\":%d,\"reconnects\":%llu,\"bytes_received\":%llu,"
+                     "\"frames\":%llu,\"crc_errors\":%llu,\"gga_sent\":%llu,\"deadline_in_s\":%.3f",
+                     state_name(status.state), stream_format_name(status.format), status.failures,
+                     static_cast<unsigned long long>(status.reconnects),
+                     static_cast<unsigned long long>(status.bytes_received),
+                     static_cast<unsigned long long>(status.frames),
+                     static_cast<unsigned long long>(status.crc_errors),
+                     static_cast<unsigned long long>(status.gga_sent),
+                     status.state == NtripClient::State::kIdle ? 0.0 : (status.deadline_us - now) / 1e6);
+            out += field;
+            snprintf(field, sizeof(field), ",\"framing_us_max\":%.3f,\"callback_us_max\":%.3f,\"callback_us_mean\":%.3f",
+                     status.framing_ns_max / 1e3, status.delivery_ns_max / 1e3,
+                     status.frames > 0 ? status.delivery_ns_total / 1e3 / status.frames : 0.0);
+            out += field;
+            out += ",\"state_age_s\":";
+            append_age(&out, now, status.state_since_us);
+            out += ",\"last_data_age_s\":";
+            append_age(&out, now, status.last_data_us);
+            out += ",\"snapshot_age_s\":";
+            append_age(&out, now, status.published_us);
+            out += ",\"last_error_age_s\":";
+            append_age(&out, now, status.last_error_us);
+            out += ",\"last_error\":";
+            append_json_string(&out, status.last_error);
+            out += "}";
+        }
+        out += "]";
+    }
+    out += "}\n";
+    return out;
+}
@@ -0,0 +1,57 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "ntrip_client.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief The published status of one stream, copied for a health report.
+ */
+struct StreamStatusSample {
+    int id = 0;
+    std::string host;
+    std::string mountpoint;
+    NtripClient::Status status;
+};
+
+/**
+ * @brief Returns the lower case name of a connection state, as used in the health report.
+ */
+const char* state_name(NtripClient::State state);
+
+/**
+ * @brief Formats the health of every stream as JSON.
+ *
+ * @param samples The stream statuses.
+ * @param now The current clock time in microseconds, for the ages in the report.
+ * @param state_filter Only list streams in this state ("" for all, "none" for the summary only).
+ * @return The JSON document.
+ */
+std::string format_health_json(const std::vector<StreamStatusSample>& samples, int64_t now,
+                               const std::string& state_filter);
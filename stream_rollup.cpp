@@ -0,0 +1,412 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_rollup.h"
+
+#include "seqlock.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+
+constexpr int64_t gps_epoch_unix = 315964800;
+constexpr int64_t leap_seconds = 18;  // GPS - UTC
+constexpr int64_t beidou_offset_ms = 14000;  // GPS - BDT
+constexpr int64_t moscow_offset_ms = 3 * 3600000;  // GLONASS time - UTC
+constexpr int64_t week_ms = 604800000;
+constexpr int64_t day_ms = 86400000;
+
+/**
+ * @brief Returns the index of a tier's first bucket in a record, rollup_num_tiers for the total.
+ */
+static constexpr int tier_offset(int tier) {
+    int offset = 0;
+    for (int t = 0; t < tier; t++) {
+        offset += rollup_tiers[t].buckets;
+    }
+    return offset;
+}
+
+constexpr int rollup_total_buckets = tier_offset(rollup_num_tiers);
+
+static const char rollup_magic[8] = {'N', 'T', 'R', 'I', 'P', 'R', 'U', '1'};
+
+struct RollupFile::Header {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t slots;
+    uint8_t reserved[48];
+};
+
+struct RollupFile::Record {
+    uint32_t sequence;  // odd while the record is being written
+    uint32_t used;
+    char key[rollup_key_size];
+    int64_t last_frame_us;  // Unix time of the latest frame, 0 if none
+    RollupBucket buckets[rollup_total_buckets];  // the rings of the tiers, one after the other
+};
+
+/**
+ * @brief Returns the correction age of an MSM epoch: how long before a Unix time it was observed.
+ *
+ * @param epoch_ms Time of week of the constellation in ms, for GLONASS the time of day (Moscow).
+ * @param unix_ms The arrival time in Unix milliseconds.
+ */
+int64_t correction_age_ms(GnssSystem system, uint32_t epoch_ms, int64_t unix_ms) {
+    int64_t now_ms;
+    int64_t period;
+    if (system == GnssSystem::kGlonass) {
+        now_ms = unix_ms + moscow_offset_ms;
+        period = day_ms;
+    } else {
+        now_ms = unix_ms - gps_epoch_unix * 1000 + leap_seconds * 1000;
+        if (system == GnssSystem::kBeidou) {
+            now_ms -= beidou_offset_ms;
+        }
+        period = week_ms;
+    }
+    // the epoch is the one nearest to the arrival, in the same or the neighbouring week or day
+    int64_t age = ((now_ms % period) - static_cast<int64_t>(epoch_ms)) % period;
+    if (age >= period / 2) {
+        age -= period;
+    } else if (age < -period / 2) {
+        age += period;
+    }
+    return age;
+}
+
+/**
+ * @brief Destructor for RollupFile, closing the file.
+ */
+RollupFile::~RollupFile() {
+    Close();
+}
+
+/**
+ * @brief Opens or creates a rollup file with room for at least the given number of streams.
+ *
+ * @return false if the file cannot be created or mapped.
+ */
+bool RollupFile::Open(const std::string& path, size_t slots) {
+    Close();
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return false;
+    }
+    Header header;
+    memset(&header, 0, sizeof(header));
+    struct stat info;
+    bool valid = fstat(fd_, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(header) &&
+                 pread(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                 memcmp(header.magic, rollup_magic, sizeof(rollup_magic)) == 0 &&
+                 header.record_size == sizeof(Record) &&
+                 static_cast<size_t>(info.st_size) >= sizeof(Header) + header.slots * sizeof(Record);
+    if (!valid) {
+        if (info.st_size > 0) {
+            std::cerr << "Warning: " << path << " is not a rollup file of this version, starting over" << std::endl;
+        }
+        header.slots = 0;
+    }
+    slots_ = std::max<size_t>(slots, header.slots);
+    size_ = sizeof(Header) + slots_ * sizeof(Record);
+    if ((!valid && ftruncate(fd_, 0) < 0) || ftruncate(fd_, static_cast<off_t>(size_)) < 0) {
+        std::cerr << "Error: Could not size " << path << std::endl;
+        Close();
+        return false;
+    }
+    void* map = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "Error: Could not map " << path << std::endl;
+        Close();
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+    Header* mapped = reinterpret_cast<Header*>(map_);
+    memcpy(mapped->magic, rollup_magic, sizeof(rollup_magic));
+    mapped->record_size = sizeof(Record);
+    mapped->slots = static_cast<uint32_t>(slots_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    next_free_ = 0;
+    for (size_t slot = 0; slot < slots_; slot++) {
+        Record* record = At(static_cast<int>(slot));
+        if (record->used) {
+            // a record torn by a crash keeps its buckets, at most one frame is half counted
+            record->sequence += record->sequence & 1;
+            index_.emplace(std::string(record->key, strnlen(record->key, rollup_key_size)),
+                           static_cast<int>(slot));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns a record of the mapping.
+ */
+RollupFile::Record* RollupFile::At(int slot) const {
+    return reinterpret_cast<Record*>(map_ + sizeof(Header) + static_cast<size_t>(slot) * sizeof(Record));
+}
+
+/**
+ * @brief Returns the record of a key, claiming a free one for a new key; thread safe.
+ *
+ * @return The record index, -1 if the file is full or not open.
+ */
+int RollupFile::Slot(const std::string& key) {
+    std::string name = key.substr(0, rollup_key_size - 1);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto known = index_.find(name);
+    if (known != index_.end()) {
+        return known->second;
+    }
+    while (next_free_ < slots_ && At(static_cast<int>(next_free_))->used) {
+        next_free_++;
+    }
+    if (next_free_ >= slots_) {
+        return -1;
+    }
+    int slot = static_cast<int>(next_free_++);
+    Record* record = At(slot);
+    memset(static_cast<void*>(record), 0, sizeof(Record));
+    memcpy(record->key, name.data(), name.size());
+    __atomic_store_n(&record->used, 1, __ATOMIC_RELEASE);
+    index_.emplace(name, slot);
+    return slot;
+}
+
+/**
+ * @brief Adds a frame to the current buckets. Only one thread may record into a given record.
+ *
+ * Only RTCM3 MSM frames carry a correction age; frames of other formats are counted without one.
+ *
+ * @param unix_us The arrival time in Unix microseconds.
+ */
+void RollupFile::Add(int slot, int64_t unix_us, const uint8_t* frame, size_t size) {
+    if (slot < 0 || static_cast<size_t>(slot) >= slots_) {
+        return;
+    }
+    GnssSystem system;
+    uint32_t epoch_ms;
+    // the message type field of other formats can look like an MSM type
+    bool has_age = size > 0 && frame[0] == rtcm3_preamble && rtcm3_msm_epoch(frame, size, &system, &epoch_ms);
+    int64_t age = has_age ? correction_age_ms(system, epoch_ms, unix_us / 1000) : 0;
+    int32_t age32 = static_cast<int32_t>(std::max<int64_t>(INT32_MIN, std::min<int64_t>(INT32_MAX, age)));
+    uint32_t now_s = static_cast<uint32_t>(unix_us / 1000000);
+
+    Record* record = At(slot);
+    uint32_t sequence = record->sequence | 1;
+    __atomic_store_n(&record->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    bool gap = record->last_frame_us > 0 && unix_us - record->last_frame_us > rollup_gap_us;
+    record->last_frame_us = unix_us;
+    RollupBucket* ring = record->buckets;
+    for (const RollupTier& tier : rollup_tiers) {
+        uint32_t start = now_s - now_s % tier.width_s;
+        RollupBucket* slot_bucket = &ring[(now_s / tier.width_s) % tier.buckets];
+        RollupBucket bucket = *slot_bucket;  // the only writer, so a plain read is safe
+        if (bucket.start != start) {
+            bucket = RollupBucket();
+            bucket.start = start;
+        }
+        bucket.frames++;
+        bucket.bytes += static_cast<uint32_t>(size);
+        bucket.gaps += gap ? 1 : 0;
+        if (has_age) {
+            bucket.age_min_ms = bucket.ages == 0 ? age32 : std::min(bucket.age_min_ms, age32);
+            bucket.age_max_ms = bucket.ages == 0 ? age32 : std::max(bucket.age_max_ms, age32);
+            bucket.age_sum_ms += age32;
+            bucket.ages++;
+        }
+        seqlock_store(slot_bucket, bucket);
+        ring += tier.buckets;
+    }
+    __atomic_store_n(&record->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Copies the buckets of one tier that cover a time range, oldest first.
+ *
+ * @param end_s Unix seconds; the last bucket is the one holding end_s - 1.
+ * @param count The number of buckets, at most the size of the ring.
+ * @param buckets Receives count buckets; those nothing arrived in have start 0.
+ * @return false if the slot or tier does not exist.
+ */
+bool RollupFile::Read(int slot, int tier, int64_t end_s, int count, std::vector<RollupBucket>* buckets) const {
+    if (slot < 0 || static_cast<size_t>(slot) >= slots_ || tier < 0 || tier >= rollup_num_tiers) {
+        return false;
+    }
+    const RollupTier& info = rollup_tiers[tier];
+    count = std::max(0, std::min(count, info.buckets));
+    const Record* record = At(slot);
+    const RollupBucket* ring = record->buckets + tier_offset(tier);
+    int64_t last = (end_s - 1) - (end_s - 1) % info.width_s;
+    buckets->resize(count);
+    uint32_t before, after;
+    do {
+        before = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+        for (int k = 0; k < count; k++) {
+            int64_t start = last - static_cast<int64_t>(count - 1 - k) * info.width_s;
+            RollupBucket bucket = seqlock_load(&ring[(start / info.width_s) % info.buckets]);
+            (*buckets)[k] = bucket.start == start ? bucket : RollupBucket();
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&record->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1) != 0 || before != after);
+    return true;
+}
+
+/**
+ * @brief Returns the keys of the streams, by record index.
+ */
+std::vector<std::pair<std::string, int>> RollupFile::Keys() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<std::string, int>> keys(index_.begin(), index_.end());
+    std::sort(keys.begin(), keys.end(), [](const std::pair<std::string, int>& a, const std::pair<std::string, int>& b) {
+        return a.second < b.second;
+    });
+    return keys;
+}
+
+/**
+ * @brief Writes the records to disk and unmaps the file.
+ */
+void RollupFile::Close() {
+    if (map_ != nullptr) {
+        msync(map_, size_, MS_SYNC);
+        munmap(map_, size_);
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    slots_ = 0;
+}
+
+/**
+ * @brief Formats a Unix time as an ISO 8601 UTC time.
+ */
+static std::string format_utc(int64_t unix_s) {
+    time_t seconds = static_cast<time_t>(unix_s);
+    tm utc;
+    gmtime_r(&seconds, &utc);
+    char text[32];
+    strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return text;
+}
+
+/**
+ * @brief Formats buckets of one tier as a text table, one line per bucket.
+ */
+std::string format_rollup_series(const std::string& key, int tier, int64_t end_s,
+                                 const std::vector<RollupBucket>& buckets) {
+    const RollupTier& info = rollup_tiers[tier];
+    std::string out = key + ", " + info.name + " buckets\n";
+    out += "time                    frames     bytes/s   gaps  age_mean_ms  age_min_ms  age_max_ms\n";
+    int64_t last = (end_s - 1) - (end_s - 1) % info.width_s;
+    char line[160];
+    for (size_t k = 0; k < buckets.size(); k++) {
+        const RollupBucket& bucket = buckets[k];
+        int64_t start = last - static_cast<int64_t>(buckets.size() - 1 - k) * info.width_s;
+        int written = snprintf(line, sizeof(line), "%-20s %9u %11.1f %6u", format_utc(start).c_str(), bucket.frames,
+                               static_cast<double>(bucket.bytes) / info.width_s, bucket.gaps);
+        if (bucket.ages > 0) {
+            snprintf(line + written, sizeof(line) - written, " %12.1f %11d %11d\n",
+                     static_cast<double>(bucket.age_sum_ms) / bucket.ages, bucket.age_min_ms, bucket.age_max_ms);
+        } else {
+            snprintf(line + written, sizeof(line) - written, " %12s %11s %11s\n", "-", "-", "-");
+        }
+        out += line;
+    }
+    return out;
+}
+
+/**
+ * @brief Formats the latest complete bucket of one tier of every stream, highest mean correction age first.
+ *
+ * @param limit The number of streams to list, 0 for all.
+ */
+std::string format_rollup_summary(const RollupFile& rollups, int tier, int64_t now_s, size_t limit) {
+    const RollupTier& info = rollup_tiers[tier];
+    int64_t end_s = now_s - now_s % info.width_s;
+    struct Row {
+        std::string key;
+        RollupBucket bucket;
+    };
+    std::vector<Row> rows;
+    std::vector<RollupBucket> buckets;
+    for (const auto& key : rollups.Keys()) {
+        if (rollups.Read(key.second, tier, end_s, 1, &buckets)) {
+            rows.push_back(Row{key.first, buckets[0]});
+        }
+    }
+    // streams without correction ages sort last, then by the mean age
+    auto mean = [](const RollupBucket& bucket) {
+        return bucket.ages > 0 ? static_cast<double>(bucket.age_sum_ms) / bucket.ages : -1e300;
+    };
+    std::stable_sort(rows.begin(), rows.end(), [&mean](const Row& a, const Row& b) {
+        return mean(a.bucket) > mean(b.bucket);
+    });
+    if (limit > 0 && rows.size() > limit) {
+        rows.resize(limit);
+    }
+    std::string out = std::string(info.name) + " bucket starting " + format_utc(end_s - info.width_s) + "\n";
+    out += "stream                                      frames     bytes/s   gaps  age_mean_ms  age_max_ms\n";
+    char line[256];
+    for (const Row& row : rows) {
+        const RollupBucket& bucket = row.bucket;
+        int written = snprintf(line, sizeof(line), "%-40s %9u %11.1f %6u", row.key.c_str(), bucket.frames,
+                               static_cast<double>(bucket.bytes) / info.width_s, bucket.gaps);
+        if (bucket.ages > 0) {
+            snprintf(line + written, sizeof(line) - written, " %12.1f %11d\n", mean(bucket), bucket.age_max_ms);
+        } else {
+            snprintf(line + written, sizeof(line) - written, " %12s %11s\n", "-", "-");
+        }
+        out += line;
+    }
+    return out;
+}
+
+/**
+ * @brief Parses a tier name: 1s, 1m or 1h.
+ *
+ * @return -1 if the name is unknown.
+ */
+int parse_rollup_tier(const std::string& name) {
+    for (int tier = 0; tier < rollup_num_tiers; tier++) {
+        if (name == rollup_tiers[tier].name) {
+            return tier;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,179 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "rtcm3.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr int64_t rollup_gap_us = 3000000;  // a pause between frames longer than this is a gap
+constexpr size_t rollup_key_size = 128;
+
+/**
+ * @brief One resolution of the rollups: buckets of width_s seconds, the latest count of them.
+ */
+struct RollupTier {
+    const char* name;
+    int width_s;
+    int buckets;
+};
+
+constexpr int rollup_num_tiers = 3;
+constexpr RollupTier rollup_tiers[rollup_num_tiers] = {{"1s", 1, 600}, {"1m", 60, 1440}, {"1h", 3600, 720}};
+
+/**
+ * @brief The frames of one stream within one bucket of time.
+ */
+struct RollupBucket {
+    uint32_t start = 0;  // Unix seconds of the bucket start, 0 if nothing arrived in it
+    uint32_t frames = 0;
+    uint32_t bytes = 0;
+    uint32_t gaps = 0;  // pauses longer than rollup_gap_us that ended in the bucket
+    uint32_t ages = 0;  // MSM frames, which carry the correction age
+    int32_t age_min_ms = 0;
+    int32_t age_max_ms = 0;
+    uint32_t reserved = 0;
+    int64_t age_sum_ms = 0;
+};
+
+/**
+ * @brief Returns the correction age of an MSM epoch: how long before a Unix time it was observed.
+ *
+ * @param epoch_ms Time of week of the constellation in ms, for GLONASS the time of day (Moscow).
+ * @param unix_ms The arrival time in Unix milliseconds.
+ */
+int64_t correction_age_ms(GnssSystem system, uint32_t epoch_ms, int64_t unix_ms);
+
+/**
+ * @brief Memory mapped file of per stream rings of 1 s, 1 min and 1 h rollups, one record per stream key.
+ *
+ * Each frame adds to the current bucket of every tier in place, so the rollups cost a fixed
+ * amount of memory per stream however long the hub runs, and they survive restarts; a bucket
+ * older than its ring is overwritten when its slot comes round again. A record is written with
+ * a sequence number that is odd while it changes, so readers on other threads retry rather than
+ * see a half updated bucket. Different threads may record into different records.
+ */
+class RollupFile {
+public:
+
+    RollupFile() = default;
+    RollupFile(const RollupFile&) = delete;
+    RollupFile& operator=(const RollupFile&) = delete;
+
+    /**
+     * @brief Destructor for RollupFile, closing the file.
+     */
+    ~RollupFile();
+
+    /**
+     * @brief Opens or creates a rollup file with room for at least the given number of streams.
+     *
+     * A file with another layout is started over.
+     *
+     * @return false if the file cannot be created or mapped.
+     */
+    bool Open(const std::string& path, size_t slots);
+
+    /**
+     * @brief Returns the record of a key, claiming a free one for a new key; thread safe.
+     *
+     * @return The record index, -1 if the file is full or not open.
+     */
+    int Slot(const std::string& key);
+
+    /**
+     * @brief Adds a frame to the current buckets. Only one thread may record into a given record.
+     *
+     * Only RTCM3 MSM frames carry a correction age; frames of other formats are counted without one.
+     *
+     * @param unix_us The arrival time in Unix microseconds.
+     */
+    void Add(int slot, int64_t unix_us, const uint8_t* frame, size_t size);
+
+    /**
+     * @brief Copies the buckets of one tier that cover a time range, oldest first.
+     *
+     * @param end_s Unix seconds; the last bucket is the one holding end_s - 1.
+     * @param count The number of buckets, at most the size of the ring.
+     * @param buckets Receives count buckets; those nothing arrived in have start 0.
+     * @return false if the slot or tier does not exist.
+     */
+    bool Read(int slot, int tier, int64_t end_s, int count, std::vector<RollupBucket>* buckets) const;
+
+    /**
+     * @brief Returns the keys of the streams, by record index.
+     */
+    std::vector<std::pair<std::string, int>> Keys() const;
+
+    /**
+     * @brief Writes the records to disk and unmaps the file.
+     */
+    void Close();
+
+    size_t slots() const { return slots_; }
+
+private:
+    struct Header;
+    struct Record;
+
+    /**
+     * @brief Returns a record of the mapping.
+     */
+    Record* At(int slot) const;
+
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t size_ = 0;
+    size_t slots_ = 0;
+    mutable std::mutex mutex_;  // guards index_ and claiming records
+    std::unordered_map<std::string, int> index_;
+    size_t next_free_ = 0;
+};
+
+/**
+ * @brief Formats buckets of one tier as a text table, one line per bucket.
+ */
+std::string format_rollup_series(const std::string& key, int tier, int64_t end_s,
+                                 const std::vector<RollupBucket>& buckets);
+
+/**
+ * @brief Formats the latest complete bucket of one tier of every stream, highest mean correction age first.
+ *
+ * @param limit The number of streams to list, 0 for all.
+ */
+std::string format_rollup_summary(const RollupFile& rollups, int tier, int64_t now_s, size_t limit);
+
+/**
+ * @brief Parses a tier name: 1s, 1m or 1h.
+ *
+ * @return -1 if the name is unknown.
+ */
+int parse_rollup_tier(const std::string& name);
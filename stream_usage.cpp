@@ -0,0 +1,226 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_usage.h"
+
+#include "tsc_clock.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+/**
+ * @brief Returns the value a sample is ranked by.
+ */
+static uint64_t usage_value(const StreamUsageSample& sample, UsageKey key) {
+    switch (key) {
+        case UsageKey::kCpu: return sample.cycles;
+        case UsageKey::kAllocations: return sample.allocations;
+        case UsageKey::kMemory: return sample.memory_bytes;
+        case UsageKey::kBuffered: return sample.buffered_bytes;
+        case UsageKey::kBytes: return sample.bytes_received;
+    }
+    return 0;
+}
+
+/**
+ * @brief Parses a usage key name: cpu, allocs, memory, buffered or bytes.
+ *
+ * @return true if the name is known.
+ */
+bool parse_usage_key(const std::string& name, UsageKey* key) {
+    if (name == "cpu") {
+        *key = UsageKey::kCpu;
+    } else if (name == "allocs") {
+        *key = UsageKey::kAllocations;
+    } else if (name == "memory") {
+        *key = UsageKey::kMemory;
+    } else if (name == "buffered") {
+        *key = UsageKey::kBuffered;
+    } else if (name == "bytes") {
+        *key = UsageKey::kBytes;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reorders the samples so the n largest by key come first, largest first, and drops the rest.
+ */
+void top_streams(std::vector<StreamUsageSample>* samples, size_t n, UsageKey key) {
+    n = std::min(n, samples->size());
+    // partial sort keeps a report over thousands of streams at O(streams log n)
+    std::partial_sort(samples->begin(), samples->begin() + n, samples->end(),
+                      [key](const StreamUsageSample& a, const StreamUsageSample& b) {
+                          uint64_t va = usage_value(a, key);
+                          uint64_t vb = usage_value(b, key);
+                          return va != vb ? va > vb : a.id < b.id;
+                      });
+    samples->resize(n);
+}
+
+/**
+ * @brief Sums every stream into one sample.
+ */
+static StreamUsageSample usage_total(const std::vector<StreamUsageSample>& samples) {
+    StreamUsageSample total;
+    for (const StreamUsageSample& sample : samples) {
+        total.cycles += sample.cycles;
+        total.dispatches += sample.dispatches;
+        total.allocations += sample.allocations;
+        total.allocated_bytes += sample.allocated_bytes;
+        total.bytes_received += sample.bytes_received;
+        total.buffered_bytes += sample.buffered_bytes;
+        total.memory_bytes += sample.memory_bytes;
+        total.receive_buffer_bytes += sample.receive_buffer_bytes;
+        total.default_receive_buffer_bytes += sample.default_receive_buffer_bytes;
+    }
+    return total;
+}
+
+/**
+ * @brief Formats totals and a table of the n most expensive streams by key.
+ */
+std::string format_usage_table(const std::vector<StreamUsageSample>& samples, size_t n, UsageKey key) {
+    double seconds_per_cycle = 1.0 / cycles_per_second();
+    StreamUsageSample total = usage_total(samples);
+    std::vector<StreamUsageSample> top = samples;
+    top_streams(&top, n, key);
+
+    std::string out;
+    char line[256];
+    snprintf(line, sizeof(line),
+             "streams %zu, cpu %.3f s, dispatches %llu, allocations %llu (%llu KiB), memory %llu KiB, buffered %llu B\n",
+             samples.size(), total.cycles * seconds_per_cycle, static_cast<unsigned long long>(total.dispatches),
+             static_cast<unsigned long long>(total.allocations),
+             static_cast<unsigned long long>(total.allocated_bytes / 1024),
+             static_cast<unsigned long long>(total.memory_bytes / 1024),
+             static_cast<unsigned long long>(total.buffered_bytes));
+    out += line;
+    if (total.default_receive_buffer_bytes > 0) {
+        snprintf(line, sizeof(line), "socket receive buffers %llu KiB, %llu KiB at the kernel default\n",
+                 static_cast<unsigned long long>(total.receive_buffer_bytes / 1024),
+                 static_cast<unsigned long long>(total.default_receive_buffer_bytes / 1024));
+        out += line;
+    }
+    snprintf(line, sizeof(line), "%4s %-24s %10s %6s %10s %9s %9s %8s %8s %8s %12s\n", "rank", "mountpoint", "cpu_ms",
+             "cpu%", "dispatches", "ns/disp", "allocs", "mem_KiB", "rcv_KiB", "buffered", "bytes");
+    out += line;
+    for (size_t i = 0; i < top.size(); i++) {
+        const StreamUsageSample& s = top[i];
+        double cpu = s.cycles * seconds_per_cycle;
+        snprintf(line, sizeof(line), "%4zu %-24s %10.3f %6.2f %10llu %9.0f %9llu %8.1f %8.1f %8llu %12llu\n", i + 1,
+                 s.mountpoint.c_str(), cpu * 1e3, total.cycles > 0 ? 100.0 * s.cycles / total.cycles : 0.0,
+                 static_cast<unsigned long long>(s.dispatches), s.dispatches > 0 ? cpu * 1e9 / s.dispatches : 0.0,
+                 static_cast<unsigned long long>(s.allocations), s.memory_bytes / 1024.0, s.receive_buffer_bytes / 1024.0,
+                 static_cast<unsigned long long>(s.buffered_bytes), static_cast<unsigned long long>(s.bytes_received));
+        out += line;
+    }
+    return out;
+}
+
+/**
+ * @brief Escapes a Prometheus label value.
+ */
+static std::string label_escape(const std::string& value) {
+    std::string out;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Formats totals and the n most expensive streams by CPU in the Prometheus text format.
+ */
+std::string format_usage_metrics(const std::vector<StreamUsageSample>& samples, size_t n) {
+    double seconds_per_cycle = 1.0 / cycles_per_second();
+    StreamUsageSample total = usage_total(samples);
+    std::vector<StreamUsageSample> top = samples;
+    top_streams(&top, n, UsageKey::kCpu);
+
+    std::string out;
+    char line[1024];
+    snprintf(line, sizeof(line),
+             "# TYPE ntrip_streams gauge\nntrip_streams %zu\n"
+             "# TYPE ntrip_cpu_seconds_total counter\nntrip_cpu_seconds_total %.6f\n"
+             "# TYPE ntrip_dispatches_total counter\nntrip_dispatches_total %llu\n"
+             "# TYPE ntrip_allocations_total counter\nntrip_allocations_total %llu\n"
+             "# TYPE ntrip_allocated_bytes_total counter\nntrip_allocated_bytes_total %llu\n"
+             "# TYPE ntrip_received_bytes_total counter\nntrip_received_bytes_total %llu\n"
+             "# TYPE ntrip_buffered_bytes gauge\nntrip_buffered_bytes %llu\n"
+             "# TYPE ntrip_memory_bytes gauge\nntrip_memory_bytes %llu\n"
+             "# TYPE ntrip_receive_buffer_bytes gauge\nntrip_receive_buffer_bytes %llu\n"
+             "# TYPE ntrip_default_receive_buffer_bytes gauge\nntrip_default_receive_buffer_bytes %llu\n",
+             samples.size(), total.cycles * seconds_per_cycle, static_cast<unsigned long long>(total.dispatches),
+             static_cast<unsigned long long>(total.allocations),
+             static_cast<unsigned long long>(total.allocated_bytes),
+             static_cast<unsigned long long>(total.bytes_received),
+             static_cast<unsigned long long>(total.buffered_bytes),
+             static_cast<unsigned long long>(total.memory_bytes),
+             static_cast<unsigned long long>(total.receive_buffer_bytes),
+             static_cast<unsigned long long>(total.default_receive_buffer_bytes));
+    out += line;
+
+    // per stream series only for the top n, so the label cardinality stays bounded
+    std::vector<std::string> labels;
+    for (const StreamUsageSample& s : top) {
+        labels.push_back("{host=\"" + label_escape(s.host) + "\",mountpoint=\"" + label_escape(s.mountpoint) + "\"}");
+    }
+    struct Family {
+        const char* name;
+        const char* type;
+        uint64_t StreamUsageSample::*field;
+    };
+    static const Family families[] = {
+        {"ntrip_stream_dispatches_total", "counter", &StreamUsageSample::dispatches},
+        {"ntrip_stream_allocations_total", "counter", &StreamUsageSample::allocations},
+        {"ntrip_stream_received_bytes_total", "counter", &StreamUsageSample::bytes_received},
+        {"ntrip_stream_buffered_bytes", "gauge", &StreamUsageSample::buffered_bytes},
+        {"ntrip_stream_memory_bytes", "gauge", &StreamUsageSample::memory_bytes},
+        {"ntrip_stream_receive_buffer_bytes", "gauge", &StreamUsageSample::receive_buffer_bytes},
+    };
+    out += "# TYPE ntrip_stream_cpu_seconds_total counter\n";
+    for (size_t i = 0; i < top.size(); i++) {
+        snprintf(line, sizeof(line), "ntrip_stream_cpu_seconds_total%s %.6f\n", labels[i].c_str(),
+                 top[i].cycles * seconds_per_cycle);
+        out += line;
+    }
+    for (const Family& family : families) {
+        out += std::string("# TYPE ") + family.name + " " + family.type + "\n";
+        for (size_t i = 0; i < top.size(); i++) {
+            snprintf(line, sizeof(line), "%s%s %llu\n", family.name, labels[i].c_str(),
+                     static_cast<unsigned long long>(top[i].*family.field));
+            out += line;
+        }
+    }
+    return out;
+}
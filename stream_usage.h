@@ -0,0 +1,94 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Resource accounting for one stream.
+ *
+ * Written only by the loop thread with relaxed stores, so it costs a few plain loads and stores
+ * per dispatch and can be read from a metrics thread without locking the loop.
+ */
+struct StreamUsage {
+    std::atomic<uint64_t> cycles{0};  // read_cycles() ticks spent inside the stream's Step()
+    std::atomic<uint64_t> dispatches{0};
+    std::atomic<uint64_t> allocations{0};  // heap allocations made during its dispatches
+    std::atomic<uint64_t> allocated_bytes{0};
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> buffered_bytes{0};  // gauges sampled after each dispatch
+    std::atomic<uint64_t> memory_bytes{0};
+    std::atomic<uint64_t> receive_buffer_bytes{0};  // kernel receive buffer of the connection
+    std::atomic<uint64_t> default_receive_buffer_bytes{0};  // what it would be at the kernel default
+};
+
+/**
+ * @brief A copy of one stream's StreamUsage, taken for a report.
+ */
+struct StreamUsageSample {
+    int id = 0;
+    std::string host;
+    std::string mountpoint;
+    uint64_t cycles = 0;
+    uint64_t dispatches = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    uint64_t bytes_received = 0;
+    uint64_t buffered_bytes = 0;
+    uint64_t memory_bytes = 0;
+    uint64_t receive_buffer_bytes = 0;
+    uint64_t default_receive_buffer_bytes = 0;
+};
+
+/**
+ * @brief What a usage report ranks streams by.
+ */
+enum class UsageKey { kCpu, kAllocations, kMemory, kBuffered, kBytes };
+
+/**
+ * @brief Parses a usage key name: cpu, allocs, memory, buffered or bytes.
+ *
+ * @return true if the name is known.
+ */
+bool parse_usage_key(const std::string& name, UsageKey* key);
+
+/**
+ * @brief Reorders the samples so the n largest by key come first, largest first, and drops the rest.
+ */
+void top_streams(std::vector<StreamUsageSample>* samples, size_t n, UsageKey key);
+
+/**
+ * @brief Formats totals and a table of the n most expensive streams by key.
+ */
+std::string format_usage_table(const std::vector<StreamUsageSample>& samples, size_t n, UsageKey key);
+
+/**
+ * @brief Formats totals and the n most expensive streams by CPU in the Prometheus text format.
+ */
+std::string format_usage_metrics(const std::vector<StreamUsageSample>& samples, size_t n);
@@ -0,0 +1,313 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "synthetic_network.h"
+#include "ephemeris.h"
+#include "rtcm3_encoder.h"
+
+#include <math.h>
+#include <string.h>
+
+constexpr int64_t week_ms = 604800000;
+constexpr int64_t day_ms = 86400000;
+constexpr int64_t ephemeris_block_ms = 7200000;  // new ephemerides every 2 hours
+constexpr int64_t leap_ms = 18000;  // GPS - UTC
+constexpr int64_t bds_offset_ms = 14000;  // GPS - BDT
+constexpr int max_signals = 4;
+
+/**
+ * @brief Orbit layout and signal plan of a simulated constellation.
+ */
+struct ConstellationModel {
+    char id;
+    GnssSystem system;
+    int first_prn;
+    int num_sats;
+    int planes;
+    double semi_major_axis;  // m
+    double inclination;  // degrees
+    int ephemeris_type;  // 0 = not broadcast
+    int num_signals;
+    uint8_t signals[max_signals];
+};
+
+static const ConstellationModel models[] = {
+    {'G', GnssSystem::kGps, 1, 32, 6, 26559700.0, 55.0, 1019, 4, {2, 10, 16, 23}},
+    {'R', GnssSystem::kGlonass, 1, 24, 3, 25508200.0, 64.8, 0, 2, {2, 8}},
+    {'E', GnssSystem::kGalileo, 1, 24, 3, 29599800.0, 56.0, 1046, 3, {2, 15, 23}},
+    {'C', GnssSystem::kBeidou, 19, 24, 3, 27906100.0, 55.0, 1042, 3, {2, 8, 14}},
+};
+
+// GLONASS frequency channels of slots 1..24
+static const int8_t glonass_channels[] = {
+    1, -4, 5, 6, 1, -4, 5, 6, -2, -7, 0, -1, -2, -7, 0, -1, 4, -3, 3, 2, 4, -3, 3, 2
+};
+
+/**
+ * @brief Returns the simulation model of a satellite's constellation.
+ */
+static const ConstellationModel& model_of(GnssSystem system) {
+    for (const ConstellationModel& model : models) {
+        if (model.system == system) {
+            return model;
+        }
+    }
+    return models[0];
+}
+
+/**
+ * @brief Constructor for SyntheticNetwork.
+ *
+ * @param options The network settings.
+ */
+SyntheticNetwork::SyntheticNetwork(const SyntheticOptions& options) : options_(options) {
+    if (options_.msm_level != 4) {
+        options_.msm_level = 7;
+    }
+    if (options_.num_stations < 1) {
+        options_.num_stations = 1;
+    }
+    if (options_.station_interval < 1) {
+        options_.station_interval = 1;
+    }
+    if (options_.ephemeris_interval < 1) {
+        options_.ephemeris_interval = 1;
+    }
+
+    // stations spread evenly over the globe on a Fibonacci lattice
+    const double golden = gnss_pi * (3.0 - sqrt(5.0));
+    for (int i = 0; i < options_.num_stations; i++) {
+        double lat = asin(1.0 - 2.0 * (i + 0.5) / options_.num_stations);
+        double lon = fmod(i * golden, 2.0 * gnss_pi) - gnss_pi;
+        Rtcm3Station station;
+        station.station_id = static_cast<uint16_t>(i % 4096);
+        geodetic_to_ecef(lat, lon, 100.0, station.ecef);
+        stations_.push_back(station);
+        station_up_.push_back(cos(lat) * cos(lon));
+        station_up_.push_back(cos(lat) * sin(lon));
+        station_up_.push_back(sin(lat));
+    }
+
+    for (const ConstellationModel& model : models) {
+        if (options_.constellations.find(model.id) == std::string::npos) {
+            continue;
+        }
+        for (int k = 0; k < model.num_sats; k++) {
+            Satellite sat{};
+            sat.system = model.system;
+            sat.prn = static_cast<uint8_t>(model.first_prn + k);
+            sat.glo_channel = model.system == GnssSystem::kGlonass ? glonass_channels[k % 24] : 0;
+            satellites_.push_back(sat);
+        }
+    }
+}
+
+/**
+ * @brief Builds the broadcast ephemerides valid for the given GPS time.
+ */
+void SyntheticNetwork::UpdateEphemerides(int64_t gps_ms) {
+    int64_t block = gps_ms / ephemeris_block_ms;
+    if (block == ephemeris_block_) {
+        return;
+    }
+    ephemeris_block_ = block;
+    int64_t block_ms = block * ephemeris_block_ms;
+    int64_t gps_week = block_ms / week_ms;
+    double toe = static_cast<double>((block_ms % week_ms) / 1000);
+
+    for (Satellite& sat : satellites_) {
+        const ConstellationModel& model = model_of(sat.system);
+        int k = sat.prn - model.first_prn;
+        int per_plane = model.num_sats / model.planes;
+        int plane = k % model.planes;
+        int slot = k / model.planes;
+
+        Rtcm3Ephemeris& eph = sat.eph;
+        eph = Rtcm3Ephemeris();
+        eph.system = sat.system;
+        eph.message_type = model.ephemeris_type;
+        eph.prn = sat.prn;
+        eph.sqrt_a = sqrt(model.semi_major_axis);
+        eph.e = 0.002 + 0.0005 * (k % 5);
+        eph.i0 = model.inclination * gnss_pi / 180.0;
+        eph.omega0 = plane * 2.0 * gnss_pi / model.planes;
+        eph.omega = 0.3 * k;
+        // mean anomaly continues across blocks: M(t) = M_slot + n * t
+        double n = sqrt(3.986005e14 / pow(model.semi_major_axis, 3));
+        double m = slot * 2.0 * gnss_pi / per_plane + plane * gnss_pi / model.num_sats + n * toe;
+        eph.m0 = remainder(m, 2.0 * gnss_pi);
+        eph.toe = toe;
+        eph.toc = toe;
+        eph.af0 = 1e-5 * sin(static_cast<double>(sat.prn));
+        eph.af1 = 1e-12 * cos(static_cast<double>(sat.prn));
+        eph.fit_interval = 4.0;
+        switch (sat.system) {
+            case GnssSystem::kGalileo:
+                eph.week = static_cast<int>(gps_week - 1024);
+                eph.iode = static_cast<int>(block % 1024);
+                eph.accuracy = 107;
+                break;
+            case GnssSystem::kBeidou:
+                eph.week = static_cast<int>(gps_week - 1356);
+                eph.iode = static_cast<int>(block % 32);
+                eph.iodc = eph.iode;
+                break;
+            default:
+                eph.week = static_cast<int>(gps_week);
+                eph.iode = static_cast<int>(block % 256);
+                eph.iodc = eph.iode;
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Advances the constellation to an epoch.
+ *
+ * @param gps_ms Milliseconds since the GPS epoch (1980-01-06).
+ */
+void SyntheticNetwork::SetEpoch(int64_t gps_ms) {
+    if (gps_ms != epoch_ms_) {
+        epoch_count_++;
+    }
+    epoch_ms_ = gps_ms;
+    UpdateEphemerides(gps_ms);
+    for (Satellite& sat : satellites_) {
+        int64_t system_ms = sat.system == GnssSystem::kBeidou ? gps_ms - bds_offset_ms : gps_ms;
+        double t = static_cast<double>(system_ms % week_ms) / 1000.0;
+        double before[3];
+        double after[3];
+        double clock_before;
+        double clock_after;
+        ephemeris_position(sat.eph, t, sat.pos, &sat.clock_bias);
+        ephemeris_position(sat.eph, t - 0.5, before, &clock_before);
+        ephemeris_position(sat.eph, t + 0.5, after, &clock_after);
+        for (int j = 0; j < 3; j++) {
+            sat.vel[j] = after[j] - before[j];
+        }
+        sat.clock_drift = clock_after - clock_before;
+    }
+}
+
+/**
+ * @brief Encodes every frame a station sends for the current epoch.
+ *
+ * @param station The station index (0..num_stations-1).
+ * @param out Buffer of at least synthetic_max_epoch_bytes bytes.
+ * @return The number of bytes written.
+ */
+size_t SyntheticNetwork::EncodeStation(int station, uint8_t* out) {
+    const Rtcm3Station& rx = stations_[station];
+    const double* up = &station_up_[station * 3];
+    const double sin_mask = sin(options_.elevation_mask * gnss_pi / 180.0);
+    const uint32_t lock_ms = static_cast<uint32_t>(epoch_ms_ % 3600000) + 1000;
+    size_t written = 0;
+
+    // find the last constellation with visible satellites so its message clears the multiple bit
+    MsmMessage msm;
+    int last_model = -1;
+    for (int m = 0; m < static_cast<int>(sizeof(models) / sizeof(models[0])); m++) {
+        if (options_.constellations.find(models[m].id) != std::string::npos) {
+            last_model = m;
+        }
+    }
+
+    size_t sat_index = 0;
+    for (int m = 0; m < static_cast<int>(sizeof(models) / sizeof(models[0])); m++) {
+        const ConstellationModel& model = models[m];
+        if (options_.constellations.find(model.id) == std::string::npos) {
+            continue;
+        }
+        msm.system = model.system;
+        msm.msm_level = options_.msm_level;
+        msm.station_id = rx.station_id;
+        msm.multiple = (m != last_model);
+        if (model.system == GnssSystem::kGlonass) {
+            int64_t moscow_ms = epoch_ms_ - leap_ms + 3 * 3600000;
+            msm.glo_day_of_week = static_cast<uint8_t>((moscow_ms / day_ms) % 7);
+            msm.epoch_ms = static_cast<uint32_t>(moscow_ms % day_ms);
+        } else if (model.system == GnssSystem::kBeidou) {
+            msm.epoch_ms = static_cast<uint32_t>((epoch_ms_ - bds_offset_ms) % week_ms);
+        } else {
+            msm.epoch_ms = static_cast<uint32_t>(epoch_ms_ % week_ms);
+        }
+        msm.num_sats = 0;
+        msm.num_cells = 0;
+        const int max_sats = 64 / model.num_signals;
+
+        for (; sat_index < satellites_.size() && satellites_[sat_index].system == model.system; sat_index++) {
+            const Satellite& sat = satellites_[sat_index];
+            double d[3] = {sat.pos[0] - rx.ecef[0], sat.pos[1] - rx.ecef[1], sat.pos[2] - rx.ecef[2]};
+            double range = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            double sin_el = (d[0] * up[0] + d[1] * up[1] + d[2] * up[2]) / range;
+            if (sin_el < sin_mask || msm.num_sats >= max_sats) {
+                continue;
+            }
+            // satellite position at transmission time plus the Earth rotation correction
+            double tau = range / speed_of_light;
+            double tx[3] = {sat.pos[0] - sat.vel[0] * tau, sat.pos[1] - sat.vel[1] * tau, sat.pos[2] - sat.vel[2] * tau};
+            double dx[3] = {tx[0] - rx.ecef[0], tx[1] - rx.ecef[1], tx[2] - rx.ecef[2]};
+            double geometric = sqrt(dx[0] * dx[0] + dx[1] * dx[1] + dx[2] * dx[2]) +
+                               earth_rotation_rate * (tx[0] * rx.ecef[1] - tx[1] * rx.ecef[0]) / speed_of_light;
+            double pseudorange = geometric - speed_of_light * sat.clock_bias;
+            double rate = (sat.vel[0] * dx[0] + sat.vel[1] * dx[1] + sat.vel[2] * dx[2]) / geometric -
+                          speed_of_light * sat.clock_drift;
+
+            msm.sat_prn[msm.num_sats] = sat.prn;
+            msm.sat_ext_info[msm.num_sats] = model.system == GnssSystem::kGlonass ?
+                static_cast<uint8_t>(sat.glo_channel + 7) : 0;
+            msm.num_sats++;
+            for (int g = 0; g < model.num_signals; g++) {
+                MsmCell& cell = msm.cells[msm.num_cells++];
+                cell.prn = sat.prn;
+                cell.signal_id = model.signals[g];
+                cell.valid = MsmCell::kPseudorange | MsmCell::kPhase | MsmCell::kRate;
+                cell.half_cycle = false;
+                cell.pseudorange = pseudorange;
+                cell.phase_range = pseudorange + ((sat.prn * 7919 + g * 104729) % 2000 - 1000) * 0.1;
+                cell.range_rate = rate;
+                cell.cnr = 30.0 + 20.0 * sin_el - 3.0 * g;
+                cell.lock_ms = lock_ms;
+            }
+        }
+        if (msm.num_sats > 0 || !msm.multiple) {
+            written += encode_rtcm3_msm(msm, out + written);
+        }
+    }
+
+    int64_t phase = (epoch_count_ + station) % options_.station_interval;
+    if (phase == 0) {
+        written += encode_rtcm3_station(rx, 1006, out + written);
+    }
+    if (epoch_count_ % options_.ephemeris_interval == 0 && !satellites_.empty()) {
+        size_t count = satellites_.size();
+        for (size_t tries = 0; tries < count; tries++) {
+            const Satellite& sat = satellites_[(epoch_count_ / options_.ephemeris_interval + station + tries) % count];
+            if (sat.eph.message_type != 0) {
+                written += encode_rtcm3_ephemeris(sat.eph, out + written);
+                break;
+            }
+        }
+    }
+    return written;
+}
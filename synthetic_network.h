@@ -0,0 +1,118 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "rtcm3.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// upper bound of the bytes EncodeStation() produces for one station and epoch
+constexpr size_t synthetic_max_epoch_bytes = 8 * rtcm3_max_frame_size;
+
+/**
+ * @brief Settings for SyntheticNetwork.
+ */
+struct SyntheticOptions {
+    int num_stations = 1;
+    std::string constellations = "GREC";  // RINEX system letters to simulate
+    int msm_level = 7;  // 4 or 7
+    int station_interval = 10;  // epochs between 1005/1006 messages
+    int ephemeris_interval = 1;  // epochs between ephemeris messages (one satellite each)
+    double elevation_mask = 10.0;  // degrees
+};
+
+/**
+ * @brief Synthetic GNSS reference station network producing valid RTCM3 streams.
+ *
+ * Satellites follow Keplerian orbits whose broadcast ephemerides are also emitted, so the
+ * observations are self-consistent: a positioning engine fed with the generated stream
+ * recovers the advertised 1005/1006 station coordinates. Satellite states are computed once
+ * per epoch and shared by every station, so a single core generates close to 100 MB/s.
+ */
+class SyntheticNetwork {
+public:
+
+    /**
+     * @brief Constructor for SyntheticNetwork.
+     *
+     * @param options The network settings.
+     */
+    explicit SyntheticNetwork(const SyntheticOptions& options);
+
+    /**
+     * @brief Advances the constellation to an epoch.
+     *
+     * @param gps_ms Milliseconds since the GPS epoch (1980-01-06).
+     */
+    void SetEpoch(int64_t gps_ms);
+
+    /**
+     * @brief Encodes every frame a station sends for the current epoch.
+     *
+     * @param station The station index (0..num_stations-1).
+     * @param out Buffer of at least synthetic_max_epoch_bytes bytes.
+     * @return The number of bytes written.
+     */
+    size_t EncodeStation(int station, uint8_t* out);
+
+    /**
+     * @brief Returns the advertised position of a station.
+     */
+    const Rtcm3Station& station(int index) const { return stations_[index]; }
+
+    int num_stations() const { return static_cast<int>(stations_.size()); }
+
+private:
+
+    /**
+     * @brief Satellite state shared by all stations for one epoch.
+     */
+    struct Satellite {
+        GnssSystem system;
+        uint8_t prn;
+        int8_t glo_channel;
+        Rtcm3Ephemeris eph;
+        double pos[3];
+        double vel[3];
+        double clock_bias;
+        double clock_drift;
+    };
+
+    /**
+     * @brief Builds the broadcast ephemerides valid for the given GPS time.
+     */
+    void UpdateEphemerides(int64_t gps_ms);
+
+    SyntheticOptions options_;
+    std::vector<Rtcm3Station> stations_;
+    std::vector<double> station_up_;  // unit up vector per station, 3 values each
+    std::vector<Satellite> satellites_;
+    int64_t epoch_ms_ = 0;
+    int64_t epoch_count_ = 0;
+    int64_t ephemeris_block_ = -1;
+};
@@ -0,0 +1,354 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "transport.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+
+constexpr int max_events = 256;
+
+/**
+ * @brief Constructor for SocketTransport, noting the receive buffer the kernel gives new sockets.
+ */
+SocketTransport::SocketTransport() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        std::cerr << "Error: Could not create epoll instance" << std::endl;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0) {
+        int size = 0;
+        socklen_t len = sizeof(size);
+        if (getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, &len) == 0 && size > 0) {
+            default_receive_buffer_ = static_cast<size_t>(size);
+        }
+        close(fd);
+    }
+}
+
+/**
+ * @brief Destructor for SocketTransport, closing every open connection.
+ */
+SocketTransport::~SocketTransport() {
+    for (size_t fd = 0; fd < states_.size(); fd++) {
+        if (states_[fd] != kClosed) {
+            close(static_cast<int>(fd));
+        }
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+/**
+ * @brief Starts a non-blocking TCP connection to a server.
+ *
+ * @param receive_buffer SO_RCVBUF to set before connecting, 0 to leave the kernel autotuning the buffer.
+ * @return The socket descriptor, -1 if the host cannot be resolved or the connection cannot be started.
+ */
+int SocketTransport::Connect(const std::string& host, const std::string& port, size_t receive_buffer) {
+    // using the host variable, resolve the ip address for the server, unless it is known
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    auto known = addresses_.find(host);
+    char* port_end = nullptr;
+    long port_number = strtol(port.c_str(), &port_end, 10);
+    if (known != addresses_.end() && *port_end == '\0' && port_number > 0 && port_number < 65536) {
+        address.sin_addr.s_addr = known->second;
+        address.sin_port = htons(static_cast<uint16_t>(port_number));
+    } else {
+        addrinfo hints, *res;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        int status = getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+        if (status != 0) {
+            std::cerr << "Error: Could not resolve host address" << std::endl;
+            return -1;
+        }
+        memcpy(&address, res->ai_addr, sizeof(address));
+        freeaddrinfo(res);
+        addresses_[host] = address.sin_addr.s_addr;
+    }
+
+    // create socket
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Error: Could not create socket" << std::endl;
+        return -1;
+    }
+
+    // TCP socket keepalive.
+#if defined(ENABLE_TCP_KEEPALIVE)
+    int keepalive = 1;  // Enable keepalive attributes.
+    int keepidle = 30;  // Time out for starting detection.
+    int keepinterval = 5;  // Time interval for sending packets during detection.
+    int keepcount = 3;  // Max times for sending packets during detection.
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive));
+    setsockopt(fd, SOL_TCP, TCP_KEEPIDLE, &keepidle, sizeof(keepidle));
+    setsockopt(fd, SOL_TCP, TCP_KEEPINTVL, &keepinterval, sizeof(keepinterval));
+    setsockopt(fd, SOL_TCP, TCP_KEEPCNT, &keepcount, sizeof(keepcount));
+#endif  // defined(ENABLE_TCP_KEEPALIVE)
+
+    if (incoming_cpu_ >= 0) {
+        setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &incoming_cpu_, sizeof(incoming_cpu_));
+    }
+
+    // the window scale is fixed by the SYN, so a larger buffer set after connect() cannot be fully used
+    if (receive_buffer > 0) {
+        int size = static_cast<int>(receive_buffer);
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    // connect to server
+    int ret = connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    if (ret < 0 && errno != EINPROGRESS) {
+        std::cerr << "Error: Could not connect to server" << std::endl;
+        addresses_.erase(host);
+        close(fd);
+        return -1;
+    }
+
+    // the socket reports writable once the connect completes
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.fd = fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    if (static_cast<size_t>(fd) >= states_.size()) {
+        states_.resize(fd + 1, kClosed);
+        connect_hosts_.resize(fd + 1);
+    }
+    states_[fd] = kPending;
+    connect_hosts_[fd] = host;
+    return fd;
+}
+
+/**
+ * @brief Returns 1 once the connection is established, 0 while pending and -1 if it failed.
+ */
+int SocketTransport::ConnectResult(int handle) {
+    if (handle < 0 || static_cast<size_t>(handle) >= states_.size() || states_[handle] == kClosed) {
+        return -1;
+    }
+    if (states_[handle] == kConnected) {
+        return 1;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(handle, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+        addresses_.erase(connect_hosts_[handle]);  // the host may have moved, look it up again
+        return -1;
+    }
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    if (getpeername(handle, (struct sockaddr*)&peer, &peer_len) < 0) {
+        return 0;  // still in progress
+    }
+
+    // connected: from now on only readability is of interest
+    states_[handle] = kConnected;
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = handle;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, handle, &event);
+    return 1;
+}
+
+/**
+ * @brief Sends bytes on an established connection.
+ *
+ * @return The number of bytes sent, kWouldBlock or kError.
+ */
+ssize_t SocketTransport::Send(int handle, const void* data, size_t size) {
+    ssize_t ret = send(handle, data, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (ret >= 0) {
+        return ret;
+    }
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? kWouldBlock : kError;
+}
+
+/**
+ * @brief Receives bytes from a connection.
+ *
+ * @return The number of bytes received, 0 if the peer closed, kWouldBlock or kError.
+ */
+ssize_t SocketTransport::Recv(int handle, void* data, size_t size) {
+    ssize_t ret = recv(handle, data, size, MSG_DONTWAIT);
+    if (ret >= 0) {
+        return ret;
+    }
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? kWouldBlock : kError;
+}
+
+/**
+ * @brief Closes a connection and releases its handle.
+ */
+void SocketTransport::Close(int handle) {
+    if (handle < 0) {
+        return;
+    }
+    if (static_cast<size_t>(handle) < states_.size()) {
+        states_[handle] = kClosed;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, handle, nullptr);
+    close(handle);
+}
+
+/**
+ * @brief Waits until sockets become readable, finish connecting or fail.
+ */
+void SocketTransport::Wait(int64_t timeout_us, std::vector<int>* ready) {
+    ready->clear();
+    struct epoll_event events[max_events];
+    int timeout_ms = timeout_us <= 0 ? 0 : static_cast<int>(std::min<int64_t>((timeout_us + 999) / 1000, 1000000));
+    int count = epoll_wait(epoll_fd_, events, max_events, timeout_ms);
+    for (int i = 0; i < count; i++) {
+        ready->push_back(events[i].data.fd);
+    }
+}
+
+/**
+ * @brief Returns the IPv4 address, in network byte order, a host last resolved to; 0 if unknown.
+ */
+uint32_t SocketTransport::ResolvedAddress(const std::string& host) const {
+    auto known = addresses_.find(host);
+    return known == addresses_.end() ? 0 : known->second;
+}
+
+/**
+ * @brief Seeds the address of a host, e.g. from a checkpoint, so the next connect skips the lookup.
+ */
+void SocketTransport::SetResolvedAddress(const std::string& host, uint32_t address) {
+    if (address != 0) {
+        addresses_[host] = address;
+    }
+}
+
+/**
+ * @brief Takes over an established connection, e.g. one handed over by another process.
+ *
+ * @return The socket descriptor, which is the handle, -1 if it is not a connected socket.
+ */
+int SocketTransport::Adopt(int fd) {
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    if (fd < 0 || getpeername(fd, (struct sockaddr*)&peer, &peer_len) < 0) {
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        return -1;
+    }
+    if (static_cast<size_t>(fd) >= states_.size()) {
+        states_.resize(fd + 1, kClosed);
+        connect_hosts_.resize(fd + 1);
+    }
+    states_[fd] = kConnected;
+    return fd;
+}
+
+/**
+ * @brief Stops watching a connection and gives up its socket without closing it.
+ *
+ * @return The socket descriptor, -1 if the handle is not an open connection.
+ */
+int SocketTransport::Release(int handle) {
+    if (handle < 0 || static_cast<size_t>(handle) >= states_.size() || states_[handle] == kClosed) {
+        return -1;
+    }
+    states_[handle] = kClosed;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, handle, nullptr);
+    return handle;
+}
+
+/**
+ * @brief Sets SO_RCVBUF, which also stops the kernel from autotuning the buffer of the connection.
+ *
+ * @return The size the kernel reports afterwards, 0 if the connection is closed or the call failed.
+ */
+size_t SocketTransport::SetReceiveBuffer(int handle, size_t bytes) {
+    if (handle < 0 || static_cast<size_t>(handle) >= states_.size() || states_[handle] == kClosed) {
+        return 0;
+    }
+    int size = static_cast<int>(bytes);
+    if (setsockopt(handle, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
+        return 0;
+    }
+    socklen_t len = sizeof(size);
+    if (getsockopt(handle, SOL_SOCKET, SO_RCVBUF, &size, &len) < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(size);
+}
+
+/**
+ * @brief Returns the SO_RCVBUF the kernel reports for a connection, 0 if it is closed or the call failed.
+ */
+size_t SocketTransport::ReceiveBuffer(int handle) const {
+    if (handle < 0 || static_cast<size_t>(handle) >= states_.size() || states_[handle] == kClosed) {
+        return 0;
+    }
+    int size = 0;
+    socklen_t len = sizeof(size);
+    if (getsockopt(handle, SOL_SOCKET, SO_RCVBUF, &size, &len) < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(size);
+}
+
+/**
+ * @brief Returns the CPU that processed the last packet received on a connection, -1 if unknown.
+ */
+int SocketTransport::IncomingCpu(int handle) const {
+    if (handle < 0 || static_cast<size_t>(handle) >= states_.size() || states_[handle] != kConnected) {
+        return -1;
+    }
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(handle, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0) {
+        return -1;
+    }
+    return cpu;
+}
@@ -0,0 +1,192 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Non-blocking stream connections, identified by small integer handles.
+ *
+ * NtripClient only talks to the network through this interface so that the socket
+ * implementation can be swapped for a simulated network driven by a VirtualClock.
+ */
+class Transport {
+public:
+    static constexpr ssize_t kWouldBlock = -1;  // no data or buffer space right now
+    static constexpr ssize_t kError = -2;  // the connection failed or was reset
+
+    virtual ~Transport() = default;
+
+    /**
+     * @brief Starts connecting to a server.
+     *
+     * @param receive_buffer The receive buffer to request before connecting, 0 for the default. Set
+     *                       before the SYN, it also sizes the window scale the connection is offered.
+     * @return The connection handle, -1 if the connection could not be started.
+     */
+    virtual int Connect(const std::string& host, const std::string& port, size_t receive_buffer) = 0;
+
+    /**
+     * @brief Returns 1 once the connection is established, 0 while pending and -1 if it failed.
+     */
+    virtual int ConnectResult(int handle) = 0;
+
+    /**
+     * @brief Sends bytes on an established connection.
+     *
+     * @return The number of bytes sent, kWouldBlock or kError.
+     */
+    virtual ssize_t Send(int handle, const void* data, size_t size) = 0;
+
+    /**
+     * @brief Receives bytes from a connection.
+     *
+     * @return The number of bytes received, 0 if the peer closed, kWouldBlock or kError.
+     */
+    virtual ssize_t Recv(int handle, void* data, size_t size) = 0;
+
+    /**
+     * @brief Closes a connection and releases its handle.
+     */
+    virtual void Close(int handle) = 0;
+
+    /**
+     * @brief Waits until connections become readable, finish connecting or fail.
+     *
+     * @param timeout_us The longest time to wait; a simulated transport advances its clock instead.
+     * @param ready Receives the handles that need attention.
+     */
+    virtual void Wait(int64_t timeout_us, std::vector<int>* ready) = 0;
+
+    /**
+     * @brief Sizes the receive buffer the kernel keeps for a connection; transports without one ignore it.
+     *
+     * @return The size in effect afterwards, 0 if the transport has no such buffer.
+     */
+    virtual size_t SetReceiveBuffer(int /*handle*/, size_t /*bytes*/) { return 0; }
+
+    /**
+     * @brief Returns the receive buffer a new connection starts with, 0 if the transport has none.
+     */
+    virtual size_t DefaultReceiveBuffer() const { return 0; }
+
+    /**
+     * @brief Returns the receive buffer in effect for a connection, 0 if the transport has none.
+     */
+    virtual size_t ReceiveBuffer(int /*handle*/) const { return 0; }
+
+    /**
+     * @brief Returns the IPv4 address, in network byte order, a host last resolved to; 0 if unknown.
+     */
+    virtual uint32_t ResolvedAddress(const std::string& /*host*/) const { return 0; }
+
+    /**
+     * @brief Seeds the address of a host, e.g. from a checkpoint, so the next connect skips the lookup.
+     */
+    virtual void SetResolvedAddress(const std::string& /*host*/, uint32_t /*address*/) {}
+
+    /**
+     * @brief Takes over an established connection, e.g. one handed over by another process.
+     *
+     * @param fd The connected socket; the transport owns it afterwards.
+     * @return The connection handle, -1 if the transport has no sockets.
+     */
+    virtual int Adopt(int /*fd*/) { return -1; }
+
+    /**
+     * @brief Stops watching a connection and gives up its socket without closing it.
+     *
+     * @return The socket descriptor, -1 if the transport has no sockets.
+     */
+    virtual int Release(int /*handle*/) { return -1; }
+};
+
+/**
+ * @brief Transport over non-blocking TCP sockets, multiplexed with epoll.
+ *
+ * Host names are resolved once and the address reused by later connects, so a reconnect
+ * does not block the event loop on a DNS lookup. A connect that fails drops the address,
+ * and the next attempt resolves the name again.
+ */
+class SocketTransport : public Transport {
+public:
+
+    /**
+     * @brief Constructor for SocketTransport.
+     */
+    SocketTransport();
+
+    /**
+     * @brief Destructor for SocketTransport, closing every open connection.
+     */
+    ~SocketTransport() override;
+
+    int Connect(const std::string& host, const std::string& port, size_t receive_buffer) override;
+    int ConnectResult(int handle) override;
+    ssize_t Send(int handle, const void* data, size_t size) override;
+    ssize_t Recv(int handle, void* data, size_t size) override;
+    void Close(int handle) override;
+    void Wait(int64_t timeout_us, std::vector<int>* ready) override;
+
+    /**
+     * @brief Sets SO_RCVBUF, which also stops the kernel from autotuning the buffer of the connection.
+     *
+     * @return The size the kernel reports afterwards, twice the request to cover its bookkeeping.
+     */
+    size_t SetReceiveBuffer(int handle, size_t bytes) override;
+    size_t DefaultReceiveBuffer() const override { return default_receive_buffer_; }
+    size_t ReceiveBuffer(int handle) const override;
+    uint32_t ResolvedAddress(const std::string& host) const override;
+    void SetResolvedAddress(const std::string& host, uint32_t address) override;
+    int Adopt(int fd) override;
+    int Release(int handle) override;
+
+    /**
+     * @brief Asks for the packets of new connections to be processed on a CPU (SO_INCOMING_CPU).
+     *
+     * A hint for receive flow steering; -1 (the default) leaves the kernel's choice.
+     */
+    void SetIncomingCpu(int cpu) { incoming_cpu_ = cpu; }
+
+    /**
+     * @brief Returns the CPU that processed the last packet received on a connection, -1 if unknown.
+     */
+    int IncomingCpu(int handle) const;
+
+private:
+    enum : uint8_t { kClosed, kPending, kConnected };
+
+    int epoll_fd_ = -1;
+    int incoming_cpu_ = -1;
+    size_t default_receive_buffer_ = 0;  // SO_RCVBUF of a fresh TCP socket
+    std::vector<uint8_t> states_;  // connection state indexed by fd
+    std::unordered_map<std::string, uint32_t> addresses_;  // resolved IPv4 address per host
+    std::vector<std::string> connect_hosts_;  // per fd, the host of a pending connect
+};
@@ -0,0 +1,117 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "tsc_clock.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <string>
+
+constexpr int64_t calibration_ns = 20000000;
+constexpr int calibration_samples = 16;
+
+/**
+ * @brief Reads the counter and CLOCK_MONOTONIC as close together as possible.
+ *
+ * Of several tries, the one where the two counter reads bracketing the clock read are
+ * closest wins, and the counter is taken as their midpoint.
+ */
+static void paired_sample(uint64_t* cycles, int64_t* ns) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < calibration_samples; i++) {
+        uint64_t before = read_cycles();
+        int64_t now = TscClock::SystemMonotonicNs();
+        uint64_t after = read_cycles();
+        if (after - before < best) {
+            best = after - before;
+            *cycles = before + (after - before) / 2;
+            *ns = now;
+        }
+    }
+}
+
+/**
+ * @brief Returns true if the time stamp counter can stand in for CLOCK_MONOTONIC.
+ */
+static bool tsc_reliable() {
+#if defined(__x86_64__) || defined(__i386__)
+    const char* env = getenv("NTRIP_TSC");
+    if (env != nullptr && strcmp(env, "0") == 0) {
+        return false;
+    }
+    // invariant TSC: constant rate across P-, C- and T-states
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || (edx & (1u << 8)) == 0) {
+        return false;
+    }
+    // the kernel drops tsc from the clock sources when it finds it unstable, e.g. unsynchronized across sockets
+    std::ifstream sources("/sys/devices/system/clocksource/clocksource0/available_clocksource");
+    std::string list;
+    if (sources && std::getline(sources, list)) {
+        return (" " + list + " ").find(" tsc ") != std::string::npos;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Returns the process wide clock, calibrating it on first use (about 20 ms).
+ */
+const TscClock& TscClock::Get() {
+    static const TscClock clock;
+    return clock;
+}
+
+/**
+ * @brief Constructor for TscClock, checking and calibrating the counter.
+ */
+TscClock::TscClock() {
+    uint64_t start_cycles, end_cycles;
+    int64_t start_ns, end_ns;
+    paired_sample(&start_cycles, &start_ns);
+    do {
+        paired_sample(&end_cycles, &end_ns);
+    } while (end_ns - start_ns < calibration_ns);
+    cycles_per_second_ = (end_cycles - start_cycles) * 1e9 / (end_ns - start_ns);
+
+    use_tsc_ = tsc_reliable() && end_cycles > start_cycles;
+    if (use_tsc_) {
+        base_ticks_ = end_cycles;
+        base_ns_ = end_ns;
+        ns_per_tick_ = 1e9 / cycles_per_second_;
+    }
+
+    struct timespec realtime;
+    int64_t before = SystemMonotonicNs();
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    int64_t after = SystemMonotonicNs();
+    realtime_offset_ns_ = static_cast<int64_t>(realtime.tv_sec) * 1000000000 + realtime.tv_nsec -
+                          (before + (after - before) / 2);
+}
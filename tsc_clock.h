@@ -0,0 +1,142 @@
+/*
+MIT License
+
+Copyright (c) 2025 Noah Giustini
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Reads a cheap, monotonic cycle counter.
+ *
+ * The time stamp counter on x86, CLOCK_MONOTONIC nanoseconds elsewhere. Only differences
+ * are meaningful; convert them with cycles_per_second().
+ */
+inline uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Timestamps from the invariant time stamp counter, calibrated against the system clocks.
+ *
+ * Reading the counter costs a few nanoseconds where a clock_gettime() call costs tens, which
+ * matters when every received frame is timestamped. The counter is calibrated once against
+ * CLOCK_MONOTONIC and CLOCK_REALTIME when first used; the short calibration leaves a rate
+ * error of a few ppm, fine for latencies and timeouts but not a replacement for NTP. Where
+ * the counter is not invariant, the kernel has rejected it as a clock source or NTRIP_TSC=0
+ * is set, the ticks are CLOCK_MONOTONIC nanoseconds instead, so the interface stays the same.
+ */
+class TscClock {
+public:
+
+    /**
+     * @brief Returns the process wide clock, calibrating it on first use (about 20 ms).
+     */
+    static const TscClock& Get();
+
+    /**
+     * @brief Returns the current ticks; only differences and ToNs() of them are meaningful.
+     */
+    uint64_t Ticks() const {
+        if (use_tsc_) {
+            return read_cycles();
+        }
+        return static_cast<uint64_t>(SystemMonotonicNs());
+    }
+
+    /**
+     * @brief Converts ticks to CLOCK_MONOTONIC nanoseconds.
+     */
+    int64_t ToNs(uint64_t ticks) const {
+        if (!use_tsc_) {
+            return static_cast<int64_t>(ticks);
+        }
+        return base_ns_ + static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(ticks - base_ticks_)) * ns_per_tick_);
+    }
+
+    /**
+     * @brief Converts ticks to CLOCK_REALTIME nanoseconds since the Unix epoch.
+     */
+    int64_t ToRealtimeNs(uint64_t ticks) const { return ToNs(ticks) + realtime_offset_ns_; }
+
+    /**
+     * @brief Returns the nanoseconds between two tick readings.
+     */
+    int64_t ElapsedNs(uint64_t from, uint64_t to) const {
+        return static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(to - from)) * ns_per_tick_);
+    }
+
+    /**
+     * @brief Returns the current CLOCK_MONOTONIC time in nanoseconds.
+     */
+    int64_t MonotonicNs() const { return ToNs(Ticks()); }
+
+    /**
+     * @brief Returns true if the ticks are time stamp counter cycles.
+     */
+    bool uses_tsc() const { return use_tsc_; }
+
+    /**
+     * @brief Returns the measured rate of read_cycles(), whether or not the ticks use it.
+     */
+    double cycles_per_second() const { return cycles_per_second_; }
+
+    /**
+     * @brief Reads CLOCK_MONOTONIC in nanoseconds.
+     */
+    static int64_t SystemMonotonicNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+private:
+
+    /**
+     * @brief Constructor for TscClock, checking and calibrating the counter.
+     */
+    TscClock();
+
+    bool use_tsc_ = false;
+    uint64_t base_ticks_ = 0;
+    int64_t base_ns_ = 0;
+    double ns_per_tick_ = 1.0;
+    int64_t realtime_offset_ns_ = 0;
+    double cycles_per_second_ = 1e9;
+};
+
+/**
+ * @brief Returns the rate of read_cycles(), measured once on first use.
+ */
+inline double cycles_per_second() {
+    return TscClock::Get().cycles_per_second();
+}